@@ -7,9 +7,17 @@
 	[ common ]
 */
 
+#ifdef _WIN32
 #include <windows.h>
+#endif
 #include "common.h"
 
+#if defined(SIMD_USE_AVX2)
+#include <immintrin.h>
+#elif defined(SIMD_USE_SSE2)
+#include <emmintrin.h>
+#endif
+
 bool check_file_extension(_TCHAR* filename, _TCHAR* ext)
 {
 	int nam_len = _tcslen(filename);
@@ -18,33 +26,273 @@ bool check_file_extension(_TCHAR* filename, _TCHAR* ext)
 	return (nam_len >= ext_len && _tcsncicmp(&filename[nam_len - ext_len], ext, ext_len) == 0);
 }
 
-uint32 getcrc32(uint8 data[], int size)
+// the tables in this file are built at startup and only read after that,
+// so they can be shared by vm instances running on several threads
+
+static uint32 crc32_table[256];
+
+static bool initialize_crc32_table()
 {
-	static bool initialized = false;
-	static uint32 table[256];
-	
-	if(!initialized) {
-		for(int i = 0; i < 256; i++) {
-			uint32 c = i;
-			for(int j = 0; j < 8; j++) {
-				if(c & 1) {
-					c = (c >> 1) ^ 0xedb88320;
-				} else {
-					c >>= 1;
-				}
+	for(int i = 0; i < 256; i++) {
+		uint32 c = i;
+		for(int j = 0; j < 8; j++) {
+			if(c & 1) {
+				c = (c >> 1) ^ 0xedb88320;
+			} else {
+				c >>= 1;
 			}
-			table[i] = c;
 		}
-		initialized = true;
+		crc32_table[i] = c;
 	}
-	
+	return true;
+}
+
+static bool crc32_initialized = initialize_crc32_table();
+
+uint32 getcrc32(uint8 data[], int size)
+{
 	uint32 c = ~0;
 	for(int i = 0; i < size; i++) {
-		c = table[(c ^ data[i]) & 0xff] ^ (c >> 8);
+		c = crc32_table[(c ^ data[i]) & 0xff] ^ (c >> 8);
 	}
 	return ~c;
 }
 
+// ----------------------------------------------------------------------------
+// sound buffer
+// ----------------------------------------------------------------------------
+
+// sound_tmp is filtered and converted by sse2/avx2 when the compiler enables them,
+// and the results are same as the scalar code at the tail of each function
+
+void lowpass_sound(int32* buffer, int samples)
+{
+	// stereo: each sample is averaged with the next sample of the same channel
+	int count = (samples - 1) * 2, i = 0;
+	
+	// the next samples are loaded before they are overwritten
+#if defined(SIMD_USE_AVX2)
+	for(; i + 8 <= count; i += 8) {
+		__m256i cur = _mm256_loadu_si256((__m256i*)(buffer + i));
+		__m256i next = _mm256_loadu_si256((__m256i*)(buffer + i + 2));
+		__m256i sum = _mm256_add_epi32(cur, next);
+		// round toward zero as the division of c
+		sum = _mm256_add_epi32(sum, _mm256_srli_epi32(sum, 31));
+		_mm256_storeu_si256((__m256i*)(buffer + i), _mm256_srai_epi32(sum, 1));
+	}
+#endif
+#if defined(SIMD_USE_SSE2)
+	for(; i + 4 <= count; i += 4) {
+		__m128i cur = _mm_loadu_si128((__m128i*)(buffer + i));
+		__m128i next = _mm_loadu_si128((__m128i*)(buffer + i + 2));
+		__m128i sum = _mm_add_epi32(cur, next);
+		sum = _mm_add_epi32(sum, _mm_srli_epi32(sum, 31));
+		_mm_storeu_si128((__m128i*)(buffer + i), _mm_srai_epi32(sum, 1));
+	}
+#endif
+	for(; i < count; i++) {
+		buffer[i] = (buffer[i] + buffer[i + 2]) / 2;
+	}
+}
+
+#if defined(SIMD_USE_SSE2)
+static inline __m128i saturate_sound_sse2(__m128i dat)
+{
+	// the lower word is sign extended, and it is replaced with 0x7fff or 0x8000
+	// when its sign is not same as the sign of the 32bit value
+	__m128i sign = _mm_srai_epi32(dat, 31);
+	__m128i low = _mm_srai_epi32(_mm_slli_epi32(dat, 16), 16);
+	__m128i over = _mm_xor_si128(sign, _mm_srai_epi32(low, 31));
+	__m128i limit = _mm_xor_si128(sign, _mm_set1_epi32(0x7fff));
+	return _mm_or_si128(_mm_and_si128(over, limit), _mm_andnot_si128(over, low));
+}
+#endif
+
+#if defined(SIMD_USE_AVX2)
+static inline __m256i saturate_sound_avx2(__m256i dat)
+{
+	__m256i sign = _mm256_srai_epi32(dat, 31);
+	__m256i low = _mm256_srai_epi32(_mm256_slli_epi32(dat, 16), 16);
+	__m256i over = _mm256_xor_si256(sign, _mm256_srai_epi32(low, 31));
+	__m256i limit = _mm256_xor_si256(sign, _mm256_set1_epi32(0x7fff));
+	return _mm256_blendv_epi8(low, limit, over);
+}
+#endif
+
+void saturate_sound(uint16* dst, int32* src, int samples)
+{
+	int count = samples * 2, i = 0;
+
+#if defined(SIMD_USE_AVX2)
+	for(; i + 16 <= count; i += 16) {
+		__m256i dat0 = saturate_sound_avx2(_mm256_loadu_si256((__m256i*)(src + i)));
+		__m256i dat1 = saturate_sound_avx2(_mm256_loadu_si256((__m256i*)(src + i + 8)));
+		// packs works in each 128bit lane, so the qwords are sorted again
+		__m256i dat = _mm256_permute4x64_epi64(_mm256_packs_epi32(dat0, dat1), 0xd8);
+		_mm256_storeu_si256((__m256i*)(dst + i), dat);
+	}
+#endif
+#if defined(SIMD_USE_SSE2)
+	for(; i + 8 <= count; i += 8) {
+		__m128i dat0 = saturate_sound_sse2(_mm_loadu_si128((__m128i*)(src + i)));
+		__m128i dat1 = saturate_sound_sse2(_mm_loadu_si128((__m128i*)(src + i + 4)));
+		_mm_storeu_si128((__m128i*)(dst + i), _mm_packs_epi32(dat0, dat1));
+	}
+#endif
+	for(; i < count; i++) {
+		int dat = src[i];
+		uint16 highlow = (uint16)(dat & 0x0000ffff);
+		
+		if((dat > 0) && (highlow >= 0x8000)) {
+			dst[i] = 0x7fff;
+			continue;
+		}
+		if((dat < 0) && (highlow < 0x8000)) {
+			dst[i] = 0x8000;
+			continue;
+		}
+		dst[i] = highlow;
+	}
+}
+
+// ----------------------------------------------------------------------------
+// bitplanes
+// ----------------------------------------------------------------------------
+
+// sse2/avx2: the bytes of the planes at the same address are gathered into a
+// 64bit word as 8x8 bit matrix, and it is flipped by three swaps of the bit
+// blocks, so that each byte of the word is one pixel and the bit n of the pixel
+// is the plane n. for msb first the planes are gathered from the msb byte and
+// the matrix is flipped at the anti diagonal, so the leftmost pixel comes to the
+// lowest byte. the scalar code at the tail looks up the 8 pixels of each byte.
+
+#if defined(SIMD_USE_SSE2)
+static inline __m128i flip_planes_sse2(__m128i x, bool lsb_first)
+{
+	__m128i t;
+	if(lsb_first) {
+		t = _mm_and_si128(_mm_xor_si128(x, _mm_slli_epi64(x, 28)), _mm_set1_epi64x(0x0f0f0f0f00000000LL));
+		x = _mm_xor_si128(x, _mm_xor_si128(t, _mm_srli_epi64(t, 28)));
+		t = _mm_and_si128(_mm_xor_si128(x, _mm_slli_epi64(x, 14)), _mm_set1_epi64x(0x3333000033330000LL));
+		x = _mm_xor_si128(x, _mm_xor_si128(t, _mm_srli_epi64(t, 14)));
+		t = _mm_and_si128(_mm_xor_si128(x, _mm_slli_epi64(x,  7)), _mm_set1_epi64x(0x5500550055005500LL));
+		x = _mm_xor_si128(x, _mm_xor_si128(t, _mm_srli_epi64(t,  7)));
+	}
+	else {
+		t = _mm_xor_si128(x, _mm_slli_epi64(x, 36));
+		x = _mm_xor_si128(x, _mm_and_si128(_mm_xor_si128(t, _mm_srli_epi64(x, 36)), _mm_set1_epi64x(0xf0f0f0f00f0f0f0fLL)));
+		t = _mm_and_si128(_mm_xor_si128(x, _mm_slli_epi64(x, 18)), _mm_set1_epi64x(0xcccc0000cccc0000LL));
+		x = _mm_xor_si128(x, _mm_xor_si128(t, _mm_srli_epi64(t, 18)));
+		t = _mm_and_si128(_mm_xor_si128(x, _mm_slli_epi64(x,  9)), _mm_set1_epi64x(0xaa00aa00aa00aa00LL));
+		x = _mm_xor_si128(x, _mm_xor_si128(t, _mm_srli_epi64(t,  9)));
+	}
+	return x;
+}
+
+// gather the bytes of 16 addresses to 8 vectors of 2 words
+static inline void gather_planes_sse2(__m128i* q, uint8* src[8], int i)
+{
+	__m128i v[8], w[8], d[8];
+	for(int k = 0; k < 8; k++) {
+		v[k] = src[k] ? _mm_loadu_si128((__m128i*)(src[k] + i)) : _mm_setzero_si128();
+	}
+	for(int k = 0; k < 8; k += 2) {
+		w[k    ] = _mm_unpacklo_epi8(v[k], v[k + 1]);
+		w[k + 1] = _mm_unpackhi_epi8(v[k], v[k + 1]);
+	}
+	for(int k = 0; k < 8; k += 4) {
+		d[k    ] = _mm_unpacklo_epi16(w[k    ], w[k + 2]);
+		d[k + 1] = _mm_unpackhi_epi16(w[k    ], w[k + 2]);
+		d[k + 2] = _mm_unpacklo_epi16(w[k + 1], w[k + 3]);
+		d[k + 3] = _mm_unpackhi_epi16(w[k + 1], w[k + 3]);
+	}
+	for(int k = 0; k < 4; k++) {
+		q[k * 2    ] = _mm_unpacklo_epi32(d[k], d[k + 4]);
+		q[k * 2 + 1] = _mm_unpackhi_epi32(d[k], d[k + 4]);
+	}
+}
+#endif
+
+#if defined(SIMD_USE_AVX2)
+static inline __m256i flip_planes_avx2(__m256i x, bool lsb_first)
+{
+	__m256i t;
+	if(lsb_first) {
+		t = _mm256_and_si256(_mm256_xor_si256(x, _mm256_slli_epi64(x, 28)), _mm256_set1_epi64x(0x0f0f0f0f00000000LL));
+		x = _mm256_xor_si256(x, _mm256_xor_si256(t, _mm256_srli_epi64(t, 28)));
+		t = _mm256_and_si256(_mm256_xor_si256(x, _mm256_slli_epi64(x, 14)), _mm256_set1_epi64x(0x3333000033330000LL));
+		x = _mm256_xor_si256(x, _mm256_xor_si256(t, _mm256_srli_epi64(t, 14)));
+		t = _mm256_and_si256(_mm256_xor_si256(x, _mm256_slli_epi64(x,  7)), _mm256_set1_epi64x(0x5500550055005500LL));
+		x = _mm256_xor_si256(x, _mm256_xor_si256(t, _mm256_srli_epi64(t,  7)));
+	}
+	else {
+		t = _mm256_xor_si256(x, _mm256_slli_epi64(x, 36));
+		x = _mm256_xor_si256(x, _mm256_and_si256(_mm256_xor_si256(t, _mm256_srli_epi64(x, 36)), _mm256_set1_epi64x(0xf0f0f0f00f0f0f0fLL)));
+		t = _mm256_and_si256(_mm256_xor_si256(x, _mm256_slli_epi64(x, 18)), _mm256_set1_epi64x(0xcccc0000cccc0000LL));
+		x = _mm256_xor_si256(x, _mm256_xor_si256(t, _mm256_srli_epi64(t, 18)));
+		t = _mm256_and_si256(_mm256_xor_si256(x, _mm256_slli_epi64(x,  9)), _mm256_set1_epi64x(0xaa00aa00aa00aa00LL));
+		x = _mm256_xor_si256(x, _mm256_xor_si256(t, _mm256_srli_epi64(t,  9)));
+	}
+	return x;
+}
+#endif
+
+static uint8 planar_table[2][256][8];
+
+static bool initialize_planar_table()
+{
+	for(int d = 0; d < 256; d++) {
+		for(int x = 0; x < 8; x++) {
+			planar_table[0][d][x] = (d >> (7 - x)) & 1;
+			planar_table[1][d][x] = (d >> x) & 1;
+		}
+	}
+	return true;
+}
+
+static bool planar_initialized = initialize_planar_table();
+
+void planar_to_chunky(uint8* dst, uint8* plane[], int plane_num, int count, bool lsb_first)
+{
+	// the planes not given (or NULL) are zero
+	uint8* src[8];
+	for(int k = 0; k < 8; k++) {
+		src[lsb_first ? k : 7 - k] = (k < plane_num) ? plane[k] : NULL;
+	}
+	int i = 0;
+	
+#if defined(SIMD_USE_SSE2)
+	for(; i + 16 <= count; i += 16) {
+		__m128i q[8];
+		gather_planes_sse2(q, src, i);
+#if defined(SIMD_USE_AVX2)
+		for(int k = 0; k < 8; k += 2) {
+			__m256i x = _mm256_inserti128_si256(_mm256_castsi128_si256(q[k]), q[k + 1], 1);
+			_mm256_storeu_si256((__m256i*)(dst + (i + k * 2) * 8), flip_planes_avx2(x, lsb_first));
+		}
+#else
+		for(int k = 0; k < 8; k++) {
+			_mm_storeu_si128((__m128i*)(dst + (i + k * 2) * 8), flip_planes_sse2(q[k], lsb_first));
+		}
+#endif
+	}
+#endif
+	if(i < count) {
+		uint8 (*pixels)[8] = planar_table[lsb_first ? 1 : 0];
+		
+		for(; i < count; i++) {
+			uint64 x = 0, t;
+			for(int k = 0; k < plane_num && k < 8; k++) {
+				if(plane[k]) {
+					memcpy(&t, pixels[plane[k][i]], 8);
+					x |= t << k;
+				}
+			}
+			memcpy(dst + i * 8, &x, 8);
+		}
+	}
+}
+
 void cur_time_t::increment()
 {
 	if(++second >= 60) {
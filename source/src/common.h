@@ -10,7 +10,49 @@
 #ifndef _COMMON_H_
 #define _COMMON_H_
 
+#ifdef _WIN32
 #include <tchar.h>
+#else
+// generic-text mappings for non-windows hosts (ansi only)
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdarg.h>
+#include <math.h>
+typedef char _TCHAR;
+#define _T(x)		x
+#define _MAX_PATH	260
+#define _tcslen		strlen
+#define _tcscpy		strcpy
+#define _tcsncpy	strncpy
+#define _tcsncat	strncat
+#define _tcscmp		strcmp
+#define _tcsicmp	strcasecmp
+#define _tcsncicmp	strncasecmp
+#define _stprintf	sprintf
+#define _vstprintf	vsprintf
+#define _ftprintf	fprintf
+#define _tfopen		fopen
+
+// integer types of windows used by the mame cores
+typedef signed char INT8;
+typedef signed short INT16;
+typedef signed int INT32;
+typedef signed long long INT64;
+typedef unsigned char UINT8;
+typedef unsigned short UINT16;
+typedef unsigned int UINT32;
+typedef unsigned long long UINT64;
+
+// min and max macros of windows.h, defined after the c++ library headers
+#ifndef max
+#define max(a, b)	(((a) > (b)) ? (a) : (b))
+#endif
+#ifndef min
+#define min(a, b)	(((a) < (b)) ? (a) : (b))
+#endif
+#endif
 
 // variable scope of 'for' loop for microsoft visual c++ 6.0 and embedded visual c++ 4.0
 #if defined(_MSC_VER) && (_MSC_VER == 1200)
@@ -24,6 +66,30 @@
 #pragma warning( disable : 4996 )
 #endif
 
+// optimization hint of microsoft visual c++
+#if !defined(_MSC_VER)
+#if defined(__GNUC__)
+#define __assume(cond) do { if(!(cond)) __builtin_unreachable(); } while(0)
+#else
+#define __assume(cond)
+#endif
+#endif
+
+// simd instruction sets enabled by the compiler options
+#if defined(__AVX2__)
+#define SIMD_USE_AVX2
+#define SIMD_USE_SSE2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define SIMD_USE_SSE2
+#endif
+
+// thread local storage
+#if defined(_MSC_VER)
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL __thread
+#endif
+
 // type definition
 #ifndef uint8
 typedef unsigned char uint8;
@@ -109,6 +175,13 @@ typedef uint32 scrntype;
 bool check_file_extension(_TCHAR* filename, _TCHAR* ext);
 uint32 getcrc32(uint8 data[], int size);
 
+// sound buffer
+void lowpass_sound(int32* buffer, int samples);
+void saturate_sound(uint16* dst, int32* src, int samples);
+
+// bitplanes
+void planar_to_chunky(uint8* dst, uint8* plane[], int plane_num, int count, bool lsb_first);
+
 #define FROM_BCD(v)	(((v) & 0x0f) + (((v) >> 4) & 0x0f) * 10)
 #define TO_BCD(v)	((int)(((v) % 100) / 10) << 4) | ((v) % 10)
 #define TO_BCD_LO(v)	((v) % 10)
@@ -11,7 +11,8 @@
 #include "config.h"
 #include "fileio.h"
 
-config_t config;
+config_t global_config;
+THREAD_LOCAL config_t* thread_config = &global_config;
 
 void init_config()
 {
@@ -48,12 +49,16 @@ void load_config()
 	
 	// get application path
 	_TCHAR app_path[_MAX_PATH], config_path[_MAX_PATH];
+#ifdef _WIN32
 	GetModuleFileName(NULL, app_path, _MAX_PATH);
 	int pt = _tcslen(app_path);
 	while(pt >= 0 && app_path[pt] != _T('\\')) {
 		pt--;
 	}
 	app_path[pt + 1] = _T('\0');
+#else
+	app_path[0] = _T('\0');	// current directory
+#endif
 	
 	// load config
 	_stprintf(config_path, _T("%s%s.cfg"), app_path, _T(CONFIG_NAME));
@@ -80,12 +85,16 @@ void save_config()
 {
 	// get config path
 	_TCHAR app_path[_MAX_PATH], config_path[_MAX_PATH];
+#ifdef _WIN32
 	GetModuleFileName(NULL, app_path, _MAX_PATH);
 	int pt = _tcslen(app_path);
 	while(pt >= 0 && app_path[pt] != _T('\\')) {
 		pt--;
 	}
 	app_path[pt + 1] = _T('\0');
+#else
+	app_path[0] = _T('\0');	// current directory
+#endif
 	_stprintf(config_path, _T("%s%s.cfg"), app_path, _T(CONFIG_NAME));
 	
 	// save config
@@ -10,10 +10,10 @@
 #ifndef _CONFIG_H_
 #define _CONFIG_H_
 
-#include <tchar.h>
+#include "common.h"
 #include "vm/vm.h"
 
-#define FILE_VERSION	0x33
+#define FILE_VERSION	0x36
 
 void init_config();
 void load_config();
@@ -63,8 +63,13 @@ typedef struct {
 	
 	// virtual machine
 	int cpu_power;
+	int cpu_quantum;	// clocks the primary cpu runs ahead of sub cpus, 0 = default
 #ifdef USE_FD1
 	bool ignore_crc;
+	bool fast_disk;
+#endif
+#ifdef USE_DATAREC
+	bool fast_tape;
 #endif
 #ifdef USE_DIPSWITCH
 	uint8 dipswitch;
@@ -75,7 +80,7 @@ typedef struct {
 #ifdef USE_CPU_CLOCK_LOW
 	bool cpu_clock_low;	// PC-8801MA, PC-9801E, PC-9801VM, PC-98DO
 #endif
-#if defined(_HC80) || defined(_PASOPIA) || defined(_PC8001SR) || defined(_PC8801MA)
+#if defined(_HC80) || defined(_PASOPIA) || defined(_PC8001SR) || defined(_PC8801MA) || defined(_FC100)
 	int device_type;
 #endif
 #if defined(USE_MONITOR_TYPE) || defined(USE_SCREEN_ROTATE)
@@ -89,7 +94,12 @@ typedef struct {
 #endif
 } config_t;
 
-extern config_t config;
+extern config_t global_config;
+
+// the settings of the vm running on this thread
+// each emu instance binds its own copy, otherwise this is global_config
+extern THREAD_LOCAL config_t* thread_config;
+#define config (*thread_config)
 
 #endif
 
@@ -181,7 +181,6 @@ void EMU::notify_power_off()
 
 _TCHAR* EMU::bios_path(_TCHAR* file_name)
 {
-	static _TCHAR file_path[_MAX_PATH];
 	_stprintf(file_path, _T("%s%s"), app_path, file_name);
 	return file_path;
 }
@@ -30,6 +30,11 @@
 //	#define _IO_DEBUG_LOG
 #endif
 
+#ifdef _HEADLESS
+// windowless emulation i/f for batch hosts
+#include "headless_emu.h"
+#else
+
 #include <windows.h>
 #include <windowsx.h>
 #include <mmsystem.h>
@@ -123,6 +128,12 @@ private:
 	void initialize_screen();
 	void release_screen();
 	void create_dib_section(HDC hdc, int width, int height, HDC *hdcDib, HBITMAP *hBmp, HBITMAP *hOldBmp, LPBYTE *lpBuf, scrntype **lpBmp, LPBITMAPINFO *lpDib);
+	void create_frame_buffers();
+	void release_frame_buffers();
+	void copy_to_dib_section(scrntype* frame);
+	void present_screen(scrntype* frame);
+	void present_loop();
+	static unsigned __stdcall present_thread(void* param);
 	
 	HWND main_window_handle;
 	HINSTANCE instance_handle;
@@ -186,7 +197,6 @@ private:
 	LPDIRECT3DSURFACE9 lpd3d9Surface;
 	LPDIRECT3DSURFACE9 lpd3d9OffscreenSurface;
 	scrntype *lpd3d9Buffer;
-	bool render_to_d3d9Buffer;
 	bool use_d3d9;
 	bool wait_vsync;
 	
@@ -198,6 +208,16 @@ private:
 	PAVISTREAM pAVICompressed;
 	AVICOMPRESSOPTIONS opts;
 	
+	// frame buffers passed from the vm thread to the presenter thread
+	scrntype* vm_screen;	// top-down, the vm draws here
+	scrntype* frame_buffer[3];
+	int draw_frame, present_frame;
+	volatile LONG ready_frame;
+	int frames_produced, frames_presented, frames_dropped;
+	CRITICAL_SECTION screen_lock;	// dib sections and d3d9 surfaces
+	HANDLE hPresentThread, hPresentEvent;
+	volatile bool present_exit;
+	
 	// ----------------------------------------
 	// sound
 	// ----------------------------------------
@@ -279,6 +299,7 @@ private:
 	bool cpu_clock_low;
 #endif
 	_TCHAR app_path[_MAX_PATH];
+	_TCHAR file_path[_MAX_PATH];
 	
 public:
 	// ----------------------------------------
@@ -383,6 +404,15 @@ public:
 	void set_display_size(int width, int height, bool window_mode);
 	void draw_screen();
 	void update_screen(HDC hdc);
+	int get_frames_produced() {
+		return frames_produced;
+	}
+	int get_frames_presented() {
+		return frames_presented;
+	}
+	int get_frames_dropped() {
+		return frames_dropped;
+	}
 #ifdef USE_BITMAP
 	void reload_bitmap() {
 		first_invalidate = true;
@@ -444,4 +474,5 @@ public:
 	void out_debug(const _TCHAR* format, ...);
 };
 
+#endif	// _HEADLESS
 #endif
@@ -11,6 +11,7 @@
 #define _FIFO_H_
 
 #include "common.h"
+#include "fileio.h"
 
 class FIFO
 {
@@ -68,6 +69,24 @@ public:
 	bool empty() {
 		return (cnt == 0);
 	}
+	void save_state(FILEIO* fio) {
+		// only the stored data is saved
+		fio->FputInt32(cnt);
+		for(int i = 0; i < cnt; i++) {
+			fio->FputInt32(read_not_remove(i));
+		}
+	}
+	bool load_state(FILEIO* fio) {
+		clear();
+		int tmp = fio->FgetInt32();
+		if(tmp < 0 || tmp > size) {
+			return false;
+		}
+		for(int i = 0; i < tmp; i++) {
+			write(fio->FgetInt32());
+		}
+		return true;
+	}
 };
 
 #endif
@@ -8,10 +8,18 @@
 */
 
 #include "fileio.h"
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#define MEMORY_STREAM_ALLOC	0x10000
 
 FILEIO::FILEIO()
 {
 	fp = NULL;
+	mem = NULL;
+	mem_size = mem_pos = mem_alloc = 0;
+	mem_owned = mem_write = false;
 }
 
 FILEIO::~FILEIO(void)
@@ -21,7 +29,11 @@ FILEIO::~FILEIO(void)
 
 bool FILEIO::IsProtected(_TCHAR *filename)
 {
+#ifdef _WIN32
 	return ((GetFileAttributes(filename) & FILE_ATTRIBUTE_READONLY) != 0);
+#else
+	return (access(filename, W_OK) != 0);
+#endif
 }
 
 bool FILEIO::Fopen(_TCHAR *filename, int mode)
@@ -45,36 +57,269 @@ bool FILEIO::Fopen(_TCHAR *filename, int mode)
 	return false;
 }
 
+bool FILEIO::Mopen(void* buffer, uint32 size, int mode)
+{
+	// open the memory stream
+	// when buffer is NULL in the write mode, the buffer is allocated and expanded by this class
+	Fclose();
+	
+	switch(mode) {
+	case FILEIO_READ_BINARY:
+	case FILEIO_READ_ASCII:
+		if(buffer == NULL) {
+			return false;
+		}
+		mem = (uint8*)buffer;
+		mem_size = mem_alloc = size;
+		mem_write = false;
+		break;
+	case FILEIO_WRITE_BINARY:
+	case FILEIO_WRITE_ASCII:
+		if(buffer == NULL) {
+			mem_alloc = (size != 0) ? size : MEMORY_STREAM_ALLOC;
+			mem = (uint8*)malloc(mem_alloc);
+			mem_owned = true;
+		}
+		else {
+			mem = (uint8*)buffer;
+			mem_alloc = size;
+		}
+		mem_size = 0;
+		mem_write = true;
+		break;
+	default:
+		return false;
+	}
+	mem_pos = 0;
+	return (mem != NULL);
+}
+
 void FILEIO::Fclose()
 {
 	if(fp) {
 		fclose(fp);
 	}
 	fp = NULL;
+	
+	if(mem_owned) {
+		free(mem);
+	}
+	mem = NULL;
+	mem_owned = false;
+}
+
+// the memory stream is accessed directly, the state is saved at every frame to rewind
+#define GET_VALUE(type) \
+	type val = 0; \
+	if(mem && mem_pos + sizeof(type) <= mem_size) { \
+		memcpy(&val, mem + mem_pos, sizeof(type)); \
+		mem_pos += sizeof(type); \
+		return val; \
+	} \
+	Fread(&val, sizeof(type), 1); \
+	return val
+
+#define PUT_VALUE(type, val) \
+	if(mem && mem_write && mem_pos + sizeof(type) <= mem_alloc) { \
+		memcpy(mem + mem_pos, &val, sizeof(type)); \
+		mem_pos += sizeof(type); \
+		if(mem_size < mem_pos) { \
+			mem_size = mem_pos; \
+		} \
+		return; \
+	} \
+	Fwrite(&val, sizeof(type), 1)
+
+bool FILEIO::FgetBool()
+{
+	GET_VALUE(bool);
+}
+
+void FILEIO::FputBool(bool val)
+{
+	PUT_VALUE(bool, val);
+}
+
+uint8 FILEIO::FgetUint8()
+{
+	GET_VALUE(uint8);
+}
+
+void FILEIO::FputUint8(uint8 val)
+{
+	PUT_VALUE(uint8, val);
+}
+
+uint16 FILEIO::FgetUint16()
+{
+	GET_VALUE(uint16);
+}
+
+void FILEIO::FputUint16(uint16 val)
+{
+	PUT_VALUE(uint16, val);
+}
+
+uint32 FILEIO::FgetUint32()
+{
+	GET_VALUE(uint32);
+}
+
+void FILEIO::FputUint32(uint32 val)
+{
+	PUT_VALUE(uint32, val);
+}
+
+uint64 FILEIO::FgetUint64()
+{
+	GET_VALUE(uint64);
+}
+
+void FILEIO::FputUint64(uint64 val)
+{
+	PUT_VALUE(uint64, val);
+}
+
+int8 FILEIO::FgetInt8()
+{
+	GET_VALUE(int8);
+}
+
+void FILEIO::FputInt8(int8 val)
+{
+	PUT_VALUE(int8, val);
+}
+
+int16 FILEIO::FgetInt16()
+{
+	GET_VALUE(int16);
+}
+
+void FILEIO::FputInt16(int16 val)
+{
+	PUT_VALUE(int16, val);
+}
+
+int32 FILEIO::FgetInt32()
+{
+	GET_VALUE(int32);
+}
+
+void FILEIO::FputInt32(int32 val)
+{
+	PUT_VALUE(int32, val);
+}
+
+int64 FILEIO::FgetInt64()
+{
+	GET_VALUE(int64);
+}
+
+void FILEIO::FputInt64(int64 val)
+{
+	PUT_VALUE(int64, val);
+}
+
+double FILEIO::FgetDouble()
+{
+	GET_VALUE(double);
+}
+
+void FILEIO::FputDouble(double val)
+{
+	PUT_VALUE(double, val);
 }
 
 int FILEIO::Fgetc()
 {
+	if(mem) {
+		return (mem_pos < mem_size) ? mem[mem_pos++] : EOF;
+	}
 	return fgetc(fp);
 }
 
 int FILEIO::Fputc(int c)
 {
+	if(mem) {
+		uint8 data = (uint8)c;
+		return (Fwrite(&data, 1, 1) == 1) ? (c & 0xff) : EOF;
+	}
 	return fputc(c, fp);
 }
 
 uint32 FILEIO::Fread(void* buffer, uint32 size, uint32 count)
 {
+	if(mem) {
+		uint32 remain = mem_size - mem_pos;
+		if(size == 0 || remain < size * count) {
+			count = (size != 0) ? remain / size : 0;
+		}
+		memcpy(buffer, mem + mem_pos, size * count);
+		mem_pos += size * count;
+		return count;
+	}
 	return fread(buffer, size, count, fp);
 }
 
 uint32 FILEIO::Fwrite(void* buffer, uint32 size, uint32 count)
 {
+	if(mem) {
+		uint32 length = size * count;
+		if(!mem_write) {
+			return 0;
+		}
+		if(mem_pos + length > mem_alloc) {
+			if(!mem_owned) {
+				count = (size != 0) ? (mem_alloc - mem_pos) / size : 0;
+				length = size * count;
+			}
+			else {
+				// expand the buffer
+				uint32 new_alloc = mem_alloc;
+				while(mem_pos + length > new_alloc) {
+					new_alloc *= 2;
+				}
+				uint8* new_mem = (uint8*)realloc(mem, new_alloc);
+				if(new_mem == NULL) {
+					return 0;
+				}
+				mem = new_mem;
+				mem_alloc = new_alloc;
+			}
+		}
+		memcpy(mem + mem_pos, buffer, length);
+		mem_pos += length;
+		if(mem_size < mem_pos) {
+			mem_size = mem_pos;
+		}
+		return count;
+	}
 	return fwrite(buffer, size, count, fp);
 }
 
 uint32 FILEIO::Fseek(long offset, int origin)
 {
+	if(mem) {
+		long pos;
+		switch(origin) {
+		case FILEIO_SEEK_CUR:
+			pos = (long)mem_pos + offset;
+			break;
+		case FILEIO_SEEK_END:
+			pos = (long)mem_size + offset;
+			break;
+		case FILEIO_SEEK_SET:
+			pos = offset;
+			break;
+		default:
+			return 0xFFFFFFFF;
+		}
+		if(pos < 0 || pos > (long)mem_size) {
+			return 0xFFFFFFFF;
+		}
+		mem_pos = (uint32)pos;
+		return 0;
+	}
 	switch(origin) {
 	case FILEIO_SEEK_CUR:
 		return fseek(fp, offset, SEEK_CUR);
@@ -88,11 +333,18 @@ uint32 FILEIO::Fseek(long offset, int origin)
 
 uint32 FILEIO::Ftell()
 {
+	if(mem) {
+		return mem_pos;
+	}
 	return ftell(fp);
 }
 
 void FILEIO::Remove(_TCHAR *filename)
 {
+#ifdef _WIN32
 	DeleteFile(filename);
 //	_tremove(filename);	// not supported on wince
+#else
+	remove(filename);
+#endif
 }
@@ -10,7 +10,9 @@
 #ifndef _FILEIO_H_
 #define _FILEIO_H_
 
+#ifdef _WIN32
 #include <windows.h>
+#endif
 #include <stdio.h>
 #include "common.h"
 
@@ -29,13 +31,43 @@ class FILEIO
 private:
 	FILE* fp;
 	
+	// memory stream
+	uint8* mem;
+	uint32 mem_size, mem_pos, mem_alloc;
+	bool mem_owned, mem_write;
+	
 public:
 	FILEIO();
 	~FILEIO();
 	bool IsProtected(_TCHAR *filename);
 	bool Fopen(_TCHAR *filename, int mode);
+	bool Mopen(void* buffer, uint32 size, int mode);
 	void Fclose();
-	bool IsOpened() { return (fp != NULL); }
+	bool IsOpened() { return (fp != NULL || mem != NULL); }
+	void* GetBuffer() { return mem; }
+	uint32 GetLength() { return mem_size; }
+	
+	bool FgetBool();
+	void FputBool(bool val);
+	uint8 FgetUint8();
+	void FputUint8(uint8 val);
+	uint16 FgetUint16();
+	void FputUint16(uint16 val);
+	uint32 FgetUint32();
+	void FputUint32(uint32 val);
+	uint64 FgetUint64();
+	void FputUint64(uint64 val);
+	int8 FgetInt8();
+	void FputInt8(int8 val);
+	int16 FgetInt16();
+	void FputInt16(int16 val);
+	int32 FgetInt32();
+	void FputInt32(int32 val);
+	int64 FgetInt64();
+	void FputInt64(int64 val);
+	double FgetDouble();
+	void FputDouble(double val);
+	
 	int Fgetc();
 	int Fputc(int c);
 	uint32 Fread(void* buffer, uint32 size, uint32 count);
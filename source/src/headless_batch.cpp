@@ -0,0 +1,296 @@
+/*
+	Skelton for retropc emulator
+
+	Author : Takeda.Toshiya
+	Date   : 2013.03.01-
+
+	[ headless batch runner ]
+*/
+
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include "config.h"
+#include "emu.h"
+#include "fileio.h"
+
+#define MAX_KEY_EVENTS	256
+#define MAX_THREADS	64
+
+typedef struct {
+	int frame;
+	int code;
+} key_event_t;
+
+// one job drives one vm instance from power on to the last frame
+typedef struct {
+	int frames;
+	uint32 crc;
+	int thread;
+	double sec;
+} job_t;
+
+// jobs of a worker thread: the owner takes them from the tail,
+// and the idle workers steal them from the head
+typedef struct {
+	pthread_mutex_t lock;
+	int* jobs;
+	int head, tail;
+} job_queue_t;
+
+typedef struct {
+	int index;
+	int stolen;
+} worker_t;
+
+// settings shared by all jobs, never written after the workers start
+static const _TCHAR* bios_dir = _T(".");
+#ifdef USE_DATAREC
+static _TCHAR* tape_path = NULL;
+#endif
+#ifdef USE_STATE
+static _TCHAR* load_path = NULL;
+#endif
+static int max_frames = 600, draw_interval = 0;
+static int cpu_quantum = 0;
+static bool enable_sound = false;
+static key_event_t key_events[MAX_KEY_EVENTS];
+static int key_event_count = 0;
+
+static job_t* jobs;
+static job_queue_t queues[MAX_THREADS];
+static worker_t workers[MAX_THREADS];
+static int thread_num;
+
+static double get_host_sec()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec / 1000000000.0;
+}
+
+static int pop_job(int index)
+{
+	job_queue_t* q = &queues[index];
+	int job = -1;
+	pthread_mutex_lock(&q->lock);
+	if(q->head < q->tail) {
+		job = q->jobs[--q->tail];
+	}
+	pthread_mutex_unlock(&q->lock);
+	return job;
+}
+
+static int steal_job(int index)
+{
+	for(int i = 1; i < thread_num; i++) {
+		job_queue_t* q = &queues[(index + i) % thread_num];
+		int job = -1;
+		pthread_mutex_lock(&q->lock);
+		if(q->head < q->tail) {
+			job = q->jobs[q->head++];
+		}
+		pthread_mutex_unlock(&q->lock);
+		if(job >= 0) {
+			return job;
+		}
+	}
+	return -1;
+}
+
+static void run_job(job_t* job, int thread)
+{
+	double start_time = get_host_sec();
+	
+	// the instance binds its own copy of the settings to this thread
+	EMU* emu = new EMU(bios_dir, enable_sound);
+#ifdef USE_DATAREC
+	if(tape_path != NULL) {
+		emu->play_datarec(tape_path);
+	}
+#endif
+#ifdef USE_STATE
+	if(load_path != NULL && !emu->load_state(load_path)) {
+		fprintf(stderr, "cannot load %s\n", load_path);
+	}
+#endif
+	bool pressed[MAX_KEY_EVENTS] = {0};
+	int total_frames = 0;
+	
+	while(total_frames < max_frames && !emu->now_power_off_requested()) {
+		for(int i = 0; i < key_event_count; i++) {
+			if(!pressed[i] && key_events[i].frame <= total_frames) {
+				emu->press_key(key_events[i].code, 0);
+				pressed[i] = true;
+			}
+		}
+		total_frames += emu->run();
+		if(draw_interval > 0 && (total_frames % draw_interval) == 0) {
+			emu->draw_screen();
+		}
+	}
+	emu->draw_screen();
+	int size = emu->get_screen_width() * emu->get_screen_height() * sizeof(scrntype);
+	job->crc = getcrc32((uint8*)emu->get_screen(), size);
+	job->frames = total_frames;
+	delete emu;
+	
+	job->thread = thread;
+	job->sec = get_host_sec() - start_time;
+}
+
+static void* worker_thread(void* arg)
+{
+	worker_t* w = (worker_t*)arg;
+	for(;;) {
+		int job = pop_job(w->index);
+		if(job < 0) {
+			// no job is added after the start, so all queues are empty when stealing fails
+			if((job = steal_job(w->index)) < 0) {
+				break;
+			}
+			w->stolen++;
+		}
+		run_job(&jobs[job], w->index);
+	}
+	return NULL;
+}
+
+static void usage(const char* name)
+{
+	fprintf(stderr, "usage: %s [options]\n", name);
+	fprintf(stderr, "  -bios <dir>          directory of rom images (default: current directory)\n");
+	fprintf(stderr, "  -instances <n>       number of vm instances to run (default: 8)\n");
+	fprintf(stderr, "  -threads <n>         number of worker threads (default: number of cores)\n");
+	fprintf(stderr, "  -frames <n>          number of frames to run each instance (default: 600)\n");
+	fprintf(stderr, "  -draw <n>            draw screen every n frames, 0 = only the last (default: 0)\n");
+	fprintf(stderr, "  -sound               mix sound\n");
+	fprintf(stderr, "  -key <frame>:<code>  press the virtual key code at the frame in all instances\n");
+	fprintf(stderr, "  -quantum <n>         clocks the primary cpu runs ahead of sub cpus, 0 = default, 4 = lockstep\n");
+#ifdef USE_DATAREC
+	fprintf(stderr, "  -tape <file>         play the tape image in all instances\n");
+#endif
+#ifdef USE_STATE
+	fprintf(stderr, "  -load <file>         load the state file before running\n");
+#endif
+}
+
+int main(int argc, char* argv[])
+{
+	int instance_num = 8;
+	thread_num = (int)sysconf(_SC_NPROCESSORS_ONLN);
+	
+	for(int i = 1; i < argc; i++) {
+		bool has_value = (i + 1 < argc);
+		if(strcmp(argv[i], "-bios") == 0 && has_value) {
+			bios_dir = argv[++i];
+		}
+		else if(strcmp(argv[i], "-instances") == 0 && has_value) {
+			instance_num = atoi(argv[++i]);
+		}
+		else if(strcmp(argv[i], "-threads") == 0 && has_value) {
+			thread_num = atoi(argv[++i]);
+		}
+		else if(strcmp(argv[i], "-frames") == 0 && has_value) {
+			max_frames = atoi(argv[++i]);
+		}
+		else if(strcmp(argv[i], "-quantum") == 0 && has_value) {
+			cpu_quantum = atoi(argv[++i]);
+		}
+		else if(strcmp(argv[i], "-draw") == 0 && has_value) {
+			draw_interval = atoi(argv[++i]);
+		}
+		else if(strcmp(argv[i], "-sound") == 0) {
+			enable_sound = true;
+		}
+		else if(strcmp(argv[i], "-key") == 0 && has_value && key_event_count < MAX_KEY_EVENTS) {
+			key_event_t* e = &key_events[key_event_count];
+			if(sscanf(argv[++i], "%d:%i", &e->frame, &e->code) == 2) {
+				key_event_count++;
+			}
+		}
+#ifdef USE_DATAREC
+		else if(strcmp(argv[i], "-tape") == 0 && has_value) {
+			tape_path = argv[++i];
+		}
+#endif
+#ifdef USE_STATE
+		else if(strcmp(argv[i], "-load") == 0 && has_value) {
+			load_path = argv[++i];
+		}
+#endif
+		else {
+			usage(argv[0]);
+			return 1;
+		}
+	}
+	if(instance_num < 1) {
+		instance_num = 1;
+	}
+	if(thread_num < 1) {
+		thread_num = 1;
+	}
+	else if(thread_num > MAX_THREADS) {
+		thread_num = MAX_THREADS;
+	}
+	if(thread_num > instance_num) {
+		thread_num = instance_num;
+	}
+	
+	// the default settings are copied by each instance
+	init_config();
+	config.cpu_quantum = cpu_quantum;
+	
+	// deal the jobs to the worker queues in turn
+	jobs = (job_t*)calloc(instance_num, sizeof(job_t));
+	for(int i = 0; i < thread_num; i++) {
+		pthread_mutex_init(&queues[i].lock, NULL);
+		queues[i].jobs = (int*)malloc(sizeof(int) * (instance_num / thread_num + 1));
+		queues[i].head = queues[i].tail = 0;
+		workers[i].index = i;
+		workers[i].stolen = 0;
+	}
+	for(int i = 0; i < instance_num; i++) {
+		job_queue_t* q = &queues[i % thread_num];
+		q->jobs[q->tail++] = i;
+	}
+	
+	double start_time = get_host_sec();
+	pthread_t threads[MAX_THREADS];
+	for(int i = 1; i < thread_num; i++) {
+		pthread_create(&threads[i], NULL, worker_thread, &workers[i]);
+	}
+	worker_thread(&workers[0]);
+	for(int i = 1; i < thread_num; i++) {
+		pthread_join(threads[i], NULL);
+	}
+	double passed_sec = get_host_sec() - start_time;
+	
+	// all instances are driven by the same inputs, so their screens must match
+	int total_frames = 0, stolen = 0, mismatch = 0;
+	for(int i = 0; i < instance_num; i++) {
+		printf("instance %d: %d frames, crc32 %08x (thread %d, %.3f sec)\n", i, jobs[i].frames, jobs[i].crc, jobs[i].thread, jobs[i].sec);
+		total_frames += jobs[i].frames;
+		if(jobs[i].crc != jobs[0].crc) {
+			mismatch++;
+		}
+	}
+	for(int i = 0; i < thread_num; i++) {
+		stolen += workers[i].stolen;
+		pthread_mutex_destroy(&queues[i].lock);
+		free(queues[i].jobs);
+	}
+	double fps = (passed_sec > 0) ? (double)total_frames / passed_sec : 0;
+	printf("%s\n", DEVICE_NAME);
+	printf("instances: %d, threads: %d, stolen jobs: %d\n", instance_num, thread_num, stolen);
+	printf("time: %.3f sec\n", passed_sec);
+	printf("speed: %.1f fps in total (%.1f fps per instance)\n", fps, fps / instance_num);
+	if(mismatch == 0) {
+		printf("screen crc32: %08x\n", jobs[0].crc);
+	}
+	else {
+		printf("screen crc32: %d instances differ from %08x\n", mismatch, jobs[0].crc);
+	}
+	free(jobs);
+	return (mismatch == 0) ? 0 : 1;
+}
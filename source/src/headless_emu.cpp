@@ -0,0 +1,477 @@
+/*
+	Skelton for retropc emulator
+
+	Author : Takeda.Toshiya
+	Date   : 2013.03.01-
+
+	[ headless emulation i/f ]
+*/
+
+#include <time.h>
+#include "emu.h"
+#include "vm/vm.h"
+#include "fileio.h"
+
+#include "config.h"
+
+#define KEY_KEEP_FRAMES 3
+
+// ----------------------------------------------------------------------------
+// initialize
+// ----------------------------------------------------------------------------
+
+EMU::EMU(const _TCHAR* bios_dir, bool enable_sound)
+{
+	// store bios path
+	_tcsncpy(app_path, bios_dir, _MAX_PATH - 2);
+	app_path[_MAX_PATH - 2] = _T('\0');
+	int pt = _tcslen(app_path);
+	if(pt > 0 && app_path[pt - 1] != _T('/')) {
+		app_path[pt] = _T('/');
+		app_path[pt + 1] = _T('\0');
+	}
+	
+	// take a private copy of the settings so that several instances can run
+	// on separate threads without sharing the global config
+	instance_config = config;
+	prev_config = thread_config;
+	thread_config = &instance_config;
+	
+	// load sound config
+#ifdef SUPPORT_SOUND_FREQ_55467HZ
+	// PC-8801/9801 series
+	static int freq_table[8] = {2000, 4000, 8000, 11025, 22050, 44100, 55467, 96000};
+#else
+	static int freq_table[8] = {2000, 4000, 8000, 11025, 22050, 44100, 48000, 96000};
+#endif
+	static double late_table[5] = {0.05, 0.1, 0.2, 0.3, 0.4};
+	
+	if(!(0 <= config.sound_frequency && config.sound_frequency < 8)) {
+		config.sound_frequency = 6;	// default: 48KHz
+	}
+	if(!(0 <= config.sound_latency && config.sound_latency < 5)) {
+		config.sound_latency = 1;	// default: 100msec
+	}
+	sound_rate = freq_table[config.sound_frequency];
+	sound_samples = (int)(sound_rate * late_table[config.sound_latency] + 0.5);
+	sound_enabled = enable_sound;
+	sound_accum = 0;
+	now_rec_snd = false;
+	now_power_off = false;
+	
+	// initialize
+	vm = new VM(this);
+	initialize_input();
+	initialize_screen();
+	vm->initialize_sound(sound_rate, sound_samples);
+	vm->reset();
+}
+
+EMU::~EMU()
+{
+	stop_rec_sound();
+	delete vm;
+	release_screen();
+	thread_config = prev_config;
+}
+
+// ----------------------------------------------------------------------------
+// drive machine
+// ----------------------------------------------------------------------------
+
+double EMU::frame_rate()
+{
+#ifdef SUPPORT_VARIABLE_TIMING
+	return vm->frame_rate();
+#else
+	return FRAMES_PER_SEC;
+#endif
+}
+
+int EMU::run()
+{
+	update_input();
+	
+	// virtual machine may be driven to fill sound buffer
+	int extra_frames = 0;
+	update_sound(&extra_frames);
+	
+	// drive virtual machine
+	if(extra_frames == 0) {
+		vm->run();
+		extra_frames = 1;
+	}
+	sound_accum += (double)sound_rate / frame_rate() * extra_frames;
+	return extra_frames;
+}
+
+void EMU::reset()
+{
+	vm->reset();
+}
+
+#ifdef USE_SPECIAL_RESET
+void EMU::special_reset()
+{
+	vm->special_reset();
+}
+#endif
+
+_TCHAR* EMU::bios_path(_TCHAR* file_name)
+{
+	_stprintf(file_path, _T("%s%s"), app_path, file_name);
+	return file_path;
+}
+
+// ----------------------------------------------------------------------------
+// input
+// ----------------------------------------------------------------------------
+
+void EMU::initialize_input()
+{
+	// initialize status
+	memset(key_status, 0, sizeof(key_status));
+	memset(joy_status, 0, sizeof(joy_status));
+	memset(mouse_status, 0, sizeof(mouse_status));
+}
+
+void EMU::update_input()
+{
+	// release keys pressed for the limited frames
+	for(int i = 0; i < 256; i++) {
+		if(key_status[i] & 0x7f) {
+			key_status[i] = (key_status[i] & 0x80) | ((key_status[i] & 0x7f) - 1);
+#ifdef NOTIFY_KEY_DOWN
+			if(!key_status[i]) {
+				vm->key_up(i);
+			}
+#endif
+		}
+	}
+}
+
+void EMU::key_down(int code, bool repeat)
+{
+	key_status[code & 0xff] = 0x80;
+#ifdef NOTIFY_KEY_DOWN
+	vm->key_down(code & 0xff, repeat);
+#endif
+}
+
+void EMU::key_up(int code)
+{
+	if(key_status[code & 0xff]) {
+		key_status[code & 0xff] &= 0x7f;
+#ifdef NOTIFY_KEY_DOWN
+		if(!key_status[code & 0xff]) {
+			vm->key_up(code & 0xff);
+		}
+#endif
+	}
+}
+
+void EMU::press_key(int code, int frames)
+{
+	// the key is released automatically after the frames
+	if(frames < 1) {
+		frames = KEY_KEEP_FRAMES;
+	}
+	key_status[code & 0xff] = (frames < 0x7f) ? frames : 0x7f;
+#ifdef NOTIFY_KEY_DOWN
+	vm->key_down(code & 0xff, false);
+#endif
+}
+
+// ----------------------------------------------------------------------------
+// screen
+// ----------------------------------------------------------------------------
+
+void EMU::initialize_screen()
+{
+	screen_width = SCREEN_WIDTH;
+	screen_height = SCREEN_HEIGHT;
+	screen = (scrntype*)calloc(screen_width * screen_height, sizeof(scrntype));
+}
+
+void EMU::release_screen()
+{
+	if(screen) {
+		free(screen);
+	}
+	screen = NULL;
+}
+
+void EMU::change_screen_size(int sw, int sh, int swa, int sha, int ww, int wh)
+{
+	// virtual machine changes the screen size
+	if(screen_width != sw || screen_height != sh) {
+		release_screen();
+		screen_width = sw;
+		screen_height = sh;
+		screen = (scrntype*)calloc(screen_width * screen_height, sizeof(scrntype));
+	}
+}
+
+void EMU::draw_screen()
+{
+	vm->draw_screen();
+}
+
+// ----------------------------------------------------------------------------
+// sound
+// ----------------------------------------------------------------------------
+
+void EMU::update_sound(int* extra_frames)
+{
+	*extra_frames = 0;
+	
+	// sound buffer is pulled when emulated time fills it, not by the host clock
+	if(sound_enabled && sound_accum >= sound_samples) {
+		sound_accum -= sound_samples;
+		uint16* sound_buffer = vm->create_sound(extra_frames);
+		if(now_rec_snd && sound_buffer) {
+			// record sound
+			int length = sound_samples * sizeof(uint16) * 2; // stereo
+			rec->Fwrite(sound_buffer, length, 1);
+			rec_bytes += length;
+		}
+	}
+}
+
+bool EMU::start_rec_sound(_TCHAR* file_path)
+{
+	if(!now_rec_snd) {
+		rec = new FILEIO();
+		if(rec->Fopen(file_path, FILEIO_WRITE_BINARY)) {
+			// write dummy wave header
+			wavheader_t header;
+			memset(&header, 0, sizeof(wavheader_t));
+			rec->Fwrite(&header, sizeof(wavheader_t), 1);
+			rec_bytes = 0;
+			now_rec_snd = true;
+		}
+		else {
+			// failed to open the wave file
+			delete rec;
+		}
+	}
+	return now_rec_snd;
+}
+
+void EMU::stop_rec_sound()
+{
+	if(now_rec_snd) {
+		// update wave header
+		wavheader_t header;
+		header.dwRIFF = 0x46464952;
+		header.dwFileSize = rec_bytes + sizeof(wavheader_t) - 8;
+		header.dwWAVE = 0x45564157;
+		header.dwfmt_ = 0x20746d66;
+		header.dwFormatSize = 16;
+		header.wFormatTag = 1;
+		header.wChannels = 2;
+		header.wBitsPerSample = 16;
+		header.dwSamplesPerSec = sound_rate;
+		header.wBlockAlign = header.wChannels * header.wBitsPerSample / 8;
+		header.dwAvgBytesPerSec = header.dwSamplesPerSec * header.wBlockAlign;
+		header.dwdata = 0x61746164;
+		header.dwDataLength = rec_bytes;
+		
+		rec->Fseek(0, FILEIO_SEEK_SET);
+		rec->Fwrite(&header, sizeof(wavheader_t), 1);
+		rec->Fclose();
+		
+		delete rec;
+		now_rec_snd = false;
+	}
+}
+
+// ----------------------------------------------------------------------------
+// timer
+// ----------------------------------------------------------------------------
+
+void EMU::get_host_time(cur_time_t* time)
+{
+	time_t now = ::time(NULL);
+	struct tm tm;
+	struct tm* t = localtime_r(&now, &tm);	// reentrant, instances may run on several threads
+	
+	time->year = t->tm_year + 1900;
+	time->month = t->tm_mon + 1;
+	time->day = t->tm_mday;
+	time->day_of_week = t->tm_wday;
+	time->hour = t->tm_hour;
+	time->minute = t->tm_min;
+	time->second = t->tm_sec;
+}
+
+// ----------------------------------------------------------------------------
+// debug log
+// ----------------------------------------------------------------------------
+
+void EMU::out_debug(const _TCHAR* format, ...)
+{
+#ifdef _DEBUG_LOG
+	va_list ap;
+	
+	va_start(ap, format);
+	vfprintf(stderr, format, ap);
+	va_end(ap);
+#endif
+}
+
+// ----------------------------------------------------------------------------
+// user interface
+// ----------------------------------------------------------------------------
+
+#ifdef USE_CART
+void EMU::open_cart(_TCHAR* file_path)
+{
+	vm->open_cart(file_path);
+}
+void EMU::close_cart()
+{
+	vm->close_cart();
+}
+#endif
+
+#ifdef USE_FD1
+void EMU::open_disk(int drv, _TCHAR* file_path, int offset)
+{
+	vm->open_disk(drv, file_path, offset);
+}
+void EMU::close_disk(int drv)
+{
+	vm->close_disk(drv);
+}
+#endif
+
+#ifdef USE_QUICKDISK
+void EMU::open_quickdisk(_TCHAR* file_path)
+{
+	vm->open_quickdisk(file_path);
+}
+void EMU::close_quickdisk()
+{
+	vm->close_quickdisk();
+}
+#endif
+
+#ifdef USE_DATAREC
+void EMU::play_datarec(_TCHAR* file_path)
+{
+	vm->play_datarec(file_path);
+}
+void EMU::rec_datarec(_TCHAR* file_path)
+{
+	vm->rec_datarec(file_path);
+}
+void EMU::close_datarec()
+{
+	vm->close_datarec();
+}
+#endif
+
+#ifdef USE_BINARY_FILE1
+void EMU::load_binary(int drv, _TCHAR* file_path)
+{
+	vm->load_binary(drv, file_path);
+}
+void EMU::save_binary(int drv, _TCHAR* file_path)
+{
+	vm->save_binary(drv, file_path);
+}
+#endif
+
+void EMU::update_config()
+{
+	vm->update_config();
+}
+
+// ----------------------------------------------------------------------------
+// state
+// ----------------------------------------------------------------------------
+
+#ifdef USE_STATE
+#define STATE_HEADER_SIZE	16
+#define REWIND_KEYFRAME_INTERVAL	60
+
+bool EMU::save_state(_TCHAR* file_path)
+{
+	bool result = false;
+	FILEIO* fio = new FILEIO();
+	if(fio->Fopen(file_path, FILEIO_WRITE_BINARY)) {
+		save_state(fio);
+		fio->Fclose();
+		result = true;
+	}
+	delete fio;
+	return result;
+}
+
+bool EMU::load_state(_TCHAR* file_path)
+{
+	bool result = false;
+	FILEIO* fio = new FILEIO();
+	if(fio->Fopen(file_path, FILEIO_READ_BINARY)) {
+		result = load_state(fio);
+		fio->Fclose();
+	}
+	delete fio;
+	return result;
+}
+
+void EMU::save_state(FILEIO* fio)
+{
+	// state of the other machine is rejected by the header
+	char header[STATE_HEADER_SIZE];
+	memset(header, 0, sizeof(header));
+	strncpy(header, CONFIG_NAME, sizeof(header) - 1);
+	fio->Fwrite(header, sizeof(header), 1);
+	
+	// sound buffer is pulled at the same timing after the state is loaded
+	fio->FputDouble(sound_accum);
+	vm->save_state(fio);
+}
+
+bool EMU::load_state(FILEIO* fio)
+{
+	char header[STATE_HEADER_SIZE];
+	if(fio->Fread(header, sizeof(header), 1) != 1) {
+		return false;
+	}
+	header[sizeof(header) - 1] = '\0';
+	if(strcmp(header, CONFIG_NAME) != 0) {
+		return false;
+	}
+	sound_accum = fio->FgetDouble();
+	if(!vm->load_state(fio)) {
+		// machine state may be broken
+		vm->reset();
+		return false;
+	}
+	return true;
+}
+
+void EMU::initialize_rewind(int seconds)
+{
+	// the oldest keyframe and its deltas are removed at once
+	int frames = (seconds > 0) ? (int)(frame_rate() * seconds + 0.5) + REWIND_KEYFRAME_INTERVAL : 0;
+	vm->initialize_rewind(frames, REWIND_KEYFRAME_INTERVAL);
+}
+
+bool EMU::restore_rewind(int frames)
+{
+	return vm->restore_rewind(frames);
+}
+
+int EMU::get_rewind_frames()
+{
+	return vm->get_rewind_frames();
+}
+
+int EMU::get_rewind_buffer_size()
+{
+	return vm->get_rewind_buffer_size();
+}
+#endif
@@ -0,0 +1,243 @@
+/*
+	Skelton for retropc emulator
+
+	Author : Takeda.Toshiya
+	Date   : 2013.03.01-
+
+	[ headless emulation i/f ]
+*/
+
+#ifndef _HEADLESS_EMU_H_
+#define _HEADLESS_EMU_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "common.h"
+#include "config.h"
+#include "vm/vm.h"
+
+#ifndef SCREEN_WIDTH_ASPECT
+#define SCREEN_WIDTH_ASPECT SCREEN_WIDTH
+#endif
+#ifndef SCREEN_HEIGHT_ASPECT
+#define SCREEN_HEIGHT_ASPECT SCREEN_HEIGHT
+#endif
+#ifndef WINDOW_WIDTH
+#define WINDOW_WIDTH SCREEN_WIDTH_ASPECT
+#endif
+#ifndef WINDOW_HEIGHT
+#define WINDOW_HEIGHT SCREEN_HEIGHT_ASPECT
+#endif
+
+#ifdef USE_SOCKET
+#define SOCKET_MAX 4
+#endif
+
+class FIFO;
+class FILEIO;
+
+class EMU
+{
+protected:
+	VM* vm;
+private:
+	// ----------------------------------------
+	// input
+	// ----------------------------------------
+	void initialize_input();
+	void update_input();
+	
+	uint8 key_status[256];	// windows key code mapping
+	uint32 joy_status[2];	// joystick #1, #2 (b0 = up, b1 = down, b2 = left, b3 = right, b4- = buttons
+	int mouse_status[3];	// x, y, button (b0 = left, b1 = right)
+	
+	// ----------------------------------------
+	// screen
+	// ----------------------------------------
+	void initialize_screen();
+	void release_screen();
+	
+	int screen_width, screen_height;
+	scrntype* screen;	// top-down, no stretch
+	
+	// ----------------------------------------
+	// sound
+	// ----------------------------------------
+	void update_sound(int* extra_frames);
+	
+	int sound_rate, sound_samples;
+	double sound_accum;
+	bool sound_enabled;
+	
+	// record sound
+	typedef struct {
+		uint32 dwRIFF;
+		uint32 dwFileSize;
+		uint32 dwWAVE;
+		uint32 dwfmt_;
+		uint32 dwFormatSize;
+		uint16 wFormatTag;
+		uint16 wChannels;
+		uint32 dwSamplesPerSec;
+		uint32 dwAvgBytesPerSec;
+		uint16 wBlockAlign;
+		uint16 wBitsPerSample;
+		uint32 dwdata;
+		uint32 dwDataLength;
+	} wavheader_t;
+	FILEIO* rec;
+	int rec_bytes;
+	bool now_rec_snd;
+	
+	// ----------------------------------------
+	// misc
+	// ----------------------------------------
+	_TCHAR app_path[_MAX_PATH];
+	_TCHAR file_path[_MAX_PATH];
+	bool now_power_off;
+	
+	// settings of this instance, bound to the creating thread
+	config_t instance_config;
+	config_t* prev_config;
+
+public:
+	// ----------------------------------------
+	// initialize
+	// ----------------------------------------
+	// the settings are copied from the current thread's config, and the
+	// instance must be driven and deleted by the thread that created it
+	EMU(const _TCHAR* bios_dir, bool enable_sound);
+	~EMU();
+	
+	_TCHAR* application_path() {
+		return app_path;
+	}
+	_TCHAR* bios_path(_TCHAR* file_name);
+	
+	// ----------------------------------------
+	// for host
+	// ----------------------------------------
+	
+	// drive virtual machine
+	double frame_rate();
+	int run();
+	void reset();
+#ifdef USE_SPECIAL_RESET
+	void special_reset();
+#endif
+	bool now_power_off_requested() {
+		return now_power_off;
+	}
+	
+	// user interface
+#ifdef USE_CART
+	void open_cart(_TCHAR* file_path);
+	void close_cart();
+#endif
+#ifdef USE_FD1
+	void open_disk(int drv, _TCHAR* file_path, int offset);
+	void close_disk(int drv);
+#endif
+#ifdef USE_QUICKDISK
+	void open_quickdisk(_TCHAR* file_path);
+	void close_quickdisk();
+#endif
+#ifdef USE_DATAREC
+	void play_datarec(_TCHAR* file_path);
+	void rec_datarec(_TCHAR* file_path);
+	void close_datarec();
+#endif
+#ifdef USE_BINARY_FILE1
+	void load_binary(int drv, _TCHAR* file_path);
+	void save_binary(int drv, _TCHAR* file_path);
+#endif
+
+	bool start_rec_sound(_TCHAR* file_path);
+	void stop_rec_sound();
+	
+	void update_config();
+#ifdef USE_STATE
+	bool save_state(_TCHAR* file_path);
+	bool load_state(_TCHAR* file_path);
+	void save_state(FILEIO* fio);
+	bool load_state(FILEIO* fio);
+	void initialize_rewind(int seconds);
+	bool restore_rewind(int frames);
+	int get_rewind_frames();
+	int get_rewind_buffer_size();
+#endif
+	
+	// input injection
+	void key_down(int code, bool repeat);
+	void key_up(int code);
+	void press_key(int code, int frames);
+	void set_joy_status(int num, uint32 status) {
+		joy_status[num & 1] = status;
+	}
+	
+	// screen
+	void draw_screen();
+	scrntype* get_screen() {
+		return screen;
+	}
+	int get_screen_width() {
+		return screen_width;
+	}
+	int get_screen_height() {
+		return screen_height;
+	}
+	
+	// ----------------------------------------
+	// for virtual machine
+	// ----------------------------------------
+	
+	// power off
+	void power_off() {
+		now_power_off = true;
+	}
+	
+	// input device
+	uint8* key_buffer() {
+		return key_status;
+	}
+	uint32* joy_buffer() {
+		return joy_status;
+	}
+	int* mouse_buffer() {
+		return mouse_status;
+	}
+	
+	// screen
+	void change_screen_size(int sw, int sh, int swa, int sha, int ww, int wh);
+	scrntype* screen_buffer(int y) {
+		return screen + screen_width * y;
+	}
+	
+	// timer
+	void get_host_time(cur_time_t* time);
+	
+	// socket (not supported)
+#ifdef USE_SOCKET
+	bool init_socket_tcp(int ch) {
+		return false;
+	}
+	bool init_socket_udp(int ch) {
+		return false;
+	}
+	bool connect_socket(int ch, uint32 ipaddr, int port) {
+		return false;
+	}
+	void disconnect_socket(int ch) {}
+	bool listen_socket(int ch) {
+		return false;
+	}
+	void send_data_tcp(int ch) {}
+	void send_data_udp(int ch, uint32 ipaddr, int port) {}
+#endif
+	// debug log
+	void out_debug(const _TCHAR* format, ...);
+};
+
+#endif
@@ -0,0 +1,321 @@
+/*
+	Skelton for retropc emulator
+
+	Author : Takeda.Toshiya
+	Date   : 2013.03.01-
+
+	[ headless main ]
+*/
+
+#include <time.h>
+#include "config.h"
+#include "emu.h"
+#include "fileio.h"
+
+#define MAX_KEY_EVENTS	256
+
+// emulation core
+EMU* emu;
+
+typedef struct {
+	int frame;
+	int code;
+} key_event_t;
+
+static double get_host_sec()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec / 1000000000.0;
+}
+
+static void save_ppm(_TCHAR* file_path)
+{
+	FILEIO* fio = new FILEIO();
+	if(fio->Fopen(file_path, FILEIO_WRITE_BINARY)) {
+		int width = emu->get_screen_width();
+		int height = emu->get_screen_height();
+		char header[64];
+		sprintf(header, "P6\n%d %d\n255\n", width, height);
+		fio->Fwrite(header, strlen(header), 1);
+		
+		scrntype* src = emu->get_screen();
+		uint8* line = (uint8*)malloc(width * 3);
+		for(int y = 0; y < height; y++) {
+			for(int x = 0; x < width; x++) {
+				uint32 c = src[x];
+#if defined(_RGB555)
+				line[x * 3 + 0] = (uint8)((c >> 7) & 0xf8);
+				line[x * 3 + 1] = (uint8)((c >> 2) & 0xf8);
+				line[x * 3 + 2] = (uint8)((c << 3) & 0xf8);
+#elif defined(_RGB565)
+				line[x * 3 + 0] = (uint8)((c >> 8) & 0xf8);
+				line[x * 3 + 1] = (uint8)((c >> 3) & 0xfc);
+				line[x * 3 + 2] = (uint8)((c << 3) & 0xf8);
+#else
+				line[x * 3 + 0] = (uint8)(c >> 16);
+				line[x * 3 + 1] = (uint8)(c >> 8);
+				line[x * 3 + 2] = (uint8)(c >> 0);
+#endif
+			}
+			fio->Fwrite(line, width * 3, 1);
+			src += width;
+		}
+		free(line);
+		fio->Fclose();
+	}
+	delete fio;
+}
+
+static void usage(const char* name)
+{
+	fprintf(stderr, "usage: %s [options]\n", name);
+	fprintf(stderr, "  -bios <dir>          directory of rom images (default: current directory)\n");
+	fprintf(stderr, "  -frames <n>          number of frames to run (default: 600)\n");
+	fprintf(stderr, "  -draw <n>            draw screen every n frames, 0 = never (default: 1)\n");
+	fprintf(stderr, "  -nosound             do not mix sound\n");
+	fprintf(stderr, "  -wav <file>          record sound to the wave file\n");
+	fprintf(stderr, "  -ppm <file>          save the last screen to the ppm file\n");
+	fprintf(stderr, "  -key <frame>:<code>  press the virtual key code at the frame\n");
+	fprintf(stderr, "  -quantum <n>         clocks the primary cpu runs ahead of sub cpus, 0 = default, 4 = lockstep\n");
+#ifdef USE_CART
+	fprintf(stderr, "  -cart <file>         open the cartridge image\n");
+#endif
+#ifdef USE_FD1
+	fprintf(stderr, "  -disk <drv>:<file>   open the floppy disk image\n");
+	fprintf(stderr, "  -fastdisk            transfer the sectors by dma at once, and skip the seek time\n");
+#endif
+#ifdef USE_DATAREC
+	fprintf(stderr, "  -tape <file>         play the tape image\n");
+	fprintf(stderr, "  -fasttape            copy the tape blocks to memory when the rom routine reads them\n");
+#endif
+#ifdef USE_STATE
+	fprintf(stderr, "  -load <file>         load the state file before running\n");
+	fprintf(stderr, "  -save <frame>:<file> save the state file at the frame\n");
+	fprintf(stderr, "  -rewind <sec>        keep the snapshots to rewind the seconds\n");
+	fprintf(stderr, "  -back <frame>:<n>    rewind n frames at the frame\n");
+#endif
+}
+
+int main(int argc, char* argv[])
+{
+	const _TCHAR* bios_dir = _T(".");
+	_TCHAR* wav_path = NULL;
+	_TCHAR* ppm_path = NULL;
+#ifdef USE_CART
+	_TCHAR* cart_path = NULL;
+#endif
+#ifdef USE_FD1
+	_TCHAR* disk_path[8] = {0};
+	bool fast_disk = false;
+#endif
+#ifdef USE_DATAREC
+	_TCHAR* tape_path = NULL;
+	bool fast_tape = false;
+#endif
+#ifdef USE_STATE
+	_TCHAR* load_path = NULL;
+	_TCHAR* save_path = NULL;
+	int save_frame = -1;
+	int rewind_sec = 0, back_frame = -1, back_count = 0;
+#endif
+	int max_frames = 600, draw_interval = 1;
+	int cpu_quantum = 0;
+	bool enable_sound = true;
+	key_event_t key_events[MAX_KEY_EVENTS];
+	int key_event_count = 0;
+	
+	for(int i = 1; i < argc; i++) {
+		bool has_value = (i + 1 < argc);
+		if(strcmp(argv[i], "-bios") == 0 && has_value) {
+			bios_dir = argv[++i];
+		}
+		else if(strcmp(argv[i], "-frames") == 0 && has_value) {
+			max_frames = atoi(argv[++i]);
+		}
+		else if(strcmp(argv[i], "-quantum") == 0 && has_value) {
+			cpu_quantum = atoi(argv[++i]);
+		}
+		else if(strcmp(argv[i], "-draw") == 0 && has_value) {
+			draw_interval = atoi(argv[++i]);
+		}
+		else if(strcmp(argv[i], "-nosound") == 0) {
+			enable_sound = false;
+		}
+		else if(strcmp(argv[i], "-wav") == 0 && has_value) {
+			wav_path = argv[++i];
+		}
+		else if(strcmp(argv[i], "-ppm") == 0 && has_value) {
+			ppm_path = argv[++i];
+		}
+		else if(strcmp(argv[i], "-key") == 0 && has_value && key_event_count < MAX_KEY_EVENTS) {
+			key_event_t* e = &key_events[key_event_count];
+			if(sscanf(argv[++i], "%d:%i", &e->frame, &e->code) == 2) {
+				key_event_count++;
+			}
+		}
+#ifdef USE_CART
+		else if(strcmp(argv[i], "-cart") == 0 && has_value) {
+			cart_path = argv[++i];
+		}
+#endif
+#ifdef USE_FD1
+		else if(strcmp(argv[i], "-disk") == 0 && has_value) {
+			_TCHAR* value = argv[++i];
+			int drv = value[0] - _T('0');
+			if(0 <= drv && drv < 8 && value[1] == _T(':')) {
+				disk_path[drv] = value + 2;
+			}
+		}
+		else if(strcmp(argv[i], "-fastdisk") == 0) {
+			fast_disk = true;
+		}
+#endif
+#ifdef USE_DATAREC
+		else if(strcmp(argv[i], "-tape") == 0 && has_value) {
+			tape_path = argv[++i];
+		}
+		else if(strcmp(argv[i], "-fasttape") == 0) {
+			fast_tape = true;
+		}
+#endif
+#ifdef USE_STATE
+		else if(strcmp(argv[i], "-load") == 0 && has_value) {
+			load_path = argv[++i];
+		}
+		else if(strcmp(argv[i], "-save") == 0 && has_value) {
+			_TCHAR* value = argv[++i];
+			_TCHAR* sep = strchr(value, _T(':'));
+			if(sep != NULL) {
+				save_frame = atoi(value);
+				save_path = sep + 1;
+			}
+		}
+		else if(strcmp(argv[i], "-rewind") == 0 && has_value) {
+			rewind_sec = atoi(argv[++i]);
+		}
+		else if(strcmp(argv[i], "-back") == 0 && has_value) {
+			if(sscanf(argv[++i], "%d:%d", &back_frame, &back_count) != 2) {
+				back_frame = -1;
+			}
+		}
+#endif
+		else {
+			usage(argv[0]);
+			return 1;
+		}
+	}
+	if(wav_path != NULL) {
+		enable_sound = true;
+	}
+	
+	// initialize emulation core with the default settings
+	init_config();
+	config.cpu_quantum = cpu_quantum;
+#ifdef USE_FD1
+	config.fast_disk = fast_disk;
+#endif
+#ifdef USE_DATAREC
+	config.fast_tape = fast_tape;
+#endif
+	emu = new EMU(bios_dir, enable_sound);
+	if(wav_path != NULL && !emu->start_rec_sound(wav_path)) {
+		fprintf(stderr, "cannot open %s\n", wav_path);
+	}
+#ifdef USE_CART
+	if(cart_path != NULL) {
+		emu->open_cart(cart_path);
+	}
+#endif
+#ifdef USE_FD1
+	for(int drv = 0; drv < 8; drv++) {
+		if(disk_path[drv] != NULL) {
+			emu->open_disk(drv, disk_path[drv], 0);
+		}
+	}
+#endif
+#ifdef USE_DATAREC
+	if(tape_path != NULL) {
+		emu->play_datarec(tape_path);
+	}
+#endif
+#ifdef USE_STATE
+	if(load_path != NULL) {
+		double load_time = get_host_sec();
+		if(emu->load_state(load_path)) {
+			printf("state loaded: %s (%.3f msec)\n", load_path, (get_host_sec() - load_time) * 1000.0);
+		}
+		else {
+			fprintf(stderr, "cannot load %s\n", load_path);
+		}
+	}
+	if(rewind_sec > 0) {
+		emu->initialize_rewind(rewind_sec);
+	}
+#endif
+
+	// main loop: drive machine as fast as the host allows
+	int total_frames = 0, draw_frames = 0;
+	double start_time = get_host_sec();
+	
+	while(total_frames < max_frames && !emu->now_power_off_requested()) {
+		for(int i = 0; i < key_event_count; i++) {
+			if(key_events[i].frame >= 0 && key_events[i].frame <= total_frames) {
+				emu->press_key(key_events[i].code, 0);
+				key_events[i].frame = -1;
+			}
+		}
+		total_frames += emu->run();
+		
+#ifdef USE_STATE
+		if(save_path != NULL && save_frame <= total_frames) {
+			double save_time = get_host_sec();
+			if(emu->save_state(save_path)) {
+				printf("state saved: %s (%.3f msec)\n", save_path, (get_host_sec() - save_time) * 1000.0);
+			}
+			else {
+				fprintf(stderr, "cannot save %s\n", save_path);
+			}
+			save_path = NULL;
+		}
+		if(back_frame >= 0 && back_frame <= total_frames) {
+			double back_time = get_host_sec();
+			if(emu->restore_rewind(back_count)) {
+				printf("rewound %d frames (%.3f msec)\n", back_count, (get_host_sec() - back_time) * 1000.0);
+			}
+			else {
+				fprintf(stderr, "cannot rewind %d frames\n", back_count);
+			}
+			back_frame = -1;
+		}
+#endif
+		if(draw_interval > 0 && (total_frames % draw_interval) == 0) {
+			emu->draw_screen();
+			draw_frames++;
+		}
+	}
+	double passed_sec = get_host_sec() - start_time;
+	
+	// the last screen is always drawn to check the result
+	emu->draw_screen();
+	int size = emu->get_screen_width() * emu->get_screen_height() * sizeof(scrntype);
+	uint32 crc = getcrc32((uint8*)emu->get_screen(), size);
+	if(ppm_path != NULL) {
+		save_ppm(ppm_path);
+	}
+	
+	double fps = (passed_sec > 0) ? (double)total_frames / passed_sec : 0;
+	printf("%s\n", DEVICE_NAME);
+	printf("frames: %d (drawn: %d)\n", total_frames, draw_frames);
+	printf("time: %.3f sec\n", passed_sec);
+	printf("speed: %.1f fps (%.2fx)\n", fps, fps / emu->frame_rate());
+	printf("screen crc32: %08x\n", crc);
+#ifdef USE_STATE
+	if(rewind_sec > 0) {
+		printf("rewind: %d frames (%d KB)\n", emu->get_rewind_frames(), emu->get_rewind_buffer_size() >> 10);
+	}
+#endif
+	
+	delete emu;
+	return 0;
+}
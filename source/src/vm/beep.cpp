@@ -9,8 +9,14 @@
 
 #include "beep.h"
 
+// queued writes
+#define QUEUE_ON	0
+#define QUEUE_MUTE	1
+#define QUEUE_DIFF	2
+
 void BEEP::reset()
 {
+	flush_queue();
 	signal = true;
 	count = 0;
 	on = mute = false;
@@ -19,24 +25,68 @@ void BEEP::reset()
 void BEEP::write_signal(int id, uint32 data, uint32 mask)
 {
 	if(id == SIG_BEEP_ON) {
-		on = ((data & mask) != 0);
+		write_queue(QUEUE_ON, data & mask);
 	}
 	else if(id == SIG_BEEP_MUTE) {
-		mute = ((data & mask) != 0);
+		write_queue(QUEUE_MUTE, data & mask);
+	}
+}
+
+void BEEP::write_queue(uint32 addr, uint32 data)
+{
+	if(queue.full()) {
+		flush_queue();
+	}
+	queue.write(current_clock(), addr, data);
+}
+
+void BEEP::apply_queue(uint32 addr, uint32 data)
+{
+	if(addr == QUEUE_ON) {
+		on = (data != 0);
+	}
+	else if(addr == QUEUE_MUTE) {
+		mute = (data != 0);
+	}
+	else if(addr == QUEUE_DIFF) {
+		diff = data;
+	}
+}
+
+void BEEP::flush_queue()
+{
+	uint32 clock, addr, data;
+	while(queue.read(&clock, &addr, &data)) {
+		apply_queue(addr, data);
 	}
 }
 
 void BEEP::mix(int32* buffer, int cnt)
 {
-	if(on && !mute) {
-		for(int i = 0; i < cnt; i++) {
-			if((count -= 1024) < 0) {
-				count += diff;
-				signal = !signal;
+	queue.start(current_clock(), cnt);
+	
+	int pos = 0, next;
+	uint32 addr, data;
+	for(;;) {
+		bool written = queue.read(&next, &addr, &data);
+		if(!written) {
+			next = cnt;
+		}
+		if(on && !mute) {
+			for(int i = pos; i < next; i++) {
+				if((count -= 1024) < 0) {
+					count += diff;
+					signal = !signal;
+				}
+				buffer[i * 2    ] += signal ? gen_vol : -gen_vol; // L
+				buffer[i * 2 + 1] += signal ? gen_vol : -gen_vol; // R
 			}
-			*buffer++ += signal ? gen_vol : -gen_vol; // L
-			*buffer++ += signal ? gen_vol : -gen_vol; // R
 		}
+		pos = next;
+		if(!written) {
+			break;
+		}
+		apply_queue(addr, data);
 	}
 }
 
@@ -49,6 +99,6 @@ void BEEP::init(int rate, double frequency, int volume)
 
 void BEEP::set_frequency(double frequency)
 {
-	diff = (int)(1024.0 * gen_rate / frequency / 2.0 + 0.5);
+	write_queue(QUEUE_DIFF, (int)(1024.0 * gen_rate / frequency / 2.0 + 0.5));
 }
 
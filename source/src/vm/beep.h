@@ -13,6 +13,7 @@
 #include "vm.h"
 #include "../emu.h"
 #include "device.h"
+#include "sound_queue.h"
 
 #define SIG_BEEP_ON	0
 #define SIG_BEEP_MUTE	1
@@ -29,6 +30,12 @@ private:
 	bool on;
 	bool mute;
 	
+	// signals are applied in mix() at their sample positions
+	SOUND_QUEUE queue;
+	void write_queue(uint32 addr, uint32 data);
+	void apply_queue(uint32 addr, uint32 data);
+	void flush_queue();
+	
 public:
 	BEEP(VM* parent_vm, EMU* parent_emu) : DEVICE(parent_vm, parent_emu) {}
 	~BEEP() {}
@@ -37,6 +44,9 @@ public:
 	void reset();
 	void write_signal(int id, uint32 data, uint32 mask);
 	void mix(int32* buffer, int cnt);
+	bool mix_per_frame() {
+		return true;
+	}
 	
 	// unique function
 	void init(int rate, double frequency, int volume);
@@ -16,7 +16,15 @@
 #ifndef DATAREC_FF_REW_SPEED
 #define DATAREC_FF_REW_SPEED	10
 #endif
-#define TMP_SAMPLES 0x10000
+
+#define IMAGE_CAS	0
+#define IMAGE_WAV	1
+#define IMAGE_TAP	2
+#define IMAGE_MZT	3
+
+#define MZT_BLOCK_NONE		0
+#define MZT_BLOCK_HEADER	1
+#define MZT_BLOCK_DATA		2
 
 #pragma pack(1)
 typedef struct {
@@ -63,6 +71,13 @@ void DATAREC::initialize()
 	buffer_ptr = buffer_length = 0;
 	is_wav = false;
 	
+	image_type = IMAGE_CAS;
+	window_ptr = window_length = 0;
+	pulse_count = -1;
+	tmp_buffer = NULL;
+	mzt_image = NULL;
+	mzt_segments = NULL;
+	
 #ifdef DATAREC_SOUND
 	mix_buffer = NULL;
 	mix_buffer_ptr = mix_buffer_length = 0;
@@ -114,10 +129,10 @@ void DATAREC::event_callback(int event_id, int err)
 			bool signal = in_signal;
 			if(is_wav) {
 				if(buffer_ptr >= 0 && buffer_ptr < buffer_length) {
-					signal = ((buffer[buffer_ptr] & 0x80) != 0);
+					signal = ((get_sample(buffer_ptr) & 0x80) != 0);
 #ifdef DATAREC_SOUND
 					if(wav_buffer != NULL && ff_rew == 0) {
-						wav_sample = wav_buffer[buffer_ptr];
+						wav_sample = wav_buffer[buffer_ptr - window_ptr];
 					} else {
 						wav_sample = 0;
 					}
@@ -135,15 +150,19 @@ void DATAREC::event_callback(int event_id, int err)
 				update_event();
 			} else {
 				while(buffer_ptr < buffer_length) {
-					if((buffer[buffer_ptr] & 0x7f) == 0) {
+					// count down the samples of the pulse, the image is not modified
+					if(pulse_count < 0) {
+						pulse_count = get_sample(buffer_ptr) & 0x7f;
+					}
+					if(pulse_count == 0) {
+						pulse_count = -1;
 						if(++buffer_ptr == buffer_length) {
 							set_remote(false);	// end of tape
 							break;
 						}
 					} else {
-						signal = ((buffer[buffer_ptr] & 0x80) != 0);
-						uint8 tmp = buffer[buffer_ptr];
-						buffer[buffer_ptr] = (tmp & 0x80) | ((tmp & 0x7f) - 1);
+						signal = ((get_sample(buffer_ptr) & 0x80) != 0);
+						pulse_count--;
 						break;
 					}
 				}
@@ -240,37 +259,45 @@ bool DATAREC::play_datarec(_TCHAR* file_path)
 		if(check_file_extension(file_path, _T(".wav"))) {
 			// standard PCM wave file
 			if((buffer_length = load_wav_image()) == 0) {
+				close_file();
 				return false;
 			}
+			image_type = IMAGE_WAV;
 			is_wav = true;
 		} else if(check_file_extension(file_path, _T(".tap"))) {
 			// SHARP X1 series tape image
 			if((buffer_length = load_tap_image()) == 0) {
+				close_file();
 				return false;
 			}
-			buffer = (uint8 *)malloc(buffer_length);
-			load_tap_image();
+			image_type = IMAGE_TAP;
+			is_wav = true;
 		} else if(check_file_extension(file_path, _T(".mzt")) || check_file_extension(file_path, _T(".m12"))) {
 			// SHARP MZ series tape image
 			if((buffer_length = load_mzt_image()) == 0) {
+				close_file();
 				return false;
 			}
-			buffer = (uint8 *)malloc(buffer_length);
-			load_mzt_image();
+			image_type = IMAGE_MZT;
 		} else {
 			// standard cas image for my emulator
 			if((buffer_length = load_cas_image()) == 0) {
+				close_file();
 				return false;
 			}
+			image_type = IMAGE_CAS;
 		}
+		buffer = (uint8 *)malloc(DATAREC_WINDOW_SIZE);
+		window_ptr = window_length = 0;
+		pulse_count = -1;
+		play = true;
 		
 		// get the first signal
-		bool signal = ((buffer[0] & 0x80) != 0);
+		bool signal = ((get_sample(0) & 0x80) != 0);
 		if(signal != in_signal) {
 			write_signals(&outputs_out, signal ? 0xffffffff : 0);
 			in_signal = signal;
 		}
-		play = true;
 		update_event();
 	}
 	return play;
@@ -321,13 +348,25 @@ void DATAREC::close_file()
 			fio->Fwrite(buffer, buffer_ptr + 1, 1);
 		}
 	}
-	if(play || rec) {
+	if(fio->IsOpened()) {
 		fio->Fclose();
 	}
 	if(buffer != NULL) {
 		free(buffer);
 		buffer = NULL;
 	}
+	if(tmp_buffer != NULL) {
+		free(tmp_buffer);
+		tmp_buffer = NULL;
+	}
+	if(mzt_image != NULL) {
+		free(mzt_image);
+		mzt_image = NULL;
+	}
+	if(mzt_segments != NULL) {
+		free(mzt_segments);
+		mzt_segments = NULL;
+	}
 #ifdef DATAREC_SOUND
 	if(wav_buffer != NULL) {
 		free(wav_buffer);
@@ -336,109 +375,118 @@ void DATAREC::close_file()
 #endif
 }
 
+// decode the samples or pulses around the position to the window
+
+void DATAREC::load_window(int ptr)
+{
+	// keep the window ahead in the direction the tape moves
+	int start = ptr;
+	if(ptr < window_ptr) {
+		if((start = ptr - DATAREC_WINDOW_SIZE + 1) < 0) {
+			start = 0;
+		}
+	}
+	int length = buffer_length - start;
+	if(length > DATAREC_WINDOW_SIZE) {
+		length = DATAREC_WINDOW_SIZE;
+	}
+	
+	switch(image_type) {
+	case IMAGE_CAS:
+		memset(buffer, 0, length);
+		fio->Fseek(start, FILEIO_SEEK_SET);
+		fio->Fread(buffer, length, 1);
+		break;
+	case IMAGE_WAV:
+		decode_wav_image(start, length);
+		break;
+	case IMAGE_TAP:
+		decode_tap_image(start, length);
+		break;
+	case IMAGE_MZT:
+		decode_mzt_image(start, length);
+		break;
+	}
+	window_ptr = start;
+	window_length = length;
+}
+
 // standard cas image for my emulator
 
 int DATAREC::load_cas_image()
 {
 	sample_rate = 48000;
 	
-	// get file size
+	// the pulses are read from the file as they are
 	fio->Fseek(0, FILEIO_SEEK_END);
-	int file_size = fio->Ftell();
-	
-	// load samples
-	if(file_size > 0) {
-		buffer = (uint8 *)malloc(file_size);
-		fio->Fseek(0, FILEIO_SEEK_SET);
-		fio->Fread(buffer, file_size, 1);
-	}
-	return file_size;
+	return fio->Ftell();
 }
 
 // standard PCM wave file
 
 int DATAREC::load_wav_image()
 {
-	// get file size
-	fio->Fseek(0, FILEIO_SEEK_END);
-	int file_size = fio->Ftell();
-	fio->Fseek(0, FILEIO_SEEK_SET);
-	
 	// check wave header
 	wav_header_t header;
 	wav_data_t data;
 	
+	fio->Fseek(0, FILEIO_SEEK_SET);
 	fio->Fread(&header, sizeof(header), 1);
-	if(header.format_id != 1 || !(header.sample_bits == 8 || header.sample_bits == 16)) {
+	if(header.format_id != 1 || !(header.sample_bits == 8 || header.sample_bits == 16) || header.channels == 0) {
 		// this is not pcm format !!!
-		fio->Fclose();
 		return 0;
 	}
 	fio->Fseek(header.fmt_size - 0x10, FILEIO_SEEK_CUR);
 	fio->Fread(&data, sizeof(data), 1);
 	
+	data_offset = fio->Ftell();
+	wav_channels = header.channels;
+	wav_bits = header.sample_bits;
+	sample_rate = header.sample_rate;
+	
 	int samples = data.data_len / header.channels;
-	int tmp_length = header.channels * TMP_SAMPLES;
 	if(header.sample_bits == 16) {
 		samples /= 2;
-		tmp_length *= 2;
 	}
-	sample_rate = header.sample_rate;
-	
-	// load samples
 	if(samples > 0) {
-		buffer = (uint8 *)malloc(samples);
+		tmp_buffer = (uint8 *)malloc(DATAREC_WINDOW_SIZE * wav_channels * (wav_bits >> 3));
 #ifdef DATAREC_SOUND
 		if(header.channels > 1) {
-			wav_buffer = (int16 *)malloc(samples * sizeof(int16));
+			wav_buffer = (int16 *)malloc(DATAREC_WINDOW_SIZE * sizeof(int16));
 		}
 #endif
-		uint8 *tmp_buffer = (uint8 *)malloc(tmp_length);
-		fio->Fread(tmp_buffer, tmp_length, 1);
-		
-		for(int i = 0, tmp_ptr = 0; i < samples; i++) {
-			typedef union {
-				int16 s16;
-				struct {
-					uint8 l, h;
-				} b;
-			} sample_pair;
-			sample_pair data;
-			
-			data.b.l = tmp_buffer[tmp_ptr++];
-			if(header.sample_bits == 16) {
-				data.b.h = tmp_buffer[tmp_ptr++];
-				buffer[i] = (data.s16 > 4096) ? 0xff : 0;
-			} else {
-				buffer[i] = (data.b.l > 128 + 16) ? 0xff : 0;
-			}
+	}
+	return samples;
+}
+
+void DATAREC::decode_wav_image(int ptr, int length)
+{
+	int bytes = wav_bits >> 3;
+	int block = wav_channels * bytes;
+	
+	memset(tmp_buffer, 0, length * block);
+	fio->Fseek(data_offset + ptr * block, FILEIO_SEEK_SET);
+	fio->Fread(tmp_buffer, length * block, 1);
+	
+	// 1st channel is the signal, and 2nd channel is the sound
+	uint8 *src = tmp_buffer;
+	for(int i = 0; i < length; i++) {
+		if(bytes == 2) {
+			buffer[i] = ((int16)(src[0] | (src[1] << 8)) > 4096) ? 0xff : 0;
+		} else {
+			buffer[i] = (src[0] > 128 + 16) ? 0xff : 0;
+		}
 #ifdef DATAREC_SOUND
-			if(header.channels > 1) {
-				data.b.l = tmp_buffer[tmp_ptr++];
-				if(header.sample_bits == 16) {
-					data.b.h = tmp_buffer[tmp_ptr++];
-					wav_buffer[i] = data.s16;
-				} else {
-					wav_buffer[i] = ((int16)data.b.l - 128) * 256;
-				}
-			}
-			for(int i = 3; i <= header.channels; i++) {
-#else
-			for(int i = 2; i <= header.channels; i++) {
-#endif
-				tmp_buffer[tmp_ptr++];
-				if(header.sample_bits == 16) {
-					tmp_buffer[tmp_ptr++];
-				}
-			}
-			if(tmp_ptr == tmp_length) {
-				fio->Fread(tmp_buffer, tmp_length, 1);
-				tmp_ptr = 0;
+		if(wav_buffer != NULL) {
+			if(bytes == 2) {
+				wav_buffer[i] = (int16)(src[2] | (src[3] << 8));
+			} else {
+				wav_buffer[i] = ((int16)src[1] - 128) * 256;
 			}
 		}
-		free(tmp_buffer);
+#endif
+		src += block;
 	}
-	return samples;
 }
 
 void DATAREC::save_wav_image()
@@ -514,67 +562,44 @@ int DATAREC::load_tap_image()
 		sample_rate = header[0] | (header[1] << 8) | (header[2] << 16) | (header[3] << 24);
 	}
 	
-	// load samples
-	int ptr = 0, data;
-	uint8 prev_data = 0;
-	while((data = fio->Fgetc()) != EOF) {
-		for(int i = 0, bit = 0x80; i < 8; i++, bit >>= 1) {
-			// inc pointer
-			bool prev_signal = ((prev_data & 0x80) != 0);
-			bool cur_signal = ((data & bit) != 0);
-			if(prev_signal != cur_signal || (prev_data & 0x7f) == 0x7f) {
-				if((prev_data & 0x7f) == 0) {
-					// don't inc pointer
-				} else {
-					ptr++;
-				}
-				prev_data = cur_signal ? 0x80 : 0;
-			}
-			// inc pulse count
-			prev_data++;
-			if(buffer != NULL) {
-				buffer[ptr] = prev_data;
-			}
-		}
+	// one bit for each sample, msb first
+	data_offset = fio->Ftell();
+	if(file_size <= data_offset) {
+		return 0;
+	}
+	tmp_buffer = (uint8 *)malloc(DATAREC_WINDOW_SIZE / 8 + 2);
+	return (file_size - data_offset) * 8;
+}
+
+void DATAREC::decode_tap_image(int ptr, int length)
+{
+	int top = ptr >> 3;
+	int bytes = ((ptr + length + 7) >> 3) - top;
+	
+	memset(tmp_buffer, 0, bytes);
+	fio->Fseek(data_offset + top, FILEIO_SEEK_SET);
+	fio->Fread(tmp_buffer, bytes, 1);
+	
+	for(int i = 0, bit = ptr & 7; i < length; i++, bit++) {
+		buffer[i] = (tmp_buffer[bit >> 3] & (0x80 >> (bit & 7))) ? 0xff : 0;
 	}
-	return (ptr + 1);
 }
 
 // SHARP MZ series tape image
 
-#define MZT_PUT_BIT(bit, len) { \
-	for(int l = 0; l < (len); l++) { \
-		if(buffer != NULL) { \
-			buffer[ptr++] = (bit) ? 0x98 : 0x8b; \
-			buffer[ptr++] = (bit) ? 0x1d : 0x0f; \
-		} else { \
-			ptr += 2; \
-		} \
-	} \
-}
+/*
+	each file is converted to the pulses below, they are generated
+	from the segments when the window is decoded
 
-#define MZT_PUT_BYTE(byte) { \
-	MZT_PUT_BIT(1, 1); \
-	for(int j = 0; j < 8; j++) { \
-		if((byte) & (0x80 >> j)) { \
-			MZT_PUT_BIT(1, 1); \
-			count++; \
-		} else { \
-			MZT_PUT_BIT(0, 1); \
-		} \
-	} \
-}
+	gap (10000 bits of 0), tape mark (40 bits of 1, 40 bits of 0), 1
+	header (128 bytes) and checksum, 1, 256 bits of 0
+	header (128 bytes) and checksum, 1
+	gap (10000 bits of 0), tape mark (20 bits of 1, 20 bits of 0), 1
+	data (size bytes) and checksum, 1
 
-#define MZT_PUT_BLOCK(buf, len) { \
-	int count = 0; \
-	for(int i = 0; i < (len); i++) { \
-		MZT_PUT_BYTE((buf)[i]); \
-	} \
-	uint8 hi = (count >> 8) & 0xff; \
-	uint8 lo = (count >> 0) & 0xff; \
-	MZT_PUT_BYTE(hi); \
-	MZT_PUT_BYTE(lo); \
-}
+	each byte starts with 1 and is followed by the bits from msb,
+	and the checksum is the number of 1 in the block
+*/
 
 int DATAREC::load_mzt_image()
 {
@@ -582,60 +607,143 @@ int DATAREC::load_mzt_image()
 	
 	// get file size
 	fio->Fseek(0, FILEIO_SEEK_END);
-	int file_size = fio->Ftell();
+	mzt_size = fio->Ftell();
 	fio->Fseek(0, FILEIO_SEEK_SET);
 	
-	// load mzt file
-	int ptr = 0;
-	while(file_size > 128) {
-		// load header
-		uint8 header[128], ram[0x20000];
-		fio->Fread(header, sizeof(header), 1);
-		file_size -= sizeof(header);
+	// the image is small, so keep it on memory
+	mzt_image = (uint8 *)malloc(mzt_size + 1);
+	fio->Fread(mzt_image, mzt_size, 1);
+	mzt_segments = (mzt_segment_t *)malloc(sizeof(mzt_segment_t) * (mzt_size / 128 + 1) * 15);
+	mzt_segment_count = 0;
+	
+	int ptr = 0, offset = 0;
+	while(mzt_size - offset > 128) {
+		uint8 *header = mzt_image + offset;
+		int size = header[0x12] | (header[0x13] << 8);
+		int first = mzt_segment_count;
 		
-		uint16 size = header[0x12] | (header[0x13] << 8);
-		uint16 offs = header[0x14] | (header[0x15] << 8);
-		memset(ram, 0, sizeof(ram));
-		fio->Fread(ram + offs, size, 1);
-		file_size -= size;
-#if 0
-		// apply mz700win patch
-		if(header[0x40] == 'P' && header[0x41] == 'A' && header[0x42] == 'T' && header[0x43] == ':') {
-			int patch_ofs = 0x44;
-			for(; patch_ofs < 0x80; ) {
-				uint16 patch_addr = header[patch_ofs] | (header[patch_ofs + 1] << 8);
-				patch_ofs += 2;
-				if(patch_addr == 0xffff) {
-					break;
-				}
-				int patch_len = header[patch_ofs++];
-				for(int i = 0; i < patch_len; i++) {
-					ram[patch_addr + i] = header[patch_ofs++];
+		add_mzt_segment(0, 10000, -1, 0, MZT_BLOCK_NONE);
+		add_mzt_segment(1, 40, -1, 0, MZT_BLOCK_NONE);
+		add_mzt_segment(0, 40, -1, 0, MZT_BLOCK_NONE);
+		add_mzt_segment(1, 1, -1, 0, MZT_BLOCK_NONE);
+		add_mzt_segment(0, 0, offset, 128, MZT_BLOCK_HEADER);
+		add_mzt_segment(1, 1, -1, 0, MZT_BLOCK_NONE);
+		add_mzt_segment(0, 256, -1, 0, MZT_BLOCK_NONE);
+		add_mzt_segment(0, 0, offset, 128, MZT_BLOCK_NONE);
+		add_mzt_segment(1, 1, -1, 0, MZT_BLOCK_NONE);
+		add_mzt_segment(0, 10000, -1, 0, MZT_BLOCK_NONE);
+		add_mzt_segment(1, 20, -1, 0, MZT_BLOCK_NONE);
+		add_mzt_segment(0, 20, -1, 0, MZT_BLOCK_NONE);
+		add_mzt_segment(1, 1, -1, 0, MZT_BLOCK_NONE);
+		add_mzt_segment(0, 0, offset + 128, size, MZT_BLOCK_DATA);
+		add_mzt_segment(1, 1, -1, 0, MZT_BLOCK_NONE);
+		
+		// fast load goes to the gap before the data, and to the next file
+		mzt_segment_t *last = &mzt_segments[mzt_segment_count - 1];
+		ptr = last->start + last->bits * 2;
+		mzt_segments[first + 4].next = mzt_segments[first + 9].start;
+		mzt_segments[first + 13].next = ptr;
+		
+		offset += 128 + size;
+	}
+	return ptr;
+}
+
+void DATAREC::add_mzt_segment(int bit, int bits, int data, int size, int type)
+{
+	mzt_segment_t *seg = &mzt_segments[mzt_segment_count];
+	
+	if(mzt_segment_count > 0) {
+		mzt_segment_t *prev = seg - 1;
+		seg->start = prev->start + prev->bits * 2;
+	} else {
+		seg->start = 0;
+	}
+	seg->data = data;
+	seg->size = size;
+	seg->type = type;
+	seg->next = 0;
+	seg->sum = 0;
+	
+	if(data >= 0) {
+		// the bytes after the end of file are 0
+		for(int i = 0; i < size && data + i < mzt_size; i++) {
+			for(uint8 d = mzt_image[data + i]; d; d >>= 1) {
+				seg->sum += d & 1;
+			}
+		}
+		seg->bit = -1;
+		seg->bits = (size + 2) * 9;
+	} else {
+		seg->bit = bit;
+		seg->bits = bits;
+	}
+	mzt_segment_count++;
+}
+
+void DATAREC::decode_mzt_image(int ptr, int length)
+{
+	// find the segment of the first pulse
+	int s = 0;
+	while(s + 1 < mzt_segment_count && mzt_segments[s + 1].start <= ptr) {
+		s++;
+	}
+	for(int i = 0; i < length; i++, ptr++) {
+		while(ptr >= mzt_segments[s].start + mzt_segments[s].bits * 2) {
+			s++;
+		}
+		mzt_segment_t *seg = &mzt_segments[s];
+		int bit = seg->bit;
+		
+		if(bit < 0) {
+			int index = (ptr - seg->start) >> 1;
+			int byte = index / 9, shift = index % 9;
+			if(shift == 0) {
+				bit = 1;	// start bit
+			} else {
+				uint8 data;
+				if(byte < seg->size) {
+					data = (seg->data + byte < mzt_size) ? mzt_image[seg->data + byte] : 0;
+				} else if(byte == seg->size) {
+					data = (uint8)(seg->sum >> 8);
+				} else {
+					data = (uint8)(seg->sum & 0xff);
 				}
+				bit = (data >> (8 - shift)) & 1;
+			}
+		}
+		if(ptr & 1) {
+			buffer[i] = bit ? 0x1d : 0x0f;
+		} else {
+			buffer[i] = bit ? 0x98 : 0x8b;
+		}
+	}
+}
+
+// fast load: copy the next header or data block to the memory instead of the pulses,
+// and move the tape to the end of the block
+
+bool DATAREC::read_mzt_block(bool header, uint8* dst, int size)
+{
+	if(!play || image_type != IMAGE_MZT) {
+		return false;
+	}
+	for(int s = 0; s < mzt_segment_count; s++) {
+		mzt_segment_t *seg = &mzt_segments[s];
+		if(seg->type == (header ? MZT_BLOCK_HEADER : MZT_BLOCK_DATA) && seg->start >= buffer_ptr) {
+			if(seg->size != size) {
+				return false;
 			}
-			for(int i = 0x40; i < patch_ofs; i++) {
-				header[i] = 0;
+			for(int i = 0; i < size; i++) {
+				dst[i] = (seg->data + i < mzt_size) ? mzt_image[seg->data + i] : 0;
 			}
+			buffer_ptr = seg->next;
+			pulse_count = -1;
+			update_event();
+			return true;
 		}
-#endif
-		// output to buffer
-		MZT_PUT_BIT(0, 10000);
-		MZT_PUT_BIT(1, 40);
-		MZT_PUT_BIT(0, 40);
-		MZT_PUT_BIT(1, 1);
-		MZT_PUT_BLOCK(header, 128);
-		MZT_PUT_BIT(1, 1);
-		MZT_PUT_BIT(0, 256);
-		MZT_PUT_BLOCK(header, 128);
-		MZT_PUT_BIT(1, 1);
-		MZT_PUT_BIT(0, 10000);
-		MZT_PUT_BIT(1, 20);
-		MZT_PUT_BIT(0, 20);
-		MZT_PUT_BIT(1, 1);
-		MZT_PUT_BLOCK(ram + offs, size);
-		MZT_PUT_BIT(1, 1);
 	}
-	return ptr;
+	return false;
 }
 
 #ifdef DATAREC_SOUND
@@ -21,6 +21,19 @@
 class FILEIO;
 
 #define DATAREC_BUFFER_SIZE 0x800000
+#define DATAREC_WINDOW_SIZE 0x10000
+
+// part of mzt image that is converted to the pulses
+typedef struct {
+	int start;	// first pulse
+	int bits;	// number of bits, 2 pulses for each bit
+	int bit;	// value of all bits, or -1 for data block
+	int data;	// data block: offset in image, size and checksum
+	int size;
+	uint16 sum;
+	int type;	// header or data block to load fast, and the pulse to go after it
+	int next;
+} mzt_segment_t;
 
 class DATAREC : public DEVICE
 {
@@ -48,6 +61,18 @@ private:
 	int buffer_ptr, buffer_length;
 	bool is_wav;
 	
+	// the image is not decoded at once when it is opened,
+	// only the samples or pulses in the window are decoded to buffer
+	int image_type;
+	int window_ptr, window_length;
+	int pulse_count;
+	uint8* tmp_buffer;
+	int data_offset, wav_channels, wav_bits;
+	uint8* mzt_image;
+	int mzt_size;
+	mzt_segment_t* mzt_segments;
+	int mzt_segment_count;
+	
 #ifdef DATAREC_SOUND
 	int16 *mix_buffer;
 	int mix_buffer_ptr, mix_buffer_length;
@@ -55,11 +80,23 @@ private:
 	void update_event();
 	void close_file();
 	
+	uint8 get_sample(int ptr) {
+		if(ptr < window_ptr || ptr >= window_ptr + window_length) {
+			load_window(ptr);
+		}
+		return buffer[ptr - window_ptr];
+	}
+	void load_window(int ptr);
+	
 	int load_cas_image();
 	int load_wav_image();
+	void decode_wav_image(int ptr, int length);
 	void save_wav_image();
 	int load_tap_image();
+	void decode_tap_image(int ptr, int length);
 	int load_mzt_image();
+	void add_mzt_segment(int bit, int bits, int data, int size, int type);
+	void decode_mzt_image(int ptr, int length);
 	
 public:
 	DATAREC(VM* parent_vm, EMU* parent_emu) : DEVICE(parent_vm, parent_emu) {
@@ -110,6 +147,7 @@ public:
 	}
 	void set_remote(bool value);
 	void set_ff_rew(int value);
+	bool read_mzt_block(bool header, uint8* dst, int size);
 #ifdef DATAREC_SOUND
 	void initialize_sound(int rate, int samples);
 #endif
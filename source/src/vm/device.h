@@ -56,7 +56,9 @@ public:
 	
 	virtual void update_config() {}
 	virtual void save_state(FILEIO* fio) {}
-	virtual void load_state(FILEIO* fio) {}
+	virtual bool load_state(FILEIO* fio) {
+		return true;
+	}
 	
 	// control
 	virtual void reset() {}
@@ -132,6 +134,19 @@ public:
 	virtual uint32 fetch_op(uint32 addr, int *wait) {
 		return read_data8w(addr, wait);
 	}
+	// memory device may export the tables of the bank pointers for the direct access by cpu.
+	// the tables must not be moved, the banks must have no wait and no side effect,
+	// and NULL bank is accessed through read_data8/write_data8
+	virtual uint8** get_read_bank_table(int* shift) {
+		return NULL;
+	}
+	virtual uint8** get_write_bank_table(int* shift) {
+		return NULL;
+	}
+	// address mask of the tables for the cpu with the wider address bus
+	virtual uint32 get_bank_table_addr_mask() {
+		return 0xffff;
+	}
 	virtual void write_dma_data8(uint32 addr, uint32 data) {
 		write_data8(addr, data);
 	}
@@ -379,6 +394,13 @@ public:
 	virtual uint32 get_pc() {
 		return 0;
 	}
+	virtual int get_run_clock() {
+		// clocks passed in the current run() before the current opecode
+		return 0;
+	}
+	virtual void stop_run() {
+		// end the current run() after the current opecode
+	}
 	
 	// bios
 	virtual bool bios_call(uint32 PC, uint16 regs[], uint16 sregs[], int32* ZeroFlag, int32* CarryFlag) {
@@ -418,6 +440,20 @@ public:
 		}
 		event_manager->cancel_event(register_id);
 	}
+	virtual void set_fine_sync(bool fine) {
+		// request to run primary cpu one opecode at a time while fine is true
+		if(event_manager == NULL) {
+			event_manager = vm->first_device->next_device;
+		}
+		event_manager->set_fine_sync(fine);
+	}
+	virtual void set_sync_point() {
+		// request to run cpus in the short quantum while they interact
+		if(event_manager == NULL) {
+			event_manager = vm->first_device->next_device;
+		}
+		event_manager->set_sync_point();
+	}
 	virtual void register_frame_event(DEVICE* device) {
 		if(event_manager == NULL) {
 			event_manager = vm->first_device->next_device;
@@ -471,6 +507,10 @@ public:
 	
 	// sound
 	virtual void mix(int32* buffer, int cnt) {}
+	// true if the device queues the register writes and mixes the whole frame at once
+	virtual bool mix_per_frame() {
+		return false;
+	}
 	
 	DEVICE* prev_device;
 	DEVICE* next_device;
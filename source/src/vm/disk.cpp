@@ -71,11 +71,19 @@ static const int secsize[8] = {
 	128, 256, 512, 1024, 2048, 4096, 8192, 16384
 };
 
-static uint8 tmp_buffer[DISK_BUFFER_SIZE];
-
 DISK::DISK()
 {
 	inserted = ejected = write_protected = changed = false;
+	fi = NULL;
+	buffer = NULL;
+	buffer_size = 0;
+	block_loaded = NULL;
+	block_crc32 = NULL;
+	block_num = 0;
+	for(int i = 0; i < 164; i++) {
+		track_index[i].built = false;
+		track_index[i].sectors = NULL;
+	}
 	file_size = 0;
 	track_size = 0x1800;
 	sector_size = sector_num = 0;
@@ -118,11 +126,10 @@ void DISK::open(_TCHAR path[], int offset)
 	// open disk image
 	fi = new FILEIO();
 	if(fi->Fopen(path, FILEIO_READ_BINARY)) {
-		bool converted = false;
-		
 		_tcscpy(file_path, path);
 		_stprintf(tmp_path, _T("%s.$$$"), path);
-		temporary = false;
+		temporary = converted = false;
+		bool on_demand = false;
 		
 		// check if file protected
 		write_protected = fi->IsProtected(path);
@@ -134,10 +141,13 @@ void DISK::open(_TCHAR path[], int offset)
 			file_size |= fi->Fgetc() << 8;
 			file_size |= fi->Fgetc() << 16;
 			file_size |= fi->Fgetc() << 24;
-			fi->Fseek(offset, FILEIO_SEEK_SET);
-			fi->Fread(buffer, file_size, 1);
 			file_offset = offset;
-			inserted = changed = true;
+			if(file_size > 0) {
+				// the tracks will be read when they are accessed
+				alloc_buffer(file_size);
+				init_blocks(false);
+				inserted = changed = on_demand = true;
+			}
 			goto file_loaded;
 		}
 		
@@ -163,12 +173,13 @@ void DISK::open(_TCHAR path[], int offset)
 				}
 			}
 		}
-		if(0 < file_size && file_size <= DISK_BUFFER_SIZE) {
-			memset(buffer, 0, sizeof(buffer));
+		if(0 < file_size) {
+			alloc_buffer(file_size);
 			fi->Fread(buffer, file_size, 1);
 			
 			// check d88 format (temporary)
-			if(*(uint32 *)(buffer + 0x1c) == file_size) {
+			if(file_size >= 0x20 && *(uint32 *)(buffer + 0x1c) == file_size) {
+				init_blocks(true);
 				inserted = changed = true;
 				goto file_loaded;
 			}
@@ -198,54 +209,194 @@ void DISK::open(_TCHAR path[], int offset)
 			}
 		}
 file_loaded:
-		if(fi->IsOpened()) {
-			fi->Fclose();
-		}
 		if(temporary) {
+			fi->Fclose();
 			fi->Remove(tmp_path);
 		}
-		if(inserted) {
-			if(converted) {
-				// write image
-				FILEIO* fio = new FILEIO();
-				if(fio->Fopen(file_path, FILEIO_WRITE_BINARY)) {
-					fio->Fwrite(buffer, file_size, 1);
-					fio->Fclose();
-				}
-				delete fio;
+		if(inserted && converted) {
+			// the converted image is written to the file when it is changed
+			file_offset = 0;
+			init_blocks(true);
+		}
+		uint8* hdr = inserted ? get_data(0, 0x20) : NULL;
+		if(hdr == NULL) {
+			inserted = changed = false;
+		}
+		else {
+			if(hdr[0x1a] != 0) {
+				write_protected = true;
 			}
-			crc32 = getcrc32(buffer, file_size);
+			media_type = hdr[0x1b];
+		}
+		if(inserted && on_demand) {
+			// keep the image file opened to read the blocks
+			return;
 		}
-		if(buffer[0x1a] != 0) {
-			write_protected = true;
+		if(fi->IsOpened()) {
+			fi->Fclose();
 		}
-		media_type = buffer[0x1b];
 	}
 	delete fi;
+	fi = NULL;
+	
+	if(!inserted) {
+		close();
+	}
 }
 
 void DISK::close()
 {
 	// write disk image
 	if(inserted) {
-		if(!write_protected && file_size && getcrc32(buffer, file_size) != crc32) {
-			// write image
-			FILEIO* fio = new FILEIO();
-			if(fio->Fopen(file_path, FILEIO_READ_WRITE_BINARY)) {
-				fio->Fseek(file_offset, FILEIO_SEEK_SET);
-				fio->Fwrite(buffer, file_size, 1);
-				fio->Fclose();
-			}
-			delete fio;
+		if(!write_protected && file_size) {
+			write_blocks();
 		}
 		ejected = true;
 	}
+	if(fi != NULL) {
+		if(fi->IsOpened()) {
+			fi->Fclose();
+		}
+		delete fi;
+		fi = NULL;
+	}
+	if(buffer != NULL) {
+		free(buffer);
+		buffer = NULL;
+	}
+	if(block_loaded != NULL) {
+		free(block_loaded);
+		block_loaded = NULL;
+	}
+	if(block_crc32 != NULL) {
+		free(block_crc32);
+		block_crc32 = NULL;
+	}
+	buffer_size = block_num = 0;
+	clear_track_index();
 	inserted = write_protected = false;
 	file_size = 0;
 	sector_size = sector_num = 0;
 	sector = NULL;
 }
 
+void DISK::alloc_buffer(int size)
+{
+	// the buffer is extended while the image is converted
+	if(size > buffer_size) {
+		int new_size = (buffer_size > 0) ? buffer_size : DISK_BLOCK_SIZE;
+		while(new_size < size) {
+			new_size *= 2;
+		}
+		if(buffer == NULL) {
+			buffer = (uint8*)calloc(new_size, 1);
+		}
+		else {
+			buffer = (uint8*)realloc(buffer, new_size);
+			memset(buffer + buffer_size, 0, new_size - buffer_size);
+		}
+		buffer_size = new_size;
+	}
+}
+
+void DISK::init_blocks(bool loaded)
+{
+	block_num = (file_size + DISK_BLOCK_SIZE - 1) / DISK_BLOCK_SIZE;
+	if(block_loaded != NULL) {
+		free(block_loaded);
+	}
+	if(block_crc32 != NULL) {
+		free(block_crc32);
+	}
+	block_loaded = (uint8*)calloc(block_num, 1);
+	block_crc32 = (uint32*)calloc(block_num, sizeof(uint32));
+	
+	if(loaded) {
+		// the whole image is already in the buffer
+		for(int i = 0; i < block_num; i++) {
+			int ofs = i * DISK_BLOCK_SIZE;
+			block_crc32[i] = getcrc32(buffer + ofs, get_block_size(i));
+			block_loaded[i] = 1;
+		}
+	}
+}
+
+uint8* DISK::get_data(uint32 offset, int size)
+{
+	// check the range in the image
+	if(offset >= (uint32)file_size || size > file_size - (int)offset) {
+		return NULL;
+	}
+	if(size > 0) {
+		for(int i = offset / DISK_BLOCK_SIZE; i <= (int)((offset + size - 1) / DISK_BLOCK_SIZE); i++) {
+			if(!block_loaded[i]) {
+				// read the block from the image file
+				int ofs = i * DISK_BLOCK_SIZE;
+				int len = get_block_size(i);
+				if(fi != NULL) {
+					fi->Fseek(file_offset + ofs, FILEIO_SEEK_SET);
+					fi->Fread(buffer + ofs, len, 1);
+				}
+				block_crc32[i] = getcrc32(buffer + ofs, len);
+				block_loaded[i] = 1;
+			}
+		}
+	}
+	return buffer + offset;
+}
+
+uint8* DISK::get_sector_data(uint32 offset)
+{
+	// read the sector header and the sector data
+	uint8* t = get_data(offset, 0x10);
+	if(t != NULL) {
+		t = get_data(offset, 0x10 + (t[0xe] | (t[0xf] << 8)));
+	}
+	return t;
+}
+
+void DISK::write_blocks()
+{
+	// check the blocks changed after they are read
+	bool dirty = false;
+	for(int i = 0; i < block_num; i++) {
+		int ofs = i * DISK_BLOCK_SIZE;
+		if(block_loaded[i] && getcrc32(buffer + ofs, get_block_size(i)) != block_crc32[i]) {
+			block_loaded[i] = 2;
+			dirty = true;
+		}
+	}
+	if(!dirty) {
+		return;
+	}
+	FILEIO* fio = new FILEIO();
+	if(converted) {
+		// write the whole converted image
+		if(fio->Fopen(file_path, FILEIO_WRITE_BINARY)) {
+			fio->Fwrite(buffer, file_size, 1);
+			fio->Fclose();
+		}
+	}
+	else if(fio->Fopen(file_path, FILEIO_READ_WRITE_BINARY)) {
+		// write the changed blocks, and the adjacent ones at once
+		for(int i = 0; i < block_num;) {
+			if(block_loaded[i] != 2) {
+				i++;
+				continue;
+			}
+			int start = i;
+			while(i < block_num && block_loaded[i] == 2) {
+				i++;
+			}
+			int ofs = start * DISK_BLOCK_SIZE;
+			fio->Fseek(file_offset + ofs, FILEIO_SEEK_SET);
+			fio->Fwrite(buffer + ofs, (i - 1 - start) * DISK_BLOCK_SIZE + get_block_size(i - 1), 1);
+		}
+		fio->Fclose();
+	}
+	delete fio;
+}
+
 bool DISK::get_track(int trk, int side)
 {
 	sector_size = sector_num = 0;
@@ -256,26 +407,20 @@ bool DISK::get_track(int trk, int side)
 	}
 	
 	// search track
-	int trkside = trk * 2 + (side & 1);
-	if(!(0 <= trkside && trkside < 164)) {
-		return false;
-	}
-	uint32 offset = buffer[0x20 + trkside * 4 + 0];
-	offset |= buffer[0x20 + trkside * 4 + 1] << 8;
-	offset |= buffer[0x20 + trkside * 4 + 2] << 16;
-	offset |= buffer[0x20 + trkside * 4 + 3] << 24;
-	
-	if(!offset) {
+	track_index_t* index_t = get_track_index(trk, side);
+	if(index_t == NULL) {
 		return false;
 	}
 	
 	// track found
-	uint8* t = buffer + offset;
-	sector_num = t[4] | (t[5] << 8);
+	sector_num = index_t->sector_num;
 	
 	for(int i = 0; i < sector_num; i++) {
-		verify[i] = t[0];
-		t += (t[0xe] | (t[0xf] << 8)) + 0x10;
+		if(i >= index_t->index_num) {
+			sector_num = i;
+			break;
+		}
+		verify[i] = index_t->sectors[i].id[0];
 	}
 	return true;
 }
@@ -290,22 +435,17 @@ bool DISK::make_track(int trk, int side)
 	}
 	
 	// search track
-	int trkside = trk * 2 + (side & 1);
-	if(!(0 <= trkside && trkside < 164)) {
+	track_index_t* index_t = get_track_index(trk, side);
+	if(index_t == NULL) {
 		return false;
 	}
-	uint32 offset = buffer[0x20 + trkside * 4 + 0];
-	offset |= buffer[0x20 + trkside * 4 + 1] << 8;
-	offset |= buffer[0x20 + trkside * 4 + 2] << 16;
-	offset |= buffer[0x20 + trkside * 4 + 3] << 24;
 	
-	if(!offset) {
+	// get verify info
+	uint8* t = get_sector_data(index_t->offset);
+	if(t == NULL) {
 		return false;
 	}
-	
-	// get verify info
-	uint8* t = buffer + offset;
-	sector_num = t[4] | (t[5] << 8);
+	sector_num = index_t->sector_num;
 	bool mfm = (t[6] == 0);
 	
 	track_size = (media_type == MEDIA_TYPE_2HD) ? 12500 : mfm ? 6250 : 3100;
@@ -338,6 +478,11 @@ bool DISK::make_track(int trk, int side)
 	}
 	// sectors
 	for(int i = 0; i < sector_num; i ++) {
+		if(i >= index_t->index_num) {
+			break;
+		}
+		sector_index_t* index_s = &index_t->sectors[i];
+		t = buffer + index_s->offset;
 		// sync
 		for(int j = 0; j < sync_size; j++) {
 			track[p++] = 0;
@@ -347,17 +492,9 @@ bool DISK::make_track(int trk, int side)
 			track[p++] = 0xa1;
 		}
 		track[p++] = 0xfe;
-		track[p++] = t[0];
-		track[p++] = t[1];
-		track[p++] = t[2];
-		track[p++] = t[3];
-		uint16 crc = 0;
-		crc = (uint16)((crc << 8) ^ crc_table[(uint8)(crc >> 8) ^ t[0]]);
-		crc = (uint16)((crc << 8) ^ crc_table[(uint8)(crc >> 8) ^ t[1]]);
-		crc = (uint16)((crc << 8) ^ crc_table[(uint8)(crc >> 8) ^ t[2]]);
-		crc = (uint16)((crc << 8) ^ crc_table[(uint8)(crc >> 8) ^ t[3]]);
-		track[p++] = crc >> 8;
-		track[p++] = crc & 0xff;
+		for(int j = 0; j < 6; j++) {
+			track[p++] = index_s->id[j];
+		}
 		// gap2
 		for(int j = 0; j < gap2_size; j++) {
 			track[p++] = gap_data;
@@ -376,16 +513,17 @@ bool DISK::make_track(int trk, int side)
 			track_offset = p;
 		}
 		int size = t[0xe] | (t[0xf] << 8);
-		crc = 0;
+		uint16 crc = 0;
 		for(int j = 0; j < size; j++) {
 			track[p++] = t[0x10 + j];
 			crc = (uint16)((crc << 8) ^ crc_table[(uint8)(crc >> 8) ^ t[0x10 + j]]);
 		}
 		track[p++] = crc >> 8;
 		track[p++] = crc & 0xff;
-		t += size + 0x10;
 		// gap3
-		int gap3_size = (t[3] == 1) ? 27 : (t[3] == 2) ? 42 : 58;
+		uint8* next = get_data(index_s->offset + size + 0x10, 4);
+		uint8 n = (next != NULL) ? next[3] : 0;
+		int gap3_size = (n == 1) ? 27 : (n == 2) ? 42 : 58;
 		for(int j = 0; j < gap3_size; j++) {
 			track[p++] = gap_data;
 		}
@@ -410,44 +548,24 @@ bool DISK::get_sector(int trk, int side, int index)
 	}
 	
 	// search track
-	int trkside = trk * 2 + (side & 1);
-	if(!(0 <= trkside && trkside < 164)) {
-		return false;
-	}
-	uint32 offset = buffer[0x20 + trkside * 4 + 0];
-	offset |= buffer[0x20 + trkside * 4 + 1] << 8;
-	offset |= buffer[0x20 + trkside * 4 + 2] << 16;
-	offset |= buffer[0x20 + trkside * 4 + 3] << 24;
-	
-	if(!offset) {
+	track_index_t* index_t = get_track_index(trk, side);
+	if(index_t == NULL) {
 		return false;
 	}
 	
 	// track found
-	uint8* t = buffer + offset;
-	sector_num = t[4] | (t[5] << 8);
+	sector_num = index_t->sector_num;
 	
-	if(index >= sector_num) {
+	if(index >= sector_num || index >= index_t->index_num) {
 		return false;
 	}
 	
-	// skip sector
-	for(int i = 0; i < index; i++) {
-		t += (t[0xe] | (t[0xf] << 8)) + 0x10;
-	}
+	// sector found
+	sector_index_t* index_s = &index_t->sectors[index];
+	uint8* t = buffer + index_s->offset;
 	
 	// header info
-	id[0] = t[0];
-	id[1] = t[1];
-	id[2] = t[2];
-	id[3] = t[3];
-	uint16 crc = 0;
-	crc = (uint16)((crc << 8) ^ crc_table[(uint8)(crc >> 8) ^ t[0]]);
-	crc = (uint16)((crc << 8) ^ crc_table[(uint8)(crc >> 8) ^ t[1]]);
-	crc = (uint16)((crc << 8) ^ crc_table[(uint8)(crc >> 8) ^ t[2]]);
-	crc = (uint16)((crc << 8) ^ crc_table[(uint8)(crc >> 8) ^ t[3]]);
-	id[4] = crc >> 8;
-	id[5] = crc & 0xff;
+	memcpy(id, index_s->id, 6);
 	density = t[6];
 	deleted = t[7];
 	status = t[8];
@@ -457,6 +575,70 @@ bool DISK::get_sector(int trk, int side, int index)
 	return true;
 }
 
+DISK::track_index_t* DISK::get_track_index(int trk, int side)
+{
+	int trkside = trk * 2 + (side & 1);
+	if(!(0 <= trkside && trkside < 164)) {
+		return NULL;
+	}
+	track_index_t* index_t = &track_index[trkside];
+	
+	if(!index_t->built) {
+		// make the sector index when the track is accessed first
+		index_t->built = true;
+		index_t->found = false;
+		index_t->sector_num = index_t->index_num = 0;
+		
+		uint8* ptr = get_data(0x20 + trkside * 4, 4);
+		if(ptr == NULL) {
+			return NULL;
+		}
+		uint32 offset = ptr[0] | (ptr[1] << 8) | (ptr[2] << 16) | (ptr[3] << 24);
+		uint8* t;
+		if(!offset || (t = get_data(offset, 0x10)) == NULL) {
+			return NULL;
+		}
+		index_t->found = true;
+		index_t->offset = offset;
+		index_t->sector_num = t[4] | (t[5] << 8);
+		index_t->sectors = (sector_index_t*)malloc(sizeof(sector_index_t) * index_t->sector_num);
+		
+		for(int i = 0; i < index_t->sector_num; i++) {
+			// the sector data is also read from the image file here
+			if((t = get_sector_data(offset)) == NULL) {
+				break;
+			}
+			sector_index_t* index_s = &index_t->sectors[i];
+			index_s->offset = offset;
+			index_s->id[0] = t[0];
+			index_s->id[1] = t[1];
+			index_s->id[2] = t[2];
+			index_s->id[3] = t[3];
+			uint16 crc = 0;
+			crc = (uint16)((crc << 8) ^ crc_table[(uint8)(crc >> 8) ^ t[0]]);
+			crc = (uint16)((crc << 8) ^ crc_table[(uint8)(crc >> 8) ^ t[1]]);
+			crc = (uint16)((crc << 8) ^ crc_table[(uint8)(crc >> 8) ^ t[2]]);
+			crc = (uint16)((crc << 8) ^ crc_table[(uint8)(crc >> 8) ^ t[3]]);
+			index_s->id[4] = crc >> 8;
+			index_s->id[5] = crc & 0xff;
+			index_t->index_num++;
+			offset += (t[0xe] | (t[0xf] << 8)) + 0x10;
+		}
+	}
+	return index_t->found ? index_t : NULL;
+}
+
+void DISK::clear_track_index()
+{
+	for(int i = 0; i < 164; i++) {
+		if(track_index[i].sectors != NULL) {
+			free(track_index[i].sectors);
+			track_index[i].sectors = NULL;
+		}
+		track_index[i].built = false;
+	}
+}
+
 bool DISK::check_media_type()
 {
 	switch(drive_type) {
@@ -485,9 +667,7 @@ bool DISK::check_media_type()
 */
 
 #define COPYBUFFER(src, size) { \
-	if(file_size + (size) > DISK_BUFFER_SIZE) { \
-		return false; \
-	} \
+	alloc_buffer(file_size + (size)); \
 	memcpy(buffer + file_size, (src), (size)); \
 	file_size += (size); \
 }
@@ -637,7 +817,9 @@ bool DISK::teledisk_to_d88()
 			trkptr += sizeof(d88_sct_t) + d88_sct.size;
 		}
 		// read next track
-		fi->Fread(&trk, sizeof(td_trk_t), 1);
+		if(fi->Fread(&trk, sizeof(td_trk_t), 1) != 1) {
+			return false;
+		}
 	}
 	d88_hdr.type = ((hdr.dens & 3) == 2) ? MEDIA_TYPE_2HD : ((trkcnt >> 1) > 60) ? MEDIA_TYPE_2DD : MEDIA_TYPE_2D;
 	d88_hdr.size = trkptr;
@@ -980,7 +1162,9 @@ bool DISK::cpdread_to_d88(int extended)
 	int t = 0;
 	
 	// get cylinder number and side number
-	memcpy(tmp_buffer, buffer, file_size);
+	int tmp_size = file_size;
+	uint8* tmp_buffer = (uint8*)malloc(tmp_size);
+	memcpy(tmp_buffer, buffer, tmp_size);
 	int ncyl = tmp_buffer[0x30];
 	int nside = tmp_buffer[0x31];
 	
@@ -1007,6 +1191,10 @@ bool DISK::cpdread_to_d88(int extended)
 			}
 			
 			// read sectors in this track
+			if(trkofs + 0x100 > tmp_size) {
+				free(tmp_buffer);
+				return false;
+			}
 			uint8 *track_info = tmp_buffer + trkofs;
 			int nsec = track_info[0x15];
 			int size = 1 << (track_info[0x14] + 7); // standard
@@ -1032,6 +1220,10 @@ bool DISK::cpdread_to_d88(int extended)
 				d88_sct.size = size;
 				
 				// copy to d88
+				if(sctofs + size > tmp_size) {
+					free(tmp_buffer);
+					return false;
+				}
 				COPYBUFFER(&d88_sct, sizeof(d88_sct_t));
 				COPYBUFFER(tmp_buffer + sctofs, size);
 				trkptr += sizeof(d88_sct_t) + size;
@@ -1048,6 +1240,7 @@ bool DISK::cpdread_to_d88(int extended)
 	}
 	d88_hdr.size = trkptr;
 	memcpy(buffer, &d88_hdr, sizeof(d88_hdr_t));
+	free(tmp_buffer);
 	return true;
 }
 
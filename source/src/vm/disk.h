@@ -26,7 +26,7 @@
 
 
 // d88 constant
-#define DISK_BUFFER_SIZE	0x180000	// 1.5MB
+#define DISK_BLOCK_SIZE		0x1000		// 4KB
 #define TRACK_BUFFER_SIZE	0x8000		// 32KB
 
 // teledisk decoder constant
@@ -44,14 +44,47 @@ class DISK
 {
 private:
 	FILEIO* fi;
-	uint8 buffer[DISK_BUFFER_SIZE];
+	uint8* buffer;
+	int buffer_size;
 	_TCHAR file_path[_MAX_PATH];
 	_TCHAR tmp_path[_MAX_PATH];
 	int file_size;
 	int file_offset;
-	uint32 crc32;
 	bool temporary;
+	bool converted;
 	
+	// the d88 image file is read block by block when the tracks are accessed,
+	// and only the blocks changed after they are read are written back
+	uint8* block_loaded;
+	uint32* block_crc32;
+	int block_num;
+	
+	void alloc_buffer(int size);
+	void init_blocks(bool loaded);
+	uint8* get_data(uint32 offset, int size);
+	int get_block_size(int index) {
+		return (index < block_num - 1) ? DISK_BLOCK_SIZE : file_size - index * DISK_BLOCK_SIZE;
+	}
+	uint8* get_sector_data(uint32 offset);
+	void write_blocks();
+	
+	// the offsets and the ids of the sectors are indexed when the track is
+	// accessed first, and the index is cleared when the disk is ejected
+	typedef struct {
+		uint32 offset;
+		uint8 id[6];
+	} sector_index_t;
+	typedef struct {
+		bool built, found;
+		uint32 offset;
+		int sector_num;
+		int index_num;
+		sector_index_t* sectors;
+	} track_index_t;
+	track_index_t track_index[164];
+	
+	track_index_t* get_track_index(int trk, int side);
+	void clear_track_index();
 	bool check_media_type();
 	
 	// teledisk image decoder (td0)
@@ -16,6 +16,8 @@
 //#endif
 #endif
 
+#define STATE_VERSION	3
+
 void EVENT::initialize()
 {
 	// load config
@@ -23,6 +25,11 @@ void EVENT::initialize()
 		config.cpu_power = 0;
 	}
 	power = config.cpu_power;
+	if(!(0 <= config.cpu_quantum && config.cpu_quantum <= MAX_CPU_QUANTUM)) {
+		config.cpu_quantum = 0;
+	}
+	max_cpu_quantum = config.cpu_quantum ? config.cpu_quantum : DEFAULT_CPU_QUANTUM;
+	cpu_quantum = max_cpu_quantum;
 	
 	// initialize sound buffer
 	sound_buffer = NULL;
@@ -43,7 +50,7 @@ void EVENT::initialize_sound(int rate, int samples)
 	memset(sound_buffer, 0, sound_samples * sizeof(uint16) * 2);
 	sound_tmp = (int32*)malloc(sound_tmp_samples * sizeof(int32) * 2);
 	memset(sound_tmp, 0, sound_tmp_samples * sizeof(int32) * 2);
-	buffer_ptr = accum_samples = 0;
+	buffer_ptr = block_ptr = accum_samples = 0;
 }
 
 void EVENT::release()
@@ -68,6 +75,8 @@ void EVENT::reset()
 	
 	event_remain = 0;
 	cpu_remain = cpu_accum = cpu_done = 0;
+	cpu_quantum = max_cpu_quantum;
+	sync_hold = 0;
 	
 	// reset sound
 	if(sound_buffer) {
@@ -141,28 +150,55 @@ void EVENT::drive()
 		while(event_remain > 0) {
 			int event_done = event_remain;
 			if(cpu_remain > 0) {
-				// run one opecode on primary cpu
 				int cpu_done_tmp;
-				if(dcount_cpu == 1) {
+				if(dcount_cpu == 1 && fine_sync_count == 0) {
+					// run primary cpu until the next event is expired
+					int event_clock = event_remain;
+					if(fire_count != 0 && fire_heap[0]->expired_clock < event_clocks + event_clock) {
+						event_clock = (int)(fire_heap[0]->expired_clock - event_clocks);
+					}
+					int cpu_clock = (event_clock << power) - cpu_accum;
+					if(cpu_clock > cpu_remain) {
+						cpu_clock = cpu_remain;
+					}
+					cpu_done_tmp = run_primary_cpu(event_clock, cpu_clock);
+				}
+				else if(dcount_cpu == 1) {
+					// some device requests to sync every opecode
 					cpu_done_tmp = d_cpu[0].device->run(-1);
 				}
+				else if(fine_sync_count == 0 && cpu_done == 0 && max_cpu_quantum > MIN_CPU_QUANTUM) {
+					// run primary cpu ahead for the quantum, and sub cpus follow it
+					int event_clock = event_remain;
+					if(fire_count != 0 && fire_heap[0]->expired_clock < event_clocks + event_clock) {
+						event_clock = (int)(fire_heap[0]->expired_clock - event_clocks);
+					}
+					int cpu_clock = (event_clock << power) - cpu_accum;
+					if(cpu_clock > cpu_remain) {
+						cpu_clock = cpu_remain;
+					}
+					if(cpu_clock > cpu_quantum) {
+						cpu_clock = cpu_quantum;
+					}
+					cpu_done_tmp = run_primary_cpu(event_clock, cpu_clock);
+					run_sub_cpus(cpu_done_tmp);
+					
+					// widen the quantum while no device marks the sync point
+					if(sync_hold > 0) {
+						sync_hold--;
+					}
+					else if(cpu_quantum < max_cpu_quantum) {
+						cpu_quantum = (cpu_quantum << 1 < max_cpu_quantum) ? cpu_quantum << 1 : max_cpu_quantum;
+					}
+				}
 				else {
-					// sync to sub cpus
+					// sync to sub cpus every 4 clocks
 					if(cpu_done == 0) {
 						cpu_done = d_cpu[0].device->run(-1);
 					}
 					cpu_done_tmp = (cpu_done < 4) ? cpu_done : 4;
 					cpu_done -= cpu_done_tmp;
-					
-					for(int i = 1; i < dcount_cpu; i++) {
-						// run sub cpus
-						d_cpu[i].accum_clocks += d_cpu[i].update_clocks * cpu_done_tmp;
-						int sub_clock = d_cpu[i].accum_clocks >> 10;
-						if(sub_clock) {
-							d_cpu[i].accum_clocks -= sub_clock << 10;
-							d_cpu[i].device->run(sub_clock);
-						}
-					}
+					run_sub_cpus(cpu_done_tmp);
 				}
 				cpu_remain -= cpu_done_tmp;
 				cpu_accum += cpu_done_tmp;
@@ -181,24 +217,24 @@ void EVENT::drive()
 		}
 		update_sound();
 	}
+	mix_sound_block();
 }
 
 void EVENT::update_event(int clock)
 {
 	uint64 event_clocks_tmp = event_clocks + clock;
 	
-	while(first_fire_event != NULL && first_fire_event->expired_clock <= event_clocks_tmp) {
-		event_t *event_handle = first_fire_event;
+	while(fire_count != 0 && fire_heap[0]->expired_clock <= event_clocks_tmp) {
+		event_t *event_handle = fire_heap[0];
 		
-		first_fire_event = event_handle->next;
-		if(first_fire_event != NULL) {
-			first_fire_event->prev = NULL;
-		}
 		if(event_handle->loop_clock != 0) {
+			// move the loop event to the next period without removing it from heap
 			event_handle->expired_clock += event_handle->loop_clock;
-			insert_event(event_handle);
+			event_handle->order = fire_order++;
+			heap_down(0);
 		}
 		else {
+			remove_event(event_handle);
 			event_handle->active = false;
 			event_handle->next = first_free_event;
 			first_free_event = event_handle;
@@ -211,7 +247,7 @@ void EVENT::update_event(int clock)
 
 uint32 EVENT::current_clock()
 {
-	return (uint32)(event_clocks & 0xffffffff);
+	return (uint32)(get_event_clocks() & 0xffffffff);
 }
 
 uint32 EVENT::passed_clock(uint32 prev)
@@ -258,47 +294,81 @@ void EVENT::register_event_by_clock(DEVICE* device, int event_id, int clock, boo
 	event_handle->active = true;
 	event_handle->device = device;
 	event_handle->event_id = event_id;
-	event_handle->expired_clock = event_clocks + clock;
+	event_handle->expired_clock = get_event_clocks() + clock;
 	event_handle->loop_clock = loop ? clock : 0;
 	
 	insert_event(event_handle);
+	
+	// primary cpu stops at the new event as it stops at the next event
+	if(cpu_running && event_handle->expired_clock < cpu_end_clocks) {
+		d_cpu[0].device->stop_run();
+	}
 }
 
 void EVENT::insert_event(event_t *event_handle)
 {
-	if(first_fire_event == NULL) {
-		first_fire_event = event_handle;
-		event_handle->prev = event_handle->next = NULL;
+	event_handle->order = fire_order++;
+	event_handle->heap_index = fire_count;
+	fire_heap[fire_count++] = event_handle;
+	heap_up(event_handle->heap_index);
+}
+
+void EVENT::remove_event(event_t *event_handle)
+{
+	int pos = event_handle->heap_index;
+	event_t *last_handle = fire_heap[--fire_count];
+	
+	if(last_handle != event_handle) {
+		// fill the hole with the last event and restore the heap order
+		fire_heap[pos] = last_handle;
+		last_handle->heap_index = pos;
+		if(pos > 0 && fire_before(last_handle, fire_heap[(pos - 1) >> 1])) {
+			heap_up(pos);
+		}
+		else {
+			heap_down(pos);
+		}
 	}
-	else {
-		for(event_t *insert_pos = first_fire_event; insert_pos != NULL; insert_pos = insert_pos->next) {
-			if(insert_pos->expired_clock > event_handle->expired_clock) {
-				if(insert_pos->prev != NULL) {
-					// insert
-					insert_pos->prev->next = event_handle;
-					event_handle->prev = insert_pos->prev;
-					event_handle->next = insert_pos;
-					insert_pos->prev = event_handle;
-					break;
-				}
-				else {
-					// add to head
-					first_fire_event = event_handle;
-					event_handle->prev = NULL;
-					event_handle->next = insert_pos;
-					insert_pos->prev = event_handle;
-					break;
-				}
-			}
-			else if(insert_pos->next == NULL) {
-				// add to tail
-				insert_pos->next = event_handle;
-				event_handle->prev = insert_pos;
-				event_handle->next = NULL;
-				break;
-			}
+}
+
+void EVENT::heap_up(int pos)
+{
+	event_t *event_handle = fire_heap[pos];
+	
+	while(pos > 0) {
+		int parent = (pos - 1) >> 1;
+		if(!fire_before(event_handle, fire_heap[parent])) {
+			break;
 		}
+		fire_heap[pos] = fire_heap[parent];
+		fire_heap[pos]->heap_index = pos;
+		pos = parent;
 	}
+	fire_heap[pos] = event_handle;
+	event_handle->heap_index = pos;
+}
+
+void EVENT::heap_down(int pos)
+{
+	event_t *event_handle = fire_heap[pos];
+	
+	while(1) {
+		int child = (pos << 1) + 1;
+		if(child >= fire_count) {
+			break;
+		}
+		if(child + 1 < fire_count && fire_before(fire_heap[child + 1], fire_heap[child])) {
+			child++;
+		}
+		if(!fire_before(fire_heap[child], event_handle)) {
+			break;
+		}
+		fire_heap[pos] = fire_heap[child];
+		fire_heap[pos]->heap_index = pos;
+		pos = child;
+	}
+	fire_heap[pos] = event_handle;
+	event_handle->heap_index = pos;
 }
 
 void EVENT::cancel_event(int register_id)
@@ -307,15 +377,7 @@ void EVENT::cancel_event(int register_id)
 	if(0 <= register_id && register_id < MAX_EVENT) {
 		event_t *event_handle = &event[register_id];
 		if(event_handle->active) {
-			if(event_handle->prev != NULL) {
-				event_handle->prev->next = event_handle->next;
-			}
-			else {
-				first_fire_event = event_handle->next;
-			}
-			if(event_handle->next != NULL) {
-				event_handle->next->prev = event_handle->prev;
-			}
+			remove_event(event_handle);
 			event_handle->active = false;
 			event_handle->next = first_free_event;
 			first_free_event = event_handle;
@@ -364,6 +426,16 @@ void EVENT::mix_sound(int samples)
 	}
 }
 
+void EVENT::mix_sound_block()
+{
+	// the devices apply the queued register writes at their sample positions in the frame
+	int samples = buffer_ptr - block_ptr;
+	for(int i = 0; i < dcount_sound_block; i++) {
+		d_sound_block[i]->mix(sound_tmp + block_ptr * 2, samples);
+	}
+	block_ptr = buffer_ptr;
+}
+
 void EVENT::update_sound()
 {
 	accum_samples += update_samples;
@@ -391,29 +463,14 @@ uint16* EVENT::create_sound(int* extra_frames)
 	// fill sound buffer
 	int samples = sound_samples - buffer_ptr;
 	mix_sound(samples);
+	mix_sound_block();
 #endif
 #ifdef LOW_PASS_FILTER
 	// low-pass filter
-	for(int i = 0; i < sound_samples - 1; i++) {
-		sound_tmp[i * 2    ] = (sound_tmp[i * 2    ] + sound_tmp[i * 2 + 2]) / 2; // L
-		sound_tmp[i * 2 + 1] = (sound_tmp[i * 2 + 1] + sound_tmp[i * 2 + 3]) / 2; // R
-	}
+	lowpass_sound(sound_tmp, sound_samples);
 #endif
 	// copy to buffer
-	for(int i = 0; i < sound_samples * 2; i++) {
-		int dat = sound_tmp[i];
-		uint16 highlow = (uint16)(dat & 0x0000ffff);
-		
-		if((dat > 0) && (highlow >= 0x8000)) {
-			sound_buffer[i] = 0x7fff;
-			continue;
-		}
-		if((dat < 0) && (highlow < 0x8000)) {
-			sound_buffer[i] = 0x8000;
-			continue;
-		}
-		sound_buffer[i] = highlow;
-	}
+	saturate_sound(sound_buffer, sound_tmp, sound_samples);
 	if(buffer_ptr > sound_samples) {
 		buffer_ptr -= sound_samples;
 		memcpy(sound_tmp, sound_tmp + sound_samples * 2, buffer_ptr * sizeof(int32) * 2);
@@ -421,6 +478,7 @@ uint16* EVENT::create_sound(int* extra_frames)
 	else {
 		buffer_ptr = 0;
 	}
+	block_ptr = buffer_ptr;
 	*extra_frames = frames;
 	return sound_buffer;
 }
@@ -431,4 +489,179 @@ void EVENT::update_config()
 		power = config.cpu_power;
 		cpu_accum = 0;
 	}
+	if(0 <= config.cpu_quantum && config.cpu_quantum <= MAX_CPU_QUANTUM) {
+		max_cpu_quantum = config.cpu_quantum ? config.cpu_quantum : DEFAULT_CPU_QUANTUM;
+		if(cpu_quantum > max_cpu_quantum) {
+			cpu_quantum = max_cpu_quantum;
+		}
+	}
+}
+
+void EVENT::save_state(FILEIO* fio)
+{
+	fio->FputUint32(STATE_VERSION);
+	fio->FputInt32(this_device_id);
+	
+	// cpu
+	fio->FputInt32(dcount_cpu);
+	for(int i = 0; i < dcount_cpu; i++) {
+		fio->FputInt32(d_cpu[i].cpu_clocks);
+		fio->FputInt32(d_cpu[i].update_clocks);
+		fio->FputInt32(d_cpu[i].accum_clocks);
+	}
+	fio->FputInt32(power);
+	fio->FputInt32(event_remain);
+	fio->FputInt32(cpu_remain);
+	fio->FputInt32(cpu_accum);
+	fio->FputInt32(cpu_done);
+	fio->FputInt32(fine_sync_count);
+	fio->FputInt32(cpu_quantum);
+	fio->FputInt32(sync_hold);
+	fio->FputUint64(event_clocks);
+	
+	// timing
+	fio->FputDouble(frames_per_sec);
+	fio->FputDouble(next_frames_per_sec);
+	fio->FputInt32(lines_per_frame);
+	fio->FputInt32(next_lines_per_frame);
+	fio->Fwrite(vclocks, sizeof(int) * lines_per_frame, 1);
+	
+	// events: devices are saved as device id, and lists are saved as event indexes
+	for(int i = 0; i < MAX_EVENT; i++) {
+		fio->FputBool(event[i].active);
+		if(event[i].active) {
+			fio->FputInt32(event[i].device->this_device_id);
+			fio->FputInt32(event[i].event_id);
+			fio->FputUint64(event[i].expired_clock);
+			fio->FputUint64(event[i].order);
+			fio->FputUint32(event[i].loop_clock);
+		}
+	}
+	fio->FputInt32(fire_count);
+	for(int i = 0; i < fire_count; i++) {
+		fio->FputInt32(fire_heap[i]->index);
+	}
+	fio->FputUint64(fire_order);
+	for(event_t *event_handle = first_free_event; event_handle; event_handle = event_handle->next) {
+		fio->FputInt32(event_handle->index);
+	}
+	fio->FputInt32(-1);
+	
+	// sound
+	fio->FputInt32(sound_rate);
+	fio->FputInt32(sound_samples);
+	fio->FputInt32(buffer_ptr);
+	fio->FputInt32(accum_samples);
+	fio->FputInt32(update_samples);
+	fio->FputBool(save_sound_tmp);
+	if(save_sound_tmp) {
+		fio->Fwrite(sound_tmp, sizeof(int32) * 2 * buffer_ptr, 1);
+	}
+}
+
+bool EVENT::load_state(FILEIO* fio)
+{
+	if(fio->FgetUint32() != STATE_VERSION) {
+		return false;
+	}
+	if(fio->FgetInt32() != this_device_id) {
+		return false;
+	}
+	
+	// cpu
+	if(fio->FgetInt32() != dcount_cpu) {
+		return false;
+	}
+	for(int i = 0; i < dcount_cpu; i++) {
+		d_cpu[i].cpu_clocks = fio->FgetInt32();
+		d_cpu[i].update_clocks = fio->FgetInt32();
+		d_cpu[i].accum_clocks = fio->FgetInt32();
+	}
+	power = fio->FgetInt32();
+	event_remain = fio->FgetInt32();
+	cpu_remain = fio->FgetInt32();
+	cpu_accum = fio->FgetInt32();
+	cpu_done = fio->FgetInt32();
+	fine_sync_count = fio->FgetInt32();
+	cpu_quantum = fio->FgetInt32();
+	sync_hold = fio->FgetInt32();
+	event_clocks = fio->FgetUint64();
+	
+	// timing
+	frames_per_sec = fio->FgetDouble();
+	next_frames_per_sec = fio->FgetDouble();
+	lines_per_frame = fio->FgetInt32();
+	next_lines_per_frame = fio->FgetInt32();
+	if(!(0 <= lines_per_frame && lines_per_frame <= MAX_LINES)) {
+		return false;
+	}
+	fio->Fread(vclocks, sizeof(int) * lines_per_frame, 1);
+	
+	// events
+	for(int i = 0; i < MAX_EVENT; i++) {
+		event[i].active = fio->FgetBool();
+		if(event[i].active) {
+			event[i].device = vm->get_device(fio->FgetInt32());
+			if(event[i].device == NULL) {
+				return false;
+			}
+			event[i].event_id = fio->FgetInt32();
+			event[i].expired_clock = fio->FgetUint64();
+			event[i].order = fio->FgetUint64();
+			event[i].loop_clock = fio->FgetUint32();
+		}
+	}
+	fire_count = fio->FgetInt32();
+	if(!(0 <= fire_count && fire_count <= MAX_EVENT)) {
+		return false;
+	}
+	for(int i = 0; i < fire_count; i++) {
+		int index = fio->FgetInt32();
+		if(!(0 <= index && index < MAX_EVENT && event[index].active)) {
+			return false;
+		}
+		fire_heap[i] = &event[index];
+		fire_heap[i]->heap_index = i;
+	}
+	fire_order = fio->FgetUint64();
+	event_t **next_handle = &first_free_event;
+	for(int i = 0; i <= MAX_EVENT; i++) {
+		int index = fio->FgetInt32();
+		if(index == -1) {
+			break;
+		}
+		if(!(0 <= index && index < MAX_EVENT && !event[index].active)) {
+			return false;
+		}
+		*next_handle = &event[index];
+		next_handle = &event[index].next;
+	}
+	*next_handle = NULL;
+	
+	// sound
+	if(fio->FgetInt32() != sound_rate) {
+		return false;
+	}
+	if(fio->FgetInt32() != sound_samples) {
+		return false;
+	}
+	buffer_ptr = fio->FgetInt32();
+	accum_samples = fio->FgetInt32();
+	update_samples = fio->FgetInt32();
+	if(!(0 <= buffer_ptr && buffer_ptr <= sound_tmp_samples)) {
+		return false;
+	}
+	if(fio->FgetBool()) {
+		fio->Fread(sound_tmp, sizeof(int32) * 2 * buffer_ptr, 1);
+	}
+	else {
+		memset(sound_tmp, 0, sizeof(int32) * 2 * buffer_ptr);
+	}
+	block_ptr = buffer_ptr;
+	
+	// restart the write queues from the loaded clock
+	for(int i = 0; i < dcount_sound_block; i++) {
+		d_sound_block[i]->mix(sound_tmp + block_ptr * 2, 0);
+	}
+	return true;
 }
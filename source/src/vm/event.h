@@ -20,6 +20,13 @@
 #define MAX_EVENT	64
 #define NO_EVENT	-1
 
+// primary cpu runs ahead of sub cpus for the quantum clocks
+#define MIN_CPU_QUANTUM		4
+#define DEFAULT_CPU_QUANTUM	256
+#define MAX_CPU_QUANTUM		4096
+// quanta kept minimum after cpus interact
+#define SYNC_HOLD_COUNT		64
+
 class EVENT : public DEVICE
 {
 private:
@@ -37,21 +44,31 @@ private:
 	int power;
 	int event_remain;
 	int cpu_remain, cpu_accum, cpu_done;
+	int fine_sync_count;	// primary cpu runs one opecode per loop while devices request
+	int cpu_quantum, max_cpu_quantum;
+	int sync_hold;		// the quantum is widened after this count of quanta without sync points
 	uint64 event_clocks;
+	bool cpu_running;	// primary cpu is in run() for the clocks to cpu_end_clocks
+	uint64 cpu_end_clocks;
 	
 	typedef struct event_t {
 		DEVICE* device;
 		int event_id;
 		uint64 expired_clock;
+		uint64 order;	// events expired at the same clock are fired in this order
 		uint32 loop_clock;
 		bool active;
 		int index;
+		int heap_index;
 		event_t *next;
-		event_t *prev;
 	} event_t;
 	event_t event[MAX_EVENT];
 	event_t *first_free_event;
-	event_t *first_fire_event;
+	
+	// active events are kept in the binary heap, the next event is fire_heap[0]
+	event_t *fire_heap[MAX_EVENT];
+	int fire_count;
+	uint64 fire_order;
 	
 	DEVICE* frame_event[MAX_EVENT];
 	DEVICE* vline_event[MAX_EVENT];
@@ -61,21 +78,55 @@ private:
 	int lines_per_frame, next_lines_per_frame;
 	
 	void update_event(int clock);
+	inline uint64 get_event_clocks() {
+		// add the clocks that primary cpu has run in the current run()
+		if(cpu_running) {
+			return event_clocks + ((cpu_accum + d_cpu[0].device->get_run_clock()) >> power);
+		}
+		return event_clocks;
+	}
+	inline int run_primary_cpu(int event_clock, int cpu_clock) {
+		cpu_running = true;
+		cpu_end_clocks = event_clocks + event_clock;
+		int cpu_done_tmp = d_cpu[0].device->run((cpu_clock > 0) ? cpu_clock : 1);
+		cpu_running = false;
+		return cpu_done_tmp;
+	}
+	inline void run_sub_cpus(int clock) {
+		for(int i = 1; i < dcount_cpu; i++) {
+			d_cpu[i].accum_clocks += d_cpu[i].update_clocks * clock;
+			int sub_clock = d_cpu[i].accum_clocks >> 10;
+			if(sub_clock) {
+				d_cpu[i].accum_clocks -= sub_clock << 10;
+				d_cpu[i].device->run(sub_clock);
+			}
+		}
+	}
 	void insert_event(event_t *event_handle);
+	void remove_event(event_t *event_handle);
+	void heap_up(int pos);
+	void heap_down(int pos);
+	inline bool fire_before(event_t *a, event_t *b) {
+		return (a->expired_clock < b->expired_clock) || (a->expired_clock == b->expired_clock && a->order < b->order);
+	}
 	
 	// sound manager
 	DEVICE* d_sound[MAX_SOUND];
 	int dcount_sound;
+	DEVICE* d_sound_block[MAX_SOUND];
+	int dcount_sound_block;
 	
 	uint16* sound_buffer;
 	int32* sound_tmp;
-	int buffer_ptr;
+	int buffer_ptr, block_ptr;
 	int sound_rate;
 	int sound_samples;
 	int sound_tmp_samples;
 	int accum_samples, update_samples;
 	void mix_sound(int samples);
 	void update_sound();
+	void mix_sound_block();
+	bool save_sound_tmp;
 	
 #ifdef _DEBUG_LOG
 	bool initialize_done;
@@ -83,8 +134,14 @@ private:
 	
 public:
 	EVENT(VM* parent_vm, EMU* parent_emu) : DEVICE(parent_vm, parent_emu) {
-		dcount_cpu = dcount_sound = 0;
+		dcount_cpu = dcount_sound = dcount_sound_block = 0;
+		buffer_ptr = block_ptr = 0;
+		fine_sync_count = 0;
+		cpu_quantum = max_cpu_quantum = MIN_CPU_QUANTUM;
+		sync_hold = 0;
+		cpu_running = false;
 		frame_event_count = vline_event_count = 0;
+		save_sound_tmp = true;
 		
 		// initialize event
 		for(int i = 0; i < MAX_EVENT; i++) {
@@ -93,7 +150,8 @@ public:
 			event[i].next = (i + 1 < MAX_EVENT) ? &event[i + 1] : NULL;
 		}
 		first_free_event = &event[0];
-		first_fire_event = NULL;
+		fire_count = 0;
+		fire_order = 0;
 		
 		event_clocks = 0;
 		
@@ -114,6 +172,8 @@ public:
 	void release();
 	void reset();
 	void update_config();
+	void save_state(FILEIO* fio);
+	bool load_state(FILEIO* fio);
 	
 	// common event functions
 	int event_manager_id() {
@@ -128,6 +188,13 @@ public:
 	void register_event(DEVICE* device, int event_id, double usec, bool loop, int* register_id);
 	void register_event_by_clock(DEVICE* device, int event_id, int clock, bool loop, int* register_id);
 	void cancel_event(int register_id);
+	void set_fine_sync(bool fine) {
+		fine_sync_count += fine ? 1 : -1;
+	}
+	void set_sync_point() {
+		cpu_quantum = MIN_CPU_QUANTUM;
+		sync_hold = SYNC_HOLD_COUNT;
+	}
 	void register_frame_event(DEVICE* device);
 	void register_vline_event(DEVICE* device);
 	uint32 current_clock();
@@ -153,7 +220,16 @@ public:
 		set_context_cpu(device, CPU_CLOCKS);
 	}
 	void set_context_sound(DEVICE* device) {
-		d_sound[dcount_sound++] = device;
+		if(device->mix_per_frame()) {
+			d_sound_block[dcount_sound_block++] = device;
+		}
+		else {
+			d_sound[dcount_sound++] = device;
+		}
+	}
+	// pending samples are not needed in the rewind snapshots
+	void set_save_sound_tmp(bool value) {
+		save_sound_tmp = value;
 	}
 };
 
@@ -10,6 +10,7 @@
 */
 
 #include "memory.h"
+#include "ppu.h"
 #include "../datarec.h"
 #include "../../fileio.h"
 
@@ -88,6 +89,7 @@ void MEMORY::write_data8(uint32 addr, uint32 data)
 		for(int i = 0; i < 256; i++) {
 			spr_ram[i] = read_data8(dma_addr | i);
 		}
+		d_ppu->write_signal(SIG_PPU_SPR_RAM, 1, 1);
 	}
 	else if(addr == 0x4016) {
 		if(data & 1) {
@@ -139,6 +139,16 @@ void PPU::initialize()
 	banks[14] = banks[10];
 	banks[15] = banks[11];
 	
+	// expand the pattern bits to the pixels
+	for(int i = 0; i < 256; i++) {
+		uint8 pixels[8], flipped[8];
+		for(int j = 0; j < 8; j++) {
+			pixels[j] = flipped[7 - j] = (i >> (7 - j)) & 1;
+		}
+		memcpy(&pattern_bits[0][i], pixels, 8);
+		memcpy(&pattern_bits[1][i], flipped, 8);
+	}
+	
 	// register event
 	register_vline_event(this);
 }
@@ -152,6 +162,7 @@ void PPU::reset()
 	
 	memset(spr_ram, 0, sizeof(spr_ram));
 	spr_ram_rw_ptr = 0;
+	spr_list_height = 0;
 	
 	memset(regs, 0, sizeof(regs));
 	bg_pattern_table_addr = 0;
@@ -192,6 +203,10 @@ void PPU::write_data8(uint32 addr, uint32 data)
 		spr_ram_rw_ptr = data;
 		break;
 	case 0x2004:
+		if(!(spr_ram_rw_ptr & 3) && spr_ram[spr_ram_rw_ptr] != data) {
+			// y is changed
+			spr_list_height = 0;
+		}
 		spr_ram[spr_ram_rw_ptr++] = data;
 		break;
 	case 0x2005:
@@ -247,6 +262,14 @@ void PPU::write_data8(uint32 addr, uint32 data)
 	}
 }
 
+void PPU::write_signal(int id, uint32 data, uint32 mask)
+{
+	if(id == SIG_PPU_SPR_RAM) {
+		// sprite ram is written by dma
+		spr_list_height = 0;
+	}
+}
+
 uint32 PPU::read_data8(uint32 addr)
 {
 	uint16 ofs;
@@ -393,17 +416,6 @@ void PPU::render_scanline(int v)
 #define BG_WRITTEN_FLAG 1
 #define SPR_WRITTEN_FLAG 2
 
-#define DRAW_BG_PIXEL() \
-	col = attrib_bits; \
-	if(pattern_lo & pattern_mask) { \
-		col |= 1; \
-	} \
-	if(pattern_hi & pattern_mask) { \
-		col |= 2; \
-	} \
-	*p++ = monochrome() ? (bg_pal[col] & 0xf0) : bg_pal[col]; \
-	*solid++ = (col & 3) ? BG_WRITTEN_FLAG : 0; \
-
 void PPU::render_bg(int v)
 {
 	uint32 tile_x = (loopy_v & 0x001f);
@@ -431,28 +443,34 @@ void PPU::render_bg(int v)
 	uint8 *p = screen[v] + (8 - loopy_x);
 	uint8 *solid = solid_buf + (8 - loopy_x);
 	
+	// monochrome is not changed in the line
+	uint8 pal[0x10];
+	for(int i = 0; i < 0x10; i++) {
+		pal[i] = monochrome() ? (bg_pal[i] & 0xf0) : bg_pal[i];
+	}
+	uint64 lsb = pattern_bits[0][0xff];
+	
 	for(int i = 33; i; i--) {
 		uint32 pattern_addr = bg_pattern_table_addr + ((int32)VRAM(name_addr) << 4) + ((loopy_v & 0x7000) >> 12);
-		uint8 pattern_lo = VRAM(pattern_addr);
-		uint8 pattern_hi = VRAM(pattern_addr + 8);
-		uint8 pattern_mask = 0x80;
-		uint8 col;
 		
-		DRAW_BG_PIXEL();
-		pattern_mask >>= 1;
-		DRAW_BG_PIXEL();
-		pattern_mask >>= 1;
-		DRAW_BG_PIXEL();
-		pattern_mask >>= 1;
-		DRAW_BG_PIXEL();
-		pattern_mask >>= 1;
-		DRAW_BG_PIXEL();
-		pattern_mask >>= 1;
-		DRAW_BG_PIXEL();
-		pattern_mask >>= 1;
-		DRAW_BG_PIXEL();
-		pattern_mask >>= 1;
-		DRAW_BG_PIXEL();
+		// 8 pixels at once, each byte has the color of a pixel
+		uint64 pixels = pattern_bits[0][VRAM(pattern_addr)] | (pattern_bits[0][VRAM(pattern_addr + 8)] << 1);
+		uint64 solids = (pixels | (pixels >> 1)) & lsb;	// BG_WRITTEN_FLAG if (col & 3)
+		uint8 col[8];
+		memcpy(col, &pixels, 8);
+		memcpy(solid, &solids, 8);
+		
+		uint8* pal4 = pal + attrib_bits;
+		p[0] = pal4[col[0]];
+		p[1] = pal4[col[1]];
+		p[2] = pal4[col[2]];
+		p[3] = pal4[col[3]];
+		p[4] = pal4[col[4]];
+		p[5] = pal4[col[5]];
+		p[6] = pal4[col[6]];
+		p[7] = pal4[col[7]];
+		p += 8;
+		solid += 8;
 		
 		tile_x++;
 		name_addr++;
@@ -492,26 +510,48 @@ void PPU::render_bg(int v)
 	}
 }
 
+void PPU::update_spr_list(int spr_height)
+{
+	memset(spr_count, 0, sizeof(spr_count));
+	
+	// 9th sprite is not drawn, but it is counted to set the overflow flag
+	for(int s = 0; s < 64; s++) {
+		int spr_y = spr_ram[s << 2] + 1;
+		
+		for(int v = spr_y; v < spr_y + spr_height && v < 240; v++) {
+			if(spr_count[v] < 9) {
+				if(spr_count[v] < 8) {
+					spr_list[v][spr_count[v]] = s;
+				}
+				spr_count[v]++;
+			}
+		}
+	}
+	spr_list_height = spr_height;
+}
+
 void PPU::render_spr(int v)
 {
-	int num_sprites = 0;
 	int spr_height = sprites_8x16() ? 16 : 8;
 	
-	for(int s = 0; s < 64; s++) {
+	if(spr_list_height != spr_height) {
+		update_spr_list(spr_height);
+	}
+	int num_sprites = spr_count[v];
+	
+	// monochrome is not changed in the line
+	uint8 pal[0x10];
+	for(int i = 0; i < 0x10; i++) {
+		pal[i] = monochrome() ? (spr_pal[i] & 0xf0) : spr_pal[i];
+	}
+	
+	for(int n = 0; n < num_sprites && n < 8; n++) {
+		int s = spr_list[v][n];
 		uint8* spr = &spr_ram[s << 2];
 		int spr_y = spr[0] + 1;
-		
-		if(spr_y > v || (spr_y + spr_height) <= v) {
-			continue;
-		}
-		num_sprites++;
-		if(num_sprites > 8) {
-			break;
-		}
 		int spr_x = spr[3];
 		int start_x = 0;
 		int end_x = 8;
-		int inc_x = 1;
 		
 		if((spr_x + 7) > 255) {
 			end_x -= ((spr_x + 7) - 255);
@@ -524,80 +564,57 @@ void PPU::render_spr(int v)
 		}
 		int y = v - spr_y;
 		
-		uint8 *p = &screen[v][8 + spr_x + start_x];
-		uint8 *solid = &solid_buf[8 + spr_x + start_x];
-		
-		if(spr[2] & 0x40) {
-			start_x = (8 - 1) - start_x;
-			end_x = (8 - 1) - end_x;
-			inc_x = -1;
-		}
 		if(spr[2] & 0x80) {
 			y = (spr_height - 1) - y;
 		}
-		uint8 priority = spr[2] & 0x20;
+		uint32 tile_addr = spr[1] << 4;
 		
-		for(int x = start_x; x != end_x; x += inc_x) {
-			uint8 col = 0;
-			uint32 tile_addr;
-			uint8 tile_mask;
-			
-			if(!((*solid) & SPR_WRITTEN_FLAG)) {
-				if(sprites_8x16()) {
-					tile_addr = spr[1] << 4;
-					if(spr[1] & 0x01) {
-						tile_addr += 0x1000;
-						if(y < 8) {
-							tile_addr -= 16;
-						}
-					}
-					else {
-						if(y >= 8) {
-							tile_addr += 16;
-						}
-					}
-					tile_addr += y & 0x07;
-					tile_mask = (0x80 >> (x & 0x07));
-				}
-				else {
-					tile_addr = spr[1] << 4;
-					tile_addr += y & 0x07;
-					tile_addr += spr_pattern_table_addr;
-					tile_mask = (0x80 >> (x & 0x07));
-				}
-				if(VRAM(tile_addr) & tile_mask) {
-					col |= 1;
+		if(sprites_8x16()) {
+			if(spr[1] & 0x01) {
+				tile_addr += 0x1000;
+				if(y < 8) {
+					tile_addr -= 16;
 				}
-				tile_addr += 8;
-				if(VRAM(tile_addr) & tile_mask) {
-					col |= 2;
-				}
-				if(spr[2] & 2) {
-					col |= 8;
-				}
-				if(spr[2] & 1) {
-					col |= 4;
+			}
+			else {
+				if(y >= 8) {
+					tile_addr += 16;
 				}
-				if(col & 3) {
-					if(s && (*solid & BG_WRITTEN_FLAG)) {
-						regs[2] |= 0x40;
-					}
-					if(priority) {
-						*solid |= SPR_WRITTEN_FLAG;
-						if(!(*solid & BG_WRITTEN_FLAG)) {
-							*p = monochrome() ? (spr_pal[col] & 0xf0) : spr_pal[col];
-						}
-					}
-					else {
-						if(!(*solid & SPR_WRITTEN_FLAG)) {
-							*p = monochrome() ? (spr_pal[col] & 0xf0) : spr_pal[col];
-							*solid |= SPR_WRITTEN_FLAG;
-						}
-					}
+			}
+		}
+		else {
+			tile_addr += spr_pattern_table_addr;
+		}
+		tile_addr += y & 0x07;
+		
+		// 8 pixels of the sprite, the flipped pattern is already in the order of the screen
+		uint64* bits = pattern_bits[(spr[2] & 0x40) ? 1 : 0];
+		uint64 pixels = bits[VRAM(tile_addr)] | (bits[VRAM(tile_addr + 8)] << 1);
+		uint8 col[8];
+		memcpy(col, &pixels, 8);
+		
+		uint8 attrib_bits = (spr[2] & 0x03) << 2;
+		uint8 priority = spr[2] & 0x20;
+		uint8 *p = &screen[v][8 + spr_x];
+		uint8 *solid = &solid_buf[8 + spr_x];
+		
+		for(int x = start_x; x < end_x; x++) {
+			if(!col[x] || (solid[x] & SPR_WRITTEN_FLAG)) {
+				continue;
+			}
+			if(s && (solid[x] & BG_WRITTEN_FLAG)) {
+				regs[2] |= 0x40;
+			}
+			if(priority) {
+				solid[x] |= SPR_WRITTEN_FLAG;
+				if(!(solid[x] & BG_WRITTEN_FLAG)) {
+					p[x] = pal[attrib_bits | col[x]];
 				}
 			}
-			p++;
-			solid++;
+			else {
+				p[x] = pal[attrib_bits | col[x]];
+				solid[x] |= SPR_WRITTEN_FLAG;
+			}
 		}
 	}
 	if(num_sprites >= 8) {
@@ -16,6 +16,8 @@
 #include "../../emu.h"
 #include "../device.h"
 
+#define SIG_PPU_SPR_RAM	0
+
 class PPU : public DEVICE
 {
 private:
@@ -31,7 +33,11 @@ private:
 	uint8 spr_ram[0x100];
 	uint8 bg_pal[0x10];
 	uint8 spr_pal[0x10];
+	uint64 pattern_bits[2][256];	// 1 byte per pixel, [1] is flipped horizontally
 	uint8 spr_ram_rw_ptr;
+	uint8 spr_list[240][8];	// first 8 sprites on each line
+	uint8 spr_count[240];
+	int spr_list_height;	// 0 = spr_list is not updated
 	
 	uint8 regs[8];
 	uint16 bg_pattern_table_addr;
@@ -48,6 +54,7 @@ private:
 	void render_scanline(int v);
 	void render_bg(int v);
 	void render_spr(int v);
+	void update_spr_list(int spr_height);
 	void update_palette();
 	
 public:
@@ -59,6 +66,7 @@ public:
 	void reset();
 	void write_data8(uint32 addr, uint32 data);
 	uint32 read_data8(uint32 addr);
+	void write_signal(int id, uint32 data, uint32 mask);
 	void event_vline(int v, int clock);
 	
 	// unique function
@@ -0,0 +1,123 @@
+/*
+	GoldStar FC-100 Emulator
+	Skelton for retropc emulator
+
+	Author : Takeda.Toshiya
+	Date   : 2010.08.03-
+
+	[ cmt ]
+*/
+
+#include "cmt.h"
+#include "../i8251.h"
+#include "../../fileio.h"
+
+#define STATE_VERSION	1
+
+void CMT::initialize()
+{
+	fio = new FILEIO();
+	play = rec = remote = false;
+}
+
+void CMT::release()
+{
+	release_datarec();
+	delete fio;
+}
+
+void CMT::reset()
+{
+	close_datarec();
+	play = rec = remote = false;
+}
+
+void CMT::write_signal(int id, uint32 data, uint32 mask)
+{
+	if(id == SIG_CMT_TRIG || id == SIG_CMT_REMOTE) {
+		// system port drives the motor relay
+		remote = ((data & mask) != 0);
+	}
+	else if(id == SIG_CMT_OUT) {
+		if(rec && remote) {
+			// recv from sio
+			buffer[bufcnt++] = data & mask;
+			if(bufcnt >= BUFFER_SIZE) {
+				fio->Fwrite(buffer, bufcnt, 1);
+				bufcnt = 0;
+			}
+		}
+	}
+}
+
+void CMT::play_datarec(_TCHAR* file_path)
+{
+	close_datarec();
+	
+	if(fio->Fopen(file_path, FILEIO_READ_BINARY)) {
+		fio->Fseek(0, FILEIO_SEEK_END);
+		int size = (fio->Ftell() + 9) & (BUFFER_SIZE - 1);
+		fio->Fseek(0, FILEIO_SEEK_SET);
+		memset(buffer, 0, sizeof(buffer));
+		fio->Fread(buffer, sizeof(buffer), 1);
+		
+		// send data to sio
+		// this implement does not care the sio buffer size... :-(
+		for(int i = 0; i < size; i++) {
+			d_sio->write_signal(SIG_I8251_RECV, buffer[i], 0xff);
+		}
+		play = true;
+	}
+}
+
+void CMT::rec_datarec(_TCHAR* file_path)
+{
+	close_datarec();
+	
+	if(fio->Fopen(file_path, FILEIO_WRITE_BINARY)) {
+		bufcnt = 0;
+		rec = true;
+	}
+}
+
+void CMT::close_datarec()
+{
+	// close file
+	release_datarec();
+	
+	// clear sio buffer
+	d_sio->write_signal(SIG_I8251_CLEAR, 0, 0);
+}
+
+void CMT::release_datarec()
+{
+	// close file
+	if(rec && bufcnt) {
+		fio->Fwrite(buffer, bufcnt, 1);
+	}
+	if(play || rec) {
+		fio->Fclose();
+	}
+	play = rec = false;
+}
+
+void CMT::save_state(FILEIO* fio)
+{
+	fio->FputUint32(STATE_VERSION);
+	fio->FputInt32(this_device_id);
+	
+	// tape image is not saved, the played data is already in sio buffer
+	fio->FputBool(remote);
+}
+
+bool CMT::load_state(FILEIO* fio)
+{
+	if(fio->FgetUint32() != STATE_VERSION) {
+		return false;
+	}
+	if(fio->FgetInt32() != this_device_id) {
+		return false;
+	}
+	remote = fio->FgetBool();
+	return true;
+}
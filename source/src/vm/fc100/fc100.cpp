@@ -27,6 +27,8 @@
 #include "system.h"
 #include "cmt.h"
 #include "../../config.h"
+#include "../../fileio.h"
+#include "../rewind.h"
 
 
 // ----------------------------------------------------------------------------
@@ -53,6 +55,8 @@ VM::VM(EMU* parent_emu) : emu(parent_emu)
 	memory = new MEMORY(this, emu);
 	system = new SYSTEM(this, emu);
 	
+	rewind_buffer = NULL;
+	
 	// set contexts
 	event->set_context_cpu(cpu);
 	event->set_context_sound(psg);
@@ -95,6 +99,10 @@ VM::VM(EMU* parent_emu) : emu(parent_emu)
 
 VM::~VM()
 {
+	if(rewind_buffer) {
+		delete rewind_buffer;
+	}
+	
 	// delete all devices
 	for(DEVICE* device = first_device; device;) {
 		DEVICE *next_device = device->next_device;
@@ -129,6 +137,10 @@ void VM::reset()
 
 void VM::run()
 {
+	// keep the state at the frame boundary
+	if(rewind_buffer) {
+		rewind_buffer->capture();
+	}
 	event->drive();
 }
 
@@ -203,3 +215,50 @@ void VM::update_config()
 		device->update_config();
 	}
 }
+
+#define STATE_VERSION	1
+
+void VM::save_state(FILEIO* fio)
+{
+	fio->FputUint32(STATE_VERSION);
+	
+	for(DEVICE* device = first_device; device; device = device->next_device) {
+		device->save_state(fio);
+	}
+}
+
+bool VM::load_state(FILEIO* fio)
+{
+	if(fio->FgetUint32() != STATE_VERSION) {
+		return false;
+	}
+	for(DEVICE* device = first_device; device; device = device->next_device) {
+		if(!device->load_state(fio)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void VM::initialize_rewind(int frames, int interval)
+{
+	if(rewind_buffer == NULL) {
+		rewind_buffer = new REWIND(this, event);
+	}
+	rewind_buffer->initialize(frames, interval);
+}
+
+bool VM::restore_rewind(int frames)
+{
+	return (rewind_buffer != NULL) && rewind_buffer->restore(frames);
+}
+
+int VM::get_rewind_frames()
+{
+	return (rewind_buffer != NULL) ? rewind_buffer->get_frames() : 0;
+}
+
+int VM::get_rewind_buffer_size()
+{
+	return (rewind_buffer != NULL) ? rewind_buffer->get_buffer_size() : 0;
+}
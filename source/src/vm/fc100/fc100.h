@@ -24,6 +24,7 @@
 #define MC6847_ATTR_AS		0x40 // maybe
 #define MC6847_ATTR_AG		0x80 // maybe
 #define HAS_AY_3_8912
+#define STATIC_IO_MAP_H		"fc100/io_map.h"
 
 // device informations for win32
 #define USE_SCANLINE
@@ -33,10 +34,13 @@
 #define USE_AUTO_KEY			8
 #define USE_AUTO_KEY_RELEASE	9
 #define NOTIFY_KEY_DOWN
+#define USE_STATE
 
 #include "../../common.h"
 
 class EMU;
+class FILEIO;
+class REWIND;
 class DEVICE;
 class EVENT;
 
@@ -55,6 +59,7 @@ class SYSTEM;
 
 class VM
 {
+	friend class STATIC_IO_MAP;
 protected:
 	EMU* emu;
 	
@@ -73,6 +78,9 @@ protected:
 	KEYBOARD* keyboard;
 	MEMORY* memory;
 	SYSTEM* system;
+	
+	// snapshots to rewind
+	REWIND* rewind_buffer;
 
 public:
 	// ----------------------------------------
@@ -108,6 +116,12 @@ public:
 	void key_up(int code);
 	void update_config();
 	void initialize_screen(); // for scanline by zanny
+	void save_state(FILEIO* fio);
+	bool load_state(FILEIO* fio);
+	void initialize_rewind(int frames, int interval);
+	bool restore_rewind(int frames);
+	int get_rewind_frames();
+	int get_rewind_buffer_size();
 	
 	// ----------------------------------------
 	// for each device
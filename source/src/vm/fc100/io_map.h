@@ -0,0 +1,42 @@
+/*
+	GoldStar FC-100 Emulator
+	Skelton for retropc emulator
+
+	Author : Takeda.Toshiya
+	Date   : 2010.08.03-
+
+	[ i/o map at compile time ]
+*/
+
+#ifndef _IO_MAP_H_
+#define _IO_MAP_H_
+
+#include "../static_io.h"
+#include "../i8251.h"
+#include "../io.h"
+#include "../ym2203.h"
+#include "keyboard.h"
+#include "memory.h"
+#include "system.h"
+
+// same as the map set to io in VM::VM()
+class STATIC_IO_MAP
+{
+public:
+	typedef STATIC_IO_R<KEYBOARD, &VM::keyboard, 0xf0, 0x00, -1,	// 00-0f
+		STATIC_IO_R<YM2203, &VM::psg, 0xf3, 0x22, 1,		// 22,26,2a,2e
+		STATIC_IO_R<I8251, &VM::sio, 0xff, 0xb0, 0,
+		STATIC_IO_R<I8251, &VM::sio, 0xff, 0xb8, 1,
+		STATIC_IO_END<IO, &VM::io> > > > > static_io_r;
+	
+	typedef STATIC_IO_W<SYSTEM, &VM::system, 0xf0, 0x10, -1,	// 10-1f
+		STATIC_IO_W<SYSTEM, &VM::system, 0xf0, 0x30, -1,	// 30-3f
+		STATIC_IO_W<YM2203, &VM::psg, 0xf3, 0x21, 1,		// 21,25,29,2d
+		STATIC_IO_W<YM2203, &VM::psg, 0xf3, 0x23, 0,		// 23,27,2b,2f
+		STATIC_IO_W<MEMORY, &VM::memory, 0xe0, 0x60, -1,	// 60-7f
+		STATIC_IO_W<I8251, &VM::sio, 0xff, 0xb0, 0,
+		STATIC_IO_W<I8251, &VM::sio, 0xff, 0xb8, 1,
+		STATIC_IO_END<IO, &VM::io> > > > > > > > static_io_w;
+};
+
+#endif
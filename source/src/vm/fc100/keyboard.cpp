@@ -18,6 +18,8 @@
 
 			   [GRAP]                 [ SPACE ]              [Ȯ]  
 */
+#define STATE_VERSION	1
+
 static const uint8 key_map[16][8] = {//
 	{0x4f, 0x50, 0xdd, 0xdb, 0x14, 0x11, 0x10, 0x12},//00:  O     P     ]     [   CAPS  CTRL  SHIFT GRAP
 	{0x0d, 0xbb, 0x08, 0xdc, 0x00, 0x00, 0x00, 0x00},//01:  CR     =    BS    \                          
@@ -62,3 +64,23 @@ void KEYBOARD::set_keyboard()
 		status[i] = val;
 	}
 }
+
+void KEYBOARD::save_state(FILEIO* fio)
+{
+	fio->FputUint32(STATE_VERSION);
+	fio->FputInt32(this_device_id);
+	
+	fio->Fwrite(status, sizeof(status), 1);
+}
+
+bool KEYBOARD::load_state(FILEIO* fio)
+{
+	if(fio->FgetUint32() != STATE_VERSION) {
+		return false;
+	}
+	if(fio->FgetInt32() != this_device_id) {
+		return false;
+	}
+	fio->Fread(status, sizeof(status), 1);
+	return true;
+}
@@ -31,6 +31,8 @@ public:
 	void reset();
 	uint32 read_io8(uint32 addr);
 	void set_keyboard();
+	void save_state(FILEIO* fio);
+	bool load_state(FILEIO* fio);
 };
 
 #endif
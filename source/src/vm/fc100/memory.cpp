@@ -12,6 +12,8 @@
 #include "../../config.h"
 #include "../../fileio.h"
 
+#define STATE_VERSION	2
+
 #define SET_BANK(s, e, w, r) { \
 	int sb = (s) >> 11, eb = (e) >> 11; \
 	for(int i = sb; i <= eb; i++) { \
@@ -139,7 +141,7 @@ void MEMORY::reset()
 	else{
 		SET_BANK(0x8000, 0xbfff, wdmy, rdmy);
 	}
-	SET_BANK(0x6000, 0x7fff, rdmy, extrom);
+	SET_BANK(0x6000, 0x7fff, wdmy, extrom);
 	romsel = 0x70;
 }
 
@@ -155,3 +157,83 @@ uint32 MEMORY::read_data8(uint32 addr)
 	return rbank[addr >> 11][addr & 0x7ff];
 }
 
+void MEMORY::save_state(FILEIO* fio)
+{
+	fio->FputUint32(STATE_VERSION);
+	fio->FputInt32(this_device_id);
+	
+	// roms are not saved, they are loaded again at reset
+	fio->Fwrite(ram, sizeof(ram), 1);
+	fio->Fwrite(pcgram, sizeof(pcgram), 1);
+	fio->Fwrite(extram, sizeof(extram), 1);
+	
+	for(int i = 0; i < 32; i++) {
+		save_bank(fio, wbank[i]);
+		save_bank(fio, rbank[i]);
+	}
+	fio->FputUint8(romsel);
+	fio->FputBool(ramsel);
+}
+
+bool MEMORY::load_state(FILEIO* fio)
+{
+	if(fio->FgetUint32() != STATE_VERSION) {
+		return false;
+	}
+	if(fio->FgetInt32() != this_device_id) {
+		return false;
+	}
+	fio->Fread(ram, sizeof(ram), 1);
+	fio->Fread(pcgram, sizeof(pcgram), 1);
+	fio->Fread(extram, sizeof(extram), 1);
+	
+	// keep the current banks if the state is broken
+	uint8* tmp_wbank[32];
+	uint8* tmp_rbank[32];
+	for(int i = 0; i < 32; i++) {
+		if((tmp_wbank[i] = load_bank(fio)) == NULL || (tmp_rbank[i] = load_bank(fio)) == NULL) {
+			return false;
+		}
+	}
+	memcpy(wbank, tmp_wbank, sizeof(wbank));
+	memcpy(rbank, tmp_rbank, sizeof(rbank));
+	romsel = fio->FgetUint8();
+	ramsel = fio->FgetBool();
+	return true;
+}
+
+// banks are saved as the index of the memory block and the offset in it,
+// and the offset is checked not to exceed the block when loaded
+
+#define BANK_BLOCKS	8
+
+void MEMORY::save_bank(FILEIO* fio, uint8* bank)
+{
+	uint8* block[BANK_BLOCKS] = {rom, ram, pcgram, cgrom, extrom, extram, wdmy, rdmy};
+	int size[BANK_BLOCKS] = {sizeof(rom), sizeof(ram), sizeof(pcgram), sizeof(cgrom), sizeof(extrom), sizeof(extram), sizeof(wdmy), sizeof(rdmy)};
+	
+	for(int i = 0; i < BANK_BLOCKS; i++) {
+		if(block[i] <= bank && bank + 0x800 <= block[i] + size[i]) {
+			fio->FputInt32(i);
+			fio->FputInt32((int)(bank - block[i]));
+			return;
+		}
+	}
+	// never happens
+	fio->FputInt32(-1);
+	fio->FputInt32(0);
+}
+
+uint8* MEMORY::load_bank(FILEIO* fio)
+{
+	uint8* block[BANK_BLOCKS] = {rom, ram, pcgram, cgrom, extrom, extram, wdmy, rdmy};
+	int size[BANK_BLOCKS] = {sizeof(rom), sizeof(ram), sizeof(pcgram), sizeof(cgrom), sizeof(extrom), sizeof(extram), sizeof(wdmy), sizeof(rdmy)};
+	int index = fio->FgetInt32();
+	int offset = fio->FgetInt32();
+	
+	if(!(0 <= index && index < BANK_BLOCKS && 0 <= offset && offset + 0x800 <= size[index])) {
+		return NULL;
+	}
+	return block[index] + offset;
+}
+
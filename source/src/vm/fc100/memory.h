@@ -31,6 +31,9 @@ private:
 	uint8* rbank[32];
 	uint8 romsel;
 	bool ramsel;
+	
+	void save_bank(FILEIO* fio, uint8* bank);
+	uint8* load_bank(FILEIO* fio);
 
 public:
 	MEMORY(VM* parent_vm, EMU* parent_emu) : DEVICE(parent_vm, parent_emu) {}
@@ -50,11 +53,21 @@ public:
 		return read_data8(addr) | (read_data8(addr + 1) << 8);
 	}
 	void write_io8(uint32 addr, uint32 data);
+	void save_state(FILEIO* fio);
+	bool load_state(FILEIO* fio);
 
 	// unique functions
 	uint8* get_vram() { return ram; }
 	uint8* get_cgrom() { return cgrom; }
 	uint8* get_pcgram() { return pcgram; }
+	uint8** get_read_bank_table(int* shift) {
+		*shift = 11;
+		return rbank;
+	}
+	uint8** get_write_bank_table(int* shift) {
+		*shift = 11;
+		return wbank;
+	}
 };
 
 #endif
@@ -12,6 +12,8 @@
 #include "cmt.h"
 #include "../mc6847.h"
 
+#define STATE_VERSION	1
+
 void SYSTEM::initialize()
 {
 	sysport = 0;
@@ -44,3 +46,23 @@ void SYSTEM::write_signal(int id, uint32 data, uint32 mask)
 {
 	sysport = (sysport & ~mask) | (data & mask);
 }
+
+void SYSTEM::save_state(FILEIO* fio)
+{
+	fio->FputUint32(STATE_VERSION);
+	fio->FputInt32(this_device_id);
+	
+	fio->FputUint8(sysport);
+}
+
+bool SYSTEM::load_state(FILEIO* fio)
+{
+	if(fio->FgetUint32() != STATE_VERSION) {
+		return false;
+	}
+	if(fio->FgetInt32() != this_device_id) {
+		return false;
+	}
+	sysport = fio->FgetUint8();
+	return true;
+}
@@ -1,7 +1,9 @@
 //	$Id: file.cpp,v 1.6 1999/12/28 11:14:05 cisc Exp $
 
 #include "headers.h"
-#include "File.h"
+#include "file.h"
+
+#ifdef _WIN32
 
 // ---------------------------------------------------------------------------
 //	\z/
@@ -194,3 +196,143 @@ bool FileIO::SetEndOfFile()
 		return false;
 	return ::SetEndOfFile(hfile) != 0;
 }
+
+#else
+
+// ---------------------------------------------------------------------------
+//	stdio implementation for non-windows hosts
+// ---------------------------------------------------------------------------
+
+FileIO::FileIO()
+{
+	flags = 0;
+}
+
+FileIO::FileIO(const _TCHAR* filename, uint flg)
+{
+	flags = 0;
+	Open(filename, flg);
+}
+
+FileIO::~FileIO()
+{
+	Close();
+}
+
+bool FileIO::Open(const _TCHAR* filename, uint flg)
+{
+	Close();
+
+	_tcsncpy(path, filename, MAX_PATH);
+
+	hfile = fopen(filename, flg & create ? "w+b" : (flg & readonly ? "rb" : "r+b"));
+	
+	flags = (flg & readonly) | (hfile == NULL ? 0 : open);
+	if (!(flags & open))
+		error = file_not_found;
+	SetLogicalOrigin(0);
+
+	return !!(flags & open);
+}
+
+bool FileIO::CreateNew(const _TCHAR* filename)
+{
+	Close();
+
+	_tcsncpy(path, filename, MAX_PATH);
+
+	if ((hfile = fopen(filename, "rb")) != NULL)
+	{
+		fclose(hfile);
+		hfile = NULL;
+	}
+	else
+		hfile = fopen(filename, "w+b");
+	
+	flags = (hfile == NULL ? 0 : open);
+	SetLogicalOrigin(0);
+
+	return !!(flags & open);
+}
+
+bool FileIO::Reopen(uint flg)
+{
+	if (!(flags & open)) return false;
+	if ((flags & readonly) && (flg & create)) return false;
+
+	if (flags & readonly) flg |= readonly;
+
+	Close();
+
+	hfile = fopen(path, flg & create ? "w+b" : (flg & readonly ? "rb" : "r+b"));
+	
+	flags = (flg & readonly) | (hfile == NULL ? 0 : open);
+	SetLogicalOrigin(0);
+
+	return !!(flags & open);
+}
+
+void FileIO::Close()
+{
+	if (GetFlags() & open)
+	{
+		fclose(hfile);
+		flags = 0;
+	}
+}
+
+int32 FileIO::Read(void* dest, int32 size)
+{
+	if (!(GetFlags() & open))
+		return -1;
+	
+	return (int32)fread(dest, 1, size, hfile);
+}
+
+int32 FileIO::Write(const void* dest, int32 size)
+{
+	if (!(GetFlags() & open) || (GetFlags() & readonly))
+		return -1;
+	
+	return (int32)fwrite(dest, 1, size, hfile);
+}
+
+bool FileIO::Seek(int32 pos, SeekMethod method)
+{
+	if (!(GetFlags() & open))
+		return false;
+	
+	int wmethod;
+	switch (method)
+	{
+	case begin:	
+		wmethod = SEEK_SET; pos += lorigin; 
+		break;
+	case current:	
+		wmethod = SEEK_CUR; 
+		break;
+	case end:		
+		wmethod = SEEK_END; 
+		break;
+	default:
+		return false;
+	}
+
+	return fseek(hfile, pos, wmethod) == 0;
+}
+
+int32 FileIO::Tellp()
+{
+	if (!(GetFlags() & open))
+		return 0;
+
+	return ftell(hfile) - lorigin;
+}
+
+bool FileIO::SetEndOfFile()
+{
+	// not supported by stdio
+	return false;
+}
+
+#endif
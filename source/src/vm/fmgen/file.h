@@ -3,7 +3,11 @@
 #if !defined(win32_file_h)
 #define win32_file_h
 
+#ifdef _WIN32
 #include <tchar.h>
+#else
+#include "headers.h"
+#endif
 #include "types.h"
 
 // ---------------------------------------------------------------------------
@@ -52,7 +56,11 @@ public:
 	void SetLogicalOrigin(int32 origin) { lorigin = origin; }
 
 private:
+#ifdef _WIN32
 	HANDLE hfile;
+#else
+	FILE* hfile;
+#endif
 	uint flags;
 	uint32 lorigin;
 	Error error;
@@ -26,8 +26,18 @@
 #include "fmgen.h"
 #include "fmgeninl.h"
 
+#include "../../fileio.h"
+
+#if defined(SIMD_USE_AVX2)
+#include <immintrin.h>
+#endif
+
 #define LOGNAME "fmgen"
 
+#define CHIP_STATE_VERSION	1
+#define OPERATOR_STATE_VERSION	1
+#define CHANNEL4_STATE_VERSION	1
+
 // ---------------------------------------------------------------------------
 
 #define FM_EG_BOTTOM 955
@@ -274,7 +284,9 @@ void Chip::MakeTable()
 // ---------------------------------------------------------------------------
 //	Operator
 //
-bool FM::Operator::tablehasmade = false;
+// The shared tables are built at startup and only read after that,
+// so chips can be created and run on several threads at once.
+bool FM::Operator::tablehasmade = (FM::Operator::MakeTable(), true);
 uint FM::Operator::sinetable[1024];
 int32 FM::Operator::cltable[FM_CLENTS];
 
@@ -701,7 +713,7 @@ inline FM::ISample FM::Operator::CalcFBL(uint fb)
 const uint8 Channel4::fbtable[8] = { 31, 7, 6, 5, 4, 3, 2, 1 };
 int Channel4::kftable[64];
 
-bool Channel4::tablehasmade = false;
+bool Channel4::tablehasmade = (Channel4::MakeTable(), true);
 
 
 Channel4::Channel4()
@@ -720,6 +732,7 @@ void Channel4::MakeTable()
 	{
 		kftable[i] = int(0x10000 * pow(2., i / 768.) );
 	}
+	tablehasmade = true;
 }
 
 // Zbg
@@ -869,6 +882,151 @@ ISample Channel4::Calc()
 	return r;
 }
 
+#if defined(SIMD_USE_AVX2)
+// ---------------------------------------------------------------------------
+//	AVX2 version of LogToLin(eg_out_ + SINE(pgin)) for 8 operators
+//
+static inline __m256i OpOutAVX2(__m256i pgin, __m256i eg, const uint* sinetable, const int32* cltable)
+{
+	const __m256i sinemask = _mm256_set1_epi32(FM_OPSINENTS - 1);
+	const __m256i clents = _mm256_set1_epi32(FM_CLENTS);
+	__m256i a = _mm256_add_epi32(eg, _mm256_i32gather_epi32((const int*)sinetable, _mm256_and_si256(pgin, sinemask), 4));
+	return _mm256_mask_i32gather_epi32(_mm256_setzero_si256(), (const int*)cltable, a, _mm256_cmpgt_epi32(clents, a), 4);
+}
+
+// ---------------------------------------------------------------------------
+//	AVX2 version of Calc for the channels without LFO
+//	each lane calculates one channel in the same way as Calc and CalcFB
+//	ch		channels to calculate (8 at most)
+//	dest	output of the channels, dest[sample * 8 + lane]
+//
+void Channel4::CalcAVX2(Channel4** ch, int nch, ISample* dest, int nsamples)
+{
+	// inputs of op[1]-op[3] and the output for each algorithm
+	//	op1:op0  op2:op0,op1  op3:op0,op1,op2  out:op0,op1,op2
+	static const uint8 algotable[8][9] =
+	{
+		{ 1, 0, 1, 0, 0, 1, 0, 0, 0 },	{ 0, 1, 1, 0, 0, 1, 0, 0, 0 },
+		{ 0, 0, 1, 1, 0, 1, 0, 0, 0 },	{ 1, 0, 0, 0, 1, 1, 0, 0, 0 },
+		{ 1, 0, 0, 0, 0, 1, 0, 1, 0 },	{ 1, 1, 0, 1, 0, 0, 0, 1, 1 },
+		{ 1, 0, 0, 0, 0, 0, 0, 1, 1 },	{ 0, 0, 0, 0, 0, 0, 1, 1, 1 },
+	};
+	
+	int32 pgc[4][8], pgd[4][8], egc[4][8], egd[4][8], ego[4][8], outv[4][8], out2v[4][8];
+	int32 algo[9][8], fbshift[8], fbmask[8];
+	for (int c=0; c<8; c++)
+	{
+		for (int k=0; k<4; k++)
+		{
+			if (c < nch)
+			{
+				Operator& op = ch[c]->op[k];
+				pgc[k][c] = op.pg_count_;		pgd[k][c] = op.pg_diff_;
+				egc[k][c] = op.eg_count_;		egd[k][c] = op.eg_count_diff_;
+				ego[k][c] = op.eg_out_;
+				outv[k][c] = op.out_;			out2v[k][c] = op.out2_;
+			}
+			else
+			{
+				pgc[k][c] = pgd[k][c] = egd[k][c] = ego[k][c] = outv[k][c] = out2v[k][c] = 0;
+				egc[k][c] = 1;
+			}
+		}
+		for (int m=0; m<9; m++)
+			algo[m][c] = (c < nch && algotable[ch[c]->algo_][m]) ? -1 : 0;
+		fbshift[c] = (c < nch) ? ch[c]->fb : 31;
+		fbmask[c] = (c < nch && ch[c]->fb < 31) ? -1 : 0;
+	}
+	
+	#define LOADV(a)	_mm256_loadu_si256((__m256i*)(a))
+	#define STOREV(a, v)	_mm256_storeu_si256((__m256i*)(a), v)
+	const __m256i one = _mm256_set1_epi32(1);
+	const __m256i m1_0 = LOADV(algo[0]), m2_0 = LOADV(algo[1]), m2_1 = LOADV(algo[2]);
+	const __m256i m3_0 = LOADV(algo[3]), m3_1 = LOADV(algo[4]), m3_2 = LOADV(algo[5]);
+	const __m256i r_0 = LOADV(algo[6]), r_1 = LOADV(algo[7]), r_2 = LOADV(algo[8]);
+	const __m256i fbs = LOADV(fbshift), fbm = LOADV(fbmask);
+	__m256i pg0 = LOADV(pgc[0]), pg1 = LOADV(pgc[1]), pg2 = LOADV(pgc[2]), pg3 = LOADV(pgc[3]);
+	const __m256i pd0 = LOADV(pgd[0]), pd1 = LOADV(pgd[1]), pd2 = LOADV(pgd[2]), pd3 = LOADV(pgd[3]);
+	__m256i out0 = LOADV(outv[0]), out1 = LOADV(outv[1]), out2 = LOADV(outv[2]), out3 = LOADV(outv[3]);
+	__m256i out0b = LOADV(out2v[0]), out1b = LOADV(out2v[1]), out2b = LOADV(out2v[2]), out3b = LOADV(out2v[3]);
+	const int lanes = (1 << nch) - 1;
+	
+	for (int i=0; i<nsamples; i++)
+	{
+		// EG is stepped by the scalar code when the count is expired
+		for (int k=0; k<4; k++)
+		{
+			__m256i count = _mm256_sub_epi32(LOADV(egc[k]), LOADV(egd[k]));
+			STOREV(egc[k], count);
+			int expired = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(one, count))) & lanes;
+			for (int c=0; expired; c++, expired >>= 1)
+			{
+				if (expired & 1)
+				{
+					Operator& op = ch[c]->op[k];
+					op.eg_count_ = egc[k][c];
+					op.EGCalc();
+					egc[k][c] = op.eg_count_;
+					egd[k][c] = op.eg_count_diff_;
+					ego[k][c] = op.eg_out_;
+				}
+			}
+		}
+		
+		// op[2] and op[1] take the outputs of the previous sample
+		__m256i in2 = _mm256_add_epi32(_mm256_and_si256(out0, m2_0), _mm256_and_si256(out1, m2_1));
+		__m256i in1 = _mm256_and_si256(out0, m1_0);
+		__m256i pgin2 = _mm256_add_epi32(_mm256_srli_epi32(pg2, 20+FM_PGBITS-FM_OPSINBITS), _mm256_srai_epi32(in2, 20+FM_PGBITS-FM_OPSINBITS-(2+IS2EC_SHIFT)));
+		__m256i pgin1 = _mm256_add_epi32(_mm256_srli_epi32(pg1, 20+FM_PGBITS-FM_OPSINBITS), _mm256_srai_epi32(in1, 20+FM_PGBITS-FM_OPSINBITS-(2+IS2EC_SHIFT)));
+		pg2 = _mm256_add_epi32(pg2, pd2);
+		pg1 = _mm256_add_epi32(pg1, pd1);
+		__m256i eg2 = LOADV(ego[2]), eg1 = LOADV(ego[1]);
+		out2b = out2;
+		out2 = OpOutAVX2(pgin2, eg2, Operator::sinetable, Operator::cltable);
+		out1b = out1;
+		out1 = OpOutAVX2(pgin1, eg1, Operator::sinetable, Operator::cltable);
+		
+		// op[3] takes op[1] and op[2] of this sample
+		__m256i in3 = _mm256_add_epi32(_mm256_and_si256(out0, m3_0), _mm256_add_epi32(_mm256_and_si256(out1, m3_1), _mm256_and_si256(out2, m3_2)));
+		__m256i pgin3 = _mm256_add_epi32(_mm256_srli_epi32(pg3, 20+FM_PGBITS-FM_OPSINBITS), _mm256_srai_epi32(in3, 20+FM_PGBITS-FM_OPSINBITS-(2+IS2EC_SHIFT)));
+		pg3 = _mm256_add_epi32(pg3, pd3);
+		__m256i eg3 = LOADV(ego[3]);
+		out3b = out3;
+		out3 = OpOutAVX2(pgin3, eg3, Operator::sinetable, Operator::cltable);
+		
+		// op[0] with self feedback
+		__m256i in0 = _mm256_add_epi32(out0, out0b);
+		__m256i fb = _mm256_srai_epi32(_mm256_srav_epi32(_mm256_slli_epi32(in0, 1 + IS2EC_SHIFT), fbs), 20+FM_PGBITS-FM_OPSINBITS);
+		__m256i pgin0 = _mm256_add_epi32(_mm256_srli_epi32(pg0, 20+FM_PGBITS-FM_OPSINBITS), _mm256_and_si256(fb, fbm));
+		pg0 = _mm256_add_epi32(pg0, pd0);
+		__m256i eg0 = LOADV(ego[0]);
+		out0b = out0;
+		out0 = OpOutAVX2(pgin0, eg0, Operator::sinetable, Operator::cltable);
+		
+		__m256i r = _mm256_add_epi32(out3, _mm256_and_si256(out0b, r_0));
+		r = _mm256_add_epi32(r, _mm256_add_epi32(_mm256_and_si256(out1, r_1), _mm256_and_si256(out2, r_2)));
+		STOREV(dest + i * 8, r);
+	}
+	
+	STOREV(pgc[0], pg0);	STOREV(pgc[1], pg1);	STOREV(pgc[2], pg2);	STOREV(pgc[3], pg3);
+	STOREV(outv[0], out0);	STOREV(outv[1], out1);	STOREV(outv[2], out2);	STOREV(outv[3], out3);
+	STOREV(out2v[0], out0b);	STOREV(out2v[1], out1b);	STOREV(out2v[2], out2b);	STOREV(out2v[3], out3b);
+	#undef LOADV
+	#undef STOREV
+	for (int c=0; c<nch; c++)
+	{
+		for (int k=0; k<4; k++)
+		{
+			Operator& op = ch[c]->op[k];
+			op.pg_count_ = pgc[k][c];
+			op.eg_count_ = egc[k][c];
+			op.out_ = outv[k][c];
+			op.out2_ = out2v[k][c];
+		}
+	}
+}
+#endif
+
 //  
 ISample Channel4::CalcL()
 {
@@ -956,4 +1114,174 @@ ISample Channel4::CalcLN(uint noise)
 	return *out[2] + o;
 }
 
+// ---------------------------------------------------------------------------
+//	save/load state
+//	table pointers are saved as offsets from the top of tables
+//
+void Chip::SaveState(void* f)
+{
+	FILEIO* fio = (FILEIO*)f;
+	
+	fio->FputUint32(CHIP_STATE_VERSION);
+	fio->FputUint32(ratio_);
+	fio->FputUint32(aml_);
+	fio->FputUint32(pml_);
+	fio->FputInt32(pmv_);
+	fio->FputInt32(optype_);
+}
+
+bool Chip::LoadState(void* f)
+{
+	FILEIO* fio = (FILEIO*)f;
+	
+	if (fio->FgetUint32() != CHIP_STATE_VERSION)
+		return false;
+	ratio_ = fio->FgetUint32();
+	aml_ = fio->FgetUint32();
+	pml_ = fio->FgetUint32();
+	pmv_ = fio->FgetInt32();
+	optype_ = OpType(fio->FgetInt32());
+	MakeTable();
+	return true;
+}
+
+void Operator::SaveState(void* f)
+{
+	FILEIO* fio = (FILEIO*)f;
+	
+	fio->FputUint32(OPERATOR_STATE_VERSION);
+	fio->FputInt32(out_);
+	fio->FputInt32(out2_);
+	fio->FputInt32(in2_);
+	fio->FputUint32(dp_);
+	fio->FputUint32(detune_);
+	fio->FputUint32(detune2_);
+	fio->FputUint32(multiple_);
+	fio->FputUint32(pg_count_);
+	fio->FputUint32(pg_diff_);
+	fio->FputInt32(pg_diff_lfo_);
+	fio->FputInt32(type_);
+	fio->FputUint32(bn_);
+	fio->FputInt32(eg_level_);
+	fio->FputInt32(eg_level_on_next_phase_);
+	fio->FputInt32(eg_count_);
+	fio->FputInt32(eg_count_diff_);
+	fio->FputInt32(eg_out_);
+	fio->FputInt32(tl_out_);
+	fio->FputInt32(eg_rate_);
+	fio->FputInt32(eg_curve_count_);
+	fio->FputInt32(ssg_offset_);
+	fio->FputInt32(ssg_vector_);
+	fio->FputInt32(ssg_phase_);
+	fio->FputUint32(key_scale_rate_);
+	fio->FputInt32(eg_phase_);
+	fio->FputInt32((int)(ams_ - &amtable[0][0][0]));
+	fio->FputUint32(ms_);
+	fio->FputUint32(tl_);
+	fio->FputUint32(tl_latch_);
+	fio->FputUint32(ar_);
+	fio->FputUint32(dr_);
+	fio->FputUint32(sr_);
+	fio->FputUint32(sl_);
+	fio->FputUint32(rr_);
+	fio->FputUint32(ks_);
+	fio->FputUint32(ssg_type_);
+	fio->FputBool(keyon_);
+	fio->FputBool(amon_);
+	fio->FputBool(param_changed_);
+	fio->FputBool(mute_);
+}
+
+bool Operator::LoadState(void* f)
+{
+	FILEIO* fio = (FILEIO*)f;
+	
+	if (fio->FgetUint32() != OPERATOR_STATE_VERSION)
+		return false;
+	out_ = fio->FgetInt32();
+	out2_ = fio->FgetInt32();
+	in2_ = fio->FgetInt32();
+	dp_ = fio->FgetUint32();
+	detune_ = fio->FgetUint32();
+	detune2_ = fio->FgetUint32();
+	multiple_ = fio->FgetUint32();
+	pg_count_ = fio->FgetUint32();
+	pg_diff_ = fio->FgetUint32();
+	pg_diff_lfo_ = fio->FgetInt32();
+	type_ = OpType(fio->FgetInt32());
+	bn_ = fio->FgetUint32();
+	eg_level_ = fio->FgetInt32();
+	eg_level_on_next_phase_ = fio->FgetInt32();
+	eg_count_ = fio->FgetInt32();
+	eg_count_diff_ = fio->FgetInt32();
+	eg_out_ = fio->FgetInt32();
+	tl_out_ = fio->FgetInt32();
+	eg_rate_ = fio->FgetInt32();
+	eg_curve_count_ = fio->FgetInt32();
+	ssg_offset_ = fio->FgetInt32();
+	ssg_vector_ = fio->FgetInt32();
+	ssg_phase_ = fio->FgetInt32();
+	key_scale_rate_ = fio->FgetUint32();
+	eg_phase_ = EGPhase(fio->FgetInt32());
+	int ams_offset = fio->FgetInt32();
+	if (ams_offset < 0 || ams_offset >= 2 * 4 * FM_LFOENTS)
+		return false;
+	ams_ = &amtable[0][0][0] + ams_offset;
+	ms_ = fio->FgetUint32();
+	tl_ = fio->FgetUint32();
+	tl_latch_ = fio->FgetUint32();
+	ar_ = fio->FgetUint32();
+	dr_ = fio->FgetUint32();
+	sr_ = fio->FgetUint32();
+	sl_ = fio->FgetUint32();
+	rr_ = fio->FgetUint32();
+	ks_ = fio->FgetUint32();
+	ssg_type_ = fio->FgetUint32();
+	keyon_ = fio->FgetBool();
+	amon_ = fio->FgetBool();
+	param_changed_ = fio->FgetBool();
+	mute_ = fio->FgetBool();
+	return true;
+}
+
+void Channel4::SaveState(void* f)
+{
+	FILEIO* fio = (FILEIO*)f;
+	
+	fio->FputUint32(CHANNEL4_STATE_VERSION);
+	fio->FputUint32(fb);
+	for (int i=0; i<4; i++)
+		fio->FputInt32(buf[i]);
+	fio->FputInt32((int)(pms - &pmtable[0][0][0]));
+	fio->FputInt32(algo_);
+	for (int i=0; i<4; i++)
+		op[i].SaveState(f);
+}
+
+bool Channel4::LoadState(void* f)
+{
+	FILEIO* fio = (FILEIO*)f;
+	
+	if (fio->FgetUint32() != CHANNEL4_STATE_VERSION)
+		return false;
+	fb = fio->FgetUint32();
+	for (int i=0; i<4; i++)
+		buf[i] = fio->FgetInt32();
+	int pms_offset = fio->FgetInt32();
+	if (pms_offset < 0 || pms_offset >= 2 * 8 * FM_LFOENTS)
+		return false;
+	pms = &pmtable[0][0][0] + pms_offset;
+	algo_ = fio->FgetInt32();
+	if (algo_ < 0 || algo_ >= 8)
+		return false;
+	// SetAlgorithm resets the feedback, so it is called before loading operators
+	SetAlgorithm(algo_);
+	for (int i=0; i<4; i++)
+	{
+		if (!op[i].LoadState(f))
+			return false;
+	}
+	return true;
+}
+
 }	// namespace FM
@@ -30,6 +30,9 @@
 //	TCg̐x 2^(1/256)
 #define FM_CLENTS		(0x1000 * 2)	// sin + TL + LFO
 
+// samples per call of Channel4::CalcAVX2
+#define FM_AVX2_SAMPLES	128
+
 // ---------------------------------------------------------------------------
 
 namespace FM
@@ -83,6 +86,9 @@ namespace FM
 		void	SetMS(uint ms);
 		void	Mute(bool);
 		
+		void	SaveState(void* f);
+		bool	LoadState(void* f);
+		
 //		static void SetAML(uint l);
 //		static void SetPML(uint l);
 
@@ -202,6 +208,9 @@ namespace FM
 		ISample CalcL();
 		ISample CalcN(uint noise);
 		ISample CalcLN(uint noise);
+#if defined(SIMD_USE_AVX2)
+		static void CalcAVX2(Channel4** ch, int nch, ISample* dest, int nsamples);
+#endif
 		void SetFNum(uint fnum);
 		void SetFB(uint fb);
 		void SetKCKF(uint kc, uint kf);
@@ -212,6 +221,9 @@ namespace FM
 		void SetMS(uint ms);
 		void Mute(bool);
 		void Refresh();
+		
+		void SaveState(void* f);
+		bool LoadState(void* f);
 
 		void dbgStopPG() { for (int i=0; i<4; i++) op[i].dbgStopPG(); }
 		
@@ -250,6 +262,9 @@ namespace FM
 		uint	GetPML() { return pml_; }
 		int		GetPMV() { return pmv_; }
 		uint	GetRatio() { return ratio_; }
+		
+		void	SaveState(void* f);
+		bool	LoadState(void* f);
 
 	private:
 		void	MakeTable();
@@ -6,9 +6,12 @@
 
 #include "headers.h"
 #include "fmtimer.h"
+#include "../../fileio.h"
 
 using namespace FM;
 
+#define TIMER_STATE_VERSION	1
+
 // ---------------------------------------------------------------------------
 //	^C}[
 //
@@ -101,3 +104,40 @@ void Timer::SetTimerPrescaler(int32 p)
 	prescaler = p;
 }
 
+// ---------------------------------------------------------------------------
+//	save/load state
+//
+void Timer::SaveState(void* f)
+{
+	FILEIO* fio = (FILEIO*)f;
+	
+	fio->FputUint32(TIMER_STATE_VERSION);
+	fio->FputUint8(status);
+	fio->FputUint8(regtc);
+	fio->FputUint8(regta[0]);
+	fio->FputUint8(regta[1]);
+	fio->FputInt32(timera);
+	fio->FputInt32(timera_count);
+	fio->FputInt32(timerb);
+	fio->FputInt32(timerb_count);
+	fio->FputInt32(prescaler);
+}
+
+bool Timer::LoadState(void* f)
+{
+	FILEIO* fio = (FILEIO*)f;
+	
+	if (fio->FgetUint32() != TIMER_STATE_VERSION)
+		return false;
+	status = fio->FgetUint8();
+	regtc = fio->FgetUint8();
+	regta[0] = fio->FgetUint8();
+	regta[1] = fio->FgetUint8();
+	timera = fio->FgetInt32();
+	timera_count = fio->FgetInt32();
+	timerb = fio->FgetInt32();
+	timerb_count = fio->FgetInt32();
+	prescaler = fio->FgetInt32();
+	return true;
+}
+
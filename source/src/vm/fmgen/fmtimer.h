@@ -19,6 +19,9 @@ namespace FM
 		void	Reset();
 		bool	Count(int32 clock);
 		int32	GetNextEvent();
+		
+		void	SaveState(void* f);
+		bool	LoadState(void* f);
 	
 	protected:
 		virtual void SetStatus(uint bit) = 0;
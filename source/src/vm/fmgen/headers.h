@@ -4,13 +4,21 @@
 #define STRICT
 #define WIN32_LEAN_AND_MEAN
 
+#ifdef _WIN32
 #include <windows.h>
+#endif
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
 #include <string.h>
 #include <assert.h>
 
+#ifndef _WIN32
+#include "../../common.h"
+#define MAX_PATH _MAX_PATH
+#define __stdcall
+#endif
+
 #ifdef _MSC_VER
 	#undef max
 	#define max _MAX
@@ -8,6 +8,7 @@
 #include "misc.h"
 #include "opna.h"
 #include "fmgeninl.h"
+#include "../../fileio.h"
 
 #define BUILD_OPN
 #define BUILD_OPNA
@@ -37,7 +38,6 @@ namespace FM
 
 #if defined(BUILD_OPN) || defined(BUILD_OPNA) || defined (BUILD_OPNB)
 
-uint32	OPNBase::lfotable[8];			// OPNA/B p
 
 OPNBase::OPNBase()
 {
@@ -178,6 +178,54 @@ void OPNBase::Intr(bool value)
 	interrupt = value;
 }
 
+// ---------------------------------------------------------------------------
+//	save/load state
+//
+#define OPNBASE_STATE_VERSION	1
+
+void OPNBase::SaveState(void* f)
+{
+	FILEIO* fio = (FILEIO*)f;
+	
+	fio->FputUint32(OPNBASE_STATE_VERSION);
+	Timer::SaveState(f);
+	fio->FputInt32(fmvolume);
+	fio->FputUint32(clock);
+	fio->FputUint32(rate);
+	fio->FputUint32(psgrate);
+	fio->FputUint32(status);
+	fio->FputBool(interrupt);
+	fio->FputUint8(prescale);
+	chip.SaveState(f);
+	psg.SaveState(f);
+}
+
+bool OPNBase::LoadState(void* f)
+{
+	FILEIO* fio = (FILEIO*)f;
+	
+	if (fio->FgetUint32() != OPNBASE_STATE_VERSION)
+		return false;
+	if (!Timer::LoadState(f))
+		return false;
+	fmvolume = fio->FgetInt32();
+	clock = fio->FgetUint32();
+	rate = fio->FgetUint32();
+	psgrate = fio->FgetUint32();
+	status = fio->FgetUint32();
+	interrupt = fio->FgetBool();
+	prescale = fio->FgetUint8();
+	if (prescale >= 3)
+		return false;
+	// rebuild the tables that depend on the prescaler
+	RebuildTimeTable();
+	if (!chip.LoadState(f))
+		return false;
+	if (!psg.LoadState(f))
+		return false;
+	return true;
+}
+
 #endif // defined(BUILD_OPN) || defined(BUILD_OPNA) || defined (BUILD_OPNB)
 
 // ---------------------------------------------------------------------------
@@ -378,6 +426,49 @@ void OPN::Mix(Sample* buffer, int nsamples)
 #undef IStoSample
 }
 
+// ---------------------------------------------------------------------------
+//	save/load state
+//
+#define OPN_STATE_VERSION	1
+
+void OPN::SaveState(void* f)
+{
+	FILEIO* fio = (FILEIO*)f;
+	
+	fio->FputUint32(OPN_STATE_VERSION);
+	OPNBase::SaveState(f);
+	for (int i=0; i<3; i++)
+	{
+		fio->FputUint32(fnum[i]);
+		fio->FputUint32(fnum3[i]);
+	}
+	fio->Fwrite(fnum2, sizeof(fnum2), 1);
+	for (int i=0; i<3; i++)
+		ch[i].SaveState(f);
+}
+
+bool OPN::LoadState(void* f)
+{
+	FILEIO* fio = (FILEIO*)f;
+	
+	if (fio->FgetUint32() != OPN_STATE_VERSION)
+		return false;
+	if (!OPNBase::LoadState(f))
+		return false;
+	for (int i=0; i<3; i++)
+	{
+		fnum[i] = fio->FgetUint32();
+		fnum3[i] = fio->FgetUint32();
+	}
+	fio->Fread(fnum2, sizeof(fnum2), 1);
+	for (int i=0; i<3; i++)
+	{
+		if (!ch[i].LoadState(f))
+			return false;
+	}
+	return true;
+}
+
 #endif // BUILD_OPN
 
 // ---------------------------------------------------------------------------
@@ -390,7 +481,8 @@ int OPNABase::amtable[FM_LFOENTS] = { -1, };
 int OPNABase::pmtable[FM_LFOENTS];
 
 int32 OPNABase::tltable[FM_TLENTS+FM_TLPOS];
-bool OPNABase::tablehasmade = false;
+// Built at startup and only read after that, like the FM::Operator tables.
+bool OPNABase::tablehasmade = (OPNABase::MakeTable2(), OPNABase::BuildLFOTable(), true);
 
 OPNABase::OPNABase()
 {
@@ -1162,6 +1254,41 @@ void OPNABase::Mix6(Sample* buffer, int nsamples, int activech)
 	idest[4] = &ibuf[pan[4]];
 	idest[5] = &ibuf[pan[5]];
 
+#if defined(SIMD_USE_AVX2)
+	// the active channels are calculated together when lfo is not used,
+	// the gathers do not pay off for less than 5 channels
+	Channel4* chs[6];
+	ISample* chdest[6];
+	int nch = 0;
+	for (int c=0; c<6; c++)
+	{
+		if (activech & (1 << (c * 2)))
+		{
+			chs[nch] = &ch[c];
+			chdest[nch++] = idest[c];
+		}
+	}
+	if (!(activech & 0xaaa) && nch >= 5)
+	{
+		ISample rbuf[FM_AVX2_SAMPLES * 8];
+		Sample* dest = buffer;
+		for (int i=0; i<nsamples; i+=FM_AVX2_SAMPLES)
+		{
+			int n = Min(nsamples - i, FM_AVX2_SAMPLES);
+			Channel4::CalcAVX2(chs, nch, rbuf, n);
+			for (int j=0; j<n; j++, dest+=2)
+			{
+				ibuf[0] = ibuf[1] = ibuf[2] = ibuf[3] = 0;
+				for (int c=0; c<nch; c++)
+					*chdest[c] += rbuf[j * 8 + c];
+				StoreSample(dest[0], IStoSample(ibuf[2] + ibuf[3]));
+				StoreSample(dest[1], IStoSample(ibuf[1] + ibuf[3]));
+			}
+		}
+		return;
+	}
+#endif
+
 	Sample* limit = buffer + nsamples * 2;
 	for (Sample* dest = buffer; dest < limit; dest+=2)
 	{
@@ -1175,6 +1302,114 @@ void OPNABase::Mix6(Sample* buffer, int nsamples, int activech)
 	}
 }
 
+// ---------------------------------------------------------------------------
+//	save/load state
+//	the contents of adpcm buffer are saved by the derived class
+//
+#define OPNABASE_STATE_VERSION	1
+
+void OPNABase::SaveState(void* f)
+{
+	FILEIO* fio = (FILEIO*)f;
+	
+	fio->FputUint32(OPNABASE_STATE_VERSION);
+	OPNBase::SaveState(f);
+	fio->Fwrite(pan, sizeof(pan), 1);
+	fio->Fwrite(fnum2, sizeof(fnum2), 1);
+	fio->FputUint8(reg22);
+	fio->FputUint32(reg29);
+	fio->FputUint32(stmask);
+	fio->FputUint32(statusnext);
+	fio->FputUint32(lfocount);
+	fio->FputUint32(lfodcount);
+	for (int i=0; i<6; i++)
+		fio->FputUint32(fnum[i]);
+	for (int i=0; i<3; i++)
+		fio->FputUint32(fnum3[i]);
+	fio->FputUint32(adpcmmask);
+	fio->FputUint32(adpcmnotice);
+	fio->FputUint32(startaddr);
+	fio->FputUint32(stopaddr);
+	fio->FputUint32(memaddr);
+	fio->FputUint32(limitaddr);
+	fio->FputInt32(adpcmlevel);
+	fio->FputInt32(adpcmvolume);
+	fio->FputInt32(adpcmvol);
+	fio->FputUint32(deltan);
+	fio->FputInt32(adplc);
+	fio->FputInt32(adpld);
+	fio->FputUint32(adplbase);
+	fio->FputInt32(adpcmx);
+	fio->FputInt32(adpcmd);
+	fio->FputInt32(adpcmout);
+	fio->FputInt32(apout0);
+	fio->FputInt32(apout1);
+	fio->FputUint32(adpcmreadbuf);
+	fio->FputBool(adpcmplay);
+	fio->FputInt8(granuality);
+	fio->FputBool(adpcmmask_);
+	fio->FputUint8(control1);
+	fio->FputUint8(control2);
+	fio->Fwrite(adpcmreg, sizeof(adpcmreg), 1);
+	fio->FputInt32(rhythmmask_);
+	for (int i=0; i<6; i++)
+		ch[i].SaveState(f);
+}
+
+bool OPNABase::LoadState(void* f)
+{
+	FILEIO* fio = (FILEIO*)f;
+	
+	if (fio->FgetUint32() != OPNABASE_STATE_VERSION)
+		return false;
+	if (!OPNBase::LoadState(f))
+		return false;
+	fio->Fread(pan, sizeof(pan), 1);
+	fio->Fread(fnum2, sizeof(fnum2), 1);
+	reg22 = fio->FgetUint8();
+	reg29 = fio->FgetUint32();
+	stmask = fio->FgetUint32();
+	statusnext = fio->FgetUint32();
+	lfocount = fio->FgetUint32();
+	lfodcount = fio->FgetUint32();
+	for (int i=0; i<6; i++)
+		fnum[i] = fio->FgetUint32();
+	for (int i=0; i<3; i++)
+		fnum3[i] = fio->FgetUint32();
+	adpcmmask = fio->FgetUint32();
+	adpcmnotice = fio->FgetUint32();
+	startaddr = fio->FgetUint32();
+	stopaddr = fio->FgetUint32();
+	memaddr = fio->FgetUint32();
+	limitaddr = fio->FgetUint32();
+	adpcmlevel = fio->FgetInt32();
+	adpcmvolume = fio->FgetInt32();
+	adpcmvol = fio->FgetInt32();
+	deltan = fio->FgetUint32();
+	adplc = fio->FgetInt32();
+	adpld = fio->FgetInt32();
+	adplbase = fio->FgetUint32();
+	adpcmx = fio->FgetInt32();
+	adpcmd = fio->FgetInt32();
+	adpcmout = fio->FgetInt32();
+	apout0 = fio->FgetInt32();
+	apout1 = fio->FgetInt32();
+	adpcmreadbuf = fio->FgetUint32();
+	adpcmplay = fio->FgetBool();
+	granuality = fio->FgetInt8();
+	adpcmmask_ = fio->FgetBool();
+	control1 = fio->FgetUint8();
+	control2 = fio->FgetUint8();
+	fio->Fread(adpcmreg, sizeof(adpcmreg), 1);
+	rhythmmask_ = fio->FgetInt32();
+	for (int i=0; i<6; i++)
+	{
+		if (!ch[i].LoadState(f))
+			return false;
+	}
+	return true;
+}
+
 #endif // defined(BUILD_OPNA) || defined(BUILD_OPNB)
 
 // ---------------------------------------------------------------------------
@@ -1493,6 +1728,53 @@ void OPNA::Mix(Sample* buffer, int nsamples)
 	RhythmMix(buffer, nsamples);
 }
 
+// ---------------------------------------------------------------------------
+//	save/load state
+//	rhythm samples are not saved, they are loaded from files in Init
+//
+#define OPNA_STATE_VERSION	1
+
+void OPNA::SaveState(void* f)
+{
+	FILEIO* fio = (FILEIO*)f;
+	
+	fio->FputUint32(OPNA_STATE_VERSION);
+	OPNABase::SaveState(f);
+	fio->Fwrite(adpcmbuf, 0x40000, 1);
+	for (int i=0; i<6; i++)
+	{
+		fio->FputUint8(rhythm[i].pan);
+		fio->FputInt8(rhythm[i].level);
+		fio->FputInt32(rhythm[i].volume);
+		fio->FputUint32(rhythm[i].pos);
+	}
+	fio->FputInt8(rhythmtl);
+	fio->FputInt32(rhythmtvol);
+	fio->FputUint8(rhythmkey);
+}
+
+bool OPNA::LoadState(void* f)
+{
+	FILEIO* fio = (FILEIO*)f;
+	
+	if (fio->FgetUint32() != OPNA_STATE_VERSION)
+		return false;
+	if (!OPNABase::LoadState(f))
+		return false;
+	fio->Fread(adpcmbuf, 0x40000, 1);
+	for (int i=0; i<6; i++)
+	{
+		rhythm[i].pan = fio->FgetUint8();
+		rhythm[i].level = fio->FgetInt8();
+		rhythm[i].volume = fio->FgetInt32();
+		rhythm[i].pos = fio->FgetUint32();
+	}
+	rhythmtl = fio->FgetInt8();
+	rhythmtvol = fio->FgetInt32();
+	rhythmkey = fio->FgetUint8();
+	return true;
+}
+
 #endif // BUILD_OPNA
 
 // ---------------------------------------------------------------------------
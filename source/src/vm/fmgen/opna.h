@@ -7,7 +7,11 @@
 #ifndef FM_OPNA_H
 #define FM_OPNA_H
 
+#ifdef _WIN32
 #include <tchar.h>
+#else
+#include "headers.h"
+#endif
 #include "fmgen.h"
 #include "fmtimer.h"
 #include "psg.h"
@@ -98,6 +102,9 @@ namespace FM
 		void	SetVolumeFM(int db);
 		void	SetVolumePSG(int db);
 		void	SetLPFCutoff(uint freq) {}	// obsolete
+		
+		void	SaveState(void* f);
+		bool	LoadState(void* f);
 
 	protected:
 		void	SetParameter(Channel4* ch, uint addr, uint data);
@@ -115,7 +122,7 @@ namespace FM
 		Channel4* csmch;
 		
 
-		static  uint32 lfotable[8];
+		uint32	lfotable[8];
 	
 	private:
 		void	TimerA();
@@ -136,9 +143,12 @@ namespace FM
 		uint	ReadStatus() { return status & 0x03; }
 		uint	ReadStatusEx();
 		void	SetChannelMask(uint mask);
+		
+		void	SaveState(void* f);
+		bool	LoadState(void* f);
 	
 	private:
-		void	MakeTable2();
+		static void	MakeTable2();
 	
 	protected:
 		bool	Init(uint c, uint r, bool);
@@ -245,6 +255,9 @@ namespace FM
 		
 		void	SetChannelMask(uint mask);
 		
+		void	SaveState(void* f);
+		bool	LoadState(void* f);
+		
 		int		dbgGetOpOut(int c, int s) { return ch[c].op[s].dbgopout_; }
 		int		dbgGetPGOut(int c, int s) { return ch[c].op[s].dbgpgout_; }
 		Channel4* dbgGetCh(int c) { return &ch[c]; }
@@ -282,6 +295,9 @@ namespace FM
 		void	SetVolumeRhythm(int index, int db);
 
 		uint8*	GetADPCMBuffer() { return adpcmbuf; }
+		
+		void	SaveState(void* f);
+		bool	LoadState(void* f);
 
 		int		dbgGetOpOut(int c, int s) { return ch[c].op[s].dbgopout_; }
 		int		dbgGetPGOut(int c, int s) { return ch[c].op[s].dbgpgout_; }
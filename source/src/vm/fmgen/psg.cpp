@@ -9,6 +9,12 @@
 #include "psg.h"
 // for AY-3-8190/8192
 #include "../vm.h"
+#include "../../fileio.h"
+#if defined(SIMD_USE_SSE2)
+#include <emmintrin.h>
+#endif
+
+#define PSG_STATE_VERSION	1
 
 // ---------------------------------------------------------------------------
 //	RXgN^EfXgN^
@@ -258,13 +264,26 @@ void PSG::Mix(Sample* dest, int nsamples)
 		
 		#define SCOUNT(ch)	(scount[ch] >> (toneshift+oversampling))
 		
+		// 4 samples at once, the rest is done by the loops below
+		int done = 0;
+#if defined(SIMD_USE_SSE2)
+		bool envon[3] = { p1 == &env, p2 == &env, p3 == &env };
+		if (envon[0] || envon[1] || envon[2])
+			done = MixSSE2<true, true>(dest, nsamples, chenable, nenable, envon);
+		else if (r7 & 0x38)
+			done = MixSSE2<true, false>(dest, nsamples, chenable, nenable, envon);
+		else
+			done = MixSSE2<false, false>(dest, nsamples, chenable, nenable, envon);
+		dest += done * 2;
+#endif
+		
 		if (p1 != &env && p2 != &env && p3 != &env)
 		{
 			// Gx[v
 			if ((r7 & 0x38) == 0)
 			{
 				// mCY
-				for (int i=0; i<nsamples; i++)
+				for (int i=done; i<nsamples; i++)
 				{
 					sample = 0;
 					for (int j=0; j < (1 << oversampling); j++)
@@ -289,7 +308,7 @@ void PSG::Mix(Sample* dest, int nsamples)
 			else
 			{
 				// mCYL
-				for (int i=0; i<nsamples; i++)
+				for (int i=done; i<nsamples; i++)
 				{
 					sample = 0;
 					for (int j=0; j < (1 << oversampling); j++)
@@ -334,7 +353,7 @@ void PSG::Mix(Sample* dest, int nsamples)
 		else
 		{
 			// Gx[v
-			for (int i=0; i<nsamples; i++)
+			for (int i=done; i<nsamples; i++)
 			{
 				sample = 0;
 				for (int j=0; j < (1 << oversampling); j++)
@@ -376,9 +395,173 @@ void PSG::Mix(Sample* dest, int nsamples)
 	}
 }
 
+#if defined(SIMD_USE_SSE2)
+// ---------------------------------------------------------------------------
+//	SSE2 version of Mix: each lane synthesizes one of 4 samples
+//	the noise and the envelope are stepped in the same order as the loops
+//	retval	number of the synthesized samples (multiple of 4)
+//
+//	one tone channel of 4 samples at a sub step
+static inline __m128i ToneSSE2(__m128i& cnt, __m128i step, __m128i chen, __m128i level, __m128i noise, __m128i nen, bool usenoise)
+{
+	__m128i x = _mm_and_si128(_mm_srli_epi32(cnt, PSG::toneshift+PSG::oversampling), chen);
+	if (usenoise)
+		x = _mm_or_si128(x, _mm_and_si128(noise, nen));
+	x = _mm_add_epi32(x, _mm_set1_epi32(-1));		// 0 or -1
+	cnt = _mm_add_epi32(cnt, step);
+	return _mm_xor_si128(_mm_add_epi32(level, x), x);
+}
+
+template <bool usenoise, bool useenv>
+int PSG::MixSSE2(Sample* dest, int nsamples, const uint8* chenable, const uint8* nenable, const bool* envon)
+{
+	const int steps = 1 << oversampling;
+	int count = nsamples & ~3;
+	if (sizeof(Sample) != 4 || count == 0)
+		return 0;
+	
+	// lane k synthesizes the sample k in the group of 4 samples
+	uint32 p0 = speriod[0] * steps, p1 = speriod[1] * steps, p2 = speriod[2] * steps;
+	__m128i cnt0 = _mm_setr_epi32(scount[0], scount[0] + p0, scount[0] + p0 * 2, scount[0] + p0 * 3);
+	__m128i cnt1 = _mm_setr_epi32(scount[1], scount[1] + p1, scount[1] + p1 * 2, scount[1] + p1 * 3);
+	__m128i cnt2 = _mm_setr_epi32(scount[2], scount[2] + p2, scount[2] + p2 * 2, scount[2] + p2 * 3);
+	__m128i step0 = _mm_set1_epi32(speriod[0]), step1 = _mm_set1_epi32(speriod[1]), step2 = _mm_set1_epi32(speriod[2]);
+	__m128i skip0 = _mm_set1_epi32(p0 * 3), skip1 = _mm_set1_epi32(p1 * 3), skip2 = _mm_set1_epi32(p2 * 3);
+	__m128i chen0 = _mm_set1_epi32(chenable[0]), chen1 = _mm_set1_epi32(chenable[1]), chen2 = _mm_set1_epi32(chenable[2]);
+	__m128i nen0 = _mm_set1_epi32(nenable[0]), nen1 = _mm_set1_epi32(nenable[1]), nen2 = _mm_set1_epi32(nenable[2]);
+	__m128i level0 = _mm_set1_epi32(envon[0] ? 0 : olevel[0]);
+	__m128i level1 = _mm_set1_epi32(envon[1] ? 0 : olevel[1]);
+	__m128i level2 = _mm_set1_epi32(envon[2] ? 0 : olevel[2]);
+	__m128i envmask0 = _mm_set1_epi32(envon[0] ? -1 : 0);
+	__m128i envmask1 = _mm_set1_epi32(envon[1] ? -1 : 0);
+	__m128i envmask2 = _mm_set1_epi32(envon[2] ? -1 : 0);
+	uint32 noise[1 << oversampling][4], env[1 << oversampling][4];
+	
+	for (int i=0; i<count; i+=4)
+	{
+		if (usenoise || useenv)
+		{
+			for (int k=0; k<4; k++)
+			{
+				for (int j=0; j<steps; j++)
+				{
+					if (useenv)
+					{
+						env[j][k] = envelop[ecount >> (envshift+oversampling)];
+						ecount += eperiod;
+						if (ecount >= (1 << (envshift+6+oversampling)))
+						{
+							if ((reg[0x0d] & 0x0b) != 0x0a)
+								ecount |= (1 << (envshift+5+oversampling));
+							ecount &= (1 << (envshift+6+oversampling)) - 1;
+						}
+					}
+					noise[j][k] = noisetable[(ncount >> (noiseshift+oversampling+6)) & (noisetablesize-1)] 
+						>> (ncount >> (noiseshift+oversampling+1) & 31);
+					ncount += nperiod;
+				}
+			}
+		}
+		
+		__m128i sample = _mm_setzero_si128();
+		for (int j=0; j<steps; j++)
+		{
+			__m128i n = _mm_setzero_si128();
+			__m128i l0 = level0, l1 = level1, l2 = level2;
+			if (usenoise)
+				n = _mm_loadu_si128((__m128i*)noise[j]);
+			if (useenv)
+			{
+				__m128i e = _mm_loadu_si128((__m128i*)env[j]);
+				l0 = _mm_or_si128(l0, _mm_and_si128(e, envmask0));
+				l1 = _mm_or_si128(l1, _mm_and_si128(e, envmask1));
+				l2 = _mm_or_si128(l2, _mm_and_si128(e, envmask2));
+			}
+			sample = _mm_add_epi32(sample, ToneSSE2(cnt0, step0, chen0, l0, n, nen0, usenoise));
+			sample = _mm_add_epi32(sample, ToneSSE2(cnt1, step1, chen1, l1, n, nen1, usenoise));
+			sample = _mm_add_epi32(sample, ToneSSE2(cnt2, step2, chen2, l2, n, nen2, usenoise));
+		}
+		cnt0 = _mm_add_epi32(cnt0, skip0);
+		cnt1 = _mm_add_epi32(cnt1, skip1);
+		cnt2 = _mm_add_epi32(cnt2, skip2);
+		
+		// sample /= (1 << oversampling), rounded toward zero
+		sample = _mm_add_epi32(sample, _mm_srli_epi32(_mm_srai_epi32(sample, 31), 32 - oversampling));
+		sample = _mm_srai_epi32(sample, oversampling);
+		
+		__m128i* d = (__m128i*)dest;
+		_mm_storeu_si128(d + 0, _mm_add_epi32(_mm_loadu_si128(d + 0), _mm_unpacklo_epi32(sample, sample)));
+		_mm_storeu_si128(d + 1, _mm_add_epi32(_mm_loadu_si128(d + 1), _mm_unpackhi_epi32(sample, sample)));
+		dest += 8;
+	}
+	scount[0] = _mm_cvtsi128_si32(cnt0);
+	scount[1] = _mm_cvtsi128_si32(cnt1);
+	scount[2] = _mm_cvtsi128_si32(cnt2);
+	return count;
+}
+#endif
+
+// ---------------------------------------------------------------------------
+//	save/load state
+//	the envelop pointer is saved as the offset from the top of table
+//
+void PSG::SaveState(void* f)
+{
+	FILEIO* fio = (FILEIO*)f;
+	
+	fio->FputUint32(PSG_STATE_VERSION);
+	fio->Fwrite(reg, sizeof(reg), 1);
+	fio->FputInt32((int)(envelop - &enveloptable[0][0]));
+	for (int i=0; i<3; i++)
+	{
+		fio->FputUint32(olevel[i]);
+		fio->FputUint32(scount[i]);
+		fio->FputUint32(speriod[i]);
+	}
+	fio->FputUint32(ecount);
+	fio->FputUint32(eperiod);
+	fio->FputUint32(ncount);
+	fio->FputUint32(nperiod);
+	fio->FputUint32(tperiodbase);
+	fio->FputUint32(eperiodbase);
+	fio->FputUint32(nperiodbase);
+	fio->FputInt32(volume);
+	fio->FputInt32(mask);
+}
+
+bool PSG::LoadState(void* f)
+{
+	FILEIO* fio = (FILEIO*)f;
+	
+	if (fio->FgetUint32() != PSG_STATE_VERSION)
+		return false;
+	fio->Fread(reg, sizeof(reg), 1);
+	int envelop_offset = fio->FgetInt32();
+	if (envelop_offset < 0 || envelop_offset >= 16 * 64)
+		return false;
+	envelop = &enveloptable[0][0] + envelop_offset;
+	for (int i=0; i<3; i++)
+	{
+		olevel[i] = fio->FgetUint32();
+		scount[i] = fio->FgetUint32();
+		speriod[i] = fio->FgetUint32();
+	}
+	ecount = fio->FgetUint32();
+	eperiod = fio->FgetUint32();
+	ncount = fio->FgetUint32();
+	nperiod = fio->FgetUint32();
+	tperiodbase = fio->FgetUint32();
+	eperiodbase = fio->FgetUint32();
+	nperiodbase = fio->FgetUint32();
+	volume = fio->FgetInt32();
+	mask = fio->FgetInt32();
+	return true;
+}
+
 // ---------------------------------------------------------------------------
 //	e[u
 //
 uint	PSG::noisetable[noisetablesize] = { 0, };
-int		PSG::EmitTable[0x20] = { -1, };
-uint	PSG::enveloptable[16][64] = { 0, };
+// The volume and envelope tables depend on SetVolume and are per instance;
+// only the noise table is shared, and it is built once at startup.
+bool	PSG::tablehasmade = (PSG::MakeNoiseTable(), true);
@@ -68,11 +68,18 @@ public:
 	void Reset();
 	void SetReg(uint regnum, uint8 data);
 	uint GetReg(uint regnum) { return reg[regnum & 0x0f]; }
+	
+	void SaveState(void* f);
+	bool LoadState(void* f);
 
 protected:
-	void MakeNoiseTable();
+	static void MakeNoiseTable();
 	void MakeEnvelopTable();
 	static void StoreSample(Sample& dest, int32 data);
+#if defined(SIMD_USE_SSE2)
+	template <bool usenoise, bool useenv>
+	int MixSSE2(Sample* dest, int nsamples, const uint8* chenable, const uint8* nenable, const bool* envon);
+#endif
 	
 	uint8 reg[16];
 
@@ -87,9 +94,11 @@ protected:
 	int volume;
 	int mask;
 
-	static uint enveloptable[16][64];
+	uint enveloptable[16][64];
+	int EmitTable[32];
+	
+	static bool tablehasmade;
 	static uint noisetable[noisetablesize];
-	static int EmitTable[32];
 };
 
 #endif // PSG_H
@@ -127,6 +127,8 @@ void MAIN::write_signal(int id, uint32 data, uint32 mask)
 {
 	switch(id) {
 	case SIG_MAIN_INTS:
+		// from sub pcb
+		set_sync_point();
 	case SIG_MAIN_INTA:
 	case SIG_MAIN_INTB:
 	case SIG_MAIN_INTC:
@@ -145,6 +147,7 @@ void MAIN::write_signal(int id, uint32 data, uint32 mask)
 		}
 		break;
 	case SIG_MAIN_COMM:
+		set_sync_point();
 		comm_data = data & 0xff;
 		break;
 	}
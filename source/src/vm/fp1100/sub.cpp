@@ -194,6 +194,7 @@ void SUB::write_signal(int id, uint32 data, uint32 mask)
 	switch(id) {
 	case SIG_SUB_INT2:
 		// from main pcb
+		set_sync_point();
 		d_cpu->write_signal(SIG_UPD7801_INTF2, data, mask);
 		// ugly patch for boot
 		if(data & mask) {
@@ -202,6 +203,7 @@ void SUB::write_signal(int id, uint32 data, uint32 mask)
 		break;
 	case SIG_SUB_COMM:
 		// from main pcb
+		set_sync_point();
 		comm_data = data & 0xff;
 		// ugly patch for command
 		if(get_cpu_pc(1) == 0x10e || get_cpu_pc(1) == 0x110) {
@@ -97,6 +97,22 @@ uint32 HUC6280::get_pc()
 	return cpustate->ppc.w.l;
 }
 
+int HUC6280::get_run_clock()
+{
+	h6280_Regs *cpustate = (h6280_Regs *)opaque;
+	return cpustate->Base_ICount - cpustate->Opecode_ICount;
+}
+
+void HUC6280::stop_run()
+{
+	h6280_Regs *cpustate = (h6280_Regs *)opaque;
+	if(cpustate->ICount > 0) {
+		cpustate->Base_ICount -= cpustate->ICount;
+		cpustate->Opecode_ICount -= cpustate->ICount;
+		cpustate->ICount = 0;
+	}
+}
+
 uint8 HUC6280::irq_status_r(uint16 offset)
 {
 	h6280_Regs *cpustate = (h6280_Regs *)opaque;
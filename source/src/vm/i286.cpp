@@ -170,3 +170,19 @@ uint32 I286::get_pc()
 	cpu_state *cpustate = (cpu_state *)opaque;
 	return cpustate->prevpc;
 }
+
+int I286::get_run_clock()
+{
+	cpu_state *cpustate = (cpu_state *)opaque;
+	return cpustate->base_icount - cpustate->opecode_icount;
+}
+
+void I286::stop_run()
+{
+	cpu_state *cpustate = (cpu_state *)opaque;
+	if(cpustate->icount > 0) {
+		cpustate->base_icount -= cpustate->icount;
+		cpustate->opecode_icount -= cpustate->icount;
+		cpustate->icount = 0;
+	}
+}
@@ -48,6 +48,8 @@ public:
 	void write_signal(int id, uint32 data, uint32 mask);
 	void set_intr_line(bool line, bool pending, uint32 bit);
 	uint32 get_pc();
+	int get_run_clock();
+	void stop_run();
 	
 	// unique function
 	void set_context_mem(DEVICE* device) {
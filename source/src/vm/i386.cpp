@@ -150,6 +150,15 @@ void I386::initialize()
 #ifdef SINGLE_MODE_DMA
 	cpustate->dma = d_dma;
 #endif
+	
+	// access the memory banks directly if the memory device exports them
+	cpustate->read_shift = cpustate->write_shift = 0;
+	cpustate->read_bank = d_mem->get_read_bank_table(&cpustate->read_shift);
+	cpustate->write_bank = d_mem->get_write_bank_table(&cpustate->write_shift);
+	cpustate->read_mask = (1 << cpustate->read_shift) - 1;
+	cpustate->write_mask = (1 << cpustate->write_shift) - 1;
+	cpustate->bank_addr_mask = d_mem->get_bank_table_addr_mask();
+	cpustate->tlb_hit = cpustate->tlb_miss = 0;
 }
 
 void I386::release()
@@ -198,3 +207,26 @@ uint32 I386::get_pc()
 	i386_state *cpustate = (i386_state *)opaque;
 	return cpustate->prev_pc;
 }
+
+int I386::get_run_clock()
+{
+	i386_state *cpustate = (i386_state *)opaque;
+	return cpustate->base_cycles - cpustate->opecode_cycles;
+}
+
+void I386::stop_run()
+{
+	i386_state *cpustate = (i386_state *)opaque;
+	if(cpustate->cycles > 0) {
+		cpustate->base_cycles -= cpustate->cycles;
+		cpustate->opecode_cycles -= cpustate->cycles;
+		cpustate->cycles = 0;
+	}
+}
+
+void I386::get_tlb_count(uint64* hit, uint64* miss)
+{
+	i386_state *cpustate = (i386_state *)opaque;
+	*hit = cpustate->tlb_hit;
+	*miss = cpustate->tlb_miss;
+}
@@ -487,9 +487,10 @@ int I8080::run(int clock)
 	else {
 		// run cpu while given clocks
 		count += clock;
-		int first_count = count;
+		first_count = count;
 		
 		while(count > 0 && !BUSREQ) {
+			opecode_count = count;
 			run_one_opecode();
 		}
 		int passed_count = first_count - count;
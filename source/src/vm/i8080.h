@@ -41,6 +41,7 @@ private:
 	--------------------------------------------------------------------------- */
 	
 	int count;
+	int first_count, opecode_count;
 	pair regs[4];
 	uint16 SP, PC, prevPC;
 	uint16 IM, RIM_IEN;
@@ -192,6 +193,16 @@ public:
 	uint32 get_pc() {
 		return prevPC;
 	}
+	int get_run_clock() {
+		return first_count - opecode_count;
+	}
+	void stop_run() {
+		if(count > 0) {
+			first_count -= count;
+			opecode_count -= count;
+			count = 0;
+		}
+	}
 	
 	// unique function
 	void set_context_mem(DEVICE* device) {
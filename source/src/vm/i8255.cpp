@@ -34,6 +34,9 @@ void I8255::write_io8(uint32 addr, uint32 data)
 	case 1:
 	case 2:
 		if(port[ch].wreg != data || port[ch].first) {
+			if(sync_cpus_by_output) {
+				set_sync_point();
+			}
 			write_signals(&port[ch].outputs, data);
 			port[ch].wreg = data;
 			port[ch].first = false;
@@ -39,6 +39,7 @@ public:
 			port[i].wreg = port[i].rreg = 0;//0xff;
 		}
 		clear_ports_by_cmdreg = false;
+		sync_cpus_by_output = false;
 	}
 	~I8255() {}
 	
@@ -59,6 +60,7 @@ public:
 		register_output_signal(&port[2].outputs, device, id, mask, shift);
 	}
 	bool clear_ports_by_cmdreg;
+	bool sync_cpus_by_output;	// the ports are connected to the other cpu
 };
 
 #endif
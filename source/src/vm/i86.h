@@ -69,6 +69,7 @@ private:
 	bool busreq, halted;
 	
 	int icount;
+	int first_icount, opecode_icount;
 	
 	bool seg_prefix;	/* prefix segment indicator */
 	uint8 prefix_seg;	/* The prefixed segment */
@@ -376,6 +377,16 @@ public:
 	uint32 get_pc() {
 		return prevpc;
 	}
+	int get_run_clock() {
+		return first_icount - opecode_icount;
+	}
+	void stop_run() {
+		if(icount > 0) {
+			first_icount -= icount;
+			opecode_icount -= icount;
+			icount = 0;
+		}
+	}
 	
 	// unique function
 	void set_context_mem(DEVICE* device) {
@@ -9,6 +9,8 @@
 
 #include "io.h"
 
+#define STATE_VERSION	1
+
 void IO::write_io8(uint32 addr, uint32 data)
 {
 	write_port8(addr, data, false);
@@ -105,6 +107,35 @@ uint32 IO::read_dma_io32(uint32 addr)
 	return read_port32(addr, true);
 }
 
+void IO::save_state(FILEIO* fio)
+{
+	fio->FputUint32(STATE_VERSION);
+	fio->FputInt32(this_device_id);
+	
+	// i/o map is static, only the registered values may be changed by flipflop
+	for(int i = 0; i < IO_ADDR_MAX; i++) {
+		if(rd_table[i].value_registered) {
+			fio->FputUint32(rd_table[i].value);
+		}
+	}
+}
+
+bool IO::load_state(FILEIO* fio)
+{
+	if(fio->FgetUint32() != STATE_VERSION) {
+		return false;
+	}
+	if(fio->FgetInt32() != this_device_id) {
+		return false;
+	}
+	for(int i = 0; i < IO_ADDR_MAX; i++) {
+		if(rd_table[i].value_registered) {
+			rd_table[i].value = fio->FgetUint32();
+		}
+	}
+	return true;
+}
+
 void IO::write_port8(uint32 addr, uint32 data, bool is_dma)
 {
 	uint32 laddr = addr & IO_ADDR_MASK, haddr = addr & ~IO_ADDR_MASK;
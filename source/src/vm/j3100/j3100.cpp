@@ -162,7 +162,7 @@ VM::VM(EMU* parent_emu) : emu(parent_emu)
 	io->set_iomap_range_rw(0x3f4, 0x3f5, fdc);
 	io->set_iomap_single_rw(0x3f7, floppy);
 	fdc->set_context_irq(pic, SIG_I8259_IR6 | SIG_I8259_CHIP0, 1);	// to PIC#0 IR6
-	fdc->set_context_drq(dma, SIG_I8237_CH2, 1);			// to DMA Ch.2
+	fdc->set_context_drq_dma(dma, SIG_I8237_CH2, 1);			// to DMA Ch.2
 	floppy->set_context_fdc(fdc);
 	
 	// printer
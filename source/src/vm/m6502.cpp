@@ -1026,9 +1026,10 @@ int M6502::run(int clock)
 	else {
 		// run cpu while given clocks
 		icount += clock;
-		int first_icount = icount;
+		first_icount = icount;
 		
 		while(icount > 0 && !busreq) {
+			opecode_icount = icount;
 			run_one_opecode();
 		}
 		int passed_icount = first_icount - icount;
@@ -28,6 +28,7 @@ private:
 	bool pending_irq, after_cli;
 	bool nmi_state, irq_state, so_state;
 	int icount;
+	int first_icount, opecode_icount;
 	bool busreq;
 	
 	void run_one_opecode();
@@ -51,6 +52,16 @@ public:
 	uint32 get_pc() {
 		return prev_pc;
 	}
+	int get_run_clock() {
+		return first_icount - opecode_icount;
+	}
+	void stop_run() {
+		if(icount > 0) {
+			first_icount -= icount;
+			opecode_icount -= icount;
+			icount = 0;
+		}
+	}
 	
 	// unique function
 	void set_context_mem(DEVICE* device) {
@@ -173,7 +173,7 @@ static CPU_EXECUTE( h6280 )
 	} else {
 		cpustate->ICount += ICount;
 	}
-	int Base_ICount = cpustate->ICount;
+	cpustate->Base_ICount = cpustate->ICount;
 
 	if ( cpustate->irq_pending == 2 ) {
 		cpustate->irq_pending--;
@@ -182,6 +182,7 @@ static CPU_EXECUTE( h6280 )
 	/* Execute instructions */
 	do
     {
+		cpustate->Opecode_ICount = cpustate->ICount;
 		cpustate->ppc = cpustate->pc;
 
 		/* Execute 1 instruction */
@@ -214,7 +215,7 @@ static CPU_EXECUTE( h6280 )
 		}
 	} while (cpustate->ICount > 0);
 
-	return Base_ICount - cpustate->ICount;
+	return cpustate->Base_ICount - cpustate->ICount;
 }
 
 /*****************************************************************************/
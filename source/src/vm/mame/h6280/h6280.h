@@ -31,6 +31,7 @@
 struct h6280_Regs
 {
 	int ICount;
+	int Base_ICount, Opecode_ICount;
 
 	PAIR  ppc;			/* previous program counter */
     PAIR  pc;           /* program counter */
@@ -1169,6 +1169,7 @@ static void i386_task_switch(i386_state *cpustate, UINT16 selector, UINT8 nested
 	cpustate->ldtr.base = seg.base;
 	cpustate->ldtr.flags = seg.flags;
 	cpustate->cr[3] = READ32(cpustate,tss+0x1c);  // CR3 (PDBR)
+	i386_flush_tlb(cpustate);
 	cpustate->eip = READ32(cpustate,tss+0x20);
 	set_flags(cpustate,READ32(cpustate,tss+0x24));
 	REG32(EAX) = READ32(cpustate,tss+0x28);
@@ -2906,7 +2907,12 @@ static void clear_cpustate(i386_state *cpustate)
 	DEVICE *save_dma = cpustate->dma;
 #endif
 	int busreq = cpustate->busreq;
+	UINT8 **save_read_bank = cpustate->read_bank, **save_write_bank = cpustate->write_bank;
+	int save_read_shift = cpustate->read_shift, save_write_shift = cpustate->write_shift;
+	UINT32 save_bank_addr_mask = cpustate->bank_addr_mask;
+	UINT64 tlb_hit = cpustate->tlb_hit, tlb_miss = cpustate->tlb_miss;
 
+	// the tlb is also flushed
 	memset( cpustate, 0, sizeof(*cpustate) );
 
 	cpustate->pic = save_pic;
@@ -2919,6 +2925,15 @@ static void clear_cpustate(i386_state *cpustate)
 	cpustate->dma = save_dma;
 #endif
 	cpustate->busreq = busreq;
+	cpustate->read_bank = save_read_bank;
+	cpustate->write_bank = save_write_bank;
+	cpustate->read_shift = save_read_shift;
+	cpustate->write_shift = save_write_shift;
+	cpustate->read_mask = (1 << save_read_shift) - 1;
+	cpustate->write_mask = (1 << save_write_shift) - 1;
+	cpustate->bank_addr_mask = save_bank_addr_mask;
+	cpustate->tlb_hit = tlb_hit;
+	cpustate->tlb_miss = tlb_miss;
 }
 
 static CPU_RESET( i386 )
@@ -3012,6 +3027,7 @@ static CPU_EXECUTE( i386 )
 
 	while( cpustate->cycles > 0 && !cpustate->busreq )
 	{
+		cpustate->opecode_cycles = cpustate->cycles;
 		i386_check_irq_line(cpustate);
 		cpustate->operand_size = cpustate->sreg[CS].d;
 		cpustate->address_size = cpustate->sreg[CS].d;
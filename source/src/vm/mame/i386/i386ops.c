@@ -687,6 +687,9 @@ static void I386OP(mov_cr_r32)(i386_state *cpustate)		// Opcode 0x0f 22
 	UINT8 cr = (modrm >> 3) & 0x7;
 
 	cpustate->cr[cr] = LOAD_RM32(modrm);
+	// the page tables or the paging mode may be changed
+	if(cr == 0 || cr == 3 || cr == 4)
+		i386_flush_tlb(cpustate);
 	switch(cr)
 	{
 		case 0: CYCLES(cpustate,CYCLES_MOV_REG_CR0); break;
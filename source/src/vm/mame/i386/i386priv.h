@@ -9,6 +9,13 @@
 
 //#define DEBUG_MISSING_OPCODE
 
+// software tlb: direct mapped by the linear page, one table for each access kind
+#define I386_TLB_BITS	9
+#define I386_TLB_SIZE	(1 << I386_TLB_BITS)
+#define I386_TLB_USER	1
+#define I386_TLB_WRITE	2
+#define I386_TLB_KINDS	4
+
 #define I386OP(XX)		i386_##XX
 #define I486OP(XX)		i486_##XX
 #define PENTIUMOP(XX)	pentium_##XX
@@ -308,6 +315,7 @@ struct i386_state
 
 	int cycles;
 	int base_cycles;
+	int opecode_cycles;
 	UINT8 opcode;
 
 	UINT8 irq_state;
@@ -322,6 +330,11 @@ struct i386_state
 #endif
 	UINT32 a20_mask;
 
+	// bank tables exported by the memory device
+	UINT8 **read_bank, **write_bank;
+	int read_shift, write_shift;
+	UINT32 read_mask, write_mask, bank_addr_mask;
+
 	int cpuid_max_input_value_eax;
 	UINT32 cpuid_id0, cpuid_id1, cpuid_id2;
 	UINT32 cpu_version;
@@ -366,6 +379,11 @@ struct i386_state
 	UINT8 *cycle_table_pm;
 	UINT8 *cycle_table_rm;
 
+	// software tlb: tag is the linear page | 1, and 0 is invalid
+	UINT32 tlb_tag[I386_TLB_KINDS][I386_TLB_SIZE];
+	UINT32 tlb_phys[I386_TLB_KINDS][I386_TLB_SIZE];
+	UINT64 tlb_hit, tlb_miss;
+
 	// bytes in current opcode, debug only
 #ifdef DEBUG_MISSING_OPCODE
 	UINT8 opcode_bytes[16];
@@ -466,7 +484,7 @@ INLINE UINT32 i386_translate(i386_state *cpustate, int segment, UINT32 ip, int r
 }
 
 // rwn; read = 0, write = 1, none = -1, read at PL 0 = -2
-INLINE int translate_address(i386_state *cpustate, int rwn, UINT32 *address, UINT32 *error)
+INLINE int translate_address_walk(i386_state *cpustate, int rwn, UINT32 *address, UINT32 *error)
 {
 	UINT32 a = *address;
 	UINT32 pdbr = cpustate->cr[3] & 0xfffff000;
@@ -559,6 +577,129 @@ INLINE int translate_address(i386_state *cpustate, int rwn, UINT32 *address, UIN
 	return 1;
 }
 
+INLINE void i386_flush_tlb(i386_state *cpustate)
+{
+	memset(cpustate->tlb_tag, 0, sizeof(cpustate->tlb_tag));
+}
+
+INLINE void i386_flush_tlb_page(i386_state *cpustate, UINT32 address)
+{
+	int index = (address >> 12) & (I386_TLB_SIZE - 1);
+	for(int kind = 0; kind < I386_TLB_KINDS; kind++)
+		cpustate->tlb_tag[kind][index] = 0;
+}
+
+// rwn; read = 0, write = 1, none = -1, read at PL 0 = -2
+INLINE int translate_address(i386_state *cpustate, int rwn, UINT32 *address, UINT32 *error)
+{
+	UINT32 a = *address;
+	int kind = (((cpustate->CPL == 3) && (rwn >= 0)) ? I386_TLB_USER : 0) | ((rwn == 1) ? I386_TLB_WRITE : 0);
+	int index = (a >> 12) & (I386_TLB_SIZE - 1);
+	UINT32 tag = (a & 0xfffff000) | 1;
+
+	if(cpustate->tlb_tag[kind][index] == tag)
+	{
+		// the accessed and dirty bits were already set by the page walk
+		*address = cpustate->tlb_phys[kind][index] | (a & 0xfff);
+		*error = 0;
+		cpustate->tlb_hit++;
+		return 1;
+	}
+	cpustate->tlb_miss++;
+	if(!translate_address_walk(cpustate, rwn, address, error))
+		return 0;
+	// rwn = -1 does not set the accessed bit, so its result is not cached
+	if(rwn != -1)
+	{
+		cpustate->tlb_tag[kind][index] = tag;
+		cpustate->tlb_phys[kind][index] = *address & 0xfffff000;
+	}
+	return 1;
+}
+
+// the banks exported by the memory device are accessed without the device call
+INLINE UINT8 *i386_read_bank(i386_state *cpustate, UINT32 address)
+{
+	if(cpustate->read_bank != NULL)
+	{
+		UINT8 *bank = cpustate->read_bank[(address & cpustate->bank_addr_mask) >> cpustate->read_shift];
+		if(bank != NULL)
+			return bank + (address & cpustate->read_mask);
+	}
+	return NULL;
+}
+
+INLINE UINT8 *i386_write_bank(i386_state *cpustate, UINT32 address)
+{
+	if(cpustate->write_bank != NULL)
+	{
+		UINT8 *bank = cpustate->write_bank[(address & cpustate->bank_addr_mask) >> cpustate->write_shift];
+		if(bank != NULL)
+			return bank + (address & cpustate->write_mask);
+	}
+	return NULL;
+}
+
+// 16/32bit accesses are aligned and never cross the bank
+INLINE UINT8 i386_read_phys8(i386_state *cpustate, UINT32 address)
+{
+	UINT8 *p = i386_read_bank(cpustate, address);
+	if(p != NULL)
+		return p[0];
+	return cpustate->program->read_data8(address);
+}
+
+INLINE UINT16 i386_read_phys16(i386_state *cpustate, UINT32 address)
+{
+	UINT8 *p = i386_read_bank(cpustate, address);
+	if(p != NULL)
+		return p[0] | (p[1] << 8);
+	return cpustate->program->read_data16(address);
+}
+
+INLINE UINT32 i386_read_phys32(i386_state *cpustate, UINT32 address)
+{
+	UINT8 *p = i386_read_bank(cpustate, address);
+	if(p != NULL)
+		return p[0] | (p[1] << 8) | (p[2] << 16) | ((UINT32)p[3] << 24);
+	return cpustate->program->read_data32(address);
+}
+
+INLINE void i386_write_phys8(i386_state *cpustate, UINT32 address, UINT8 value)
+{
+	UINT8 *p = i386_write_bank(cpustate, address);
+	if(p != NULL)
+		p[0] = value;
+	else
+		cpustate->program->write_data8(address, value);
+}
+
+INLINE void i386_write_phys16(i386_state *cpustate, UINT32 address, UINT16 value)
+{
+	UINT8 *p = i386_write_bank(cpustate, address);
+	if(p != NULL)
+	{
+		p[0] = value & 0xff;
+		p[1] = value >> 8;
+	}
+	else
+		cpustate->program->write_data16(address, value);
+}
+
+INLINE void i386_write_phys32(i386_state *cpustate, UINT32 address, UINT32 value)
+{
+	UINT8 *p = i386_write_bank(cpustate, address);
+	if(p != NULL)
+	{
+		p[0] = value & 0xff;
+		p[1] = (value >> 8) & 0xff;
+		p[2] = (value >> 16) & 0xff;
+		p[3] = value >> 24;
+	}
+	else
+		cpustate->program->write_data32(address, value);
+}
+
 INLINE void CHANGE_PC(i386_state *cpustate, UINT32 pc)
 {
 	UINT32 address, error;
@@ -598,7 +739,7 @@ INLINE UINT8 FETCH(i386_state *cpustate)
 			PF_THROW(error);
 	}
 
-	value = cpustate->program->read_data8(address & cpustate->a20_mask);
+	value = i386_read_phys8(cpustate, address & cpustate->a20_mask);
 #ifdef DEBUG_MISSING_OPCODE
 	cpustate->opcode_bytes[cpustate->opcode_bytes_length] = value;
 	cpustate->opcode_bytes_length = (cpustate->opcode_bytes_length + 1) & 15;
@@ -622,7 +763,7 @@ INLINE UINT16 FETCH16(i386_state *cpustate)
 				PF_THROW(error);
 		}
 		address &= cpustate->a20_mask;
-		value = cpustate->program->read_data16(address);
+		value = i386_read_phys16(cpustate, address);
 		cpustate->eip += 2;
 		cpustate->pc += 2;
 	}
@@ -646,7 +787,7 @@ INLINE UINT32 FETCH32(i386_state *cpustate)
 		}
 
 		address &= cpustate->a20_mask;
-		value = cpustate->program->read_data32(address);
+		value = i386_read_phys32(cpustate, address);
 		cpustate->eip += 4;
 		cpustate->pc += 4;
 	}
@@ -664,7 +805,7 @@ INLINE UINT8 READ8(i386_state *cpustate,UINT32 ea)
 	}
 
 	address &= cpustate->a20_mask;
-	return cpustate->program->read_data8(address);
+	return i386_read_phys8(cpustate, address);
 }
 INLINE UINT16 READ16(i386_state *cpustate,UINT32 ea)
 {
@@ -682,7 +823,7 @@ INLINE UINT16 READ16(i386_state *cpustate,UINT32 ea)
 		}
 
 		address &= cpustate->a20_mask;
-		value = cpustate->program->read_data16( address );
+		value = i386_read_phys16(cpustate, address);
 	}
 	return value;
 }
@@ -704,7 +845,7 @@ INLINE UINT32 READ32(i386_state *cpustate,UINT32 ea)
 		}
 
 		address &= cpustate->a20_mask;
-		value = cpustate->program->read_data32( address );
+		value = i386_read_phys32(cpustate, address);
 	}
 	return value;
 }
@@ -731,8 +872,8 @@ INLINE UINT64 READ64(i386_state *cpustate,UINT32 ea)
 		}
 
 		address &= cpustate->a20_mask;
-		value = (((UINT64) cpustate->program->read_data32( address+0 )) << 0) |
-				(((UINT64) cpustate->program->read_data32( address+4 )) << 32);
+		value = (((UINT64) i386_read_phys32(cpustate, address+0)) << 0) |
+				(((UINT64) i386_read_phys32(cpustate, address+4)) << 32);
 	}
 	return value;
 }
@@ -747,7 +888,7 @@ INLINE UINT8 READ8PL0(i386_state *cpustate,UINT32 ea)
 	}
 
 	address &= cpustate->a20_mask;
-	return cpustate->program->read_data8(address);
+	return i386_read_phys8(cpustate, address);
 }
 INLINE UINT16 READ16PL0(i386_state *cpustate,UINT32 ea)
 {
@@ -765,7 +906,7 @@ INLINE UINT16 READ16PL0(i386_state *cpustate,UINT32 ea)
 		}
 
 		address &= cpustate->a20_mask;
-		value = cpustate->program->read_data16( address );
+		value = i386_read_phys16(cpustate, address);
 	}
 	return value;
 }
@@ -787,7 +928,7 @@ INLINE UINT32 READ32PL0(i386_state *cpustate,UINT32 ea)
 		}
 
 		address &= cpustate->a20_mask;
-		value = cpustate->program->read_data32( address );
+		value = i386_read_phys32(cpustate, address);
 	}
 	return value;
 }
@@ -813,7 +954,7 @@ INLINE void WRITE8(i386_state *cpustate,UINT32 ea, UINT8 value)
 	}
 
 	address &= cpustate->a20_mask;
-	cpustate->program->write_data8(address, value);
+	i386_write_phys8(cpustate, address, value);
 }
 INLINE void WRITE16(i386_state *cpustate,UINT32 ea, UINT16 value)
 {
@@ -830,7 +971,7 @@ INLINE void WRITE16(i386_state *cpustate,UINT32 ea, UINT16 value)
 		}
 
 		address &= cpustate->a20_mask;
-		cpustate->program->write_data16(address, value);
+		i386_write_phys16(cpustate, address, value);
 	}
 }
 INLINE void WRITE32(i386_state *cpustate,UINT32 ea, UINT32 value)
@@ -850,7 +991,7 @@ INLINE void WRITE32(i386_state *cpustate,UINT32 ea, UINT32 value)
 		}
 
 		ea &= cpustate->a20_mask;
-		cpustate->program->write_data32(address, value);
+		i386_write_phys32(cpustate, address, value);
 	}
 }
 
@@ -875,8 +1016,8 @@ INLINE void WRITE64(i386_state *cpustate,UINT32 ea, UINT64 value)
 		}
 
 		ea &= cpustate->a20_mask;
-		cpustate->program->write_data32(address+0, value & 0xffffffff);
-		cpustate->program->write_data32(address+4, (value >> 32) & 0xffffffff);
+		i386_write_phys32(cpustate, address+0, value & 0xffffffff);
+		i386_write_phys32(cpustate, address+4, (value >> 32) & 0xffffffff);
 	}
 }
 
@@ -301,7 +301,12 @@ static void I486OP(group0F01_16)(i386_state *cpustate)		// Opcode 0x0f 01
 			}
 		case 7:			/* INVLPG */
 			{
-				// Nothing to do ?
+				if(PROTECTED_MODE && cpustate->CPL)
+					FAULT(FAULT_GP,0)
+				if( modrm < 0xc0 ) {
+					ea = GetEA(cpustate,modrm,-1);
+					i386_flush_tlb_page(cpustate, ea);
+				}
 				break;
 			}
 		default:
@@ -410,7 +415,12 @@ static void I486OP(group0F01_32)(i386_state *cpustate)		// Opcode 0x0f 01
 			}
 		case 7:			/* INVLPG */
 			{
-				// Nothing to do ?
+				if(PROTECTED_MODE && cpustate->CPL)
+					FAULT(FAULT_GP,0)
+				if( modrm < 0xc0 ) {
+					ea = GetEA(cpustate,modrm,-1);
+					i386_flush_tlb_page(cpustate, ea);
+				}
 				break;
 			}
 		default:
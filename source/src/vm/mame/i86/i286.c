@@ -79,6 +79,7 @@ struct i80286_state
 	int trap_level;
 
 	int icount;
+	int base_icount, opecode_icount;
 	char seg_prefix;
 	UINT8	prefix_seg;
 	unsigned ea;
@@ -229,7 +230,7 @@ static CPU_EXECUTE( i80286 )
 	} else {
 		cpustate->icount += icount;
 	}
-	int base_icount = cpustate->icount;
+	cpustate->base_icount = cpustate->icount;
 
 	/* copy over the cycle counts if they're not correct */
 	if (timing.id != 80286)
@@ -242,6 +243,7 @@ static CPU_EXECUTE( i80286 )
 	/* run until we're out */
 	while(cpustate->icount > 0 && !cpustate->busreq)
 	{
+		cpustate->opecode_icount = cpustate->icount;
 		cpustate->seg_prefix=FALSE;
 		try
 		{
@@ -267,7 +269,7 @@ static CPU_EXECUTE( i80286 )
 	cpustate->icount -= cpustate->extra_cycles;
 	cpustate->extra_cycles = 0;
 
-	int passed_icount = base_icount - cpustate->icount;
+	int passed_icount = cpustate->base_icount - cpustate->icount;
 
 	if (cpustate->icount > 0 && cpustate->busreq) {
 		cpustate->icount = 0;
@@ -49,6 +49,9 @@
 // 6msec, 12msec, 20msec, 30msec
 static const int seek_wait[4] = {6000, 12000, 20000, 30000};
 
+// fast disk: step the head every 100usec
+#define GET_SEEK_TIME (fast_disk ? 100 : seek_wait[cmdreg & 3])
+
 #define CANCEL_EVENT(event) { \
 	if(register_id[event] != -1) { \
 		cancel_event(register_id[event]); \
@@ -79,6 +82,7 @@ void MB8877::initialize()
 {
 	// config
 	ignore_crc = config.ignore_crc;
+	fast_disk = config.fast_disk;
 	
 	// initialize d88 handler
 	for(int i = 0; i < MAX_DRIVE; i++) {
@@ -118,6 +122,7 @@ void MB8877::reset()
 void MB8877::update_config()
 {
 	ignore_crc = config.ignore_crc;
+	fast_disk = config.fast_disk;
 }
 
 void MB8877::write_io8(uint32 addr, uint32 data)
@@ -490,7 +495,7 @@ void MB8877::event_callback(int event_id, int err)
 			set_irq(true);
 		}
 		else {
-			REGISTER_EVENT(EVENT_SEEK, seek_wait[cmdreg & 3] + err);
+			REGISTER_EVENT(EVENT_SEEK, GET_SEEK_TIME + err);
 		}
 		break;
 	case EVENT_SEEKEND:
@@ -619,7 +624,7 @@ void MB8877::cmd_restore()
 	seektrk = 0;
 	seekvct = true;
 	
-	REGISTER_EVENT(EVENT_SEEK, seek_wait[cmdreg & 3]);
+	REGISTER_EVENT(EVENT_SEEK, GET_SEEK_TIME);
 	REGISTER_EVENT(EVENT_SEEKEND, 300);
 }
 
@@ -637,7 +642,7 @@ void MB8877::cmd_seek()
 	seektrk = (seektrk > 83) ? 83 : (seektrk < 0) ? 0 : seektrk;
 	seekvct = !(datareg > trkreg);
 	
-	REGISTER_EVENT(EVENT_SEEK, seek_wait[cmdreg & 3]);
+	REGISTER_EVENT(EVENT_SEEK, GET_SEEK_TIME);
 	REGISTER_EVENT(EVENT_SEEKEND, 300);
 }
 
@@ -661,7 +666,7 @@ void MB8877::cmd_stepin()
 	seektrk = (fdc[drvreg].track < 83) ? fdc[drvreg].track + 1 : 83;
 	seekvct = false;
 	
-	REGISTER_EVENT(EVENT_SEEK, seek_wait[cmdreg & 3]);
+	REGISTER_EVENT(EVENT_SEEK, GET_SEEK_TIME);
 	REGISTER_EVENT(EVENT_SEEKEND, 300);
 }
 
@@ -674,12 +679,12 @@ void MB8877::cmd_stepout()
 	seektrk = (fdc[drvreg].track > 0) ? fdc[drvreg].track - 1 : 0;
 	seekvct = true;
 	
-	REGISTER_EVENT(EVENT_SEEK, seek_wait[cmdreg & 3]);
+	REGISTER_EVENT(EVENT_SEEK, GET_SEEK_TIME);
 	REGISTER_EVENT(EVENT_SEEKEND, 300);
 }
 
 // wait 70msec to read/write data just after seek command is done
-#define GET_SEARCH_TIME (after_seek ? (after_seek = false, 70000) : 200)
+#define GET_SEARCH_TIME (after_seek ? (after_seek = false, fast_disk ? 200 : 70000) : 200)
 
 void MB8877::cmd_readdata()
 {
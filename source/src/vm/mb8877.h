@@ -26,6 +26,7 @@ class MB8877 : public DEVICE
 private:
 	// config
 	bool ignore_crc;
+	bool fast_disk;
 	
 	// disk info
 	DISK* disk[MAX_DRIVE];
@@ -745,9 +745,10 @@ int MC6800::run(int clock)
 		CLEANUP_COUNTERS();
 #endif
 		icount += clock;
-		int first_icount = icount;
+		first_icount = icount;
 		
 		while(icount > 0) {
+			opecode_icount = icount;
 			run_one_opecode();
 		}
 		return first_icount - icount;
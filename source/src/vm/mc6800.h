@@ -44,6 +44,7 @@ private:
 	int int_state;
 	
 	int icount;
+	int first_icount, opecode_icount;
 	
 	uint32 RM(uint32 Addr);
 	void WM(uint32 Addr, uint32 Value);
@@ -374,6 +375,16 @@ public:
 	uint32 get_pc() {
 		return prevpc;
 	}
+	int get_run_clock() {
+		return first_icount - opecode_icount;
+	}
+	void stop_run() {
+		if(icount > 0) {
+			first_icount -= icount;
+			opecode_icount -= icount;
+			icount = 0;
+		}
+	}
 	
 	// unique function
 	void set_context_mem(DEVICE* device) {
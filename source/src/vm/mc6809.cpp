@@ -310,9 +310,10 @@ int MC6809::run(int clock)
 	else {
 		// run cpu while given clocks
 		icount += clock;
-		int first_icount = icount;
+		first_icount = icount;
 		
 		while(icount > 0) {
+			opecode_icount = icount;
 			run_one_opecode();
 		}
 		return first_icount - icount;
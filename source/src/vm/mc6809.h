@@ -33,6 +33,7 @@ private:
 	
 	uint8 int_state;
 	int icount;
+	int first_icount, opecode_icount;
 	
 	inline uint32 RM16(uint32 Addr);
 	inline void WM16(uint32 Addr, pair *p);
@@ -331,6 +332,16 @@ public:
 	uint32 get_pc() {
 		return ppc.w.l;
 	}
+	int get_run_clock() {
+		return first_icount - opecode_icount;
+	}
+	void stop_run() {
+		if(icount > 0) {
+			first_icount -= icount;
+			opecode_icount -= icount;
+			icount = 0;
+		}
+	}
 	
 	// unique function
 	void set_context_mem(DEVICE* device) {
@@ -27,6 +27,8 @@
 #define TXTGREEN	9
 #define TXTRED		10
 #define TXTORANGE	11
+
+#define STATE_VERSION	1
  
 void MC6847::initialize()
 {
@@ -83,10 +85,15 @@ void MC6847::reset()
 	delete fio;
 
 	vsync = hsync = true;
+	redraw_all = true;
 }
 
 void MC6847::write_signal(int id, uint32 data, uint32 mask)
 {
+	bool prev_ag = ag, prev_as = as, prev_intext = intext;
+	bool prev_css = css, prev_inv = inv;
+	uint8 prev_gm = gm;
+	
 	switch(id) {
 	case SIG_MC6847_AG:
 		ag = ((data & mask) != 0);
@@ -118,7 +125,10 @@ void MC6847::write_signal(int id, uint32 data, uint32 mask)
 	else{
 		bg = BLACK;
 	}
-
+	// all cells are rendered again when the mode is changed
+	if(ag != prev_ag || as != prev_as || intext != prev_intext || gm != prev_gm || css != prev_css || inv != prev_inv) {
+		redraw_all = true;
+	}
 }
 
 void MC6847::update_timing(int new_clocks, double new_frames_per_sec, int new_lines_per_frame)
@@ -160,9 +170,59 @@ void MC6847::set_hsync(bool val)
 	}
 }
 
+void MC6847::save_state(FILEIO* fio)
+{
+	fio->FputUint32(STATE_VERSION);
+	fio->FputInt32(this_device_id);
+	
+	fio->FputBool(ag);
+	fio->FputBool(as);
+	fio->FputBool(intext);
+	fio->FputUint8(gm);
+	fio->FputBool(css);
+	fio->FputBool(inv);
+	fio->FputUint8(bg);
+	fio->FputBool(vsync);
+	fio->FputBool(hsync);
+	fio->FputInt32(tWHS);
+}
+
+bool MC6847::load_state(FILEIO* fio)
+{
+	if(fio->FgetUint32() != STATE_VERSION) {
+		return false;
+	}
+	if(fio->FgetInt32() != this_device_id) {
+		return false;
+	}
+	ag = fio->FgetBool();
+	as = fio->FgetBool();
+	intext = fio->FgetBool();
+	gm = fio->FgetUint8();
+	css = fio->FgetBool();
+	inv = fio->FgetBool();
+	bg = fio->FgetUint8();
+	vsync = fio->FgetBool();
+	hsync = fio->FgetBool();
+	tWHS = fio->FgetInt32();
+	redraw_all = true;
+	return true;
+}
+
 void MC6847::draw_screen()
 {
-	// render screen
+	// the screen buffer may be re-created when the window is resized
+	scrntype* buffer = emu->screen_buffer(0);
+	if(buffer != last_buffer) {
+		last_buffer = buffer;
+		redraw_all = true;
+	}
+	if(redraw_all) {
+		memset(line_dirty, 1, sizeof(line_dirty));
+	}
+	rendered_cells = 0;
+	
+	// render only the cells changed after the last frame
 	if(ag) {
 		// graphics mode
 		switch(gm) {
@@ -177,13 +237,38 @@ void MC6847::draw_screen()
 		}
 	} else {
 		// alphanumerics / semigraphics
+		update_pcg();
 		draw_alpha();
 	}
+	redraw_all = false;
 	
 	for(int y = 0; y < 192; y++) {
-		scrntype* dest = emu->screen_buffer(y);
-		for(int x = 0; x < 256; x++) {
-			dest[x] = palette_pc[screen[y][x]];
+		if(line_dirty[y]) {
+			scrntype* dest = emu->screen_buffer(y);
+			for(int x = 0; x < 256; x++) {
+				dest[x] = palette_pc[screen[y][x]];
+			}
+			line_dirty[y] = false;
+		}
+	}
+#ifdef _MC6847_DEBUG_LOG
+	emu->out_debug(_T("MC6847: %d cells rendered\n"), rendered_cells);
+#endif
+}
+
+void MC6847::update_pcg()
+{
+	// check the programmable characters rewritten after the last frame
+	if(pcgfont_ptr == NULL) {
+		return;
+	}
+	for(int i = 0; i < 128; i++) {
+		if(redraw_all || memcmp(&shadow_pcg[16 * i], &pcgfont_ptr[16 * i], 16) != 0) {
+			memcpy(&shadow_pcg[16 * i], &pcgfont_ptr[16 * i], 16);
+			pcg_dirty[i] = true;
+		}
+		else {
+			pcg_dirty[i] = false;
 		}
 	}
 }
@@ -191,7 +276,7 @@ void MC6847::draw_screen()
 void MC6847::draw_cg(int xofs, int yofs)
 {
 	uint8 color = css ? 4 : 0;
-	int ofs = 0;
+	int ofs = 0, cell = 0;
 	
 	for(int y = 0; y < 192; y += yofs) {
 		for(int x = 0; x < 256; x += xofs * 4) {
@@ -199,24 +284,27 @@ void MC6847::draw_cg(int xofs, int yofs)
 			if(++ofs >= vram_size) {
 				ofs = 0;
 			}
-			uint8* dest = &screen[y][x];
-			
-			if(xofs == 4) {
-				dest[ 0] = dest[ 1] = dest[ 2] = dest[ 3] = color | ((data >> 6) & 3);
-				dest[ 4] = dest[ 5] = dest[ 6] = dest[ 7] = color | ((data >> 4) & 3);
-				dest[ 8] = dest[ 9] = dest[10] = dest[11] = color | ((data >> 2) & 3);
-				dest[12] = dest[13] = dest[14] = dest[15] = color | ((data >> 0) & 3);
-			} else {
-				dest[0] = dest[1] = color | ((data >> 6) & 3);
-				dest[2] = dest[3] = color | ((data >> 4) & 3);
-				dest[4] = dest[5] = color | ((data >> 2) & 3);
-				dest[6] = dest[7] = color | ((data >> 0) & 3);
+			if(!redraw_all && shadow_vram[cell] == data) {
+				cell++;
+				continue;
 			}
-		}
-		if(yofs >= 2) {
-			memcpy(screen[y + 1], screen[y], 256);
-			if(yofs >= 3) {
-				memcpy(screen[y + 2], screen[y], 256);
+			shadow_vram[cell++] = data;
+			rendered_cells++;
+			
+			for(int l = 0; l < yofs; l++) {
+				uint8* dest = &screen[y + l][x];
+				if(xofs == 4) {
+					dest[ 0] = dest[ 1] = dest[ 2] = dest[ 3] = color | ((data >> 6) & 3);
+					dest[ 4] = dest[ 5] = dest[ 6] = dest[ 7] = color | ((data >> 4) & 3);
+					dest[ 8] = dest[ 9] = dest[10] = dest[11] = color | ((data >> 2) & 3);
+					dest[12] = dest[13] = dest[14] = dest[15] = color | ((data >> 0) & 3);
+				} else {
+					dest[0] = dest[1] = color | ((data >> 6) & 3);
+					dest[2] = dest[3] = color | ((data >> 4) & 3);
+					dest[4] = dest[5] = color | ((data >> 2) & 3);
+					dest[6] = dest[7] = color | ((data >> 0) & 3);
+				}
+				line_dirty[y + l] = true;
 			}
 		}
 	}
@@ -228,7 +316,7 @@ void MC6847::draw_rg(int xofs, int yofs)
 		TXTGREEN, GREEN, BLACK, WHITE
 	};
 	uint8 color = css ? 2 : 0;
-	int ofs = 0;
+	int ofs = 0, cell = 0;
 	
 	for(int y = 0; y < 192; y += yofs) {
 		for(int x = 0; x < 256; x += xofs * 8) {
@@ -236,22 +324,25 @@ void MC6847::draw_rg(int xofs, int yofs)
 			if(++ofs >= vram_size) {
 				ofs = 0;
 			}
-			uint8* dest = &screen[y][x];
+			if(!redraw_all && shadow_vram[cell] == data) {
+				cell++;
+				continue;
+			}
+			shadow_vram[cell++] = data;
+			rendered_cells++;
 			
-			if(xofs == 2) {
-				for(int i = 0; i < 8; i++) {
-					dest[i << 1] = dest[i << 1 | 1] = color_table[color | (data >> (7-i) & 1)];
-				}
-			} else {
-				for(int i = 0; i < 8; i++) {
-					dest[i] = color_table[color | (data >> (7-i) & 1)];
+			for(int l = 0; l < yofs; l++) {
+				uint8* dest = &screen[y + l][x];
+				if(xofs == 2) {
+					for(int i = 0; i < 8; i++) {
+						dest[i << 1] = dest[i << 1 | 1] = color_table[color | (data >> (7-i) & 1)];
+					}
+				} else {
+					for(int i = 0; i < 8; i++) {
+						dest[i] = color_table[color | (data >> (7-i) & 1)];
+					}
 				}
-			}
-		}
-		if(yofs >= 2) {
-			memcpy(screen[y + 1], screen[y], 256);
-			if(yofs >= 3) {
-				memcpy(screen[y + 2], screen[y], 256);
+				line_dirty[y + l] = true;
 			}
 		}
 	}
@@ -259,12 +350,15 @@ void MC6847::draw_rg(int xofs, int yofs)
 
 void MC6847::draw_alpha()
 {
-	
-	int ofs = 0;
+	int ofs = 0, cell = 0;
 	for(int y = 0; y < 192; y += 12) {
 		for(int x = 0; x < 256; x += 8) {
 			uint8 data = vram_ptr[ofs + MC6847_VRAM_OFS];
+#ifdef MC6847_ATTR_OFS
 			uint8 attr = vram_ptr[ofs + MC6847_ATTR_OFS];
+#else
+			uint8 attr = 0;
+#endif
 			if(++ofs >= vram_size) {
 				ofs = 0;
 			}
@@ -299,6 +393,16 @@ void MC6847::draw_alpha()
 			inv2 = ((attr & MC6847_ATTR_INV) != 0);
 #endif
 #endif
+			// skip the cell when the code, the attribute and the pattern are not changed
+			bool pcg = (!as2 && intext2 && (data & 0x80));
+			if(!redraw_all && shadow_vram[cell] == data && shadow_attr[cell] == attr && !(pcg && pcg_dirty[data & 0x7f])) {
+				cell++;
+				continue;
+			}
+			shadow_vram[cell] = data;
+			shadow_attr[cell++] = attr;
+			rendered_cells++;
+			
 			uint8 *pattern;
 			uint8 col_fore, col_back;
 			if(!as2) {
@@ -341,6 +445,7 @@ void MC6847::draw_alpha()
 				for(int i = 0; i < 8; i++) {
 					dest[i] = (0x80 >> i & pat) ? col_fore : col_back;
 				}
+				line_dirty[y + l] = true;
 			}
 		}
 	}
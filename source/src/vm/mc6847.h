@@ -51,8 +51,19 @@ private:
 	bool vsync, hsync;
 	int tWHS;
 	
+	// vram, attributes and pcg patterns of the last rendered screen
+	uint8 shadow_vram[32 * 192];
+	uint8 shadow_attr[32 * 16];
+	uint8 shadow_pcg[128 * 16];
+	bool pcg_dirty[128];
+	bool line_dirty[192];
+	bool redraw_all;
+	scrntype* last_buffer;
+	int rendered_cells;
+	
 	void set_vsync(bool val);
 	void set_hsync(bool val);
+	void update_pcg();
 	void draw_cg(int xofs, int yofs);
 	void draw_rg(int xofs, int yofs);
 	void draw_alpha();
@@ -62,6 +73,10 @@ public:
 	MC6847(VM* parent_vm, EMU* parent_emu) : DEVICE(parent_vm, parent_emu) {
 		ag = as = intext = css = inv = false;
 		gm = 0;
+		extfont_ptr = pcgfont_ptr = NULL;
+		redraw_all = true;
+		last_buffer = NULL;
+		rendered_cells = 0;
 		init_output_signals(&outputs_vsync);
 		init_output_signals(&outputs_hsync);
 	}
@@ -74,6 +89,8 @@ public:
 	void event_vline(int v, int clock);
 	void event_callback(int event_id, int err);
 	void update_timing(int new_clocks, double new_frames_per_sec, int new_lines_per_frame);
+	void save_state(FILEIO* fio);
+	bool load_state(FILEIO* fio);
 	
 	// unique functions
 	void set_context_vsync(DEVICE* device, int id, uint32 mask) {
@@ -93,6 +110,10 @@ public:
 		vdg_type = type;
 	}
 	void draw_screen();
+	int get_rendered_cells() {
+		// character cells or graphics bytes rendered at the last draw_screen()
+		return rendered_cells;
+	}
 	scrntype get_border_color() {
 		return palette_pc[bg];
 	}
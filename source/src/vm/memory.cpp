@@ -17,6 +17,8 @@ void MEMORY::release()
 {
 	free(read_table);
 	free(write_table);
+	free(read_ptr);
+	free(write_ptr);
 }
 
 uint32 MEMORY::read_data8(uint32 addr)
@@ -106,7 +108,7 @@ void MEMORY::set_memory_r(uint32 start, uint32 end, uint8 *memory)
 	
 	for(uint32 i = start_bank; i <= end_bank; i++) {
 		read_table[i].dev = NULL;
-		read_table[i].memory = memory + MEMORY_BANK_SIZE * (i - start_bank);
+		read_table[i].memory = read_ptr[i] = memory + MEMORY_BANK_SIZE * (i - start_bank);
 	}
 }
 
@@ -117,7 +119,7 @@ void MEMORY::set_memory_w(uint32 start, uint32 end, uint8 *memory)
 	
 	for(uint32 i = start_bank; i <= end_bank; i++) {
 		write_table[i].dev = NULL;
-		write_table[i].memory = memory + MEMORY_BANK_SIZE * (i - start_bank);
+		write_table[i].memory = write_ptr[i] = memory + MEMORY_BANK_SIZE * (i - start_bank);
 	}
 }
 
@@ -128,6 +130,7 @@ void MEMORY::set_memory_mapped_io_r(uint32 start, uint32 end, DEVICE *device)
 	
 	for(uint32 i = start_bank; i <= end_bank; i++) {
 		read_table[i].dev = device;
+		read_ptr[i] = NULL;
 	}
 }
 
@@ -138,6 +141,7 @@ void MEMORY::set_memory_mapped_io_w(uint32 start, uint32 end, DEVICE *device)
 	
 	for(uint32 i = start_bank; i <= end_bank; i++) {
 		write_table[i].dev = device;
+		write_ptr[i] = NULL;
 	}
 }
 
@@ -148,7 +152,7 @@ void MEMORY::unset_memory_r(uint32 start, uint32 end)
 	
 	for(uint32 i = start_bank; i <= end_bank; i++) {
 		read_table[i].dev = NULL;
-		read_table[i].memory = read_dummy;
+		read_table[i].memory = read_ptr[i] = read_dummy;
 	}
 }
 
@@ -159,7 +163,7 @@ void MEMORY::unset_memory_w(uint32 start, uint32 end)
 	
 	for(uint32 i = start_bank; i <= end_bank; i++) {
 		write_table[i].dev = NULL;
-		write_table[i].memory = write_dummy;
+		write_table[i].memory = write_ptr[i] = write_dummy;
 	}
 }
 
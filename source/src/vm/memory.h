@@ -32,6 +32,10 @@ private:
 	bank_t *read_table;
 	bank_t *write_table;
 	
+	// bank pointers exported to cpu, NULL for memory mapped i/o
+	uint8 **read_ptr;
+	uint8 **write_ptr;
+	
 	int addr_shift;
 	
 	uint8 read_dummy[MEMORY_BANK_SIZE];
@@ -43,13 +47,15 @@ public:
 		
 		read_table = (bank_t *)malloc(sizeof(bank_t) * bank_num);
 		write_table = (bank_t *)malloc(sizeof(bank_t) * bank_num);
+		read_ptr = (uint8 **)malloc(sizeof(uint8 *) * bank_num);
+		write_ptr = (uint8 **)malloc(sizeof(uint8 *) * bank_num);
 		
 		for(int i = 0; i < bank_num; i++) {
 			read_table[i].dev = NULL;
-			read_table[i].memory = read_dummy;
+			read_table[i].memory = read_ptr[i] = read_dummy;
 			
 			write_table[i].dev = NULL;
-			write_table[i].memory = write_dummy;
+			write_table[i].memory = write_ptr[i] = write_dummy;
 		}
 		for(int i = 0;; i++) {
 			if(MEMORY_BANK_SIZE == (1 << i)) {
@@ -69,6 +75,25 @@ public:
 	void write_data16(uint32 addr, uint32 data);
 	uint32 read_data32(uint32 addr);
 	void write_data32(uint32 addr, uint32 data);
+	uint8** get_read_bank_table(int* shift) {
+#if MEMORY_ADDR_MAX >= 0x10000
+		*shift = addr_shift;
+		return read_ptr;
+#else
+		return NULL;
+#endif
+	}
+	uint8** get_write_bank_table(int* shift) {
+#if MEMORY_ADDR_MAX >= 0x10000
+		*shift = addr_shift;
+		return write_ptr;
+#else
+		return NULL;
+#endif
+	}
+	uint32 get_bank_table_addr_mask() {
+		return MEMORY_ADDR_MAX - 1;
+	}
 	
 	// unique functions
 	void set_memory_r(uint32 start, uint32 end, uint8 *memory);
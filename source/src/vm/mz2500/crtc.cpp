@@ -88,18 +88,6 @@ void CRTC::initialize()
 	prev256 = 0xffff;
 	update256 = true;
 	
-	// extract cg optimize matrix
-	for(int p1 = 0; p1 < 256; p1++) {
-		for(int p2 = 0; p2 < 256; p2++) {
-			for(int i = 0; i < 8; i++) {
-				cg_matrix0[p1][p2][i] = (p1 & (1 << i) ? 0x01 : 0) | (p2 & (1 << i) ? 0x02 : 0);
-				cg_matrix1[p1][p2][i] = (p1 & (1 << i) ? 0x04 : 0) | (p2 & (1 << i) ? 0x08 : 0);
-				cg_matrix2[p1][p2][i] = (p1 & (1 << i) ? 0x10 : 0) | (p2 & (1 << i) ? 0x20 : 0);
-				cg_matrix3[p1][p2][i] = (p1 & (1 << i) ? 0x40 : 0) | (p2 & (1 << i) ? 0x80 : 0);
-			}
-		}
-	}
-	
 	// initialize crtc
 	memset(textreg, 0, sizeof(textreg));
 	memset(cgreg, 0, sizeof(cgreg));
@@ -1518,10 +1506,16 @@ void CRTC::draw_cg()
 	}
 }
 
+// the planes of each line are gathered and converted to the pixels at once.
+// the pixels of a line are contiguous from the horizontal scroll offset (HDSC)
+
 void CRTC::draw_320x200x16screen(uint8 pl)
 {
-	uint8 B, R, G, I, col;
-	uint32 dest = 0;
+	uint8 B[40], R[40], G[40], I[40], col[320];
+	uint8 mask = (pl == 0 || pl == 2) ? cgreg[0x18] : (cgreg[0x18] >> 4);
+	uint8 *plane[4] = {
+		(mask & 1) ? B : NULL, (mask & 2) ? R : NULL, (mask & 4) ? G : NULL, (mask & 8) ? I : NULL
+	};
 	
 	if(map_init) {
 		create_addr_map(40, 200);
@@ -1529,39 +1523,26 @@ void CRTC::draw_320x200x16screen(uint8 pl)
 	for(int y = 0; y < 200; y++) {
 		for(int x = 0; x < 40; x++) {
 			uint16 src = (map_addr[y][x] + (0x2000 * pl)) & 0x7fff;
-			uint32 dest2 = dest + map_hdsc[y][x];
-			dest += 16;
-			
-			if(pl == 0 || pl == 2) {
-				B = (cgreg[0x18] & 0x01) ? vram_b[src] : 0;
-				R = (cgreg[0x18] & 0x02) ? vram_r[src] : 0;
-				G = (cgreg[0x18] & 0x04) ? vram_g[src] : 0;
-				I = (cgreg[0x18] & 0x08) ? vram_i[src] : 0;
-			}
-			else {
-				B = (cgreg[0x18] & 0x10) ? vram_b[src] : 0;
-				R = (cgreg[0x18] & 0x20) ? vram_r[src] : 0;
-				G = (cgreg[0x18] & 0x40) ? vram_g[src] : 0;
-				I = (cgreg[0x18] & 0x80) ? vram_i[src] : 0;
+			B[x] = vram_b[src];
+			R[x] = vram_r[src];
+			G[x] = vram_g[src];
+			I[x] = vram_i[src];
+		}
+		planar_to_chunky(col, plane, 4, 40, true);
+		
+		// color 0 is transparent
+		uint8 *dest = cg + y * 1280 + map_hdsc[y][0];
+		for(int x = 0; x < 320; x++) {
+			if(col[x]) {
+				dest[x * 2] = dest[x * 2 + 1] = col[x];
 			}
-			
-			col = cg_matrix0[B][R][0] | cg_matrix1[G][I][0]; if(col) cg[dest2     ] = cg[dest2 +  1] = col;
-			col = cg_matrix0[B][R][1] | cg_matrix1[G][I][1]; if(col) cg[dest2 +  2] = cg[dest2 +  3] = col;
-			col = cg_matrix0[B][R][2] | cg_matrix1[G][I][2]; if(col) cg[dest2 +  4] = cg[dest2 +  5] = col;
-			col = cg_matrix0[B][R][3] | cg_matrix1[G][I][3]; if(col) cg[dest2 +  6] = cg[dest2 +  7] = col;
-			col = cg_matrix0[B][R][4] | cg_matrix1[G][I][4]; if(col) cg[dest2 +  8] = cg[dest2 +  9] = col;
-			col = cg_matrix0[B][R][5] | cg_matrix1[G][I][5]; if(col) cg[dest2 + 10] = cg[dest2 + 11] = col;
-			col = cg_matrix0[B][R][6] | cg_matrix1[G][I][6]; if(col) cg[dest2 + 12] = cg[dest2 + 13] = col;
-			col = cg_matrix0[B][R][7] | cg_matrix1[G][I][7]; if(col) cg[dest2 + 14] = cg[dest2 + 15] = col;
 		}
-		dest += 640;
 	}
 }
 
 void CRTC::draw_320x200x256screen(uint8 pl)
 {
-	uint8 B0, B1, R0, R1, G0, G1, I0, I1;
-	uint32 dest = 0;
+	uint8 B0[40], B1[40], R0[40], R1[40], G0[40], G1[40], I0[40], I1[40], col[320];
 	
 	if(map_init) {
 		create_addr_map(40, 200);
@@ -1579,39 +1560,38 @@ void CRTC::draw_320x200x256screen(uint8 pl)
 		}
 		cg_mask256_init = false;
 	}
+	uint8 *plane[8] = {
+		(cg_mask256 & 0x10) ? B0 : NULL, (cg_mask256 & 0x20) ? R0 : NULL, (cg_mask256 & 0x40) ? G0 : NULL, (cg_mask256 & 0x80) ? I0 : NULL,
+		(cg_mask256 & 0x01) ? B1 : NULL, (cg_mask256 & 0x02) ? R1 : NULL, (cg_mask256 & 0x04) ? G1 : NULL, (cg_mask256 & 0x08) ? I1 : NULL
+	};
 	for(int y = 0; y < 200; y++) {
 		for(int x = 0; x < 40; x++) {
 			uint16 src1 = (map_addr[y][x] + (0x4000 * pl)) & 0x7fff;
 			uint16 src2 = (src1 + 0x2000) & 0x7fff;
-			uint32 dest2 = dest + map_hdsc[y][x];
-			dest += 16;
-			
-			B1 = (cg_mask256 & 0x01) ? vram_b[src1] : 0;
-			B0 = (cg_mask256 & 0x10) ? vram_b[src2] : 0;
-			R1 = (cg_mask256 & 0x02) ? vram_r[src1] : 0;
-			R0 = (cg_mask256 & 0x20) ? vram_r[src2] : 0;
-			G1 = (cg_mask256 & 0x04) ? vram_g[src1] : 0;
-			G0 = (cg_mask256 & 0x40) ? vram_g[src2] : 0;
-			I1 = (cg_mask256 & 0x08) ? vram_i[src1] : 0;
-			I0 = (cg_mask256 & 0x80) ? vram_i[src2] : 0;
-			
-			cg[dest2     ] = cg[dest2 +  1] = cg_matrix0[B0][R0][0] | cg_matrix1[G0][I0][0] | cg_matrix2[B1][R1][0] | cg_matrix3[G1][I1][0];
-			cg[dest2 +  2] = cg[dest2 +  3] = cg_matrix0[B0][R0][1] | cg_matrix1[G0][I0][1] | cg_matrix2[B1][R1][1] | cg_matrix3[G1][I1][1];
-			cg[dest2 +  4] = cg[dest2 +  5] = cg_matrix0[B0][R0][2] | cg_matrix1[G0][I0][2] | cg_matrix2[B1][R1][2] | cg_matrix3[G1][I1][2];
-			cg[dest2 +  6] = cg[dest2 +  7] = cg_matrix0[B0][R0][3] | cg_matrix1[G0][I0][3] | cg_matrix2[B1][R1][3] | cg_matrix3[G1][I1][3];
-			cg[dest2 +  8] = cg[dest2 +  9] = cg_matrix0[B0][R0][4] | cg_matrix1[G0][I0][4] | cg_matrix2[B1][R1][4] | cg_matrix3[G1][I1][4];
-			cg[dest2 + 10] = cg[dest2 + 11] = cg_matrix0[B0][R0][5] | cg_matrix1[G0][I0][5] | cg_matrix2[B1][R1][5] | cg_matrix3[G1][I1][5];
-			cg[dest2 + 12] = cg[dest2 + 13] = cg_matrix0[B0][R0][6] | cg_matrix1[G0][I0][6] | cg_matrix2[B1][R1][6] | cg_matrix3[G1][I1][6];
-			cg[dest2 + 14] = cg[dest2 + 15] = cg_matrix0[B0][R0][7] | cg_matrix1[G0][I0][7] | cg_matrix2[B1][R1][7] | cg_matrix3[G1][I1][7];
+			B1[x] = vram_b[src1];
+			B0[x] = vram_b[src2];
+			R1[x] = vram_r[src1];
+			R0[x] = vram_r[src2];
+			G1[x] = vram_g[src1];
+			G0[x] = vram_g[src2];
+			I1[x] = vram_i[src1];
+			I0[x] = vram_i[src2];
+		}
+		planar_to_chunky(col, plane, 8, 40, true);
+		
+		uint8 *dest = cg + y * 1280 + map_hdsc[y][0];
+		for(int x = 0; x < 320; x++) {
+			dest[x * 2] = dest[x * 2 + 1] = col[x];
 		}
-		dest += 640;
 	}
 }
 
 void CRTC::draw_640x200x16screen(uint8 pl)
 {
-	uint8 B, R, G, I;
-	uint32 dest = 0;
+	uint8 B[80], R[80], G[80], I[80];
+	uint8 *plane[4] = {
+		(cgreg[0x18] & 1) ? B : NULL, (cgreg[0x18] & 2) ? R : NULL, (cgreg[0x18] & 4) ? G : NULL, (cgreg[0x18] & 8) ? I : NULL
+	};
 	
 	if(map_init) {
 		create_addr_map(80, 200);
@@ -1619,31 +1599,21 @@ void CRTC::draw_640x200x16screen(uint8 pl)
 	for(int y = 0; y < 200; y++) {
 		for(int x = 0; x < 80; x++) {
 			uint16 src = (map_addr[y][x] + (0x4000 * pl)) & 0x7fff;
-			uint32 dest2 = dest + map_hdsc[y][x];
-			dest += 8;
-			
-			B = (cgreg[0x18] & 0x01) ? vram_b[src] : 0;
-			R = (cgreg[0x18] & 0x02) ? vram_r[src] : 0;
-			G = (cgreg[0x18] & 0x04) ? vram_g[src] : 0;
-			I = (cgreg[0x18] & 0x08) ? vram_i[src] : 0;
-			
-			cg[dest2    ] = cg_matrix0[B][R][0] | cg_matrix1[G][I][0];
-			cg[dest2 + 1] = cg_matrix0[B][R][1] | cg_matrix1[G][I][1];
-			cg[dest2 + 2] = cg_matrix0[B][R][2] | cg_matrix1[G][I][2];
-			cg[dest2 + 3] = cg_matrix0[B][R][3] | cg_matrix1[G][I][3];
-			cg[dest2 + 4] = cg_matrix0[B][R][4] | cg_matrix1[G][I][4];
-			cg[dest2 + 5] = cg_matrix0[B][R][5] | cg_matrix1[G][I][5];
-			cg[dest2 + 6] = cg_matrix0[B][R][6] | cg_matrix1[G][I][6];
-			cg[dest2 + 7] = cg_matrix0[B][R][7] | cg_matrix1[G][I][7];
+			B[x] = vram_b[src];
+			R[x] = vram_r[src];
+			G[x] = vram_g[src];
+			I[x] = vram_i[src];
 		}
-		dest += 640;
+		planar_to_chunky(cg + y * 1280 + map_hdsc[y][0], plane, 4, 80, true);
 	}
 }
 
 void CRTC::draw_640x400x4screen()
 {
-	uint8 B, R;
-	uint32 dest = 0;
+	uint8 B[80], R[80];
+	uint8 *plane[2] = {
+		(cgreg[0x18] & 1) ? B : NULL, (cgreg[0x18] & 2) ? R : NULL
+	};
 	
 	if(map_init) {
 		create_addr_map(80, 400);
@@ -1651,28 +1621,17 @@ void CRTC::draw_640x400x4screen()
 	for(int y = 0; y < 400; y++) {
 		for(int x = 0; x < 80; x++) {
 			uint16 src = map_addr[y][x];
-			uint32 dest2 = dest + map_hdsc[y][x];
-			dest += 8;
-			
-			B = (cgreg[0x18] & 0x01) ? ((src & 0x4000) ? vram_g[src & 0x3fff] : vram_b[src]) : 0;
-			R = (cgreg[0x18] & 0x02) ? ((src & 0x4000) ? vram_i[src & 0x3fff] : vram_r[src]) : 0;
-			
-			cg[dest2    ] = cg_matrix0[B][R][0];
-			cg[dest2 + 1] = cg_matrix0[B][R][1];
-			cg[dest2 + 2] = cg_matrix0[B][R][2];
-			cg[dest2 + 3] = cg_matrix0[B][R][3];
-			cg[dest2 + 4] = cg_matrix0[B][R][4];
-			cg[dest2 + 5] = cg_matrix0[B][R][5];
-			cg[dest2 + 6] = cg_matrix0[B][R][6];
-			cg[dest2 + 7] = cg_matrix0[B][R][7];
+			B[x] = (src & 0x4000) ? vram_g[src & 0x3fff] : vram_b[src];
+			R[x] = (src & 0x4000) ? vram_i[src & 0x3fff] : vram_r[src];
 		}
+		planar_to_chunky(cg + y * 640 + map_hdsc[y][0], plane, 2, 80, true);
 	}
 }
 
 void CRTC::draw_640x400x16screen()
 {
-	uint8 B, R, G, I;
-	uint32 dest = 0;
+	uint8 B[80], R[80], G[80], I[80];
+	uint8 *plane[4] = {B, R, G, I};
 	
 	if(map_init) {
 		create_addr_map(80, 400);
@@ -1680,23 +1639,12 @@ void CRTC::draw_640x400x16screen()
 	for(int y = 0; y < 400; y++) {
 		for(int x = 0; x < 80; x++) {
 			uint16 src = map_addr[y][x];
-			uint32 dest2 = dest + map_hdsc[y][x];
-			dest += 8;
-			
-			B = vram_b[src];
-			R = vram_r[src];
-			G = vram_g[src];
-			I = vram_i[src];
-			
-			cg[dest2    ] = cg_matrix0[B][R][0] | cg_matrix1[G][I][0];
-			cg[dest2 + 1] = cg_matrix0[B][R][1] | cg_matrix1[G][I][1];
-			cg[dest2 + 2] = cg_matrix0[B][R][2] | cg_matrix1[G][I][2];
-			cg[dest2 + 3] = cg_matrix0[B][R][3] | cg_matrix1[G][I][3];
-			cg[dest2 + 4] = cg_matrix0[B][R][4] | cg_matrix1[G][I][4];
-			cg[dest2 + 5] = cg_matrix0[B][R][5] | cg_matrix1[G][I][5];
-			cg[dest2 + 6] = cg_matrix0[B][R][6] | cg_matrix1[G][I][6];
-			cg[dest2 + 7] = cg_matrix0[B][R][7] | cg_matrix1[G][I][7];
+			B[x] = vram_b[src];
+			R[x] = vram_r[src];
+			G[x] = vram_g[src];
+			I[x] = vram_i[src];
 		}
+		planar_to_chunky(cg + y * 640 + map_hdsc[y][0], plane, 4, 80, true);
 	}
 }
 
@@ -53,18 +53,6 @@ void CRTC::initialize()
 		palette65536[i] = RGB_COLOR(r, g, b);
 	}
 	
-	// extract cg optimize matrix
-	for(int p1 = 0; p1 < 256; p1++) {
-		for(int p2 = 0; p2 < 256; p2++) {
-			for(int i = 0; i < 8; i++) {
-				cg_matrix0[p1][p2][i] = (p1 & (0x80 >> i) ? 0x01 : 0) | (p2 & (0x80 >> i) ? 0x02 : 0);
-				cg_matrix1[p1][p2][i] = (p1 & (0x80 >> i) ? 0x04 : 0) | (p2 & (0x80 >> i) ? 0x08 : 0);
-				cg_matrix2[p1][p2][i] = (p1 & (0x80 >> i) ? 0x10 : 0) | (p2 & (0x80 >> i) ? 0x20 : 0);
-				cg_matrix3[p1][p2][i] = (p1 & (0x80 >> i) ? 0x40 : 0) | (p2 & (0x80 >> i) ? 0x80 : 0);
-			}
-		}
-	}
-	
 	// initialize crtc
 	memset(textreg, 0, sizeof(textreg));
 	memset(rmwreg, 0, sizeof(rmwreg));
@@ -1274,28 +1262,25 @@ void CRTC::draw_cg()
 	}
 	if(is_16col) {
 		// 16/4096 color mode
+		uint8 B[80], R[80], G[80], I[80], col[640];
+		uint8 *plane[4] = {
+			(cgreg[0x10] & 1) ? B : NULL, (cgreg[0x10] & 2) ? R : NULL, (cgreg[0x10] & 4) ? G : NULL, (cgreg[0x10] & 8) ? I : NULL
+		};
+		
 		for(int y = 0; y < ymax; y++) {
+			// the planes of each line are gathered and converted to the pixels at once
 			for(int x = 0; x < 80; x++) {
 				uint32 src = map_addr[y][x];
-				uint32 dest2 = dest + map_hdsc[y][x];
-				dest += 8;
-				
-				uint8 B = (cgreg[0x10] & 1) ? vram_b[src] : 0;
-				uint8 R = (cgreg[0x10] & 2) ? vram_r[src] : 0;
-				uint8 G = (cgreg[0x10] & 4) ? vram_g[src] : 0;
-				uint8 I = (cgreg[0x10] & 8) ? vram_i[src] : 0;
-				
-				cg[dest2    ] = cg_matrix0[B][R][0] | cg_matrix1[G][I][0];
-				cg[dest2 + 1] = cg_matrix0[B][R][1] | cg_matrix1[G][I][1];
-				cg[dest2 + 2] = cg_matrix0[B][R][2] | cg_matrix1[G][I][2];
-				cg[dest2 + 3] = cg_matrix0[B][R][3] | cg_matrix1[G][I][3];
-				cg[dest2 + 4] = cg_matrix0[B][R][4] | cg_matrix1[G][I][4];
-				cg[dest2 + 5] = cg_matrix0[B][R][5] | cg_matrix1[G][I][5];
-				cg[dest2 + 6] = cg_matrix0[B][R][6] | cg_matrix1[G][I][6];
-				cg[dest2 + 7] = cg_matrix0[B][R][7] | cg_matrix1[G][I][7];
+				B[x] = vram_b[src];
+				R[x] = vram_r[src];
+				G[x] = vram_g[src];
+				I[x] = vram_i[src];
 			}
-			if(!is_400l) {
-				dest += 640;
+			planar_to_chunky(col, plane, 4, 80, false);
+			
+			uint16 *dest2 = cg + y * (is_400l ? 640 : 1280) + map_hdsc[y][0];
+			for(int x = 0; x < 640; x++) {
+				dest2[x] = col[x];
 			}
 		}
 	}
@@ -73,10 +73,6 @@ private:
 	uint8 map_hdsc[400][80];
 	
 	// speed optimize
-	uint8 cg_matrix0[256][256][8];
-	uint8 cg_matrix1[256][256][8];
-	uint8 cg_matrix2[256][256][8];
-	uint8 cg_matrix3[256][256][8];
 	uint8 text_matrix[256][8][8];
 	uint8 text_matrixw[256][8][16];
 	uint8 trans_color;
@@ -121,6 +121,7 @@ void MAIN::write_io8(uint32 addr, uint32 data)
 	case 0xfc:	// mz3500sm p.23
 		if((srqb & 2) != (data & 2)) {
 //			emu->out_debug("MAIN->SUB\tBUSREQ=%d\n",(data&2)?1:0);
+			set_sync_point();
 			d_subcpu->write_signal(SIG_CPU_BUSREQ, data, 2);
 			srqb = data & 2;
 		}
@@ -130,6 +131,7 @@ void MAIN::write_io8(uint32 addr, uint32 data)
 	case 0xfd:	// mz3500sm p.23
 		if(!(sres & 0x80) && (data & 0x80)) {
 //			emu->out_debug("MAIN->SUB\tRESET\n");
+			set_sync_point();
 			d_subcpu->reset();
 		}
 		sres = data;
@@ -180,10 +182,12 @@ uint32 MAIN::read_io8(uint32 addr)
 void MAIN::write_signal(int id, uint32 data, uint32 mask)
 {
 	if(id == SIG_MAIN_SACK) {
+		set_sync_point();
 		sack = ((data & mask) != 0);
 //		emu->out_debug("SUB->MAIN\tSACK=%d\n",sack?1:0);
 	}
 	else if(id == SIG_MAIN_SRDY) {
+		set_sync_point();
 		srdy = ((data & mask) != 0);
 //		emu->out_debug("SUB->MAIN\tSRDY=%d\n",srdy?1:0);
 	}
@@ -193,6 +197,7 @@ void MAIN::write_signal(int id, uint32 data, uint32 mask)
 		update_irq();
 	}
 	else if(id == SIG_MAIN_INT0) {
+		set_sync_point();
 		int0 = ((data & mask) != 0);
 //		emu->out_debug("SUB->MAIN\tINT0=%d\n",int0?1:0);
 		update_irq();
@@ -0,0 +1,94 @@
+/*
+	SHARP MZ-700 Emulator 'EmuZ-700'
+	SHARP MZ-800 Emulator 'EmuZ-800'
+	SHARP MZ-1500 Emulator 'EmuZ-1500'
+	Skelton for retropc emulator
+
+	Author : Takeda.Toshiya
+	Date   : 2008.06.05 -
+
+	[ i/o map at compile time ]
+*/
+
+#ifndef _IO_MAP_H_
+#define _IO_MAP_H_
+
+#include "../static_io.h"
+#include "../io.h"
+#include "emm.h"
+#include "memory.h"
+#include "ramfile.h"
+#if defined(_MZ800)
+#include "../i8253.h"
+#include "../i8255.h"
+#endif
+#if defined(_MZ800) || defined(_MZ1500)
+#include "../mb8877.h"
+#include "../sn76489an.h"
+#include "floppy.h"
+#endif
+#if defined(_MZ1500)
+#include "psg.h"
+#endif
+
+// same as the map set to io in VM::VM(),
+// z80pio and z80sio are not accessed so often and are left to io
+class STATIC_IO_MAP
+{
+public:
+#if defined(_MZ800)
+	typedef STATIC_IO_R<MEMORY, &VM::memory, 0xfe, 0xe0, -1,	// e0-e1
+		STATIC_IO_R<MEMORY, &VM::memory, 0xff, 0xce, -1,
+		STATIC_IO_R<I8255, &VM::pio, 0xfc, 0xd0, -1,		// d0-d3
+		STATIC_IO_R<I8253, &VM::pit, 0xfc, 0xd4, -1,		// d4-d7
+		STATIC_IO_R<MB8877, &VM::fdc, 0xfc, 0xd8, -1,		// d8-db
+		STATIC_IO_R<EMM, &VM::emm, 0xfc, 0x00, -1,		// 00-03
+		STATIC_IO_R<RAMFILE, &VM::ramfile, 0xfe, 0xea, -1,	// ea-eb
+		STATIC_IO_END<IO, &VM::io> > > > > > > > static_io_r;
+	
+	typedef STATIC_IO_W<MEMORY, &VM::memory, 0xfc, 0xe0, -1,	// e0-e3
+		STATIC_IO_W<MEMORY, &VM::memory, 0xfe, 0xe4, -1,	// e4-e5
+		STATIC_IO_W<MEMORY, &VM::memory, 0xff, 0xe6, -1,
+		STATIC_IO_W<MEMORY, &VM::memory, 0xfc, 0xcc, -1,	// cc-cf
+		STATIC_IO_W<MEMORY, &VM::memory, 0xff, 0xf0, -1,
+		STATIC_IO_W<SN76489AN, &VM::psg, 0xff, 0xf2, -1,
+		STATIC_IO_W<I8255, &VM::pio, 0xfc, 0xd0, -1,		// d0-d3
+		STATIC_IO_W<I8253, &VM::pit, 0xfc, 0xd4, -1,		// d4-d7
+		STATIC_IO_W<MB8877, &VM::fdc, 0xfc, 0xd8, -1,		// d8-db
+		STATIC_IO_W<FLOPPY, &VM::floppy, 0xfe, 0xdc, -1,	// dc-dd
+		STATIC_IO_W<EMM, &VM::emm, 0xfc, 0x00, -1,		// 00-03
+		STATIC_IO_W<RAMFILE, &VM::ramfile, 0xfe, 0xea, -1,	// ea-eb
+		STATIC_IO_END<IO, &VM::io> > > > > > > > > > > > > static_io_w;
+#elif defined(_MZ1500)
+	typedef STATIC_IO_R<MB8877, &VM::fdc, 0xfc, 0xd8, -1,		// d8-db
+		STATIC_IO_R<EMM, &VM::emm, 0xfc, 0x00, -1,		// 00-03
+		STATIC_IO_R<RAMFILE, &VM::ramfile, 0xfe, 0xea, -1,	// ea-eb
+		STATIC_IO_END<IO, &VM::io> > > > static_io_r;
+	
+	typedef STATIC_IO_W<MEMORY, &VM::memory, 0xfc, 0xe0, -1,	// e0-e3
+		STATIC_IO_W<MEMORY, &VM::memory, 0xfe, 0xe4, -1,	// e4-e5
+		STATIC_IO_W<MEMORY, &VM::memory, 0xff, 0xe6, -1,
+		STATIC_IO_W<MEMORY, &VM::memory, 0xfe, 0xf0, -1,	// f0-f1
+		STATIC_IO_W<PSG, &VM::psg, 0xff, 0xe9, -1,
+		STATIC_IO_W<SN76489AN, &VM::psg_l, 0xff, 0xf2, -1,
+		STATIC_IO_W<SN76489AN, &VM::psg_r, 0xff, 0xf3, -1,
+		STATIC_IO_W<MB8877, &VM::fdc, 0xfc, 0xd8, -1,		// d8-db
+		STATIC_IO_W<FLOPPY, &VM::floppy, 0xfe, 0xdc, -1,	// dc-dd
+		STATIC_IO_W<EMM, &VM::emm, 0xfc, 0x00, -1,		// 00-03
+		STATIC_IO_W<RAMFILE, &VM::ramfile, 0xfe, 0xea, -1,	// ea-eb
+		STATIC_IO_END<IO, &VM::io> > > > > > > > > > > > static_io_w;
+#else
+	// fe (printer) has the registered value
+	typedef STATIC_IO_R<EMM, &VM::emm, 0xfc, 0x00, -1,		// 00-03
+		STATIC_IO_R<RAMFILE, &VM::ramfile, 0xfe, 0xea, -1,	// ea-eb
+		STATIC_IO_END<IO, &VM::io> > > static_io_r;
+	
+	typedef STATIC_IO_W<MEMORY, &VM::memory, 0xfc, 0xe0, -1,	// e0-e3
+		STATIC_IO_W<MEMORY, &VM::memory, 0xff, 0xe4, -1,
+		STATIC_IO_W<EMM, &VM::emm, 0xfc, 0x00, -1,		// 00-03
+		STATIC_IO_W<RAMFILE, &VM::ramfile, 0xfe, 0xea, -1,	// ea-eb
+		STATIC_IO_END<IO, &VM::io> > > > > static_io_w;
+#endif
+};
+
+#endif
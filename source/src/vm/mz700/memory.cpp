@@ -15,8 +15,11 @@
 #include "../i8255.h"
 #if defined(_MZ800)
 #include "../z80pio.h"
-#include "../../config.h"
 #endif
+#if defined(_MZ700)
+#include "../datarec.h"
+#endif
+#include "../../config.h"
 #include "../../fileio.h"
 
 #define EVENT_TEMPO		0
@@ -137,6 +140,9 @@ void MEMORY::reset()
 	
 	// reset memory map
 	mem_bank = MEM_BANK_MON_L | MEM_BANK_MON_H;
+#if defined(_MZ700)
+	fast_load_ret = -1;
+#endif
 #if defined(_MZ800)
 	// TODO: check initial params
 	wf = rf = 0x01;
@@ -519,6 +525,47 @@ uint32 MEMORY::read_data8w(uint32 addr, int* wait)
 	return read_data8(addr);
 }
 
+#if defined(_MZ700)
+// fast tape load: when the monitor calls RDINF (04D8H) or RDDAT (04F8H),
+// the block is copied from the tape image and "xor a; ret" is executed
+// instead of the routine, so it returns with CF=0 (no error)
+
+uint32 MEMORY::fetch_op(uint32 addr, int* wait)
+{
+	if((mem_bank & MEM_BANK_MON_L) && config.fast_tape) {
+		if((int)addr == fast_load_ret) {
+			fast_load_ret = -1;
+			*wait = 1;
+			return 0xc9;	// ret
+		}
+		if((addr == 0x4d8 || addr == 0x4f8) && fast_load(addr == 0x4d8)) {
+			fast_load_ret = addr + 1;
+			*wait = 1;
+			return 0xaf;	// xor a
+		}
+	}
+	return read_data8w(addr, wait);
+}
+
+bool MEMORY::fast_load(bool header)
+{
+	// RDINF reads the header to IBUFE (10F0H), and RDDAT reads SIZE (1102H)
+	// bytes to DTADR (1104H), both are not changed when the block is not found
+	int size = header ? 128 : (read_data8(0x1102) | (read_data8(0x1103) << 8));
+	int addr = header ? 0x10f0 : (read_data8(0x1104) | (read_data8(0x1105) << 8));
+	uint8* buffer = (uint8*)malloc(size + 1);
+	bool result = d_drec->read_mzt_block(header, buffer, size);
+	
+	if(result) {
+		for(int i = 0; i < size; i++) {
+			write_data8((addr + i) & 0xffff, buffer[i]);
+		}
+	}
+	free(buffer);
+	return result;
+}
+#endif
+
 void MEMORY::write_io8(uint32 addr, uint32 data)
 {
 	switch(addr & 0xff) {
@@ -20,6 +20,9 @@
 #if defined(_MZ800)
 class DISPLAY;
 #endif
+#if defined(_MZ700)
+class DATAREC;
+#endif
 
 class MEMORY : public DEVICE
 {
@@ -28,6 +31,13 @@ private:
 #if defined(_MZ800)
 	DEVICE *d_pio_int;
 #endif
+#if defined(_MZ700)
+	DATAREC *d_drec;
+	
+	// fast tape load
+	int fast_load_ret;
+	bool fast_load(bool header);
+#endif
 	
 	// memory
 	uint8* rbank[32];
@@ -122,6 +132,9 @@ public:
 	uint32 read_data8(uint32 addr);
 	void write_data8w(uint32 addr, uint32 data, int* wait);
 	uint32 read_data8w(uint32 addr, int* wait);
+#if defined(_MZ700)
+	uint32 fetch_op(uint32 addr, int* wait);
+#endif
 	
 	void write_io8(uint32 addr, uint32 data);
 #if defined(_MZ800)
@@ -142,6 +155,11 @@ public:
 	void set_context_pio_int(DEVICE* device) {
 		d_pio_int = device;
 	}
+#endif
+#if defined(_MZ700)
+	void set_context_drec(DATAREC* device) {
+		d_drec = device;
+	}
 #endif
 	void draw_screen();
 };
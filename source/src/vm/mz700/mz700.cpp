@@ -110,6 +110,10 @@ VM::VM(EMU* parent_emu) : emu(parent_emu)
 	
 	// VRAM/PCG wait
 	memory->set_context_cpu(cpu);
+#if defined(_MZ700)
+	// fast tape load
+	memory->set_context_drec(drec);
+#endif
 	
 	// memory mapped I/O
 	memory->set_context_pio(pio);
@@ -47,6 +47,7 @@
 #define PCM1BIT_HIGH_QUALITY
 //#define LOW_PASS_FILTER
 #define Z80_MEMORY_WAIT
+#define STATIC_IO_MAP_H		"mz700/io_map.h"
 #if defined(_MZ800) || defined(_MZ1500)
 #define MAX_DRIVE		4
 #define HAS_MB8876
@@ -114,6 +115,7 @@ class QUICKDISK;
 
 class VM
 {
+	friend class STATIC_IO_MAP;
 protected:
 	EMU* emu;
 	
@@ -75,6 +75,7 @@ void MEMORY::reset()
 	SET_BANK(0xff0000, 0xffffff, wdmy, ipl);
 	
 	protect = true;
+	update_bank();
 }
 
 void MEMORY::write_data8(uint32 addr, uint32 data)
@@ -97,10 +98,22 @@ void MEMORY::write_io8(uint32 addr, uint32 data)
 	switch(addr) {
 	case 0x74:
 		protect = ((data & 1) != 0);
+		update_bank();
 		break;
 	}
 }
 
+void MEMORY::update_bank()
+{
+	// the write protected backup ram is not exported to cpu
+	if(protect) {
+		SET_BANK(0x0e7800, 0x0effff, wdmy, backup);
+	}
+	else {
+		SET_BANK(0x0e7800, 0x0effff, backup, backup);
+	}
+}
+
 uint32 MEMORY::read_io8(uint32 addr)
 {
 	return 0xff;
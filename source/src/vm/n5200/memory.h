@@ -31,6 +31,7 @@ private:
 	uint8 ipl[0x10000];		// IPL 64KB
 	
 	bool protect;
+	void update_bank();
 	
 public:
 	MEMORY(VM* parent_vm, EMU* parent_emu) : DEVICE(parent_vm, parent_emu) {}
@@ -44,6 +45,17 @@ public:
 	uint32 read_data8(uint32 addr);
 	void write_io8(uint32 addr, uint32 data);
 	uint32 read_io8(uint32 addr);
+	uint8** get_read_bank_table(int* shift) {
+		*shift = 11;
+		return rbank;
+	}
+	uint8** get_write_bank_table(int* shift) {
+		*shift = 11;
+		return wbank;
+	}
+	uint32 get_bank_table_addr_mask() {
+		return 0xffffff;
+	}
 	
 	// unitque function
 	uint8* get_vram() {
@@ -16,6 +16,8 @@
 
 #define SIG_NOT_INPUT	0
 
+#define NOT_STATE_VERSION	1
+
 class NOT : public DEVICE
 {
 private:
@@ -39,6 +41,24 @@ public:
 		}
 	}
 	
+	void save_state(FILEIO* fio) {
+		fio->FputUint32(NOT_STATE_VERSION);
+		fio->FputInt32(this_device_id);
+		fio->FputBool(prev);
+		fio->FputBool(first);
+	}
+	bool load_state(FILEIO* fio) {
+		if(fio->FgetUint32() != NOT_STATE_VERSION) {
+			return false;
+		}
+		if(fio->FgetInt32() != this_device_id) {
+			return false;
+		}
+		prev = fio->FgetBool();
+		first = fio->FgetBool();
+		return true;
+	}
+	
 	// unique functions
 	void set_context_out(DEVICE* device, int id, uint32 mask) {
 		register_output_signal(&outputs, device, id, mask);
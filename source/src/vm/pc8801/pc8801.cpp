@@ -105,11 +105,13 @@ VM::VM(EMU* parent_emu) : emu(parent_emu)
 	pc88pio->set_context_port_c(pc88pio_sub, SIG_I8255_PORT_C, 0x0f, 4);
 	pc88pio->set_context_port_c(pc88pio_sub, SIG_I8255_PORT_C, 0xf0, -4);
 	pc88pio->clear_ports_by_cmdreg = true;
+	pc88pio->sync_cpus_by_output = true;
 	pc88pio_sub->set_context_port_a(pc88pio, SIG_I8255_PORT_B, 0xff, 0);
 	pc88pio_sub->set_context_port_b(pc88pio, SIG_I8255_PORT_A, 0xff, 0);
 	pc88pio_sub->set_context_port_c(pc88pio, SIG_I8255_PORT_C, 0x0f, 4);
 	pc88pio_sub->set_context_port_c(pc88pio, SIG_I8255_PORT_C, 0xf0, -4);
 	pc88pio_sub->clear_ports_by_cmdreg = true;
+	pc88pio_sub->sync_cpus_by_output = true;
 	pc88fdc_sub->set_context_irq(pc88cpu_sub, SIG_CPU_IRQ, 1);
 #ifdef _FDC_DEBUG_LOG
 	pc88fdc_sub->set_context_cpu(pc88cpu_sub);
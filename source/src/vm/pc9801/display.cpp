@@ -741,28 +741,27 @@ void DISPLAY::draw_gfx_screen()
 	}
 	uint32 *addr = &gdc_addr[0][0];
 	uint8 *dest = &screen_gfx[0][0];
+	uint8 b[80], r[80], g[80], e[80];
+	uint8 *plane[4] = {b, r, g, e};
 	
 	for(int y = 0; y < 400; y++) {
-		for(int x = 0; x < 640; x += 8) {
-			uint8 b = vram_disp_b[*addr];
-			uint8 r = vram_disp_r[*addr];
-			uint8 g = vram_disp_g[*addr];
+		// gather the planes of this line and convert them to the pixels
+		for(int x = 0; x < 80; x++) {
+			b[x] = vram_disp_b[*addr];
+			r[x] = vram_disp_r[*addr];
+			g[x] = vram_disp_g[*addr];
 #if defined(SUPPORT_16_COLORS)
-			uint8 e = vram_disp_e[*addr];
-#else
-			uint8 e = 0;
+			e[x] = vram_disp_e[*addr];
 #endif
 			addr++;
-			
-			*dest++ = ((b & 0x80) >> 7) | ((r & 0x80) >> 6) | ((g & 0x80) >> 5) | ((e & 0x80) >> 4);
-			*dest++ = ((b & 0x40) >> 6) | ((r & 0x40) >> 5) | ((g & 0x40) >> 4) | ((e & 0x40) >> 3);
-			*dest++ = ((b & 0x20) >> 5) | ((r & 0x20) >> 4) | ((g & 0x20) >> 3) | ((e & 0x20) >> 2);
-			*dest++ = ((b & 0x10) >> 4) | ((r & 0x10) >> 3) | ((g & 0x10) >> 2) | ((e & 0x10) >> 1);
-			*dest++ = ((b & 0x08) >> 3) | ((r & 0x08) >> 2) | ((g & 0x08) >> 1) | ((e & 0x08)     );
-			*dest++ = ((b & 0x04) >> 2) | ((r & 0x04) >> 1) | ((g & 0x04)     ) | ((e & 0x04) << 1);
-			*dest++ = ((b & 0x02) >> 1) | ((r & 0x02)     ) | ((g & 0x02) << 1) | ((e & 0x02) << 2);
-			*dest++ = ((b & 0x01)     ) | ((r & 0x01) << 1) | ((g & 0x01) << 2) | ((e & 0x01) << 3);
 		}
+#if defined(SUPPORT_16_COLORS)
+		planar_to_chunky(dest, plane, 4, 80, false);
+#else
+		planar_to_chunky(dest, plane, 3, 80, false);
+#endif
+		dest += 640;
+		
 		if((cs_gfx[0] & 0x1f) == 1) {
 			// 200 line
 			if(modereg1[MODE1_200LINE]) {
@@ -16,6 +16,13 @@
 #include "pce.h"
 #include "../huc6280.h"
 
+#define PSG_BLOCK_SAMPLES	256
+
+static const int32 psg_vol_table[32] = {
+	 100, 451, 508, 573, 646, 728, 821, 925,1043,1175,1325, 1493, 1683, 1898, 2139, 2411,
+	2718,3064,3454,3893,4388,4947,5576,6285,7085,7986,9002,10148,11439,12894,14535,16384
+};
+
 #define STATE_VSW		0
 #define STATE_VDS		1
 #define STATE_VDW		2
@@ -651,6 +658,7 @@ void PCE::vdc_advance_line(int which)
 			{
 				vdc[which].sprite_ram[i] = ( vdc[which].vram[ ( vdc[which].vdc_data[DVSSR].w.l << 1 ) + i * 2 + 1 ] << 8 ) | vdc[which].vram[ ( vdc[which].vdc_data[DVSSR].w.l << 1 ) + i * 2 ];
 			}
+			vdc_update_sprite_list(which);
 
 			/* generate interrupt if needed */
 			if ( vdc[which].vdc_data[DCR].w.l & DCR_DSC )
@@ -698,6 +706,7 @@ void PCE::vdc_advance_line(int which)
 			{
 				vdc[which].sprite_ram[i] = ( vdc[which].vram[ ( vdc[which].vdc_data[DVSSR].w.l << 1 ) + i * 2 + 1 ] << 8 ) | vdc[which].vram[ ( vdc[which].vdc_data[DVSSR].w.l << 1 ) + i * 2 ];
 			}
+			vdc_update_sprite_list(which);
 
 			/* generate interrupt if needed */
 			if(vdc[which].vdc_data[DCR].w.l & DCR_DSC)
@@ -713,6 +722,8 @@ void PCE::vdc_advance_line(int which)
 
 void PCE::vdc_reset()
 {
+	int i;
+
 	/* clear context */
 	memset(&vdc, 0, sizeof(vdc));
 	memset(&vce, 0, sizeof(vce));
@@ -721,9 +732,14 @@ void PCE::vdc_reset()
 	vdc[0].inc = 1;
 	vdc[1].inc = 1;
 
-	/* initialize palette */
-	int i;
+	/* decode all patterns at the first use */
+	for( i = 0; i < 2; i++ )
+	{
+		memset(vdc[i].sprite_dirty, 1, sizeof(vdc[i].sprite_dirty));
+		memset(vdc[i].bg_dirty, 1, sizeof(vdc[i].bg_dirty));
+	}
 
+	/* initialize palette */
 	for( i = 0; i < 512; i++ )
 	{
 		int r = (( i >> 3) & 7) << 5;
@@ -789,6 +805,8 @@ void PCE::vram_write(int which, uint32 offset, uint8 data)
 	else
 	{
 		vdc[which].vram[offset] = data;
+		vdc[which].sprite_dirty[offset >> 7] = true;
+		vdc[which].bg_dirty[offset >> 5] = true;
 	}
 }
 
@@ -992,8 +1010,7 @@ void PCE::pce_refresh_line(int which, int line, int external_input, uint8 *drawn
 	/* Are we in greyscale mode or in color mode? */
 	scrntype *color_base = vce.palette + (vce.vce_control & 0x80 ? 512 : 0);
 
-	int b0, b1, b2, b3;
-	int i0, i1, i2, i3;
+	uint8 *pattern;
 	int cell_pattern_index;
 	int cell_palette;
 	int x, c, i;
@@ -1018,28 +1035,17 @@ void PCE::pce_refresh_line(int which, int line, int external_input, uint8 *drawn
 			/* palette # = index from 0-15 */
 			cell_palette = ( bat[nt_index + 1] >> 4 ) & 0x0F;
 
-			/* This is the 'character number', from 0-0x0FFF         */
-			/* then it is shifted left 4 bits to form a VRAM address */
-			/* and one more bit to convert VRAM word offset to a     */
-			/* byte-offset within the VRAM space                     */
-			cell_pattern_index = ( ( ( bat[nt_index + 1] << 8 ) | bat[nt_index] ) & 0x0FFF) << 5;
+			/* This is the 'character number', from 0-0x0FFF,     */
+			/* and the pattern at the 0x10000 byte-offset or later */
+			/* is mirrored to the start of VRAM                    */
+			cell_pattern_index = ( ( bat[nt_index + 1] << 8 ) | bat[nt_index] ) & 0x07FF;
 
-			b0 = vram_read(which, (cell_pattern_index) + (v_row << 1) + 0x00);
-			b1 = vram_read(which, (cell_pattern_index) + (v_row << 1) + 0x01);
-			b2 = vram_read(which, (cell_pattern_index) + (v_row << 1) + 0x10);
-			b3 = vram_read(which, (cell_pattern_index) + (v_row << 1) + 0x11);
+			pattern = get_bg_pattern(which, cell_pattern_index, v_row);
 
 			for(x=0;x<8;x++)
 			{
-				i0 = (b0 >> (7-x)) & 1;
-				i1 = (b1 >> (7-x)) & 1;
-				i2 = (b2 >> (7-x)) & 1;
-				i3 = (b3 >> (7-x)) & 1;
-				c = (cell_palette << 4 | i3 << 3 | i2 << 2 | i1 << 1 | i0);
-
 				/* colour #0 always comes from palette #0 */
-				if ( ! ( c & 0x0F ) )
-					c &= 0x0F;
+				c = pattern[x] ? (cell_palette << 4 | pattern[x]) : 0;
 
 				if ( phys_x >= 0 && phys_x < vdc[which].physical_width )
 				{
@@ -1064,50 +1070,121 @@ void PCE::pce_refresh_line(int which, int line, int external_input, uint8 *drawn
 	}
 }
 
+uint8* PCE::get_bg_pattern(int which, int index, int row)
+{
+	if ( vdc[which].bg_dirty[index] )
+	{
+		/* decode 8x8 pattern from 2 words of plane 0/1 and 2 words of plane 2/3 per row */
+		uint8 *src = &vdc[which].vram[index << 5];
+		int y, x;
+
+		for( y = 0; y < 8; y++ )
+		{
+			int b0 = src[(y << 1) + 0x00];
+			int b1 = src[(y << 1) + 0x01];
+			int b2 = src[(y << 1) + 0x10];
+			int b3 = src[(y << 1) + 0x11];
+
+			for( x = 0; x < 8; x++ )
+			{
+				int xi = 7 - x;
+				vdc[which].bg_cache[index][y][x] = ((b3 >> xi) & 1) << 3 | ((b2 >> xi) & 1) << 2 | ((b1 >> xi) & 1) << 1 | ((b0 >> xi) & 1);
+			}
+		}
+		vdc[which].bg_dirty[index] = false;
+	}
+	return vdc[which].bg_cache[index][row];
+}
+
+uint8* PCE::get_sprite_pattern(int which, int index, int row)
+{
+	if ( vdc[which].sprite_dirty[index] )
+	{
+		/* decode 16x16 pattern from 16 words of each plane */
+		uint8 *src = &vdc[which].vram[index << 7];
+		int y, x;
+
+		for( y = 0; y < 16; y++ )
+		{
+			int b0 = src[(y << 1) + 0x00] | (src[(y << 1) + 0x01] << 8);
+			int b1 = src[(y << 1) + 0x20] | (src[(y << 1) + 0x21] << 8);
+			int b2 = src[(y << 1) + 0x40] | (src[(y << 1) + 0x41] << 8);
+			int b3 = src[(y << 1) + 0x60] | (src[(y << 1) + 0x61] << 8);
+
+			for( x = 0; x < 16; x++ )
+			{
+				int xi = 15 - x;
+				vdc[which].sprite_cache[index][y][x] = ((b3 >> xi) & 1) << 3 | ((b2 >> xi) & 1) << 2 | ((b1 >> xi) & 1) << 1 | ((b0 >> xi) & 1);
+			}
+		}
+		vdc[which].sprite_dirty[index] = false;
+	}
+	return vdc[which].sprite_cache[index][row];
+}
+
 void PCE::conv_obj(int which, int i, int l, int hf, int vf, char *buf)
 {
-	int b0, b1, b2, b3, i0, i1, i2, i3, x;
-	int xi;
-	int tmp;
+	uint8 *pattern;
+	int x;
 
 	l &= 0x0F;
 	if(vf) l = (15 - l);
 
-	tmp = l + ( i << 5);
+	/* the pattern at the 0x10000 byte-offset or later is mirrored to the start of VRAM */
+	pattern = get_sprite_pattern(which, (i >> 1) & 0x01FF, l);
+
+	if(hf)
+	{
+		for(x=0;x<16;x++)
+			buf[x] = pattern[15 - x];
+	}
+	else
+	{
+		memcpy(buf, pattern, 16);
+	}
+}
+
+void PCE::vdc_update_sprite_list(int which)
+{
+	static const int cgy_table[] = {16, 32, 64, 64};
+	int i, line;
 
-	b0 = vram_read(which, (tmp + 0x00)<<1);
-	b0 |= vram_read(which, ((tmp + 0x00)<<1)+1)<<8;
-	b1 = vram_read(which, (tmp + 0x10)<<1);
-	b1 |= vram_read(which, ((tmp + 0x10)<<1)+1)<<8;
-	b2 = vram_read(which, (tmp + 0x20)<<1);
-	b2 |= vram_read(which, ((tmp + 0x20)<<1)+1)<<8;
-	b3 = vram_read(which, (tmp + 0x30)<<1);
-	b3 |= vram_read(which, ((tmp + 0x30)<<1)+1)<<8;
+	/* list the sprites on each line once per SATB DMA, instead of scanning 64 sprites per line */
+	memset(vdc[which].sprite_count, 0, sizeof(vdc[which].sprite_count));
 
-	for(x=0;x<16;x++)
+	/* count up: Highest priority is Sprite 0 */
+	for(i = 0; i < 64; i++)
 	{
-		if(hf) xi = x; else xi = (15 - x);
-		i0 = (b0 >> xi) & 1;
-		i1 = (b1 >> xi) & 1;
-		i2 = (b2 >> xi) & 1;
-		i3 = (b3 >> xi) & 1;
-		buf[x] = (i3 << 3 | i2 << 2 | i1 << 1 | i0);
+		int obj_y = (vdc[which].sprite_ram[(i << 2) + 0] & 0x03FF) - 64;
+		int obj_h = cgy_table[(vdc[which].sprite_ram[(i << 2) + 3] >> 12) & 3];
+		int top = (obj_y < 0) ? 0 : obj_y;
+		int bottom = (obj_y + obj_h < VDC_SPR_LINES) ? obj_y + obj_h : VDC_SPR_LINES;
+
+		if (obj_y == -64) continue;
+
+		for(line = top; line < bottom; line++)
+		{
+			vdc[which].sprite_list[line][vdc[which].sprite_count[line]++] = i;
+		}
 	}
 }
 
 void PCE::pce_refresh_sprites(int which, int line, uint8 *drawn, scrntype *line_buffer)
 {
-	int i;
+	int n;
 	uint8 sprites_drawn = 0;
 
 	/* Are we in greyscale mode or in color mode? */
 	scrntype *color_base = vce.palette + (vce.vce_control & 0x80 ? 512 : 0);
 
+	if(line < 0 || line >= VDC_SPR_LINES) return;
+
 	/* count up: Highest priority is Sprite 0 */
-	for(i = 0; i < 64; i++)
+	for(n = 0; n < vdc[which].sprite_count[line]; n++)
 	{
 		static const int cgy_table[] = {16, 32, 64, 64};
 
+		int i = vdc[which].sprite_list[line][n];
 		int obj_y = (vdc[which].sprite_ram[(i << 2) + 0] & 0x03FF) - 64;
 		int obj_x = (vdc[which].sprite_ram[(i << 2) + 1] & 0x03FF) - 32;
 		int obj_i = (vdc[which].sprite_ram[(i << 2) + 2] & 0x07FE);
@@ -1481,6 +1558,39 @@ void PCE::psg_reset()
 	
 	psg_ch = 0;
 	psg_vol = psg_lfo_freq = psg_lfo_ctrl = 0;
+	
+	for(int ch = 0; ch < 8; ch++) {
+		psg_update_volume(ch);
+		psg_update_freq(ch);
+	}
+}
+
+void PCE::psg_update_volume(int ch)
+{
+	int32 vol = max((psg_vol >> 3) & 0x1e, (psg_vol << 1) & 0x1e) + (psg[ch].regs[4] & 0x1f) + max((psg[ch].regs[5] >> 3) & 0x1e, (psg[ch].regs[5] << 1) & 0x1e) - 60;
+	vol = (vol < 0) ? 0 : (vol > 31) ? 31 : vol;
+	psg[ch].vol = psg_vol_table[vol];
+	
+	for(int i = 0; i < 32; i++) {
+		psg[ch].outvol[i] = ((int32)psg[ch].wav[i] - 16) * 702 * psg[ch].vol / 16384;
+	}
+	psg[ch].noisevol[0] = -10 * 702 * psg[ch].vol / 16384;
+	psg[ch].noisevol[1] = 10 * 702 * psg[ch].vol / 16384;
+}
+
+void PCE::psg_update_freq(int ch)
+{
+	if(sample_rate > 0) {
+		uint32 freq = psg[ch].regs[2] + ((uint32)psg[ch].regs[3] << 8);
+		if(freq) {
+			uint32 step = 32 * 1118608 / freq;
+			psg[ch].step_q = step / (10 * sample_rate);
+			psg[ch].step_r = step % (10 * sample_rate);
+		}
+		uint32 noise = 3000 + (psg[ch].regs[7] & 0x1f) * 512;
+		psg[ch].noise_q = noise / sample_rate;
+		psg[ch].noise_r = noise % sample_rate;
+	}
 }
 
 void PCE::psg_write(uint16 addr, uint8 data)
@@ -1491,31 +1601,41 @@ void PCE::psg_write(uint16 addr, uint8 data)
 		break;
 	case 1:
 		psg_vol = data;
+		for(int ch = 0; ch < 8; ch++) {
+			psg_update_volume(ch);
+		}
 		break;
 	case 2:
 		psg[psg_ch].regs[2] = data;
+		psg_update_freq(psg_ch);
 		break;
 	case 3:
 //		psg[psg_ch].regs[3] = data & 0x1f;
 		psg[psg_ch].regs[3] = data & 0xf;
+		psg_update_freq(psg_ch);
 		break;
 	case 4:
 		psg[psg_ch].regs[4] = data;
+		psg_update_volume(psg_ch);
 		break;
 	case 5:
 		psg[psg_ch].regs[5] = data;
+		psg_update_volume(psg_ch);
 		break;
 	case 6:
-		if(psg[psg_ch].regs[4] & 0x40) {
-			psg[psg_ch].wav[0] =data & 0x1f;
-		}
-		else {
-			psg[psg_ch].wav[psg[psg_ch].wavptr] = data & 0x1f;
-			psg[psg_ch].wavptr = (psg[psg_ch].wavptr + 1) & 0x1f;
+		{
+			int ptr = 0;
+			if(!(psg[psg_ch].regs[4] & 0x40)) {
+				ptr = psg[psg_ch].wavptr;
+				psg[psg_ch].wavptr = (psg[psg_ch].wavptr + 1) & 0x1f;
+			}
+			psg[psg_ch].wav[ptr] = data & 0x1f;
+			psg[psg_ch].outvol[ptr] = ((int32)psg[psg_ch].wav[ptr] - 16) * 702 * psg[psg_ch].vol / 16384;
 		}
 		break;
 	case 7:
 		psg[psg_ch].regs[7] = data;
+		psg_update_freq(psg_ch);
 		break;
 	case 8:
 		psg_lfo_freq = data;
@@ -1559,10 +1679,7 @@ uint8 PCE::psg_read(uint16 addr)
 
 void PCE::mix(int32* buffer, int cnt)
 {
-	int vol_tbl[32] = {
-		 100, 451, 508, 573, 646, 728, 821, 925,1043,1175,1325, 1493, 1683, 1898, 2139, 2411,
-		2718,3064,3454,3893,4388,4947,5576,6285,7085,7986,9002,10148,11439,12894,14535,16384
-	};
+	int32 block[PSG_BLOCK_SAMPLES];
 	
 	if(!running) {
 		return;
@@ -1572,62 +1689,65 @@ void PCE::mix(int32* buffer, int cnt)
 			// mute
 			psg[ch].genptr = psg[ch].remain = 0;
 		}
-		else if(psg[ch].regs[4] & 0x40) {
-			// dda
-			int32 wav = ((int32)psg[ch].wav[0] - 16) * 702;
-			int32 vol = max((psg_vol >> 3) & 0x1e, (psg_vol << 1) & 0x1e) + (psg[ch].regs[4] & 0x1f) + max((psg[ch].regs[5] >> 3) & 0x1e, (psg[ch].regs[5] << 1) & 0x1e) - 60;
-			vol = (vol < 0) ? 0 : (vol > 31) ? 31 : vol;
-			vol = wav * vol_tbl[vol] / 16384;
-			for(int i = 0, j = 0; i < cnt; i++, j += 2) {
-				buffer[j    ] += vol; // L
-				buffer[j + 1] += vol; // R
-			}
+	}
+	for(int pos = 0; pos < cnt; pos += PSG_BLOCK_SAMPLES) {
+		int samples = cnt - pos;
+		if(samples > PSG_BLOCK_SAMPLES) {
+			samples = PSG_BLOCK_SAMPLES;
 		}
-		else if(ch >= 4 && (psg[ch].regs[7] & 0x80)) {
-			// noise
-			uint16 freq = (psg[ch].regs[7] & 0x1f);
-			int32 vol = max((psg_vol >> 3) & 0x1e, (psg_vol << 1) & 0x1e) + (psg[ch].regs[4] & 0x1f) + max((psg[ch].regs[5] >> 3) & 0x1e, (psg[ch].regs[5] << 1) & 0x1e) - 60;
-			vol = (vol < 0) ? 0 : (vol > 31) ? 31 : vol;
-			vol = vol_tbl[vol];
-			for(int i = 0, j = 0; i < cnt; i++, j += 2) {
-				psg[ch].remain += 3000 + freq * 512;
-				uint32 t = psg[ch].remain / sample_rate;
-				if(t >= 1) {
-					if(psg[ch].randval & 0x80000) {
-						psg[ch].randval = ((psg[ch].randval ^ 4) << 1) + 1;
-						psg[ch].noise = true;
-					}
-					else {
-						psg[ch].randval <<= 1;
-						psg[ch].noise = false;
-					}
-					psg[ch].remain -= sample_rate * t;
-				}
-				int32 outvol = (int32)((psg[ch].noise ? 10 * 702 : -10 * 702) * vol / 16384);
-				buffer[j    ] += outvol; // L
-				buffer[j + 1] += outvol; // R
+		int32 dda = 0;
+		memset(block, 0, sizeof(int32) * samples);
+		
+		for(int ch = 0; ch < 6; ch++) {
+			psg_t *p = &psg[ch];
+			
+			if(!(p->regs[4] & 0x80)) {
+				// mute
 			}
-		}
-		else {
-			int32 wav[32];
-			for(int i = 0; i < 32; i++) {
-				wav[i] = ((int32)psg[ch].wav[i] - 16) * 702;
+			else if(p->regs[4] & 0x40) {
+				// dda
+				dda += p->outvol[0];
 			}
-			uint32 freq = psg[ch].regs[2] + ((uint32)psg[ch].regs[3] << 8);
-			if(freq) {
-				int32 vol = max((psg_vol >> 3) & 0x1e, (psg_vol << 1) & 0x1e) + (psg[ch].regs[4] & 0x1f) + max((psg[ch].regs[5] >> 3) & 0x1e, (psg[ch].regs[5] << 1) & 0x1e) - 60;
-				vol = (vol < 0) ? 0 : (vol > 31) ? 31 : vol;
-				vol = vol_tbl[vol];
-				for(int i = 0, j = 0; i < cnt; i++, j += 2) {
-					int32 outvol = wav[psg[ch].genptr] * vol / 16384;
-					buffer[j    ] += outvol; // L
-					buffer[j + 1] += outvol; // R
-					psg[ch].remain += 32 * 1118608 / freq;
-					uint32 t = psg[ch].remain / (10 * sample_rate);
-					psg[ch].genptr = (psg[ch].genptr + t) & 0x1f;
-					psg[ch].remain -= 10 * sample_rate * t;
+			else if(ch >= 4 && (p->regs[7] & 0x80)) {
+				// noise
+				uint32 rate = sample_rate, remain = p->remain, randval = p->randval;
+				uint32 noise = p->noise ? 1 : 0;
+				// the remainder left by the tone generator may be more than the sample rate
+				uint32 extra = remain / rate;
+				remain -= rate * extra;
+				for(int i = 0; i < samples; i++) {
+					remain += p->noise_r;
+					uint32 carry = (remain >= rate) ? 1 : 0;
+					remain -= rate & (0 - carry);
+					uint32 shift = (p->noise_q + carry + extra) ? 0xffffffff : 0;
+					uint32 bit = (randval >> 19) & 1;
+					randval = ((((randval ^ (bit << 2)) << 1) + bit) & shift) | (randval & ~shift);
+					noise = (bit & shift) | (noise & ~shift);
+					extra = 0;
+					block[i] += p->noisevol[noise];
 				}
+				p->remain = remain;
+				p->randval = randval;
+				p->noise = (noise != 0);
 			}
+			else if(p->regs[2] | p->regs[3]) {
+				// tone
+				uint32 period = 10 * sample_rate, remain = p->remain, genptr = p->genptr;
+				for(int i = 0; i < samples; i++) {
+					block[i] += p->outvol[genptr];
+					remain += p->step_r;
+					uint32 carry = (remain >= period) ? 1 : 0;
+					remain -= period & (0 - carry);
+					genptr = (genptr + p->step_q + carry) & 0x1f;
+				}
+				p->remain = remain;
+				p->genptr = genptr;
+			}
+		}
+		for(int i = 0, j = pos * 2; i < samples; i++, j += 2) {
+			int32 vol = block[i] + dda;
+			buffer[j    ] += vol; // L
+			buffer[j + 1] += vol; // R
 		}
 	}
 }
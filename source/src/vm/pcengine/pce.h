@@ -21,6 +21,7 @@
 
 #define VDC_WPF		684	/* width of a line in frame including blanking areas */
 #define VDC_LPF		262	/* number of lines in a single frame */
+#define VDC_SPR_LINES	512	/* number of lines in the sprite lists */
 
 class HUC6280;
 
@@ -65,6 +66,12 @@ private:
 		pair vdc_data[32];
 		int status;
 		int y_scroll;
+		uint8 sprite_list[VDC_SPR_LINES][64];	/* sprites on each line in priority order */
+		uint8 sprite_count[VDC_SPR_LINES];
+		uint8 sprite_cache[512][16][16];	/* decoded 16x16 sprite patterns */
+		uint8 bg_cache[2048][8][8];		/* decoded 8x8 background patterns */
+		bool sprite_dirty[512];
+		bool bg_dirty[2048];
 	} vdc[2];
 	struct {
 		uint8 vce_control;		/* VCE control register */
@@ -103,6 +110,9 @@ private:
 	void vce_w(uint16 offset, uint8 data);
 	uint8 vce_r(uint16 offset);
 	void pce_refresh_line(int which, int line, int external_input, uint8 *drawn, scrntype *line_buffer);
+	uint8* get_bg_pattern(int which, int index, int row);
+	uint8* get_sprite_pattern(int which, int index, int row);
+	void vdc_update_sprite_list(int which);
 	void conv_obj(int which, int i, int l, int hf, int vf, char *buf);
 	void pce_refresh_sprites(int which, int line, uint8 *drawn, scrntype *line_buffer);
 	void vdc_do_dma(int which);
@@ -123,11 +133,19 @@ private:
 		uint32 remain;
 		bool noise;
 		uint32 randval;
+		// updated when the registers are written
+		int32 vol;
+		int32 outvol[32];	// wave samples at the volume
+		int32 noisevol[2];
+		uint32 step_q, step_r;	// tone period per sample, in whole and remainder of 10 * sample_rate
+		uint32 noise_q, noise_r;	// noise period per sample, in whole and remainder of sample_rate
 	} psg_t;
 	psg_t psg[8];
 	uint8 psg_ch, psg_vol, psg_lfo_freq, psg_lfo_ctrl;
 	int sample_rate;
 	void psg_reset();
+	void psg_update_volume(int ch);
+	void psg_update_freq(int ch);
 	void psg_write(uint16 addr, uint8 data);
 	uint8 psg_read(uint16 addr);
 	
@@ -142,7 +160,9 @@ private:
 	uint8 joy_read(uint16 addr);
 	
 public:
-	PCE(VM* parent_vm, EMU* parent_emu) : DEVICE(parent_vm, parent_emu) {}
+	PCE(VM* parent_vm, EMU* parent_emu) : DEVICE(parent_vm, parent_emu) {
+		sample_rate = 0;
+	}
 	~PCE() {}
 	
 	// common functions
@@ -162,6 +182,9 @@ public:
 	}
 	void initialize_sound(int rate) {
 		sample_rate = rate;
+		for(int ch = 0; ch < 8; ch++) {
+			psg_update_freq(ch);
+		}
 	}
 	void open_cart(_TCHAR* file_path);
 	void close_cart();
@@ -9,15 +9,20 @@
 
 #include "pcm1bit.h"
 
+// queued writes
+#define QUEUE_SIGNAL	0
+#define QUEUE_ON	1
+#define QUEUE_MUTE	2
+#define QUEUE_EXPIRE	3
+
 void PCM1BIT::initialize()
 {
-	signal = false;
+	signal = out_signal = false;
 	on = true;
 	mute = false;
+	active = false;
 	
 #ifdef PCM1BIT_HIGH_QUALITY
-	sample_count = 0;
-	prev_clock = 0;
 	prev_vol = 0;
 #endif
 	update = 0;
@@ -30,30 +35,52 @@ void PCM1BIT::write_signal(int id, uint32 data, uint32 mask)
 	if(id == SIG_PCM1BIT_SIGNAL) {
 		bool next = ((data & mask) != 0);
 		if(signal != next) {
-#ifdef PCM1BIT_HIGH_QUALITY
-			if(sample_count < 1024) {
-				samples_signal[sample_count] = signal;
-				samples_out[sample_count] = (on && !mute);
-				samples_clock[sample_count] = passed_clock(prev_clock);
-				sample_count++;
-			}
-#endif
 			// mute if signal is not changed in 2 frames
 			update = 2;
 			signal = next;
+			write_queue(QUEUE_SIGNAL, next ? 1 : 0);
 		}
 	}
 	else if(id == SIG_PCM1BIT_ON) {
-		on = ((data & mask) != 0);
+		write_queue(QUEUE_ON, data & mask);
 	}
 	else if(id == SIG_PCM1BIT_MUTE) {
-		mute = ((data & mask) != 0);
+		write_queue(QUEUE_MUTE, data & mask);
 	}
 }
 
 void PCM1BIT::event_frame()
 {
 	if(update && --update == 0) {
+		write_queue(QUEUE_EXPIRE, 0);
+	}
+}
+
+void PCM1BIT::write_queue(uint32 addr, uint32 data)
+{
+	if(queue.full()) {
+		uint32 clock, queued_addr, queued_data;
+		while(queue.read(&clock, &queued_addr, &queued_data)) {
+			apply_queue(queued_addr, queued_data);
+		}
+	}
+	queue.write(current_clock(), addr, data);
+}
+
+void PCM1BIT::apply_queue(uint32 addr, uint32 data)
+{
+	if(addr == QUEUE_SIGNAL) {
+		out_signal = (data != 0);
+		active = true;
+	}
+	else if(addr == QUEUE_ON) {
+		on = (data != 0);
+	}
+	else if(addr == QUEUE_MUTE) {
+		mute = (data != 0);
+	}
+	else if(addr == QUEUE_EXPIRE) {
+		active = false;
 #ifdef PCM1BIT_HIGH_QUALITY
 		prev_vol = 0;
 #endif
@@ -62,67 +89,73 @@ void PCM1BIT::event_frame()
 
 void PCM1BIT::mix(int32* buffer, int cnt)
 {
+	queue.start(current_clock(), cnt);
+	uint32 clock, addr, data;
+	
 #ifdef PCM1BIT_HIGH_QUALITY
-	uint32 cur_clock = current_clock();
-	if(update) {
-		if(sample_count < 1024) {
-			samples_signal[sample_count] = signal;
-			samples_out[sample_count] = (on && !mute);
-			samples_clock[sample_count] = passed_clock(prev_clock);
-			sample_count++;
-		}
-		uint32 start_clock = 0;
-		int start_index = 0;
-		for(int i = 0; i < cnt; i++) {
-			uint32 end_clock = ((cur_clock - prev_clock) * (i + 1)) / cnt;
-			int on_clocks = 0, off_clocks = 0;
-			for(int s = start_index; s < sample_count; s++) {
-				uint32 clock = samples_clock[s];
-				if(clock <= end_clock) {
-					if(samples_out[s]) {
-						if(samples_signal[s]) {
-							on_clocks += clock - start_clock;
-						}
-						else {
-							off_clocks += clock - start_clock;
-						}
-					}
-					start_clock = clock;
-					start_index = s + 1;
+	// average the signal in the period of each sample
+	uint32 span = queue.span();
+	uint32 start_clock = 0;
+	for(int i = 0; i < cnt; i++) {
+		uint32 end_clock = (uint32)((uint64)span * (i + 1) / cnt);
+		int on_clocks = 0, off_clocks = 0;
+		for(;;) {
+			bool written = (queue.peek(&clock) && clock <= end_clock);
+			if(!written) {
+				clock = end_clock;
+			}
+			if(active && on && !mute) {
+				if(out_signal) {
+					on_clocks += clock - start_clock;
 				}
 				else {
-					if(samples_out[s]) {
-						if(samples_signal[s]) {
-							on_clocks += end_clock - start_clock;
-						}
-						else {
-							off_clocks += end_clock - start_clock;
-						}
-					}
-					start_clock = end_clock;
-					start_index = s;
-					break;
+					off_clocks += clock - start_clock;
 				}
 			}
-			int clocks = on_clocks + off_clocks;
-			if(clocks) {
-				prev_vol = max_vol * (on_clocks - off_clocks) / clocks;
+			start_clock = clock;
+			if(!written) {
+				break;
 			}
+			queue.read(&clock, &addr, &data);
+			apply_queue(addr, data);
+		}
+		int clocks = on_clocks + off_clocks;
+		if(clocks) {
+			prev_vol = max_vol * (on_clocks - off_clocks) / clocks;
+		}
+		if(active) {
 			*buffer++ += prev_vol; // L
 			*buffer++ += prev_vol; // R
 		}
+		else {
+			buffer += 2;
+		}
 	}
-	prev_clock = cur_clock;
-	sample_count = 0;
 #else
-	if(on && !mute && update) {
-		int cur_vol = signal ? max_vol : -max_vol;
-		for(int i = 0; i < cnt; i++) {
-			*buffer++ += cur_vol; // L
-			*buffer++ += cur_vol; // R
+	int pos = 0, next;
+	for(;;) {
+		bool written = queue.read(&next, &addr, &data);
+		if(!written) {
+			next = cnt;
+		}
+		if(active && on && !mute) {
+			int cur_vol = out_signal ? max_vol : -max_vol;
+			for(int i = pos; i < next; i++) {
+				buffer[i * 2    ] += cur_vol; // L
+				buffer[i * 2 + 1] += cur_vol; // R
+			}
+		}
+		pos = next;
+		if(!written) {
+			break;
 		}
+		apply_queue(addr, data);
 	}
 #endif
+	// apply the rest if no samples are mixed
+	while(queue.read(&clock, &addr, &data)) {
+		apply_queue(addr, data);
+	}
 }
 
 void PCM1BIT::init(int rate, int volume)
@@ -13,6 +13,7 @@
 #include "vm.h"
 #include "../emu.h"
 #include "device.h"
+#include "sound_queue.h"
 
 #define SIG_PCM1BIT_SIGNAL	0
 #define SIG_PCM1BIT_ON		1
@@ -21,18 +22,18 @@
 class PCM1BIT : public DEVICE
 {
 private:
-	bool signal, on, mute;
+	bool signal;
+	int update;
 	
+	// signals are applied in mix() at their clocks
+	SOUND_QUEUE queue;
+	void write_queue(uint32 addr, uint32 data);
+	void apply_queue(uint32 addr, uint32 data);
+	bool out_signal, on, mute, active;
 #ifdef PCM1BIT_HIGH_QUALITY
-	bool samples_signal[1024];
-	bool samples_out[1024];
-	uint32 samples_clock[1024];
-	int sample_count;
-	uint32 prev_clock;
 	int32 prev_vol;
 #endif
 	int max_vol;
-	int update;
 	
 public:
 	PCM1BIT(VM* parent_vm, EMU* parent_emu) : DEVICE(parent_vm, parent_emu) {}
@@ -43,6 +44,9 @@ public:
 	void write_signal(int id, uint32 data, uint32 mask);
 	void event_frame();
 	void mix(int32* buffer, int cnt);
+	bool mix_per_frame() {
+		return true;
+	}
 	
 	// unique function
 	void init(int rate, int volume);
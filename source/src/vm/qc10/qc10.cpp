@@ -92,7 +92,7 @@ VM::VM(EMU* parent_emu) : emu(parent_emu)
 	// IR5 of I8259 #0 is from light pen
 	fdc->set_context_irq(pic, SIG_I8259_IR6 | SIG_I8259_CHIP0, 1);
 	fdc->set_context_irq(memory, SIG_MEMORY_FDC_IRQ, 1);
-	fdc->set_context_drq(dma0, SIG_I8237_CH0, 1);
+	fdc->set_context_drq_dma(dma0, SIG_I8237_CH0, 1);
 #ifdef _FDC_DEBUG_LOG
 	fdc->set_context_cpu(cpu);
 #endif
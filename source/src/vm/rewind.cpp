@@ -0,0 +1,390 @@
+/*
+	Skelton for retropc emulator
+
+	Author : Takeda.Toshiya
+	Date   : 2013.03.01-
+
+	[ rewind buffer ]
+*/
+
+#include "rewind.h"
+#include "device.h"
+#include "event.h"
+#include "../fileio.h"
+
+// snapshot format:
+//	int32 block_count, int32 block_size[block_count]
+//	for each block:
+//		{ varint skipped_pages, { uint8 same_bytes, uint8 xor_bytes, xor[xor_bytes] } ... } ...
+//		varint skipped_pages (until the end of block)
+
+#define PUT_VARINT(p, v) { \
+	uint32 tmp_v = (uint32)(v); \
+	while(tmp_v >= 0x80) { \
+		*(p)++ = (uint8)(tmp_v | 0x80); \
+		tmp_v >>= 7; \
+	} \
+	*(p)++ = (uint8)tmp_v; \
+}
+
+REWIND::REWIND(VM* parent_vm, EVENT* parent_event) : vm(parent_vm), d_event(parent_event)
+{
+	memset(&cur, 0, sizeof(cur));
+	memset(&key, 0, sizeof(key));
+	memset(&tmp, 0, sizeof(tmp));
+	memset(zero_page, 0, sizeof(zero_page));
+	
+	fio = new FILEIO();
+	fio->Mopen(NULL, 0, FILEIO_WRITE_BINARY);
+	
+	ring = NULL;
+	ring_frames = ring_first = ring_count = 0;
+	keyframe_interval = 1;
+	delta_count = -1;
+	enc_buffer = NULL;
+	enc_alloc = 0;
+}
+
+REWIND::~REWIND()
+{
+	initialize(0, 0);
+	fio->Fclose();
+	delete fio;
+	if(key.buffer) {
+		free(key.buffer);
+	}
+	if(tmp.buffer) {
+		free(tmp.buffer);
+	}
+	if(enc_buffer) {
+		free(enc_buffer);
+	}
+}
+
+void REWIND::initialize(int frames, int interval)
+{
+	// release the snapshots
+	if(ring) {
+		for(int i = 0; i < ring_frames; i++) {
+			if(ring[i].data) {
+				free(ring[i].data);
+			}
+		}
+		free(ring);
+		ring = NULL;
+	}
+	ring_frames = ring_first = ring_count = 0;
+	delta_count = -1;
+	
+	if(frames > 1) {
+		ring_frames = frames;
+		ring = (snapshot_t*)calloc(ring_frames, sizeof(snapshot_t));
+		
+		// at least 2 keyframes are kept not to lose all deltas at once
+		keyframe_interval = (interval < 1) ? 1 : (interval > frames / 2) ? frames / 2 : interval;
+	}
+}
+
+int REWIND::get_buffer_size()
+{
+	int size = cur.size + key.alloc + tmp.alloc + enc_alloc;
+	for(int i = 0; i < ring_frames; i++) {
+		size += ring[i].alloc;
+	}
+	return size;
+}
+
+// ----------------------------------------------------------------------------
+// capture and restore
+// ----------------------------------------------------------------------------
+
+void REWIND::capture()
+{
+	if(ring == NULL || !save_raw(&cur)) {
+		return;
+	}
+	
+	// remove the oldest keyframe and its deltas
+	if(ring_count == ring_frames) {
+		do {
+			ring_first = (ring_first + 1) % ring_frames;
+			ring_count--;
+		}
+		while(ring_count > 0 && !get_snapshot(0)->keyframe);
+	}
+	
+	// encode the current state
+	bool keyframe = (delta_count < 0 || delta_count + 1 >= keyframe_interval);
+	int size = encode(&cur, keyframe ? NULL : &key);
+	
+	snapshot_t* snapshot = get_snapshot(ring_count);
+	if(snapshot->alloc < size || snapshot->alloc > size * 4) {
+		// the buffer is shrunk when the keyframe slot is reused for the delta
+		uint8* data = (uint8*)realloc(snapshot->data, size);
+		if(data == NULL) {
+			return;
+		}
+		snapshot->data = data;
+		snapshot->alloc = size;
+	}
+	memcpy(snapshot->data, enc_buffer, size);
+	snapshot->size = size;
+	snapshot->keyframe = keyframe;
+	ring_count++;
+	
+	if(keyframe) {
+		// the next deltas are made from this state
+		alloc_raw(&key, cur.size);
+		memcpy(key.buffer, cur.buffer, cur.size);
+		key.size = cur.size;
+		key.block_count = cur.block_count;
+		memcpy(key.block_ofs, cur.block_ofs, sizeof(key.block_ofs));
+		memcpy(key.block_size, cur.block_size, sizeof(key.block_size));
+		delta_count = 0;
+	}
+	else {
+		delta_count++;
+	}
+}
+
+bool REWIND::restore(int frames)
+{
+	// restore the state at the start of the frame that was run before the frames
+	if(frames < 1 || frames > ring_count) {
+		return false;
+	}
+	int index = ring_count - frames;
+	int key_index = index;
+	while(key_index > 0 && !get_snapshot(key_index)->keyframe) {
+		key_index--;
+	}
+	if(!decode(get_snapshot(key_index), NULL, &key)) {
+		return false;
+	}
+	if(key_index != index) {
+		if(!decode(get_snapshot(index), &key, &tmp) || !load_raw(&tmp)) {
+			return false;
+		}
+	}
+	else if(!load_raw(&key)) {
+		return false;
+	}
+	
+	// the restored state is captured again at the next frame boundary
+	ring_count = index;
+	if(key_index == index) {
+		key_index--;
+		while(key_index >= 0 && !get_snapshot(key_index)->keyframe) {
+			key_index--;
+		}
+		if(key_index < 0 || !decode(get_snapshot(key_index), NULL, &key)) {
+			// no snapshot remains
+			ring_count = 0;
+			delta_count = -1;
+			return true;
+		}
+	}
+	delta_count = ring_count - 1 - key_index;
+	return true;
+}
+
+// ----------------------------------------------------------------------------
+// raw state
+// ----------------------------------------------------------------------------
+
+bool REWIND::save_raw(raw_t* raw)
+{
+	// pending sound samples are not needed to restore the machine
+	d_event->set_save_sound_tmp(false);
+	fio->Fseek(0, FILEIO_SEEK_SET);
+	raw->block_count = 0;
+	for(DEVICE* device = vm->first_device; device; device = device->next_device) {
+		if(raw->block_count == REWIND_MAX_BLOCKS) {
+			d_event->set_save_sound_tmp(true);
+			return false;
+		}
+		raw->block_ofs[raw->block_count] = fio->Ftell();
+		device->save_state(fio);
+		raw->block_size[raw->block_count] = fio->Ftell() - raw->block_ofs[raw->block_count];
+		raw->block_count++;
+	}
+	d_event->set_save_sound_tmp(true);
+	
+	// the stream buffer may be moved when it is expanded
+	raw->buffer = (uint8*)fio->GetBuffer();
+	raw->size = fio->Ftell();
+	return true;
+}
+
+bool REWIND::load_raw(raw_t* raw)
+{
+	FILEIO* rfio = new FILEIO();
+	bool result = rfio->Mopen(raw->buffer, raw->size, FILEIO_READ_BINARY);
+	int count = 0;
+	for(DEVICE* device = vm->first_device; device && result; device = device->next_device) {
+		if(count == raw->block_count) {
+			result = false;
+			break;
+		}
+		rfio->Fseek(raw->block_ofs[count++], FILEIO_SEEK_SET);
+		result = device->load_state(rfio);
+	}
+	rfio->Fclose();
+	delete rfio;
+	return result && (count == raw->block_count);
+}
+
+void REWIND::alloc_raw(raw_t* raw, int size)
+{
+	if(raw->alloc < size) {
+		raw->buffer = (uint8*)realloc(raw->buffer, size);
+		raw->alloc = size;
+	}
+}
+
+// ----------------------------------------------------------------------------
+// xor delta + rle
+// ----------------------------------------------------------------------------
+
+int REWIND::encode(raw_t* raw, raw_t* ref)
+{
+	// worst case: every other byte is changed
+	int max_size = 4 + 4 * raw->block_count + raw->size * 2 + 16 * raw->block_count;
+	if(enc_alloc < max_size) {
+		enc_buffer = (uint8*)realloc(enc_buffer, max_size);
+		enc_alloc = max_size;
+	}
+	uint8* p = enc_buffer;
+	uint8 ref_page[REWIND_PAGE_SIZE];
+	
+	*(int32*)p = raw->block_count;
+	p += 4;
+	for(int i = 0; i < raw->block_count; i++) {
+		*(int32*)p = raw->block_size[i];
+		p += 4;
+	}
+	for(int i = 0; i < raw->block_count; i++) {
+		uint8* src = raw->buffer + raw->block_ofs[i];
+		int size = raw->block_size[i];
+		uint8* ref_src = NULL;
+		int ref_size = 0;
+		if(ref != NULL && i < ref->block_count) {
+			ref_src = ref->buffer + ref->block_ofs[i];
+			ref_size = ref->block_size[i];
+		}
+		int skipped = 0;
+		
+		for(int pos = 0; pos < size; pos += REWIND_PAGE_SIZE) {
+			int length = (size - pos < REWIND_PAGE_SIZE) ? size - pos : REWIND_PAGE_SIZE;
+			uint8* cur_page = src + pos;
+			uint8* old_page;
+			
+			// the block may be longer than the reference, compare with zero
+			if(pos + length <= ref_size) {
+				old_page = ref_src + pos;
+			}
+			else if(pos < ref_size) {
+				memcpy(ref_page, ref_src + pos, ref_size - pos);
+				memset(ref_page + ref_size - pos, 0, length - (ref_size - pos));
+				old_page = ref_page;
+			}
+			else {
+				old_page = zero_page;
+			}
+			if(memcmp(cur_page, old_page, length) == 0) {
+				skipped++;
+				continue;
+			}
+			PUT_VARINT(p, skipped);
+			skipped = 0;
+			
+			for(int j = 0; j < length;) {
+				int same = 0, diff = 0;
+				while(j < length && same < 255 && cur_page[j] == old_page[j]) {
+					j++;
+					same++;
+				}
+				while(j < length && diff < 255 && cur_page[j] != old_page[j]) {
+					p[2 + diff] = cur_page[j] ^ old_page[j];
+					j++;
+					diff++;
+				}
+				p[0] = same;
+				p[1] = diff;
+				p += 2 + diff;
+			}
+		}
+		PUT_VARINT(p, skipped);
+	}
+	return (int)(p - enc_buffer);
+}
+
+bool REWIND::decode(snapshot_t* snapshot, raw_t* ref, raw_t* raw)
+{
+	uint8* p = snapshot->data;
+	uint8* end = snapshot->data + snapshot->size;
+	
+	int block_count = *(int32*)p;
+	p += 4;
+	if(!(0 < block_count && block_count <= REWIND_MAX_BLOCKS)) {
+		return false;
+	}
+	int size = 0;
+	for(int i = 0; i < block_count; i++) {
+		raw->block_ofs[i] = size;
+		raw->block_size[i] = *(int32*)p;
+		size += raw->block_size[i];
+		p += 4;
+	}
+	alloc_raw(raw, size);
+	raw->size = size;
+	raw->block_count = block_count;
+	
+	for(int i = 0; i < block_count; i++) {
+		uint8* dst = raw->buffer + raw->block_ofs[i];
+		int size = raw->block_size[i];
+		
+		// start from the reference block
+		int ref_size = 0;
+		if(ref != NULL && i < ref->block_count) {
+			ref_size = (ref->block_size[i] < size) ? ref->block_size[i] : size;
+			memcpy(dst, ref->buffer + ref->block_ofs[i], ref_size);
+		}
+		memset(dst + ref_size, 0, size - ref_size);
+		
+		for(int pos = 0;;) {
+			// skipped pages
+			uint32 skipped = 0;
+			for(int shift = 0; p < end; shift += 7) {
+				uint8 data = *p++;
+				skipped |= (uint32)(data & 0x7f) << shift;
+				if(!(data & 0x80)) {
+					break;
+				}
+			}
+			pos += skipped * REWIND_PAGE_SIZE;
+			if(pos >= size) {
+				break;
+			}
+			int length = (size - pos < REWIND_PAGE_SIZE) ? size - pos : REWIND_PAGE_SIZE;
+			uint8* page = dst + pos;
+			
+			for(int j = 0; j < length;) {
+				if(p + 2 > end) {
+					return false;
+				}
+				int same = p[0], diff = p[1];
+				p += 2;
+				j += same;
+				if(j + diff > length || p + diff > end) {
+					return false;
+				}
+				for(int k = 0; k < diff; k++) {
+					page[j++] ^= *p++;
+				}
+			}
+			pos += length;
+		}
+	}
+	return true;
+}
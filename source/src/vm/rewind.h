@@ -0,0 +1,80 @@
+/*
+	Skelton for retropc emulator
+
+	Author : Takeda.Toshiya
+	Date   : 2013.03.01-
+
+	[ rewind buffer ]
+*/
+
+#ifndef _REWIND_H_
+#define _REWIND_H_
+
+#include "vm.h"
+#include "../emu.h"
+
+#define REWIND_PAGE_SIZE	256
+#define REWIND_MAX_BLOCKS	64
+
+class EVENT;
+class FILEIO;
+
+// the states of all devices are captured at every frame boundary.
+// each device block is compared page by page with the same block of the last
+// keyframe, and only the changed pages are kept as xor delta with rle.
+
+class REWIND
+{
+private:
+	VM* vm;
+	EVENT* d_event;
+	
+	// raw state: blocks of the devices
+	typedef struct {
+		uint8* buffer;
+		int size, alloc;
+		int block_count;
+		int block_ofs[REWIND_MAX_BLOCKS];
+		int block_size[REWIND_MAX_BLOCKS];
+	} raw_t;
+	raw_t cur, key, tmp;
+	FILEIO* fio;
+	
+	// encoded snapshots
+	typedef struct {
+		uint8* data;
+		int size, alloc;
+		bool keyframe;
+	} snapshot_t;
+	snapshot_t* ring;
+	int ring_frames, ring_first, ring_count;
+	int keyframe_interval, delta_count;
+	
+	uint8* enc_buffer;
+	int enc_alloc;
+	uint8 zero_page[REWIND_PAGE_SIZE];
+	
+	bool save_raw(raw_t* raw);
+	bool load_raw(raw_t* raw);
+	void alloc_raw(raw_t* raw, int size);
+	int encode(raw_t* raw, raw_t* ref);
+	bool decode(snapshot_t* snapshot, raw_t* ref, raw_t* raw);
+	snapshot_t* get_snapshot(int index) {
+		return &ring[(ring_first + index) % ring_frames];
+	}
+
+public:
+	REWIND(VM* parent_vm, EVENT* parent_event);
+	~REWIND();
+	
+	void initialize(int frames, int interval);
+	void capture();
+	bool restore(int frames);
+	int get_frames() {
+		return ring_count;
+	}
+	int get_buffer_size();
+};
+
+#endif
+
@@ -22,6 +22,10 @@
 #endif
 #define NOISE_MODE	((regs[6] & 4) ? 1 : 0)
 
+// queued writes
+#define QUEUE_DATA	0
+#define QUEUE_MUTE	1
+
 void SN76489AN::initialize()
 {
 	mute = false;
@@ -30,6 +34,7 @@ void SN76489AN::initialize()
 
 void SN76489AN::reset()
 {
+	flush_queue();
 	for(int i = 0; i < 4; i++) {
 		ch[i].count = 0;
 		ch[i].period = 1;
@@ -46,7 +51,18 @@ void SN76489AN::reset()
 
 void SN76489AN::write_io8(uint32 addr, uint32 data)
 {
-	if(data & 0x80) {
+	if(queue.full()) {
+		flush_queue();
+	}
+	queue.write(current_clock(), QUEUE_DATA, data);
+}
+
+void SN76489AN::write_reg(uint32 addr, uint32 data)
+{
+	if(addr == QUEUE_MUTE) {
+		mute = (data != 0);
+	}
+	else if(data & 0x80) {
 		index = (data >> 4) & 7;
 		int c = index >> 1;
 		
@@ -94,7 +110,10 @@ void SN76489AN::write_io8(uint32 addr, uint32 data)
 void SN76489AN::write_signal(int id, uint32 data, uint32 mask)
 {
 	if(id == SIG_SN76489AN_MUTE) {
-		mute = ((data & mask) != 0);
+		if(queue.full()) {
+			flush_queue();
+		}
+		queue.write(current_clock(), QUEUE_MUTE, data & mask);
 	}
 	else if(id == SIG_SN76489AN_DATA) {
 		val = data & mask;
@@ -127,11 +146,38 @@ void SN76489AN::write_signal(int id, uint32 data, uint32 mask)
 	}
 }
 
+void SN76489AN::flush_queue()
+{
+	uint32 clock, addr, data;
+	while(queue.read(&clock, &addr, &data)) {
+		write_reg(addr, data);
+	}
+}
+
 void SN76489AN::mix(int32* buffer, int cnt)
 {
-	if(mute) {
-		return;
+	queue.start(current_clock(), cnt);
+	
+	int pos = 0, next;
+	uint32 addr, data;
+	for(;;) {
+		bool written = queue.read(&next, &addr, &data);
+		if(!written) {
+			next = cnt;
+		}
+		if(next > pos && !mute) {
+			update_sound(buffer + pos * 2, next - pos);
+		}
+		pos = next;
+		if(!written) {
+			break;
+		}
+		write_reg(addr, data);
 	}
+}
+
+void SN76489AN::update_sound(int32* buffer, int cnt)
+{
 	for(int i = 0; i < cnt; i++) {
 		int32 vol = 0;
 		for(int j = 0; j < 4; j++) {
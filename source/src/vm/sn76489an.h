@@ -13,6 +13,7 @@
 #include "vm.h"
 #include "../emu.h"
 #include "device.h"
+#include "sound_queue.h"
 
 #define SIG_SN76489AN_MUTE	0
 #define SIG_SN76489AN_DATA	1
@@ -40,6 +41,12 @@ private:
 	bool mute, cs, we;
 	uint8 val;
 	
+	// register writes are applied in mix() at their sample positions
+	SOUND_QUEUE queue;
+	void write_reg(uint32 addr, uint32 data);
+	void flush_queue();
+	void update_sound(int32* buffer, int cnt);
+	
 public:
 	SN76489AN(VM* parent_vm, EMU* parent_emu) : DEVICE(parent_vm, parent_emu) {}
 	~SN76489AN() {}
@@ -50,6 +57,9 @@ public:
 	void write_io8(uint32 addr, uint32 data);
 	void write_signal(int id, uint32 data, uint32 mask);
 	void mix(int32* buffer, int cnt);
+	bool mix_per_frame() {
+		return true;
+	}
 	
 	// unique function
 	void init(int rate, int clock, int volume);
@@ -0,0 +1,100 @@
+/*
+	Skelton for retropc emulator
+
+	Author : Takeda.Toshiya
+	Date   : 2013.03.01-
+
+	[ sound register write queue ]
+*/
+
+#ifndef _SOUND_QUEUE_H_
+#define _SOUND_QUEUE_H_
+
+#include "vm.h"
+#include "../emu.h"
+
+// the cpu and the mixer run in the same thread, so a simple ring buffer is enough
+#define SOUND_QUEUE_SIZE	4096
+
+class SOUND_QUEUE
+{
+private:
+	typedef struct {
+		uint32 clock;
+		uint32 addr;
+		uint32 data;
+	} write_t;
+	write_t queue[SOUND_QUEUE_SIZE];
+	int read_ptr, write_ptr;
+	
+	// clock at the start of the next block, and the block being mixed
+	uint32 next_clock;
+	uint32 block_clock, block_span;
+	int block_samples;
+	
+public:
+	SOUND_QUEUE() {
+		reset(0);
+	}
+	~SOUND_QUEUE() {}
+	
+	void reset(uint32 clock) {
+		read_ptr = write_ptr = 0;
+		next_clock = block_clock = clock;
+		block_span = 0;
+		block_samples = 0;
+	}
+	bool empty() {
+		return (read_ptr == write_ptr);
+	}
+	bool full() {
+		return (((write_ptr + 1) & (SOUND_QUEUE_SIZE - 1)) == read_ptr);
+	}
+	void write(uint32 clock, uint32 addr, uint32 data) {
+		queue[write_ptr].clock = clock;
+		queue[write_ptr].addr = addr;
+		queue[write_ptr].data = data;
+		write_ptr = (write_ptr + 1) & (SOUND_QUEUE_SIZE - 1);
+	}
+	
+	// mixer side: start the block that ends at the current clock
+	void start(uint32 cur_clock, int cnt) {
+		block_clock = next_clock;
+		block_span = cur_clock - block_clock;
+		block_samples = cnt;
+		next_clock = cur_clock;
+	}
+	uint32 span() {
+		return block_span;
+	}
+	// clock of the next write from the start of the block
+	bool peek(uint32* clock) {
+		if(read_ptr == write_ptr) {
+			return false;
+		}
+		uint32 offset = queue[read_ptr].clock - block_clock;
+		*clock = (offset < block_span) ? offset : block_span;
+		return true;
+	}
+	bool read(uint32* clock, uint32* addr, uint32* data) {
+		if(!peek(clock)) {
+			return false;
+		}
+		*addr = queue[read_ptr].addr;
+		*data = queue[read_ptr].data;
+		read_ptr = (read_ptr + 1) & (SOUND_QUEUE_SIZE - 1);
+		return true;
+	}
+	// sample position of the next write in the block
+	bool read(int* pos, uint32* addr, uint32* data) {
+		uint32 clock;
+		if(!read(&clock, addr, data)) {
+			return false;
+		}
+		*pos = block_span ? (int)((uint64)clock * block_samples / block_span) : 0;
+		return true;
+	}
+};
+
+#endif
+
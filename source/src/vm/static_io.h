@@ -0,0 +1,108 @@
+/*
+	Skelton for retropc emulator
+
+	Author : Takeda.Toshiya
+	Date   : 2013.03.01-
+
+	[ compile time i/o map ]
+
+	a machine may declare the i/o map of a cpu as a chain of the entries
+	in STATIC_IO_MAP class, that is the friend of its VM class, for example:
+
+	typedef STATIC_IO_W<SYSTEM, &VM::system, 0xf0, 0x10, -1,
+		STATIC_IO_W<MEMORY, &VM::memory, 0xe0, 0x60, -1,
+		STATIC_IO_END<IO, &VM::io> > > static_io_w;
+
+	and defines STATIC_IO_MAP_H as the header of STATIC_IO_MAP class.
+	the header has to include the headers of the devices in the map.
+	the map is used only when the virtual machine is built with _STATIC_IO,
+	the tools that build the cpu without the devices do not define it.
+
+	an entry passes the access to the port that matches (addr & mask) == value
+	to the device by the non virtual call. alias replaces the lower address,
+	as set_iomap_alias_*() of IO. the ports not in the chain are accessed
+	through the runtime i/o map of the bus device, so the ports that have
+	the registered values or are remapped at runtime must not be in the chain.
+	the entries are checked in order, so put the frequently accessed ports
+	first. the map is used only by the cpu connected to the bus device of
+	STATIC_IO_END.
+*/
+
+#ifndef _STATIC_IO_H_
+#define _STATIC_IO_H_
+
+#ifndef IO_ADDR_MAX
+#define IO_ADDR_MAX 0x100
+#endif
+#define IO_ADDR_MASK (IO_ADDR_MAX - 1)
+
+class VM;
+class DEVICE;
+
+template <class T, T* VM::*bus>
+class STATIC_IO_END
+{
+public:
+	static inline bool is_bus(VM* vm, DEVICE* device) {
+		return static_cast<DEVICE*>(vm->*bus) == device;
+	}
+	static inline bool write_io8(VM* vm, uint32 addr, uint32 data) {
+		return false;
+	}
+	static inline bool read_io8(VM* vm, uint32 addr, uint32* data) {
+		return false;
+	}
+	static inline DEVICE* get_device(VM* vm, uint32 addr, uint32* addr2) {
+		return NULL;
+	}
+};
+
+template <class T, T* VM::*dev, uint32 mask, uint32 value, int alias, class next>
+class STATIC_IO_W
+{
+public:
+	static inline bool is_bus(VM* vm, DEVICE* device) {
+		return next::is_bus(vm, device);
+	}
+	static inline bool write_io8(VM* vm, uint32 addr, uint32 data) {
+		if((addr & mask) == value) {
+			(vm->*dev)->T::write_io8((alias < 0) ? addr : ((addr & ~IO_ADDR_MASK) | alias), data & 0xff);
+			return true;
+		}
+		return next::write_io8(vm, addr, data);
+	}
+	// for checking the map
+	static inline DEVICE* get_device(VM* vm, uint32 addr, uint32* addr2) {
+		if((addr & mask) == value) {
+			*addr2 = (alias < 0) ? addr : ((addr & ~IO_ADDR_MASK) | alias);
+			return static_cast<DEVICE*>(vm->*dev);
+		}
+		return next::get_device(vm, addr, addr2);
+	}
+};
+
+template <class T, T* VM::*dev, uint32 mask, uint32 value, int alias, class next>
+class STATIC_IO_R
+{
+public:
+	static inline bool is_bus(VM* vm, DEVICE* device) {
+		return next::is_bus(vm, device);
+	}
+	static inline bool read_io8(VM* vm, uint32 addr, uint32* data) {
+		if((addr & mask) == value) {
+			*data = (vm->*dev)->T::read_io8((alias < 0) ? addr : ((addr & ~IO_ADDR_MASK) | alias)) & 0xff;
+			return true;
+		}
+		return next::read_io8(vm, addr, data);
+	}
+	// for checking the map
+	static inline DEVICE* get_device(VM* vm, uint32 addr, uint32* addr2) {
+		if((addr & mask) == value) {
+			*addr2 = (alias < 0) ? addr : ((addr & ~IO_ADDR_MASK) | alias);
+			return static_cast<DEVICE*>(vm->*dev);
+		}
+		return next::get_device(vm, addr, addr2);
+	}
+};
+
+#endif
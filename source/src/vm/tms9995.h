@@ -27,6 +27,7 @@ private:
 	
 	// clocks
 	int count, period;
+	int first_count, opecode_count;
 	// register
 	uint16 WP, PC, prevPC, ST;
 	uint8 RAM[256];
@@ -123,6 +124,16 @@ public:
 	uint32 get_pc() {
 		return prevPC;
 	}
+	int get_run_clock() {
+		return first_count - opecode_count;
+	}
+	void stop_run() {
+		if(count > 0) {
+			first_count -= count;
+			opecode_count -= count;
+			count = 0;
+		}
+	}
 	
 	// unique function
 	void set_context_mem(DEVICE* device) {
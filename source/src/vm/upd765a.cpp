@@ -10,6 +10,7 @@
 
 #include "upd765a.h"
 #include "disk.h"
+#include "../config.h"
 
 #define EVENT_PHASE	0
 #define EVENT_DRQ	1
@@ -85,6 +86,10 @@
 	} \
 }
 
+// fast disk: drq is kept asserted while dma transfers the sector,
+// only when the drq is connected to the dma controller by set_context_drq_dma()
+#define BURST_DRQ() (fast_disk && drq_dma && !no_dma_mode && !drq_masked)
+
 #define CANCEL_EVENT() { \
 	if(phase_id != -1) { \
 		cancel_event(phase_id); \
@@ -112,6 +117,9 @@
 
 void UPD765A::initialize()
 {
+	// config
+	fast_disk = config.fast_disk;
+	
 	// initialize d88 handler
 	for(int i = 0; i < 4; i++) {
 		disk[i] = new DISK();
@@ -171,6 +179,11 @@ void UPD765A::reset()
 	set_drq(false);
 }
 
+void UPD765A::update_config()
+{
+	fast_disk = config.fast_disk;
+}
+
 void UPD765A::write_io8(uint32 addr, uint32 data)
 {
 	if(addr & 1) {
@@ -246,12 +259,17 @@ void UPD765A::write_io8(uint32 addr, uint32 data)
 				emu->out_debug("FDC: WRITE=%2x\n", data);
 #endif
 				*bufptr++ = data;
-				set_drq(false);
-				if(--count) {
-					REGISTER_DRQ_EVENT();
+				if(--count && BURST_DRQ()) {
+					status |= S_RQM;
 				}
 				else {
-					process_cmd(command & 0x1f);
+					set_drq(false);
+					if(count) {
+						REGISTER_DRQ_EVENT();
+					}
+					else {
+						process_cmd(command & 0x1f);
+					}
 				}
 				fdc[hdu & DRIVE_MASK].access = true;
 				break;
@@ -265,12 +283,17 @@ void UPD765A::write_io8(uint32 addr, uint32 data)
 					}
 				}
 				bufptr++;
-				set_drq(false);
-				if(--count) {
-					REGISTER_DRQ_EVENT();
+				if(--count && BURST_DRQ()) {
+					status |= S_RQM;
 				}
 				else {
-					cmd_scan();
+					set_drq(false);
+					if(count) {
+						REGISTER_DRQ_EVENT();
+					}
+					else {
+						cmd_scan();
+					}
 				}
 				fdc[hdu & DRIVE_MASK].access = true;
 				break;
@@ -319,12 +342,17 @@ uint32 UPD765A::read_io8(uint32 addr)
 #ifdef _FDC_DEBUG_LOG
 				emu->out_debug("FDC: READ=%2x\n", data);
 #endif
-				set_drq(false);
-				if(--count) {
-					REGISTER_DRQ_EVENT();
+				if(--count && BURST_DRQ()) {
+					status |= S_RQM;
 				}
 				else {
-					process_cmd(command & 0x1f);
+					set_drq(false);
+					if(count) {
+						REGISTER_DRQ_EVENT();
+					}
+					else {
+						process_cmd(command & 0x1f);
+					}
 				}
 				fdc[hdu & DRIVE_MASK].access = true;
 				return data;
@@ -648,7 +676,7 @@ void UPD765A::cmd_recalib()
 void UPD765A::seek(int drv, int trk)
 {
 	// get distance
-	int seektime = (trk == fdc[drv].track) ? 120 : 40 * abs(trk - fdc[drv].track) + 500; //usec
+	int seektime = (trk == fdc[drv].track || fast_disk) ? 120 : 40 * abs(trk - fdc[drv].track) + 500; //usec
 	
 	if(drv >= MAX_DRIVE) {
 		// invalid drive number
@@ -29,6 +29,9 @@ class DISK;
 class UPD765A : public DEVICE
 {
 private:
+	// config
+	bool fast_disk;
+	
 	// fdc
 	typedef struct {
 		uint8 track;
@@ -41,6 +44,7 @@ private:
 	// output signals
 	outputs_t outputs_irq;
 	outputs_t outputs_drq;
+	bool drq_dma;
 	outputs_t outputs_hdu;
 	outputs_t outputs_index;
 #ifdef _FDC_DEBUG_LOG
@@ -118,6 +122,7 @@ public:
 		init_output_signals(&outputs_drq);
 		init_output_signals(&outputs_hdu);
 		init_output_signals(&outputs_index);
+		drq_dma = false;
 #ifdef _FDC_DEBUG_LOG
 		d_cpu = NULL;
 #endif
@@ -136,6 +141,7 @@ public:
 	void write_signal(int id, uint32 data, uint32 mask);
 	uint32 read_signal(int ch);
 	void event_callback(int event_id, int err);
+	void update_config();
 	
 	// unique function
 	void set_context_irq(DEVICE* device, int id, uint32 mask) {
@@ -144,6 +150,11 @@ public:
 	void set_context_drq(DEVICE* device, int id, uint32 mask) {
 		register_output_signal(&outputs_drq, device, id, mask);
 	}
+	// the dma controller that keeps transferring while the drq is asserted
+	void set_context_drq_dma(DEVICE* device, int id, uint32 mask) {
+		register_output_signal(&outputs_drq, device, id, mask);
+		drq_dma = true;
+	}
 	void set_context_hdu(DEVICE* device, int id, uint32 mask) {
 		register_output_signal(&outputs_hdu, device, id, mask);
 	}
@@ -1112,9 +1112,10 @@ int UPD7801::run(int clock)
 	else {
 		// run cpu while given clocks
 		count += clock;
-		int first_count = count;
+		first_count = count;
 		
 		while(count > 0) {
+			opecode_count = count;
 			run_one_opecode();
 		}
 		return first_count - count;
@@ -41,6 +41,7 @@ private:
 	--------------------------------------------------------------------------- */
 	
 	int count, period, scount, tcount;
+	int first_count, opecode_count;
 	bool wait;
 	
 	pair regs[4];
@@ -96,6 +97,16 @@ public:
 	uint32 get_pc() {
 		return prevPC;
 	}
+	int get_run_clock() {
+		return first_count - opecode_count;
+	}
+	void stop_run() {
+		if(count > 0) {
+			first_count -= count;
+			opecode_count -= count;
+			count = 0;
+		}
+	}
 	
 	// unique function
 	void set_context_mem(DEVICE* device) {
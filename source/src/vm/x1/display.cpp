@@ -833,23 +833,17 @@ void DISPLAY::draw_cg(int line)
 	int ofs_b = ofs + 0x0000;
 	int ofs_r = ofs + 0x4000;
 	int ofs_g = ofs + 0x8000;
+	uint8 b[80], r[80], g[80];
+	uint8 *plane[3] = {b, r, g};
+	int x;
 	
-	for(int x = 0; x < hz_disp && x < width; x++) {
+	for(x = 0; x < hz_disp && x < width; x++) {
 		src &= 0x7ff;
-		uint8 b = vram_ptr[ofs_b | src];
-		uint8 r = vram_ptr[ofs_r | src];
-		uint8 g = vram_ptr[ofs_g | src++];
-		uint8* d = &cg[line][x << 3];
-		
-		d[0] = ((b & 0x80) >> 7) | ((r & 0x80) >> 6) | ((g & 0x80) >> 5);
-		d[1] = ((b & 0x40) >> 6) | ((r & 0x40) >> 5) | ((g & 0x40) >> 4);
-		d[2] = ((b & 0x20) >> 5) | ((r & 0x20) >> 4) | ((g & 0x20) >> 3);
-		d[3] = ((b & 0x10) >> 4) | ((r & 0x10) >> 3) | ((g & 0x10) >> 2);
-		d[4] = ((b & 0x08) >> 3) | ((r & 0x08) >> 2) | ((g & 0x08) >> 1);
-		d[5] = ((b & 0x04) >> 2) | ((r & 0x04) >> 1) | ((g & 0x04) >> 0);
-		d[6] = ((b & 0x02) >> 1) | ((r & 0x02) >> 0) | ((g & 0x02) << 1);
-		d[7] = ((b & 0x01) >> 0) | ((r & 0x01) << 1) | ((g & 0x01) << 2);
+		b[x] = vram_ptr[ofs_b | src];
+		r[x] = vram_ptr[ofs_r | src];
+		g[x] = vram_ptr[ofs_g | src++];
 	}
+	planar_to_chunky(cg[line], plane, 3, x, false);
 }
 
 // kanji rom (from X1EMU by KM)
@@ -9,6 +9,8 @@
 
 #include "ym2203.h"
 
+#define STATE_VERSION	1
+
 void YM2203::initialize()
 {
 #ifdef HAS_YM2608
@@ -19,6 +21,7 @@ void YM2203::initialize()
 #if defined(_WIN32) && !defined(HAS_AY_3_8912)
 	fmdll = new CFMDLL(_T("mamefm.dll"));
 	dllchip = NULL;
+	memset(dllchip_reg, 0, sizeof(dllchip_reg));
 #endif
 	register_vline_event(this);
 	mute = false;
@@ -38,6 +41,7 @@ void YM2203::release()
 
 void YM2203::reset()
 {
+	flush_queue();
 	chip->Reset();
 #if defined(_WIN32) && !defined(HAS_AY_3_8912)
 	if(dllchip) {
@@ -45,6 +49,9 @@ void YM2203::reset()
 	}
 #endif
 	this->SetReg(0x27, 0); // stop timer
+	for(int i = 0; i < 16; i++) {
+		psg_reg[i] = chip->GetReg(i);
+	}
 	
 	port[0].first = port[1].first = true;
 	irq_prev = false;
@@ -89,7 +96,7 @@ void YM2203::write_io8(uint32 addr, uint32 data)
 		// don't write again for prescaler
 		if(!(0x2d <= ch && ch <= 0x2f)) {
 			update_count();
-			this->SetReg(ch, data);
+			write_reg(ch, data);
 #ifndef HAS_AY_3_8912
 			update_interrupt();
 #endif
@@ -101,7 +108,7 @@ void YM2203::write_io8(uint32 addr, uint32 data)
 		break;
 	case 3:
 		update_count();
-		this->SetReg(0x100 | ch1, data);
+		write_reg(0x100 | ch1, data);
 		data1 = data;
 		update_interrupt();
 		break;
@@ -126,6 +133,9 @@ uint32 YM2203::read_io8(uint32 addr)
 		else if(ch == 15) {
 			return (mode & 0x80) ? port[1].wreg : port[1].rreg;
 		}
+		else if(ch < 16) {
+			return psg_reg[ch];
+		}
 		return chip->GetReg(ch);
 #ifdef HAS_YM2608
 	case 2:
@@ -155,7 +165,10 @@ void YM2203::write_signal(int id, uint32 data, uint32 mask)
 		port[1].rreg = (port[1].rreg & ~mask) | (data & mask);
 	}
 	else if(id == SIG_YM2203_MUTE) {
-		mute = ((data & mask) != 0);
+		if(queue.full()) {
+			flush_queue();
+		}
+		queue.write(current_clock(), 0x200, data & mask);
 	}
 }
 
@@ -192,15 +205,64 @@ void YM2203::update_interrupt()
 }
 #endif
 
+void YM2203::write_reg(uint addr, uint data)
+{
+	if(addr < 16) {
+		psg_reg[addr] = data;
+	}
+	// timer, status and adpcm memory registers are read back by the cpu, so write them now
+	if((0x24 <= addr && addr <= 0x29) || (0x2d <= addr && addr <= 0x2f) || (0x100 <= addr && addr <= 0x110)) {
+		this->SetReg(addr, data);
+		return;
+	}
+	if(queue.full()) {
+		flush_queue();
+	}
+	queue.write(current_clock(), addr, data);
+}
+
+void YM2203::flush_queue()
+{
+	uint32 clock, addr, data;
+	while(queue.read(&clock, &addr, &data)) {
+		apply_reg(addr, data);
+	}
+}
+
+void YM2203::apply_reg(uint addr, uint data)
+{
+	if(addr == 0x200) {
+		mute = (data != 0);
+	}
+	else {
+		this->SetReg(addr, data);
+	}
+}
+
 void YM2203::mix(int32* buffer, int cnt)
 {
-	if(cnt > 0 && !mute) {
-		chip->Mix(buffer, cnt);
-#if defined(_WIN32) && !defined(HAS_AY_3_8912)
-		if(dllchip) {
-			fmdll->Mix(dllchip, buffer, cnt);
+	queue.start(current_clock(), cnt);
+	
+	int pos = 0, next;
+	uint32 addr, data;
+	for(;;) {
+		bool written = queue.read(&next, &addr, &data);
+		if(!written) {
+			next = cnt;
 		}
+		if(next > pos && !mute) {
+			chip->Mix(buffer + pos * 2, next - pos);
+#if defined(_WIN32) && !defined(HAS_AY_3_8912)
+			if(dllchip) {
+				fmdll->Mix(dllchip, buffer + pos * 2, next - pos);
+			}
 #endif
+		}
+		pos = next;
+		if(!written) {
+			break;
+		}
+		apply_reg(addr, data);
 	}
 }
 
@@ -237,6 +299,7 @@ void YM2203::SetReg(uint addr, uint data)
 	if(dllchip) {
 		fmdll->SetReg(dllchip, addr, data);
 	}
+	dllchip_reg[addr & 0x1ff] = data;
 #endif
 }
 
@@ -249,3 +312,78 @@ void YM2203::update_timing(int new_clocks, double new_frames_per_sec, int new_li
 #endif
 }
 
+
+void YM2203::save_state(FILEIO* fio)
+{
+	flush_queue();
+	
+	fio->FputUint32(STATE_VERSION);
+	fio->FputInt32(this_device_id);
+	
+	chip->SaveState((void*)fio);
+#if defined(_WIN32) && !defined(HAS_AY_3_8912)
+	fio->Fwrite(dllchip_reg, sizeof(dllchip_reg), 1);
+#endif
+	fio->FputUint8(ch);
+	fio->FputUint8(mode);
+#ifdef HAS_YM2608
+	fio->FputUint8(ch1);
+	fio->FputUint8(data1);
+#endif
+	for(int i = 0; i < 2; i++) {
+		fio->FputUint8(port[i].wreg);
+		fio->FputUint8(port[i].rreg);
+		fio->FputBool(port[i].first);
+	}
+	fio->FputInt32(chip_clock);
+	fio->FputBool(irq_prev);
+	fio->FputBool(mute);
+	fio->FputUint32(clock_prev);
+	fio->FputUint32(clock_accum);
+	fio->FputUint32(clock_const);
+}
+
+bool YM2203::load_state(FILEIO* fio)
+{
+	if(fio->FgetUint32() != STATE_VERSION) {
+		return false;
+	}
+	if(fio->FgetInt32() != this_device_id) {
+		return false;
+	}
+	if(!chip->LoadState((void*)fio)) {
+		return false;
+	}
+#if defined(_WIN32) && !defined(HAS_AY_3_8912)
+	fio->Fread(dllchip_reg, sizeof(dllchip_reg), 1);
+	if(dllchip) {
+		// dll chip can not save its state, so restore the registers
+		for(int addr = 0; addr < 0x200; addr++) {
+			if(!(0x27 <= addr && addr <= 0x28) && !(0x2d <= addr && addr <= 0x2f)) {
+				fmdll->SetReg(dllchip, addr, dllchip_reg[addr]);
+			}
+		}
+	}
+#endif
+	ch = fio->FgetUint8();
+	mode = fio->FgetUint8();
+#ifdef HAS_YM2608
+	ch1 = fio->FgetUint8();
+	data1 = fio->FgetUint8();
+#endif
+	for(int i = 0; i < 2; i++) {
+		port[i].wreg = fio->FgetUint8();
+		port[i].rreg = fio->FgetUint8();
+		port[i].first = fio->FgetBool();
+	}
+	chip_clock = fio->FgetInt32();
+	irq_prev = fio->FgetBool();
+	mute = fio->FgetBool();
+	clock_prev = fio->FgetUint32();
+	clock_accum = fio->FgetUint32();
+	clock_const = fio->FgetUint32();
+	for(int i = 0; i < 16; i++) {
+		psg_reg[i] = chip->GetReg(i);
+	}
+	return true;
+}
@@ -13,6 +13,7 @@
 #include "vm.h"
 #include "../emu.h"
 #include "device.h"
+#include "sound_queue.h"
 #include "fmgen/opna.h"
 #if defined(_WIN32) && !defined(HAS_AY_3_8912)
 #include "fmdll/fmdll.h"
@@ -33,6 +34,7 @@ private:
 #if defined(_WIN32) && !defined(HAS_AY_3_8912)
 	CFMDLL* fmdll;
 	LPVOID* dllchip;
+	uint8 dllchip_reg[0x200];	// to restore the state of dll chip
 #endif
 	
 	uint8 ch, mode;
@@ -52,6 +54,13 @@ private:
 	int chip_clock;
 	bool irq_prev, mute;
 	
+	// sound registers are written in mix() at their sample positions
+	SOUND_QUEUE queue;
+	uint8 psg_reg[16];	// psg registers for the cpu, the chip may be behind
+	void write_reg(uint addr, uint data);
+	void apply_reg(uint addr, uint data);
+	void flush_queue();
+	
 	uint32 clock_prev;
 	uint32 clock_accum;
 	uint32 clock_const;
@@ -84,7 +93,12 @@ public:
 	void write_signal(int id, uint32 data, uint32 mask);
 	void event_vline(int v, int clock);
 	void mix(int32* buffer, int cnt);
+	bool mix_per_frame() {
+		return true;
+	}
 	void update_timing(int new_clocks, double new_frames_per_sec, int new_lines_per_frame);
+	void save_state(FILEIO* fio);
+	bool load_state(FILEIO* fio);
 	
 	// unique functions
 #ifndef HAS_AY_3_8912
@@ -9,6 +9,9 @@
 */
 
 #include "z80.h"
+#ifdef Z80_STATIC_IO
+#include STATIC_IO_MAP_H
+#endif
 
 #ifndef CPU_START_ADDR
 #define CPU_START_ADDR	0
@@ -16,6 +19,8 @@
 
 #define NMI_REQ_BIT	0x80000000
 
+#define STATE_VERSION	1
+
 #define CF	0x01
 #define NF	0x02
 #define PF	0x04
@@ -76,8 +81,6 @@ static uint8 SZHV_dec[256];	/* zero, sign, half carry and overflow flags DEC r8
 static uint8 SZHVC_add[2 * 256 * 256];
 static uint8 SZHVC_sub[2 * 256 * 256];
 
-static bool flags_initialized = false;
-
 static const uint8 cc_op[0x100] = {
 	 4,10, 7, 6, 4, 4, 7, 4, 4,11, 7, 6, 4, 4, 7, 4,
 	 8,10, 7, 6, 4, 4, 7, 4,12,11, 7, 6, 4, 4, 7, 4,
@@ -208,6 +211,12 @@ static const uint8 cc_ex[0x100] = {
 
 inline uint8 Z80::RM8(uint32 addr)
 {
+	if(read_bank != NULL) {
+		uint8* bank = read_bank[addr >> read_shift];
+		if(bank != NULL) {
+			return bank[addr & read_mask];
+		}
+	}
 #ifdef Z80_MEMORY_WAIT
 	int wait;
 	uint8 val = d_mem->read_data8w(addr, &wait);
@@ -220,6 +229,13 @@ inline uint8 Z80::RM8(uint32 addr)
 
 inline void Z80::WM8(uint32 addr, uint8 val)
 {
+	if(write_bank != NULL) {
+		uint8* bank = write_bank[addr >> write_shift];
+		if(bank != NULL) {
+			bank[addr & write_mask] = val;
+			return;
+		}
+	}
 #ifdef Z80_MEMORY_WAIT
 	int wait;
 	d_mem->write_data8w(addr, val, &wait);
@@ -247,6 +263,13 @@ inline uint8 Z80::FETCHOP()
 	PC++;
 	R++;
 	
+	if(read_bank != NULL) {
+		uint8* bank = read_bank[pctmp >> read_shift];
+		if(bank != NULL) {
+			return bank[pctmp & read_mask];
+		}
+	}
+	
 	// consider m1 cycle wait
 	int wait;
 	uint8 val = d_mem->fetch_op(pctmp, &wait);
@@ -276,6 +299,12 @@ inline uint8 Z80::IN8(uint32 addr)
 	icount -= wait;
 	return val;
 #else
+#ifdef Z80_STATIC_IO
+	uint32 val;
+	if(static_io && STATIC_IO_MAP::static_io_r::read_io8(vm, addr, &val)) {
+		return val;
+	}
+#endif
 	return d_io->read_io8(addr);
 #endif
 }
@@ -293,6 +322,11 @@ inline void Z80::OUT8(uint32 addr, uint8 val)
 	d_io->write_io8w(addr, val, &wait);
 	icount -= wait;
 #else
+#ifdef Z80_STATIC_IO
+	if(static_io && STATIC_IO_MAP::static_io_w::write_io8(vm, addr, val)) {
+		return;
+	}
+#endif
 	d_io->write_io8(addr, val);
 #endif
 }
@@ -1681,8 +1715,52 @@ void Z80::OP_ED(uint8 code)
 	}
 }
 
+#ifdef Z80_THREADED_DISPATCH
+#define OP_CASE(code)	op_##code:
+#define OP_END		goto op_next
+void Z80::OP(uint8 code, bool chain)
+#else
+#define OP_CASE(code)	case 0x##code:
+#define OP_END		break
 void Z80::OP(uint8 code)
+#endif
 {
+#ifdef Z80_THREADED_DISPATCH
+	static void* const op_table[256] = {
+		&&op_00, &&op_01, &&op_02, &&op_03, &&op_04, &&op_05, &&op_06, &&op_07,
+		&&op_08, &&op_09, &&op_0a, &&op_0b, &&op_0c, &&op_0d, &&op_0e, &&op_0f,
+		&&op_10, &&op_11, &&op_12, &&op_13, &&op_14, &&op_15, &&op_16, &&op_17,
+		&&op_18, &&op_19, &&op_1a, &&op_1b, &&op_1c, &&op_1d, &&op_1e, &&op_1f,
+		&&op_20, &&op_21, &&op_22, &&op_23, &&op_24, &&op_25, &&op_26, &&op_27,
+		&&op_28, &&op_29, &&op_2a, &&op_2b, &&op_2c, &&op_2d, &&op_2e, &&op_2f,
+		&&op_30, &&op_31, &&op_32, &&op_33, &&op_34, &&op_35, &&op_36, &&op_37,
+		&&op_38, &&op_39, &&op_3a, &&op_3b, &&op_3c, &&op_3d, &&op_3e, &&op_3f,
+		&&op_40, &&op_41, &&op_42, &&op_43, &&op_44, &&op_45, &&op_46, &&op_47,
+		&&op_48, &&op_49, &&op_4a, &&op_4b, &&op_4c, &&op_4d, &&op_4e, &&op_4f,
+		&&op_50, &&op_51, &&op_52, &&op_53, &&op_54, &&op_55, &&op_56, &&op_57,
+		&&op_58, &&op_59, &&op_5a, &&op_5b, &&op_5c, &&op_5d, &&op_5e, &&op_5f,
+		&&op_60, &&op_61, &&op_62, &&op_63, &&op_64, &&op_65, &&op_66, &&op_67,
+		&&op_68, &&op_69, &&op_6a, &&op_6b, &&op_6c, &&op_6d, &&op_6e, &&op_6f,
+		&&op_70, &&op_71, &&op_72, &&op_73, &&op_74, &&op_75, &&op_76, &&op_77,
+		&&op_78, &&op_79, &&op_7a, &&op_7b, &&op_7c, &&op_7d, &&op_7e, &&op_7f,
+		&&op_80, &&op_81, &&op_82, &&op_83, &&op_84, &&op_85, &&op_86, &&op_87,
+		&&op_88, &&op_89, &&op_8a, &&op_8b, &&op_8c, &&op_8d, &&op_8e, &&op_8f,
+		&&op_90, &&op_91, &&op_92, &&op_93, &&op_94, &&op_95, &&op_96, &&op_97,
+		&&op_98, &&op_99, &&op_9a, &&op_9b, &&op_9c, &&op_9d, &&op_9e, &&op_9f,
+		&&op_a0, &&op_a1, &&op_a2, &&op_a3, &&op_a4, &&op_a5, &&op_a6, &&op_a7,
+		&&op_a8, &&op_a9, &&op_aa, &&op_ab, &&op_ac, &&op_ad, &&op_ae, &&op_af,
+		&&op_b0, &&op_b1, &&op_b2, &&op_b3, &&op_b4, &&op_b5, &&op_b6, &&op_b7,
+		&&op_b8, &&op_b9, &&op_ba, &&op_bb, &&op_bc, &&op_bd, &&op_be, &&op_bf,
+		&&op_c0, &&op_c1, &&op_c2, &&op_c3, &&op_c4, &&op_c5, &&op_c6, &&op_c7,
+		&&op_c8, &&op_c9, &&op_ca, &&op_cb, &&op_cc, &&op_cd, &&op_ce, &&op_cf,
+		&&op_d0, &&op_d1, &&op_d2, &&op_d3, &&op_d4, &&op_d5, &&op_d6, &&op_d7,
+		&&op_d8, &&op_d9, &&op_da, &&op_db, &&op_dc, &&op_dd, &&op_de, &&op_df,
+		&&op_e0, &&op_e1, &&op_e2, &&op_e3, &&op_e4, &&op_e5, &&op_e6, &&op_e7,
+		&&op_e8, &&op_e9, &&op_ea, &&op_eb, &&op_ec, &&op_ed, &&op_ee, &&op_ef,
+		&&op_f0, &&op_f1, &&op_f2, &&op_f3, &&op_f4, &&op_f5, &&op_f6, &&op_f7,
+		&&op_f8, &&op_f9, &&op_fa, &&op_fb, &&op_fc, &&op_fd, &&op_fe, &&op_ff
+	};
+#endif
 	prevpc = PC - 1;
 	icount -= cc_op[code];
 	
@@ -1695,265 +1773,282 @@ void Z80::OP(uint8 code)
 	debug_ops[3] = RM8(PC + 2);
 #endif
 	
+#ifdef Z80_THREADED_DISPATCH
+	goto *op_table[code];
+#else
 	switch(code) {
-	case 0x00: break;												/* NOP              */
-	case 0x01: BC = FETCH16(); break;										/* LD   BC,w        */
-	case 0x02: WM8(BC, A); WZ_L = (BC + 1) & 0xff; WZ_H = A; break;							/* LD (BC),A        */
-	case 0x03: BC++; break;												/* INC  BC          */
-	case 0x04: B = INC(B); break;											/* INC  B           */
-	case 0x05: B = DEC(B); break;											/* DEC  B           */
-	case 0x06: B = FETCH8(); break;											/* LD   B,n         */
-	case 0x07: RLCA(); break;											/* RLCA             */
-	case 0x08: EX_AF(); break;											/* EX   AF,AF'      */
-	case 0x09: ADD16(hl, bc); break;										/* ADD  HL,BC       */
-	case 0x0a: A = RM8(BC); WZ = BC+1; break;									/* LD   A,(BC)      */
-	case 0x0b: BC--; break;												/* DEC  BC          */
-	case 0x0c: C = INC(C); break;											/* INC  C           */
-	case 0x0d: C = DEC(C); break;											/* DEC  C           */
-	case 0x0e: C = FETCH8(); break;											/* LD   C,n         */
-	case 0x0f: RRCA(); break;											/* RRCA             */
-	case 0x10: B--; JR_COND(B, 0x10); break;									/* DJNZ o           */
-	case 0x11: DE = FETCH16(); break;										/* LD   DE,w        */
-	case 0x12: WM8(DE, A); WZ_L = (DE + 1) & 0xff; WZ_H = A; break;							/* LD (DE),A        */
-	case 0x13: DE++; break;												/* INC  DE          */
-	case 0x14: D = INC(D); break;											/* INC  D           */
-	case 0x15: D = DEC(D); break;											/* DEC  D           */
-	case 0x16: D = FETCH8(); break;											/* LD   D,n         */
-	case 0x17: RLA(); break;											/* RLA              */
-	case 0x18: JR(); break;												/* JR   o           */
-	case 0x19: ADD16(hl, de); break;										/* ADD  HL,DE       */
-	case 0x1a: A = RM8(DE); WZ = DE + 1; break;									/* LD   A,(DE)      */
-	case 0x1b: DE--; break;												/* DEC  DE          */
-	case 0x1c: E = INC(E); break;											/* INC  E           */
-	case 0x1d: E = DEC(E); break;											/* DEC  E           */
-	case 0x1e: E = FETCH8(); break;											/* LD   E,n         */
-	case 0x1f: RRA(); break;											/* RRA              */
-	case 0x20: JR_COND(!(F & ZF), 0x20); break;									/* JR   NZ,o        */
-	case 0x21: HL = FETCH16(); break;										/* LD   HL,w        */
-	case 0x22: ea = FETCH16(); WM16(ea, &hl); WZ = ea + 1; break;							/* LD   (w),HL      */
-	case 0x23: HL++; break;												/* INC  HL          */
-	case 0x24: H = INC(H); break;											/* INC  H           */
-	case 0x25: H = DEC(H); break;											/* DEC  H           */
-	case 0x26: H = FETCH8(); break;											/* LD   H,n         */
-	case 0x27: DAA(); break;											/* DAA              */
-	case 0x28: JR_COND(F & ZF, 0x28); break;									/* JR   Z,o         */
-	case 0x29: ADD16(hl, hl); break;										/* ADD  HL,HL       */
-	case 0x2a: ea = FETCH16(); RM16(ea, &hl); WZ = ea + 1; break;							/* LD   HL,(w)      */
-	case 0x2b: HL--; break;												/* DEC  HL          */
-	case 0x2c: L = INC(L); break;											/* INC  L           */
-	case 0x2d: L = DEC(L); break;											/* DEC  L           */
-	case 0x2e: L = FETCH8(); break;											/* LD   L,n         */
-	case 0x2f: A ^= 0xff; F = (F & (SF | ZF | PF | CF)) | HF | NF | (A & (YF | XF)); break;				/* CPL              */
-	case 0x30: JR_COND(!(F & CF), 0x30); break;									/* JR   NC,o        */
-	case 0x31: SP = FETCH16(); break;										/* LD   SP,w        */
-	case 0x32: ea = FETCH16(); WM8(ea, A); WZ_L = (ea + 1) & 0xff; WZ_H = A; break;					/* LD   (w),A       */
-	case 0x33: SP++; break;												/* INC  SP          */
-	case 0x34: WM8(HL, INC(RM8(HL))); break;									/* INC  (HL)        */
-	case 0x35: WM8(HL, DEC(RM8(HL))); break;									/* DEC  (HL)        */
-	case 0x36: WM8(HL, FETCH8()); break;										/* LD   (HL),n      */
-	case 0x37: F = (F & (SF | ZF | YF | XF | PF)) | CF | (A & (YF | XF)); break;					/* SCF              */
-	case 0x38: JR_COND(F & CF, 0x38); break;									/* JR   C,o         */
-	case 0x39: ADD16(hl, sp); break;										/* ADD  HL,SP       */
-	case 0x3a: ea = FETCH16(); A = RM8(ea); WZ = ea + 1; break;							/* LD   A,(w)       */
-	case 0x3b: SP--; break;												/* DEC  SP          */
-	case 0x3c: A = INC(A); break;											/* INC  A           */
-	case 0x3d: A = DEC(A); break;											/* DEC  A           */
-	case 0x3e: A = FETCH8(); break;											/* LD   A,n         */
-	case 0x3f: F = ((F & (SF | ZF | YF | XF | PF | CF)) | ((F & CF) << 4) | (A & (YF | XF))) ^ CF; break;		/* CCF              */
-	case 0x40: break;												/* LD   B,B         */
-	case 0x41: B = C; break;											/* LD   B,C         */
-	case 0x42: B = D; break;											/* LD   B,D         */
-	case 0x43: B = E; break;											/* LD   B,E         */
-	case 0x44: B = H; break;											/* LD   B,H         */
-	case 0x45: B = L; break;											/* LD   B,L         */
-	case 0x46: B = RM8(HL); break;											/* LD   B,(HL)      */
-	case 0x47: B = A; break;											/* LD   B,A         */
-	case 0x48: C = B; break;											/* LD   C,B         */
-	case 0x49: break;												/* LD   C,C         */
-	case 0x4a: C = D; break;											/* LD   C,D         */
-	case 0x4b: C = E; break;											/* LD   C,E         */
-	case 0x4c: C = H; break;											/* LD   C,H         */
-	case 0x4d: C = L; break;											/* LD   C,L         */
-	case 0x4e: C = RM8(HL); break;											/* LD   C,(HL)      */
-	case 0x4f: C = A; break;											/* LD   C,A         */
-	case 0x50: D = B; break;											/* LD   D,B         */
-	case 0x51: D = C; break;											/* LD   D,C         */
-	case 0x52: break;												/* LD   D,D         */
-	case 0x53: D = E; break;											/* LD   D,E         */
-	case 0x54: D = H; break;											/* LD   D,H         */
-	case 0x55: D = L; break;											/* LD   D,L         */
-	case 0x56: D = RM8(HL); break;											/* LD   D,(HL)      */
-	case 0x57: D = A; break;											/* LD   D,A         */
-	case 0x58: E = B; break;											/* LD   E,B         */
-	case 0x59: E = C; break;											/* LD   E,C         */
-	case 0x5a: E = D; break;											/* LD   E,D         */
-	case 0x5b: break;												/* LD   E,E         */
-	case 0x5c: E = H; break;											/* LD   E,H         */
-	case 0x5d: E = L; break;											/* LD   E,L         */
-	case 0x5e: E = RM8(HL); break;											/* LD   E,(HL)      */
-	case 0x5f: E = A; break;											/* LD   E,A         */
-	case 0x60: H = B; break;											/* LD   H,B         */
-	case 0x61: H = C; break;											/* LD   H,C         */
-	case 0x62: H = D; break;											/* LD   H,D         */
-	case 0x63: H = E; break;											/* LD   H,E         */
-	case 0x64: break;												/* LD   H,H         */
-	case 0x65: H = L; break;											/* LD   H,L         */
-	case 0x66: H = RM8(HL); break;											/* LD   H,(HL)      */
-	case 0x67: H = A; break;											/* LD   H,A         */
-	case 0x68: L = B; break;											/* LD   L,B         */
-	case 0x69: L = C; break;											/* LD   L,C         */
-	case 0x6a: L = D; break;											/* LD   L,D         */
-	case 0x6b: L = E; break;											/* LD   L,E         */
-	case 0x6c: L = H; break;											/* LD   L,H         */
-	case 0x6d: break;												/* LD   L,L         */
-	case 0x6e: L = RM8(HL); break;											/* LD   L,(HL)      */
-	case 0x6f: L = A; break;											/* LD   L,A         */
-	case 0x70: WM8(HL, B); break;											/* LD   (HL),B      */
-	case 0x71: WM8(HL, C); break;											/* LD   (HL),C      */
-	case 0x72: WM8(HL, D); break;											/* LD   (HL),D      */
-	case 0x73: WM8(HL, E); break;											/* LD   (HL),E      */
-	case 0x74: WM8(HL, H); break;											/* LD   (HL),H      */
-	case 0x75: WM8(HL, L); break;											/* LD   (HL),L      */
-	case 0x76: ENTER_HALT(); break;											/* halt             */
-	case 0x77: WM8(HL, A); break;											/* LD   (HL),A      */
-	case 0x78: A = B; break;											/* LD   A,B         */
-	case 0x79: A = C; break;											/* LD   A,C         */
-	case 0x7a: A = D; break;											/* LD   A,D         */
-	case 0x7b: A = E; break;											/* LD   A,E         */
-	case 0x7c: A = H; break;											/* LD   A,H         */
-	case 0x7d: A = L; break;											/* LD   A,L         */
-	case 0x7e: A = RM8(HL); break;											/* LD   A,(HL)      */
-	case 0x7f: break;												/* LD   A,A         */
-	case 0x80: ADD(B); break;											/* ADD  A,B         */
-	case 0x81: ADD(C); break;											/* ADD  A,C         */
-	case 0x82: ADD(D); break;											/* ADD  A,D         */
-	case 0x83: ADD(E); break;											/* ADD  A,E         */
-	case 0x84: ADD(H); break;											/* ADD  A,H         */
-	case 0x85: ADD(L); break;											/* ADD  A,L         */
-	case 0x86: ADD(RM8(HL)); break;											/* ADD  A,(HL)      */
-	case 0x87: ADD(A); break;											/* ADD  A,A         */
-	case 0x88: ADC(B); break;											/* ADC  A,B         */
-	case 0x89: ADC(C); break;											/* ADC  A,C         */
-	case 0x8a: ADC(D); break;											/* ADC  A,D         */
-	case 0x8b: ADC(E); break;											/* ADC  A,E         */
-	case 0x8c: ADC(H); break;											/* ADC  A,H         */
-	case 0x8d: ADC(L); break;											/* ADC  A,L         */
-	case 0x8e: ADC(RM8(HL)); break;											/* ADC  A,(HL)      */
-	case 0x8f: ADC(A); break;											/* ADC  A,A         */
-	case 0x90: SUB(B); break;											/* SUB  B           */
-	case 0x91: SUB(C); break;											/* SUB  C           */
-	case 0x92: SUB(D); break;											/* SUB  D           */
-	case 0x93: SUB(E); break;											/* SUB  E           */
-	case 0x94: SUB(H); break;											/* SUB  H           */
-	case 0x95: SUB(L); break;											/* SUB  L           */
-	case 0x96: SUB(RM8(HL)); break;											/* SUB  (HL)        */
-	case 0x97: SUB(A); break;											/* SUB  A           */
-	case 0x98: SBC(B); break;											/* SBC  A,B         */
-	case 0x99: SBC(C); break;											/* SBC  A,C         */
-	case 0x9a: SBC(D); break;											/* SBC  A,D         */
-	case 0x9b: SBC(E); break;											/* SBC  A,E         */
-	case 0x9c: SBC(H); break;											/* SBC  A,H         */
-	case 0x9d: SBC(L); break;											/* SBC  A,L         */
-	case 0x9e: SBC(RM8(HL)); break;											/* SBC  A,(HL)      */
-	case 0x9f: SBC(A); break;											/* SBC  A,A         */
-	case 0xa0: AND(B); break;											/* AND  B           */
-	case 0xa1: AND(C); break;											/* AND  C           */
-	case 0xa2: AND(D); break;											/* AND  D           */
-	case 0xa3: AND(E); break;											/* AND  E           */
-	case 0xa4: AND(H); break;											/* AND  H           */
-	case 0xa5: AND(L); break;											/* AND  L           */
-	case 0xa6: AND(RM8(HL)); break;											/* AND  (HL)        */
-	case 0xa7: AND(A); break;											/* AND  A           */
-	case 0xa8: XOR(B); break;											/* XOR  B           */
-	case 0xa9: XOR(C); break;											/* XOR  C           */
-	case 0xaa: XOR(D); break;											/* XOR  D           */
-	case 0xab: XOR(E); break;											/* XOR  E           */
-	case 0xac: XOR(H); break;											/* XOR  H           */
-	case 0xad: XOR(L); break;											/* XOR  L           */
-	case 0xae: XOR(RM8(HL)); break;											/* XOR  (HL)        */
-	case 0xaf: XOR(A); break;											/* XOR  A           */
-	case 0xb0: OR(B); break;											/* OR   B           */
-	case 0xb1: OR(C); break;											/* OR   C           */
-	case 0xb2: OR(D); break;											/* OR   D           */
-	case 0xb3: OR(E); break;											/* OR   E           */
-	case 0xb4: OR(H); break;											/* OR   H           */
-	case 0xb5: OR(L); break;											/* OR   L           */
-	case 0xb6: OR(RM8(HL)); break;											/* OR   (HL)        */
-	case 0xb7: OR(A); break;											/* OR   A           */
-	case 0xb8: CP(B); break;											/* CP   B           */
-	case 0xb9: CP(C); break;											/* CP   C           */
-	case 0xba: CP(D); break;											/* CP   D           */
-	case 0xbb: CP(E); break;											/* CP   E           */
-	case 0xbc: CP(H); break;											/* CP   H           */
-	case 0xbd: CP(L); break;											/* CP   L           */
-	case 0xbe: CP(RM8(HL)); break;											/* CP   (HL)        */
-	case 0xbf: CP(A); break;											/* CP   A           */
-	case 0xc0: RET_COND(!(F & ZF), 0xc0); break;									/* RET  NZ          */
-	case 0xc1: POP(bc); break;											/* POP  BC          */
-	case 0xc2: JP_COND(!(F & ZF)); break;										/* JP   NZ,a        */
-	case 0xc3: JP(); break;												/* JP   a           */
-	case 0xc4: CALL_COND(!(F & ZF), 0xc4); break;									/* CALL NZ,a        */
-	case 0xc5: PUSH(bc); break;											/* PUSH BC          */
-	case 0xc6: ADD(FETCH8()); break;										/* ADD  A,n         */
-	case 0xc7: RST(0x00); break;											/* RST  0           */
-	case 0xc8: RET_COND(F & ZF, 0xc8); break;									/* RET  Z           */
-	case 0xc9: POP(pc); WZ = PCD; break;										/* RET              */
-	case 0xca: JP_COND(F & ZF); break;										/* JP   Z,a         */
-	case 0xcb: OP_CB(FETCHOP()); break;										/* **** CB xx       */
-	case 0xcc: CALL_COND(F & ZF, 0xcc); break;									/* CALL Z,a         */
-	case 0xcd: CALL(); break;											/* CALL a           */
-	case 0xce: ADC(FETCH8()); break;										/* ADC  A,n         */
-	case 0xcf: RST(0x08); break;											/* RST  1           */
-	case 0xd0: RET_COND(!(F & CF), 0xd0); break;									/* RET  NC          */
-	case 0xd1: POP(de); break;											/* POP  DE          */
-	case 0xd2: JP_COND(!(F & CF)); break;										/* JP   NC,a        */
-	case 0xd3: {unsigned n = FETCH8() | (A << 8); OUT8(n, A); WZ_L = ((n & 0xff) + 1) & 0xff; WZ_H = A;} break;	/* OUT  (n),A       */
-	case 0xd4: CALL_COND(!(F & CF), 0xd4); break;									/* CALL NC,a        */
-	case 0xd5: PUSH(de); break;											/* PUSH DE          */
-	case 0xd6: SUB(FETCH8()); break;										/* SUB  n           */
-	case 0xd7: RST(0x10); break;											/* RST  2           */
-	case 0xd8: RET_COND(F & CF, 0xd8); break;									/* RET  C           */
-	case 0xd9: EXX(); break;											/* EXX              */
-	case 0xda: JP_COND(F & CF); break;										/* JP   C,a         */
-	case 0xdb: {unsigned n = FETCH8() | (A << 8); A = IN8(n); WZ = n + 1;} break;					/* IN   A,(n)       */
-	case 0xdc: CALL_COND(F & CF, 0xdc); break;									/* CALL C,a         */
-	case 0xdd: OP_DD(FETCHOP()); break;										/* **** DD xx       */
-	case 0xde: SBC(FETCH8()); break;										/* SBC  A,n         */
-	case 0xdf: RST(0x18); break;											/* RST  3           */
-	case 0xe0: RET_COND(!(F & PF), 0xe0); break;									/* RET  PO          */
-	case 0xe1: POP(hl); break;											/* POP  HL          */
-	case 0xe2: JP_COND(!(F & PF)); break;										/* JP   PO,a        */
-	case 0xe3: EXSP(hl); break;											/* EX   HL,(SP)     */
-	case 0xe4: CALL_COND(!(F & PF), 0xe4); break;									/* CALL PO,a        */
-	case 0xe5: PUSH(hl); break;											/* PUSH HL          */
-	case 0xe6: AND(FETCH8()); break;										/* AND  n           */
-	case 0xe7: RST(0x20); break;											/* RST  4           */
-	case 0xe8: RET_COND(F & PF, 0xe8); break;									/* RET  PE          */
-	case 0xe9: PC = HL; break;											/* JP   (HL)        */
-	case 0xea: JP_COND(F & PF); break;										/* JP   PE,a        */
-	case 0xeb: EX_DE_HL(); break;											/* EX   DE,HL       */
-	case 0xec: CALL_COND(F & PF, 0xec); break;									/* CALL PE,a        */
-	case 0xed: OP_ED(FETCHOP()); break;										/* **** ED xx       */
-	case 0xee: XOR(FETCH8()); break;										/* XOR  n           */
-	case 0xef: RST(0x28); break;											/* RST  5           */
-	case 0xf0: RET_COND(!(F & SF), 0xf0); break;									/* RET  P           */
-	case 0xf1: POP(af); break;											/* POP  AF          */
-	case 0xf2: JP_COND(!(F & SF)); break;										/* JP   P,a         */
-	case 0xf3: iff1 = iff2 = 0; break;										/* DI               */
-	case 0xf4: CALL_COND(!(F & SF), 0xf4); break;									/* CALL P,a         */
-	case 0xf5: PUSH(af); break;											/* PUSH AF          */
-	case 0xf6: OR(FETCH8()); break;											/* OR   n           */
-	case 0xf7: RST(0x30); break;											/* RST  6           */
-	case 0xf8: RET_COND(F & SF, 0xf8); break;									/* RET  M           */
-	case 0xf9: SP = HL; break;											/* LD   SP,HL       */
-	case 0xfa: JP_COND(F & SF); break;										/* JP   M,a         */
-	case 0xfb: EI(); break;												/* EI               */
-	case 0xfc: CALL_COND(F & SF, 0xfc); break;									/* CALL M,a         */
-	case 0xfd: OP_FD(FETCHOP()); break;										/* **** FD xx       */
-	case 0xfe: CP(FETCH8()); break;											/* CP   n           */
-	case 0xff: RST(0x38); break;											/* RST  7           */
+#endif
+	OP_CASE(00) OP_END;												/* NOP              */
+	OP_CASE(01) BC = FETCH16(); OP_END;										/* LD   BC,w        */
+	OP_CASE(02) WM8(BC, A); WZ_L = (BC + 1) & 0xff; WZ_H = A; OP_END;						/* LD (BC),A        */
+	OP_CASE(03) BC++; OP_END;											/* INC  BC          */
+	OP_CASE(04) B = INC(B); OP_END;											/* INC  B           */
+	OP_CASE(05) B = DEC(B); OP_END;											/* DEC  B           */
+	OP_CASE(06) B = FETCH8(); OP_END;										/* LD   B,n         */
+	OP_CASE(07) RLCA(); OP_END;											/* RLCA             */
+	OP_CASE(08) EX_AF(); OP_END;											/* EX   AF,AF'      */
+	OP_CASE(09) ADD16(hl, bc); OP_END;										/* ADD  HL,BC       */
+	OP_CASE(0a) A = RM8(BC); WZ = BC+1; OP_END;									/* LD   A,(BC)      */
+	OP_CASE(0b) BC--; OP_END;											/* DEC  BC          */
+	OP_CASE(0c) C = INC(C); OP_END;											/* INC  C           */
+	OP_CASE(0d) C = DEC(C); OP_END;											/* DEC  C           */
+	OP_CASE(0e) C = FETCH8(); OP_END;										/* LD   C,n         */
+	OP_CASE(0f) RRCA(); OP_END;											/* RRCA             */
+	OP_CASE(10) B--; JR_COND(B, 0x10); OP_END;									/* DJNZ o           */
+	OP_CASE(11) DE = FETCH16(); OP_END;										/* LD   DE,w        */
+	OP_CASE(12) WM8(DE, A); WZ_L = (DE + 1) & 0xff; WZ_H = A; OP_END;						/* LD (DE),A        */
+	OP_CASE(13) DE++; OP_END;											/* INC  DE          */
+	OP_CASE(14) D = INC(D); OP_END;											/* INC  D           */
+	OP_CASE(15) D = DEC(D); OP_END;											/* DEC  D           */
+	OP_CASE(16) D = FETCH8(); OP_END;										/* LD   D,n         */
+	OP_CASE(17) RLA(); OP_END;											/* RLA              */
+	OP_CASE(18) JR(); OP_END;											/* JR   o           */
+	OP_CASE(19) ADD16(hl, de); OP_END;										/* ADD  HL,DE       */
+	OP_CASE(1a) A = RM8(DE); WZ = DE + 1; OP_END;									/* LD   A,(DE)      */
+	OP_CASE(1b) DE--; OP_END;											/* DEC  DE          */
+	OP_CASE(1c) E = INC(E); OP_END;											/* INC  E           */
+	OP_CASE(1d) E = DEC(E); OP_END;											/* DEC  E           */
+	OP_CASE(1e) E = FETCH8(); OP_END;										/* LD   E,n         */
+	OP_CASE(1f) RRA(); OP_END;											/* RRA              */
+	OP_CASE(20) JR_COND(!(F & ZF), 0x20); OP_END;									/* JR   NZ,o        */
+	OP_CASE(21) HL = FETCH16(); OP_END;										/* LD   HL,w        */
+	OP_CASE(22) ea = FETCH16(); WM16(ea, &hl); WZ = ea + 1; OP_END;							/* LD   (w),HL      */
+	OP_CASE(23) HL++; OP_END;											/* INC  HL          */
+	OP_CASE(24) H = INC(H); OP_END;											/* INC  H           */
+	OP_CASE(25) H = DEC(H); OP_END;											/* DEC  H           */
+	OP_CASE(26) H = FETCH8(); OP_END;										/* LD   H,n         */
+	OP_CASE(27) DAA(); OP_END;											/* DAA              */
+	OP_CASE(28) JR_COND(F & ZF, 0x28); OP_END;									/* JR   Z,o         */
+	OP_CASE(29) ADD16(hl, hl); OP_END;										/* ADD  HL,HL       */
+	OP_CASE(2a) ea = FETCH16(); RM16(ea, &hl); WZ = ea + 1; OP_END;							/* LD   HL,(w)      */
+	OP_CASE(2b) HL--; OP_END;											/* DEC  HL          */
+	OP_CASE(2c) L = INC(L); OP_END;											/* INC  L           */
+	OP_CASE(2d) L = DEC(L); OP_END;											/* DEC  L           */
+	OP_CASE(2e) L = FETCH8(); OP_END;										/* LD   L,n         */
+	OP_CASE(2f) A ^= 0xff; F = (F & (SF | ZF | PF | CF)) | HF | NF | (A & (YF | XF)); OP_END;			/* CPL              */
+	OP_CASE(30) JR_COND(!(F & CF), 0x30); OP_END;									/* JR   NC,o        */
+	OP_CASE(31) SP = FETCH16(); OP_END;										/* LD   SP,w        */
+	OP_CASE(32) ea = FETCH16(); WM8(ea, A); WZ_L = (ea + 1) & 0xff; WZ_H = A; OP_END;				/* LD   (w),A       */
+	OP_CASE(33) SP++; OP_END;											/* INC  SP          */
+	OP_CASE(34) WM8(HL, INC(RM8(HL))); OP_END;									/* INC  (HL)        */
+	OP_CASE(35) WM8(HL, DEC(RM8(HL))); OP_END;									/* DEC  (HL)        */
+	OP_CASE(36) WM8(HL, FETCH8()); OP_END;										/* LD   (HL),n      */
+	OP_CASE(37) F = (F & (SF | ZF | YF | XF | PF)) | CF | (A & (YF | XF)); OP_END;					/* SCF              */
+	OP_CASE(38) JR_COND(F & CF, 0x38); OP_END;									/* JR   C,o         */
+	OP_CASE(39) ADD16(hl, sp); OP_END;										/* ADD  HL,SP       */
+	OP_CASE(3a) ea = FETCH16(); A = RM8(ea); WZ = ea + 1; OP_END;							/* LD   A,(w)       */
+	OP_CASE(3b) SP--; OP_END;											/* DEC  SP          */
+	OP_CASE(3c) A = INC(A); OP_END;											/* INC  A           */
+	OP_CASE(3d) A = DEC(A); OP_END;											/* DEC  A           */
+	OP_CASE(3e) A = FETCH8(); OP_END;										/* LD   A,n         */
+	OP_CASE(3f) F = ((F & (SF | ZF | YF | XF | PF | CF)) | ((F & CF) << 4) | (A & (YF | XF))) ^ CF; OP_END;		/* CCF              */
+	OP_CASE(40) OP_END;												/* LD   B,B         */
+	OP_CASE(41) B = C; OP_END;											/* LD   B,C         */
+	OP_CASE(42) B = D; OP_END;											/* LD   B,D         */
+	OP_CASE(43) B = E; OP_END;											/* LD   B,E         */
+	OP_CASE(44) B = H; OP_END;											/* LD   B,H         */
+	OP_CASE(45) B = L; OP_END;											/* LD   B,L         */
+	OP_CASE(46) B = RM8(HL); OP_END;										/* LD   B,(HL)      */
+	OP_CASE(47) B = A; OP_END;											/* LD   B,A         */
+	OP_CASE(48) C = B; OP_END;											/* LD   C,B         */
+	OP_CASE(49) OP_END;												/* LD   C,C         */
+	OP_CASE(4a) C = D; OP_END;											/* LD   C,D         */
+	OP_CASE(4b) C = E; OP_END;											/* LD   C,E         */
+	OP_CASE(4c) C = H; OP_END;											/* LD   C,H         */
+	OP_CASE(4d) C = L; OP_END;											/* LD   C,L         */
+	OP_CASE(4e) C = RM8(HL); OP_END;										/* LD   C,(HL)      */
+	OP_CASE(4f) C = A; OP_END;											/* LD   C,A         */
+	OP_CASE(50) D = B; OP_END;											/* LD   D,B         */
+	OP_CASE(51) D = C; OP_END;											/* LD   D,C         */
+	OP_CASE(52) OP_END;												/* LD   D,D         */
+	OP_CASE(53) D = E; OP_END;											/* LD   D,E         */
+	OP_CASE(54) D = H; OP_END;											/* LD   D,H         */
+	OP_CASE(55) D = L; OP_END;											/* LD   D,L         */
+	OP_CASE(56) D = RM8(HL); OP_END;										/* LD   D,(HL)      */
+	OP_CASE(57) D = A; OP_END;											/* LD   D,A         */
+	OP_CASE(58) E = B; OP_END;											/* LD   E,B         */
+	OP_CASE(59) E = C; OP_END;											/* LD   E,C         */
+	OP_CASE(5a) E = D; OP_END;											/* LD   E,D         */
+	OP_CASE(5b) OP_END;												/* LD   E,E         */
+	OP_CASE(5c) E = H; OP_END;											/* LD   E,H         */
+	OP_CASE(5d) E = L; OP_END;											/* LD   E,L         */
+	OP_CASE(5e) E = RM8(HL); OP_END;										/* LD   E,(HL)      */
+	OP_CASE(5f) E = A; OP_END;											/* LD   E,A         */
+	OP_CASE(60) H = B; OP_END;											/* LD   H,B         */
+	OP_CASE(61) H = C; OP_END;											/* LD   H,C         */
+	OP_CASE(62) H = D; OP_END;											/* LD   H,D         */
+	OP_CASE(63) H = E; OP_END;											/* LD   H,E         */
+	OP_CASE(64) OP_END;												/* LD   H,H         */
+	OP_CASE(65) H = L; OP_END;											/* LD   H,L         */
+	OP_CASE(66) H = RM8(HL); OP_END;										/* LD   H,(HL)      */
+	OP_CASE(67) H = A; OP_END;											/* LD   H,A         */
+	OP_CASE(68) L = B; OP_END;											/* LD   L,B         */
+	OP_CASE(69) L = C; OP_END;											/* LD   L,C         */
+	OP_CASE(6a) L = D; OP_END;											/* LD   L,D         */
+	OP_CASE(6b) L = E; OP_END;											/* LD   L,E         */
+	OP_CASE(6c) L = H; OP_END;											/* LD   L,H         */
+	OP_CASE(6d) OP_END;												/* LD   L,L         */
+	OP_CASE(6e) L = RM8(HL); OP_END;										/* LD   L,(HL)      */
+	OP_CASE(6f) L = A; OP_END;											/* LD   L,A         */
+	OP_CASE(70) WM8(HL, B); OP_END;											/* LD   (HL),B      */
+	OP_CASE(71) WM8(HL, C); OP_END;											/* LD   (HL),C      */
+	OP_CASE(72) WM8(HL, D); OP_END;											/* LD   (HL),D      */
+	OP_CASE(73) WM8(HL, E); OP_END;											/* LD   (HL),E      */
+	OP_CASE(74) WM8(HL, H); OP_END;											/* LD   (HL),H      */
+	OP_CASE(75) WM8(HL, L); OP_END;											/* LD   (HL),L      */
+	OP_CASE(76) ENTER_HALT(); OP_END;										/* halt             */
+	OP_CASE(77) WM8(HL, A); OP_END;											/* LD   (HL),A      */
+	OP_CASE(78) A = B; OP_END;											/* LD   A,B         */
+	OP_CASE(79) A = C; OP_END;											/* LD   A,C         */
+	OP_CASE(7a) A = D; OP_END;											/* LD   A,D         */
+	OP_CASE(7b) A = E; OP_END;											/* LD   A,E         */
+	OP_CASE(7c) A = H; OP_END;											/* LD   A,H         */
+	OP_CASE(7d) A = L; OP_END;											/* LD   A,L         */
+	OP_CASE(7e) A = RM8(HL); OP_END;										/* LD   A,(HL)      */
+	OP_CASE(7f) OP_END;												/* LD   A,A         */
+	OP_CASE(80) ADD(B); OP_END;											/* ADD  A,B         */
+	OP_CASE(81) ADD(C); OP_END;											/* ADD  A,C         */
+	OP_CASE(82) ADD(D); OP_END;											/* ADD  A,D         */
+	OP_CASE(83) ADD(E); OP_END;											/* ADD  A,E         */
+	OP_CASE(84) ADD(H); OP_END;											/* ADD  A,H         */
+	OP_CASE(85) ADD(L); OP_END;											/* ADD  A,L         */
+	OP_CASE(86) ADD(RM8(HL)); OP_END;										/* ADD  A,(HL)      */
+	OP_CASE(87) ADD(A); OP_END;											/* ADD  A,A         */
+	OP_CASE(88) ADC(B); OP_END;											/* ADC  A,B         */
+	OP_CASE(89) ADC(C); OP_END;											/* ADC  A,C         */
+	OP_CASE(8a) ADC(D); OP_END;											/* ADC  A,D         */
+	OP_CASE(8b) ADC(E); OP_END;											/* ADC  A,E         */
+	OP_CASE(8c) ADC(H); OP_END;											/* ADC  A,H         */
+	OP_CASE(8d) ADC(L); OP_END;											/* ADC  A,L         */
+	OP_CASE(8e) ADC(RM8(HL)); OP_END;										/* ADC  A,(HL)      */
+	OP_CASE(8f) ADC(A); OP_END;											/* ADC  A,A         */
+	OP_CASE(90) SUB(B); OP_END;											/* SUB  B           */
+	OP_CASE(91) SUB(C); OP_END;											/* SUB  C           */
+	OP_CASE(92) SUB(D); OP_END;											/* SUB  D           */
+	OP_CASE(93) SUB(E); OP_END;											/* SUB  E           */
+	OP_CASE(94) SUB(H); OP_END;											/* SUB  H           */
+	OP_CASE(95) SUB(L); OP_END;											/* SUB  L           */
+	OP_CASE(96) SUB(RM8(HL)); OP_END;										/* SUB  (HL)        */
+	OP_CASE(97) SUB(A); OP_END;											/* SUB  A           */
+	OP_CASE(98) SBC(B); OP_END;											/* SBC  A,B         */
+	OP_CASE(99) SBC(C); OP_END;											/* SBC  A,C         */
+	OP_CASE(9a) SBC(D); OP_END;											/* SBC  A,D         */
+	OP_CASE(9b) SBC(E); OP_END;											/* SBC  A,E         */
+	OP_CASE(9c) SBC(H); OP_END;											/* SBC  A,H         */
+	OP_CASE(9d) SBC(L); OP_END;											/* SBC  A,L         */
+	OP_CASE(9e) SBC(RM8(HL)); OP_END;										/* SBC  A,(HL)      */
+	OP_CASE(9f) SBC(A); OP_END;											/* SBC  A,A         */
+	OP_CASE(a0) AND(B); OP_END;											/* AND  B           */
+	OP_CASE(a1) AND(C); OP_END;											/* AND  C           */
+	OP_CASE(a2) AND(D); OP_END;											/* AND  D           */
+	OP_CASE(a3) AND(E); OP_END;											/* AND  E           */
+	OP_CASE(a4) AND(H); OP_END;											/* AND  H           */
+	OP_CASE(a5) AND(L); OP_END;											/* AND  L           */
+	OP_CASE(a6) AND(RM8(HL)); OP_END;										/* AND  (HL)        */
+	OP_CASE(a7) AND(A); OP_END;											/* AND  A           */
+	OP_CASE(a8) XOR(B); OP_END;											/* XOR  B           */
+	OP_CASE(a9) XOR(C); OP_END;											/* XOR  C           */
+	OP_CASE(aa) XOR(D); OP_END;											/* XOR  D           */
+	OP_CASE(ab) XOR(E); OP_END;											/* XOR  E           */
+	OP_CASE(ac) XOR(H); OP_END;											/* XOR  H           */
+	OP_CASE(ad) XOR(L); OP_END;											/* XOR  L           */
+	OP_CASE(ae) XOR(RM8(HL)); OP_END;										/* XOR  (HL)        */
+	OP_CASE(af) XOR(A); OP_END;											/* XOR  A           */
+	OP_CASE(b0) OR(B); OP_END;											/* OR   B           */
+	OP_CASE(b1) OR(C); OP_END;											/* OR   C           */
+	OP_CASE(b2) OR(D); OP_END;											/* OR   D           */
+	OP_CASE(b3) OR(E); OP_END;											/* OR   E           */
+	OP_CASE(b4) OR(H); OP_END;											/* OR   H           */
+	OP_CASE(b5) OR(L); OP_END;											/* OR   L           */
+	OP_CASE(b6) OR(RM8(HL)); OP_END;										/* OR   (HL)        */
+	OP_CASE(b7) OR(A); OP_END;											/* OR   A           */
+	OP_CASE(b8) CP(B); OP_END;											/* CP   B           */
+	OP_CASE(b9) CP(C); OP_END;											/* CP   C           */
+	OP_CASE(ba) CP(D); OP_END;											/* CP   D           */
+	OP_CASE(bb) CP(E); OP_END;											/* CP   E           */
+	OP_CASE(bc) CP(H); OP_END;											/* CP   H           */
+	OP_CASE(bd) CP(L); OP_END;											/* CP   L           */
+	OP_CASE(be) CP(RM8(HL)); OP_END;										/* CP   (HL)        */
+	OP_CASE(bf) CP(A); OP_END;											/* CP   A           */
+	OP_CASE(c0) RET_COND(!(F & ZF), 0xc0); OP_END;									/* RET  NZ          */
+	OP_CASE(c1) POP(bc); OP_END;											/* POP  BC          */
+	OP_CASE(c2) JP_COND(!(F & ZF)); OP_END;										/* JP   NZ,a        */
+	OP_CASE(c3) JP(); OP_END;											/* JP   a           */
+	OP_CASE(c4) CALL_COND(!(F & ZF), 0xc4); OP_END;									/* CALL NZ,a        */
+	OP_CASE(c5) PUSH(bc); OP_END;											/* PUSH BC          */
+	OP_CASE(c6) ADD(FETCH8()); OP_END;										/* ADD  A,n         */
+	OP_CASE(c7) RST(0x00); OP_END;											/* RST  0           */
+	OP_CASE(c8) RET_COND(F & ZF, 0xc8); OP_END;									/* RET  Z           */
+	OP_CASE(c9) POP(pc); WZ = PCD; OP_END;										/* RET              */
+	OP_CASE(ca) JP_COND(F & ZF); OP_END;										/* JP   Z,a         */
+	OP_CASE(cb) OP_CB(FETCHOP()); OP_END;										/* **** CB xx       */
+	OP_CASE(cc) CALL_COND(F & ZF, 0xcc); OP_END;									/* CALL Z,a         */
+	OP_CASE(cd) CALL(); OP_END;											/* CALL a           */
+	OP_CASE(ce) ADC(FETCH8()); OP_END;										/* ADC  A,n         */
+	OP_CASE(cf) RST(0x08); OP_END;											/* RST  1           */
+	OP_CASE(d0) RET_COND(!(F & CF), 0xd0); OP_END;									/* RET  NC          */
+	OP_CASE(d1) POP(de); OP_END;											/* POP  DE          */
+	OP_CASE(d2) JP_COND(!(F & CF)); OP_END;										/* JP   NC,a        */
+	OP_CASE(d3) {unsigned n = FETCH8() | (A << 8); OUT8(n, A); WZ_L = ((n & 0xff) + 1) & 0xff; WZ_H = A;} OP_END;	/* OUT  (n),A       */
+	OP_CASE(d4) CALL_COND(!(F & CF), 0xd4); OP_END;									/* CALL NC,a        */
+	OP_CASE(d5) PUSH(de); OP_END;											/* PUSH DE          */
+	OP_CASE(d6) SUB(FETCH8()); OP_END;										/* SUB  n           */
+	OP_CASE(d7) RST(0x10); OP_END;											/* RST  2           */
+	OP_CASE(d8) RET_COND(F & CF, 0xd8); OP_END;									/* RET  C           */
+	OP_CASE(d9) EXX(); OP_END;											/* EXX              */
+	OP_CASE(da) JP_COND(F & CF); OP_END;										/* JP   C,a         */
+	OP_CASE(db) {unsigned n = FETCH8() | (A << 8); A = IN8(n); WZ = n + 1;} OP_END;					/* IN   A,(n)       */
+	OP_CASE(dc) CALL_COND(F & CF, 0xdc); OP_END;									/* CALL C,a         */
+	OP_CASE(dd) OP_DD(FETCHOP()); OP_END;										/* **** DD xx       */
+	OP_CASE(de) SBC(FETCH8()); OP_END;										/* SBC  A,n         */
+	OP_CASE(df) RST(0x18); OP_END;											/* RST  3           */
+	OP_CASE(e0) RET_COND(!(F & PF), 0xe0); OP_END;									/* RET  PO          */
+	OP_CASE(e1) POP(hl); OP_END;											/* POP  HL          */
+	OP_CASE(e2) JP_COND(!(F & PF)); OP_END;										/* JP   PO,a        */
+	OP_CASE(e3) EXSP(hl); OP_END;											/* EX   HL,(SP)     */
+	OP_CASE(e4) CALL_COND(!(F & PF), 0xe4); OP_END;									/* CALL PO,a        */
+	OP_CASE(e5) PUSH(hl); OP_END;											/* PUSH HL          */
+	OP_CASE(e6) AND(FETCH8()); OP_END;										/* AND  n           */
+	OP_CASE(e7) RST(0x20); OP_END;											/* RST  4           */
+	OP_CASE(e8) RET_COND(F & PF, 0xe8); OP_END;									/* RET  PE          */
+	OP_CASE(e9) PC = HL; OP_END;											/* JP   (HL)        */
+	OP_CASE(ea) JP_COND(F & PF); OP_END;										/* JP   PE,a        */
+	OP_CASE(eb) EX_DE_HL(); OP_END;											/* EX   DE,HL       */
+	OP_CASE(ec) CALL_COND(F & PF, 0xec); OP_END;									/* CALL PE,a        */
+	OP_CASE(ed) OP_ED(FETCHOP()); OP_END;										/* **** ED xx       */
+	OP_CASE(ee) XOR(FETCH8()); OP_END;										/* XOR  n           */
+	OP_CASE(ef) RST(0x28); OP_END;											/* RST  5           */
+	OP_CASE(f0) RET_COND(!(F & SF), 0xf0); OP_END;									/* RET  P           */
+	OP_CASE(f1) POP(af); OP_END;											/* POP  AF          */
+	OP_CASE(f2) JP_COND(!(F & SF)); OP_END;										/* JP   P,a         */
+	OP_CASE(f3) iff1 = iff2 = 0; OP_END;										/* DI               */
+	OP_CASE(f4) CALL_COND(!(F & SF), 0xf4); OP_END;									/* CALL P,a         */
+	OP_CASE(f5) PUSH(af); OP_END;											/* PUSH AF          */
+	OP_CASE(f6) OR(FETCH8()); OP_END;										/* OR   n           */
+	OP_CASE(f7) RST(0x30); OP_END;											/* RST  6           */
+	OP_CASE(f8) RET_COND(F & SF, 0xf8); OP_END;									/* RET  M           */
+	OP_CASE(f9) SP = HL; OP_END;											/* LD   SP,HL       */
+	OP_CASE(fa) JP_COND(F & SF); OP_END;										/* JP   M,a         */
+	OP_CASE(fb) EI(); OP_END;											/* EI               */
+	OP_CASE(fc) CALL_COND(F & SF, 0xfc); OP_END;									/* CALL M,a         */
+	OP_CASE(fd) OP_FD(FETCHOP()); OP_END;										/* **** FD xx       */
+	OP_CASE(fe) CP(FETCH8()); OP_END;										/* CP   n           */
+	OP_CASE(ff) RST(0x38); OP_END;											/* RST  7           */
+#ifdef Z80_THREADED_DISPATCH
+op_next:
+	// jump to the next opecode directly while run_one_opecode() has nothing to do
+	// between opecodes, this is same as the loop in run()
+	if(chain && icount > 0 && !busreq && !after_ei && !after_ldair && !intr_req_bit) {
+		opecode_icount = icount;
+		code = FETCHOP();
+		prevpc = PC - 1;
+		icount -= cc_op[code];
+		goto *op_table[code];
+	}
+#else
 	default: __assume(0);
 	}
+#endif
 #ifdef _CPU_DEBUG_LOG
 	if(debug_count && !dasm_done) {
 		if(!(prev_halt && halt)) {
@@ -1974,77 +2069,93 @@ void Z80::OP(uint8 code)
 
 // main
 
-void Z80::initialize()
+static bool initialize_flags()
 {
-	if(!flags_initialized) {
-		uint8 *padd = SZHVC_add;
-		uint8 *padc = SZHVC_add + 256 * 256;
-		uint8 *psub = SZHVC_sub;
-		uint8 *psbc = SZHVC_sub + 256 * 256;
-		
-		for(int oldval = 0; oldval < 256; oldval++) {
-			for(int newval = 0; newval < 256; newval++) {
-				/* add or adc w/o carry set */
-				int val = newval - oldval;
-				*padd = (newval) ? ((newval & 0x80) ? SF : 0) : ZF;
-				*padd |= (newval & (YF | XF));	/* undocumented flag bits 5+3 */
-				if((newval & 0x0f) < (oldval & 0x0f)) *padd |= HF;
-				if(newval < oldval) *padd |= CF;
-				if((val ^ oldval ^ 0x80) & (val ^ newval) & 0x80) *padd |= VF;
-				padd++;
-				
-				/* adc with carry set */
-				val = newval - oldval - 1;
-				*padc = (newval) ? ((newval & 0x80) ? SF : 0) : ZF;
-				*padc |= (newval & (YF | XF));	/* undocumented flag bits 5+3 */
-				if((newval & 0x0f) <= (oldval & 0x0f)) *padc |= HF;
-				if(newval <= oldval) *padc |= CF;
-				if((val ^ oldval ^ 0x80) & (val ^ newval) & 0x80) *padc |= VF;
-				padc++;
-				
-				/* cp, sub or sbc w/o carry set */
-				val = oldval - newval;
-				*psub = NF | ((newval) ? ((newval & 0x80) ? SF : 0) : ZF);
-				*psub |= (newval & (YF | XF));	/* undocumented flag bits 5+3 */
-				if((newval & 0x0f) > (oldval & 0x0f)) *psub |= HF;
-				if(newval > oldval) *psub |= CF;
-				if((val ^ oldval) & (oldval ^ newval) & 0x80) *psub |= VF;
-				psub++;
-				
-				/* sbc with carry set */
-				val = oldval - newval - 1;
-				*psbc = NF | ((newval) ? ((newval & 0x80) ? SF : 0) : ZF);
-				*psbc |= (newval & (YF | XF));	/* undocumented flag bits 5+3 */
-				if((newval & 0x0f) >= (oldval & 0x0f)) *psbc |= HF;
-				if(newval >= oldval) *psbc |= CF;
-				if((val ^ oldval) & (oldval ^ newval) & 0x80) *psbc |= VF;
-				psbc++;
-			}
-		}
-		for(int i = 0; i < 256; i++) {
-			int p = 0;
-			if(i & 0x01) ++p;
-			if(i & 0x02) ++p;
-			if(i & 0x04) ++p;
-			if(i & 0x08) ++p;
-			if(i & 0x10) ++p;
-			if(i & 0x20) ++p;
-			if(i & 0x40) ++p;
-			if(i & 0x80) ++p;
-			SZ[i] = i ? i & SF : ZF;
-			SZ[i] |= (i & (YF | XF));	/* undocumented flag bits 5+3 */
-			SZ_BIT[i] = i ? i & SF : ZF | PF;
-			SZ_BIT[i] |= (i & (YF | XF));	/* undocumented flag bits 5+3 */
-			SZP[i] = SZ[i] | ((p & 1) ? 0 : PF);
-			SZHV_inc[i] = SZ[i];
-			if(i == 0x80) SZHV_inc[i] |= VF;
-			if((i & 0x0f) == 0x00) SZHV_inc[i] |= HF;
-			SZHV_dec[i] = SZ[i] | NF;
-			if(i == 0x7f) SZHV_dec[i] |= VF;
-			if((i & 0x0f) == 0x0f) SZHV_dec[i] |= HF;
+	uint8 *padd = SZHVC_add;
+	uint8 *padc = SZHVC_add + 256 * 256;
+	uint8 *psub = SZHVC_sub;
+	uint8 *psbc = SZHVC_sub + 256 * 256;
+	
+	for(int oldval = 0; oldval < 256; oldval++) {
+		for(int newval = 0; newval < 256; newval++) {
+			/* add or adc w/o carry set */
+			int val = newval - oldval;
+			*padd = (newval) ? ((newval & 0x80) ? SF : 0) : ZF;
+			*padd |= (newval & (YF | XF));	/* undocumented flag bits 5+3 */
+			if((newval & 0x0f) < (oldval & 0x0f)) *padd |= HF;
+			if(newval < oldval) *padd |= CF;
+			if((val ^ oldval ^ 0x80) & (val ^ newval) & 0x80) *padd |= VF;
+			padd++;
+			
+			/* adc with carry set */
+			val = newval - oldval - 1;
+			*padc = (newval) ? ((newval & 0x80) ? SF : 0) : ZF;
+			*padc |= (newval & (YF | XF));	/* undocumented flag bits 5+3 */
+			if((newval & 0x0f) <= (oldval & 0x0f)) *padc |= HF;
+			if(newval <= oldval) *padc |= CF;
+			if((val ^ oldval ^ 0x80) & (val ^ newval) & 0x80) *padc |= VF;
+			padc++;
+			
+			/* cp, sub or sbc w/o carry set */
+			val = oldval - newval;
+			*psub = NF | ((newval) ? ((newval & 0x80) ? SF : 0) : ZF);
+			*psub |= (newval & (YF | XF));	/* undocumented flag bits 5+3 */
+			if((newval & 0x0f) > (oldval & 0x0f)) *psub |= HF;
+			if(newval > oldval) *psub |= CF;
+			if((val ^ oldval) & (oldval ^ newval) & 0x80) *psub |= VF;
+			psub++;
+			
+			/* sbc with carry set */
+			val = oldval - newval - 1;
+			*psbc = NF | ((newval) ? ((newval & 0x80) ? SF : 0) : ZF);
+			*psbc |= (newval & (YF | XF));	/* undocumented flag bits 5+3 */
+			if((newval & 0x0f) >= (oldval & 0x0f)) *psbc |= HF;
+			if(newval >= oldval) *psbc |= CF;
+			if((val ^ oldval) & (oldval ^ newval) & 0x80) *psbc |= VF;
+			psbc++;
 		}
-		flags_initialized = true;
 	}
+	for(int i = 0; i < 256; i++) {
+		int p = 0;
+		if(i & 0x01) ++p;
+		if(i & 0x02) ++p;
+		if(i & 0x04) ++p;
+		if(i & 0x08) ++p;
+		if(i & 0x10) ++p;
+		if(i & 0x20) ++p;
+		if(i & 0x40) ++p;
+		if(i & 0x80) ++p;
+		SZ[i] = i ? i & SF : ZF;
+		SZ[i] |= (i & (YF | XF));	/* undocumented flag bits 5+3 */
+		SZ_BIT[i] = i ? i & SF : ZF | PF;
+		SZ_BIT[i] |= (i & (YF | XF));	/* undocumented flag bits 5+3 */
+		SZP[i] = SZ[i] | ((p & 1) ? 0 : PF);
+		SZHV_inc[i] = SZ[i];
+		if(i == 0x80) SZHV_inc[i] |= VF;
+		if((i & 0x0f) == 0x00) SZHV_inc[i] |= HF;
+		SZHV_dec[i] = SZ[i] | NF;
+		if(i == 0x7f) SZHV_dec[i] |= VF;
+		if((i & 0x0f) == 0x0f) SZHV_dec[i] |= HF;
+	}
+	return true;
+}
+
+// the flag tables are shared by all cpus and never written after this,
+// so build them at startup before any vm is created on a worker thread
+static bool flags_initialized = initialize_flags();
+
+void Z80::initialize()
+{
+	// access the memory banks directly if the memory device exports them
+	read_shift = write_shift = 0;
+	read_bank = d_mem->get_read_bank_table(&read_shift);
+	write_bank = d_mem->get_write_bank_table(&write_shift);
+	read_mask = (1 << read_shift) - 1;
+	write_mask = (1 << write_shift) - 1;
+#ifdef Z80_STATIC_IO
+	// access the i/o ports directly if the machine declares the map of this bus
+	static_io = STATIC_IO_MAP::static_io_w::is_bus(vm, d_io) && STATIC_IO_MAP::static_io_r::is_bus(vm, d_io);
+#endif
 }
 
 void Z80::reset()
@@ -2126,9 +2237,10 @@ int Z80::run(int clock)
 	else {
 		// run cpu while given clocks
 		icount += clock;
-		int first_icount = icount;
+		first_icount = icount;
 		
 		while(icount > 0 && !busreq) {
+			opecode_icount = icount;
 			run_one_opecode();
 		}
 		int passed_icount = first_icount - icount;
@@ -2145,7 +2257,11 @@ void Z80::run_one_opecode()
 #ifdef _CPU_DEBUG_LOG
 	dasm_done = false;
 #endif
+#ifdef Z80_THREADED_DISPATCH
+	OP(FETCHOP(), true);
+#else
 	OP(FETCHOP());
+#endif
 #if HAS_LDAIR_QUIRK
 	if(after_ldair) F &= ~PF;	// reset parity flag after LD A,I or LD A,R
 #endif
@@ -2281,6 +2397,82 @@ void Z80::run_one_opecode()
 #endif
 }
 
+void Z80::save_state(FILEIO* fio)
+{
+	fio->FputUint32(STATE_VERSION);
+	fio->FputInt32(this_device_id);
+	
+	fio->FputInt32(icount);
+	fio->FputUint16(prevpc);
+	fio->FputUint32(pc.d);
+	fio->FputUint32(sp.d);
+	fio->FputUint32(af.d);
+	fio->FputUint32(bc.d);
+	fio->FputUint32(de.d);
+	fio->FputUint32(hl.d);
+	fio->FputUint32(ix.d);
+	fio->FputUint32(iy.d);
+	fio->FputUint32(wz.d);
+	fio->FputUint32(af2.d);
+	fio->FputUint32(bc2.d);
+	fio->FputUint32(de2.d);
+	fio->FputUint32(hl2.d);
+	fio->FputUint8(I);
+	fio->FputUint8(R);
+	fio->FputUint8(R2);
+	fio->FputUint32(ea);
+	fio->FputBool(busreq);
+	fio->FputBool(halt);
+	fio->FputUint8(im);
+	fio->FputUint8(iff1);
+	fio->FputUint8(iff2);
+	fio->FputUint8(icr);
+	fio->FputBool(after_ei);
+	fio->FputBool(after_ldair);
+	fio->FputUint32(intr_req_bit);
+	fio->FputUint32(intr_pend_bit);
+}
+
+bool Z80::load_state(FILEIO* fio)
+{
+	if(fio->FgetUint32() != STATE_VERSION) {
+		return false;
+	}
+	if(fio->FgetInt32() != this_device_id) {
+		return false;
+	}
+	icount = fio->FgetInt32();
+	prevpc = fio->FgetUint16();
+	pc.d = fio->FgetUint32();
+	sp.d = fio->FgetUint32();
+	af.d = fio->FgetUint32();
+	bc.d = fio->FgetUint32();
+	de.d = fio->FgetUint32();
+	hl.d = fio->FgetUint32();
+	ix.d = fio->FgetUint32();
+	iy.d = fio->FgetUint32();
+	wz.d = fio->FgetUint32();
+	af2.d = fio->FgetUint32();
+	bc2.d = fio->FgetUint32();
+	de2.d = fio->FgetUint32();
+	hl2.d = fio->FgetUint32();
+	I = fio->FgetUint8();
+	R = fio->FgetUint8();
+	R2 = fio->FgetUint8();
+	ea = fio->FgetUint32();
+	busreq = fio->FgetBool();
+	halt = fio->FgetBool();
+	im = fio->FgetUint8();
+	iff1 = fio->FgetUint8();
+	iff2 = fio->FgetUint8();
+	icr = fio->FgetUint8();
+	after_ei = fio->FgetBool();
+	after_ldair = fio->FgetBool();
+	intr_req_bit = fio->FgetUint32();
+	intr_pend_bit = fio->FgetUint32();
+	return true;
+}
+
 #ifdef _CPU_DEBUG_LOG
 void Z80::DASM()
 {
@@ -15,6 +15,18 @@
 #include "../emu.h"
 #include "device.h"
 
+// computed goto dispatch needs gcc extension, and the debugger and single mode dma
+// have to check something after every opecode
+#if defined(Z80_THREADED_DISPATCH) && (!defined(__GNUC__) || defined(_CPU_DEBUG_LOG) || defined(SINGLE_MODE_DMA))
+#undef Z80_THREADED_DISPATCH
+#endif
+
+// the i/o map declared at compile time is used only in the build of the virtual machine with _STATIC_IO,
+// and does not support the wait and the debug log of IO
+#if defined(_STATIC_IO) && defined(STATIC_IO_MAP_H) && !defined(Z80_IO_WAIT) && !defined(_IO_DEBUG_LOG)
+#define Z80_STATIC_IO
+#endif
+
 #ifdef HAS_NSC800
 #define SIG_NSC800_INT	0
 #define SIG_NSC800_RSTA	1
@@ -35,11 +47,20 @@ private:
 #endif
 	outputs_t outputs_busack;
 	
+	// bank tables exported by the memory device
+	uint8 **read_bank, **write_bank;
+	int read_shift, write_shift;
+	uint32 read_mask, write_mask;
+#ifdef Z80_STATIC_IO
+	bool static_io;
+#endif
+	
 	/* ---------------------------------------------------------------------------
 	registers
 	--------------------------------------------------------------------------- */
 	
 	int icount;
+	int first_icount, opecode_icount;
 	uint16 prevpc;
 	pair pc, sp, af, bc, de, hl, ix, iy, wz;
 	pair af2, bc2, de2, hl2;
@@ -81,7 +102,11 @@ private:
 	void OP_DD(uint8 code);
 	void OP_FD(uint8 code);
 	void OP_ED(uint8 code);
+#ifdef Z80_THREADED_DISPATCH
+	void OP(uint8 code, bool chain = false);
+#else
 	void OP(uint8 code);
+#endif
 	void run_one_opecode();
 	
 	/* ---------------------------------------------------------------------------
@@ -136,6 +161,8 @@ public:
 	void reset();
 	int run(int clock);
 	void write_signal(int id, uint32 data, uint32 mask);
+	void save_state(FILEIO* fio);
+	bool load_state(FILEIO* fio);
 	void set_intr_line(bool line, bool pending, uint32 bit) {
 		uint32 mask = 1 << bit;
 		intr_req_bit = line ? (intr_req_bit | mask) : (intr_req_bit & ~mask);
@@ -144,6 +171,16 @@ public:
 	uint32 get_pc() {
 		return prevpc;
 	}
+	int get_run_clock() {
+		return first_icount - opecode_icount;
+	}
+	void stop_run() {
+		if(icount > 0) {
+			first_icount -= icount;
+			opecode_icount -= icount;
+			icount = 0;
+		}
+	}
 	
 	// unique function
 	void set_context_mem(DEVICE* device) {
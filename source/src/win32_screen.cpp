@@ -7,10 +7,15 @@
 	[ win32 screen ]
 */
 
+#include <process.h>
 #include "emu.h"
 #include "vm/vm.h"
 #include "config.h"
 
+// ready_frame: index of the last frame, and FRAME_FRESH until it is presented
+#define FRAME_INDEX	3
+#define FRAME_FRESH	4
+
 void EMU::initialize_screen()
 {
 	screen_width = SCREEN_WIDTH;
@@ -44,7 +49,6 @@ void EMU::initialize_screen()
 	lpd3d9Surface = NULL;
 	lpd3d9OffscreenSurface = NULL;
 	lpd3d9Buffer = NULL;
-	render_to_d3d9Buffer = false;
 	use_d3d9 = config.use_d3d9;
 	wait_vsync = config.wait_vsync;
 	
@@ -57,6 +61,16 @@ void EMU::initialize_screen()
 	// initialize update flags
 	first_draw_screen = false;
 	first_invalidate = self_invalidate = false;
+	
+	// create frame buffers
+	create_frame_buffers();
+	frames_produced = frames_presented = frames_dropped = 0;
+	
+	// start presenter thread
+	InitializeCriticalSection(&screen_lock);
+	hPresentEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+	present_exit = false;
+	hPresentThread = (HANDLE)_beginthreadex(NULL, 0, present_thread, this, 0, NULL);
 }
 
 #define release_dib_section(hdcdib, hbmp, holdbmp, lpbuf) { \
@@ -109,6 +123,17 @@ void EMU::initialize_screen()
 
 void EMU::release_screen()
 {
+	// stop presenter thread
+	if(hPresentThread != NULL) {
+		present_exit = true;
+		SetEvent(hPresentEvent);
+		WaitForSingleObject(hPresentThread, INFINITE);
+		CloseHandle(hPresentThread);
+		hPresentThread = NULL;
+	}
+	CloseHandle(hPresentEvent);
+	DeleteCriticalSection(&screen_lock);
+	
 	// stop video recording
 	stop_rec_video();
 	
@@ -122,6 +147,34 @@ void EMU::release_screen()
 	
 	// release d3d9
 	release_d3d9();
+	
+	// release frame buffers
+	release_frame_buffers();
+}
+
+void EMU::create_frame_buffers()
+{
+	vm_screen = (scrntype*)calloc(screen_width * screen_height, sizeof(scrntype));
+	for(int i = 0; i < 3; i++) {
+		frame_buffer[i] = (scrntype*)calloc(screen_width * screen_height, sizeof(scrntype));
+	}
+	draw_frame = 0;
+	ready_frame = 1;
+	present_frame = 2;
+}
+
+void EMU::release_frame_buffers()
+{
+	if(vm_screen != NULL) {
+		free(vm_screen);
+		vm_screen = NULL;
+	}
+	for(int i = 0; i < 3; i++) {
+		if(frame_buffer[i] != NULL) {
+			free(frame_buffer[i]);
+			frame_buffer[i] = NULL;
+		}
+	}
 }
 
 void EMU::create_dib_section(HDC hdc, int width, int height, HDC *hdcDib, HBITMAP *hBmp, HBITMAP *hOldBmp, LPBYTE *lpBuf, scrntype **lpBmp, LPBITMAPINFO *lpDib)
@@ -181,6 +234,7 @@ int EMU::get_window_height(int mode)
 
 void EMU::set_display_size(int width, int height, bool window_mode)
 {
+	EnterCriticalSection(&screen_lock);
 RETRY:
 	bool display_size_changed = false;
 	bool stretch_changed = false;
@@ -204,9 +258,6 @@ RETRY:
 		stretch_changed = true;
 	}
 	
-	// virtual machine renders to d3d9 buffer directly???
-	render_to_d3d9Buffer = use_d3d9;
-	
 #ifdef USE_SCREEN_ROTATE
 	if(config.monitor_type) {
 		hdcDibSource = hdcDibRotate;
@@ -223,8 +274,6 @@ RETRY:
 		source_height = screen_width;
 		source_width_aspect = screen_height_aspect;
 		source_height_aspect = screen_width_aspect;
-		
-		render_to_d3d9Buffer = false;
 	}
 	else {
 #endif
@@ -287,9 +336,6 @@ RETRY:
 		stretch_pow_y = new_pow_y;
 		stretch_changed = true;
 	}
-	if(stretch_pow_x != 1 || stretch_pow_y != 1) {
-		render_to_d3d9Buffer = false;
-	}
 	// border color not support yet
 	if(stretch_changed) {
 		release_dib_section(hdcDibStretch1, hBmpStretch1, hOldBmpStretch1, lpBufStretch1);
@@ -361,20 +407,20 @@ RETRY:
 				goto RETRY;
 			}
 		}
-		if(stretch_screen) {
-			render_to_d3d9Buffer = false;
-		}
 	}
 	
 	first_draw_screen = false;
 	first_invalidate = true;
 	screen_size_changed = false;
+	LeaveCriticalSection(&screen_lock);
 }
 
 void EMU::change_screen_size(int sw, int sh, int swa, int sha, int ww, int wh)
 {
 	// virtual machine changes the screen size
 	if(screen_width != sw || screen_height != sh) {
+		// wait until the presenter thread releases the buffers
+		EnterCriticalSection(&screen_lock);
 		screen_width = sw;
 		screen_height = sh;
 		screen_width_aspect = (swa != -1) ? swa : sw;
@@ -393,11 +439,16 @@ void EMU::change_screen_size(int sw, int sh, int swa, int sha, int ww, int wh)
 #endif
 		ReleaseDC(main_window_handle, hdc);
 		
+		// re-create frame buffers, the frames not presented yet are discarded
+		release_frame_buffers();
+		create_frame_buffers();
+		
 		// stop recording
 		if(now_rec_vid) {
 			stop_rec_video();
 			stop_rec_sound();
 		}
+		LeaveCriticalSection(&screen_lock);
 		
 		// change the window size
 		PostMessage(main_window_handle, WM_RESIZE, 0L, 0L);
@@ -411,28 +462,82 @@ void EMU::draw_screen()
 		return;
 	}
 	
-	// lock offscreen surface
-	D3DLOCKED_RECT pLockedRect;
-	if(use_d3d9 && lpd3d9OffscreenSurface != NULL && lpd3d9OffscreenSurface->LockRect(&pLockedRect, NULL, 0) == D3D_OK) {
-		lpd3d9Buffer = (scrntype *)pLockedRect.pBits;
-	}
-	else {
-		lpd3d9Buffer = NULL;
-	}
-	
 	// draw screen
 	vm->draw_screen();
 	
 	// screen size was changed in vm->draw_screen()
 	if(screen_size_changed) {
-		// unlock offscreen surface
-		if(use_d3d9 && lpd3d9Buffer != NULL) {
-			lpd3d9Buffer = NULL;
-			lpd3d9OffscreenSurface->UnlockRect();
-		}
 		return;
 	}
 	
+	// record picture
+	if(now_rec_vid) {
+		EnterCriticalSection(&screen_lock);
+		copy_to_dib_section(vm_screen);
+		if(AVIStreamWrite(pAVICompressed, rec_frames++, 1, (LPBYTE)lpBmpSource, pbmInfoHeader->biSizeImage, AVIIF_KEYFRAME, NULL, NULL) != AVIERR_OK) {
+			stop_rec_video();
+		}
+		LeaveCriticalSection(&screen_lock);
+	}
+	
+	// pass the frame to the presenter thread and take the free buffer,
+	// the vm thread never waits for the presenter thread
+	memcpy(frame_buffer[draw_frame], vm_screen, screen_width * screen_height * sizeof(scrntype));
+	LONG prev_frame = InterlockedExchange(&ready_frame, draw_frame | FRAME_FRESH);
+	if(prev_frame & FRAME_FRESH) {
+		// the previous frame was not presented
+		frames_dropped++;
+	}
+	draw_frame = prev_frame & FRAME_INDEX;
+	frames_produced++;
+	SetEvent(hPresentEvent);
+}
+
+unsigned __stdcall EMU::present_thread(void* param)
+{
+	((EMU*)param)->present_loop();
+	return 0;
+}
+
+void EMU::present_loop()
+{
+	while(1) {
+		WaitForSingleObject(hPresentEvent, INFINITE);
+		if(present_exit) {
+			break;
+		}
+		EnterCriticalSection(&screen_lock);
+		if(!screen_size_changed && (ready_frame & FRAME_FRESH)) {
+			// take the last frame, and the frames skipped by the presenter are dropped
+			present_frame = InterlockedExchange(&ready_frame, present_frame) & FRAME_INDEX;
+			present_screen(frame_buffer[present_frame]);
+			frames_presented++;
+			
+			if(first_invalidate) {
+				// the background is erased in WM_PAINT of the main thread
+				InvalidateRect(main_window_handle, NULL, TRUE);
+			}
+			else {
+				// don't send any message to the main thread that may wait for screen_lock
+				HDC hdc = GetDC(main_window_handle);
+				if(hdc != NULL) {
+					self_invalidate = true;
+					update_screen(hdc);
+					ReleaseDC(main_window_handle, hdc);
+				}
+			}
+		}
+		LeaveCriticalSection(&screen_lock);
+	}
+}
+
+void EMU::copy_to_dib_section(scrntype* frame)
+{
+	// dib section is bottom-up
+	for(int y = 0; y < screen_height; y++) {
+		memcpy(lpBmp + screen_width * (screen_height - y - 1), frame + screen_width * y, screen_width * sizeof(scrntype));
+	}
+	
 #ifdef USE_SCREEN_ROTATE
 	// rotate screen
 	if(config.monitor_type) {
@@ -446,6 +551,21 @@ void EMU::draw_screen()
 		}
 	}
 #endif	
+}
+
+void EMU::present_screen(scrntype* frame)
+{
+	// lock offscreen surface
+	D3DLOCKED_RECT pLockedRect;
+	if(use_d3d9 && lpd3d9OffscreenSurface != NULL && lpd3d9OffscreenSurface->LockRect(&pLockedRect, NULL, 0) == D3D_OK) {
+		lpd3d9Buffer = (scrntype *)pLockedRect.pBits;
+	}
+	else {
+		lpd3d9Buffer = NULL;
+	}
+	
+	// copy frame
+	copy_to_dib_section(frame);
 	
 	// stretch screen
 	if(stretch_screen) {
@@ -493,48 +613,33 @@ void EMU::draw_screen()
 	
 	// copy bitmap to d3d9 offscreen surface
 	if(use_d3d9 && lpd3d9Buffer != NULL) {
-		if(!(render_to_d3d9Buffer && !now_rec_vid)) {
-			scrntype *src = stretch_screen ? lpBmpStretch1 : lpBmpSource;
-			src += source_width * stretch_pow_x * (source_height * stretch_pow_y - 1);
-			scrntype *out = lpd3d9Buffer;
-			int data_len = source_width * stretch_pow_x;
-			
-			for(int y = 0; y < source_height * stretch_pow_y; y++) {
-				for(int i = 0; i < data_len; i++) {
-					out[i] = src[i];
-				}
-				src -= data_len;
-				out += data_len;
+		scrntype *src = stretch_screen ? lpBmpStretch1 : lpBmpSource;
+		src += source_width * stretch_pow_x * (source_height * stretch_pow_y - 1);
+		scrntype *out = lpd3d9Buffer;
+		int data_len = source_width * stretch_pow_x;
+		
+		for(int y = 0; y < source_height * stretch_pow_y; y++) {
+			for(int i = 0; i < data_len; i++) {
+				out[i] = src[i];
 			}
+			src -= data_len;
+			out += data_len;
 		}
 		// unlock offscreen surface
 		lpd3d9Buffer = NULL;
 		lpd3d9OffscreenSurface->UnlockRect();
 	}
-	
-	// invalidate window
-	InvalidateRect(main_window_handle, NULL, first_invalidate);
-	UpdateWindow(main_window_handle);
-	self_invalidate = true;
-	
-	// record picture
-	if(now_rec_vid) {
-		if(AVIStreamWrite(pAVICompressed, rec_frames++, 1, (LPBYTE)lpBmpSource, pbmInfoHeader->biSizeImage, AVIIF_KEYFRAME, NULL, NULL) != AVIERR_OK) {
-			stop_rec_video();
-		}
-	}
 }
 
 scrntype* EMU::screen_buffer(int y)
 {
-	if(use_d3d9 && lpd3d9Buffer != NULL && render_to_d3d9Buffer && !now_rec_vid) {
-		return lpd3d9Buffer + screen_width * y;
-	}
-	return lpBmp + screen_width * (screen_height - y - 1);
+	return vm_screen + screen_width * y;
 }
 
 void EMU::update_screen(HDC hdc)
 {
+	// called from the main thread (WM_PAINT) and the presenter thread
+	EnterCriticalSection(&screen_lock);
 #ifdef USE_BITMAP
 	if(first_invalidate || !self_invalidate) {
 		HDC hmdc = CreateCompatibleDC(hdc);
@@ -607,14 +712,13 @@ void EMU::update_screen(HDC hdc)
 #endif
 		first_invalidate = self_invalidate = false;
 	}
+	LeaveCriticalSection(&screen_lock);
 }
 
 void EMU::capture_screen()
 {
-	if(use_d3d9 && render_to_d3d9Buffer && !now_rec_vid) {
-		// virtual machine may render screen to d3d9 buffer directly...
-		vm->draw_screen();
-	}
+	// the dib section has the last presented frame
+	EnterCriticalSection(&screen_lock);
 	
 	SYSTEMTIME sTime;
 	GetLocalTime(&sTime);
@@ -632,6 +736,8 @@ void EMU::capture_screen()
 	WriteFile(hFile, lpDibSource, sizeof(BITMAPINFOHEADER), &dwSize, NULL);
 	WriteFile(hFile, lpBmpSource, pbmInfoHeader->biSizeImage, &dwSize, NULL);
 	CloseHandle(hFile);
+	
+	LeaveCriticalSection(&screen_lock);
 }
 
 void EMU::start_rec_video(int fps, bool show_dialog)
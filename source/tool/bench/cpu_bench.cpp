@@ -0,0 +1,810 @@
+/*
+	Skelton for retropc emulator
+
+	Author : Takeda.Toshiya
+	Date   : 2013.03.01-
+
+	[ cpu core test and benchmark ]
+
+	runs a cpu core against the flat ram and the dummy i/o device.
+
+	the built-in workload is hand assembled for each cpu: it adds the 128
+	bytes of the source buffer to the running xor sum, stores them to the
+	destination buffer and repeats it 256 times. the result, the buffer and
+	the clocks/opecodes are checked with the golden values, and the speed
+	is reported in MIPS and nsec/opecode.
+
+	instruction exerciser binaries can be run with the options:
+	  -bin <file>[:<addr>]  load the binary (default address: 0, or 0x100 with -cpm)
+	  -start <addr>         start address (default: the load address)
+	  -trap <addr>          stop when the cpu reaches the address
+	  -cpm                  cp/m console (bdos function 2 and 9) and warm boot (z80/i8080)
+	and the options for the memory access:
+	  -bank                 export the ram as the bank tables (z80/i386)
+	  -paging               run the workload in protected mode with paging (i386)
+
+	build one binary for each cpu with the machine that uses the core:
+	  z80     -DBENCH_Z80     -D_FC100      ../../src/vm/z80.cpp
+	  i8080   -DBENCH_I8080   -D_TK80BS     ../../src/vm/i8080.cpp
+	  m6502   -DBENCH_M6502   -D_FAMILYBASIC ../../src/vm/m6502.cpp
+	  mc6800  -DBENCH_MC6800  -D_HC20       ../../src/vm/mc6800.cpp
+	  mc6809  -DBENCH_MC6809  -D_FC100      ../../src/vm/mc6809.cpp
+	  upd7801 -DBENCH_UPD7801 -D_SCV        ../../src/vm/upd7801.cpp
+	  tms9995 -DBENCH_TMS9995 -D_PYUTA      ../../src/vm/tms9995.cpp
+	  i86     -DBENCH_I86     -D_FM16PI     ../../src/vm/i86.cpp
+	  i386    -DBENCH_I386    -D_N5200      ../../src/vm/i386.cpp
+	  h6280   -DBENCH_HUC6280 -D_PCENGINE   ../../src/vm/huc6280.cpp
+	for example:
+	g++ -O2 -DBENCH_Z80 -D_FC100 -D_HEADLESS -fno-operator-names -fpermissive -I../../src \
+	    cpu_bench.cpp ../../src/vm/z80.cpp ../../src/common.cpp ../../src/fileio.cpp -o cpu_bench_z80
+*/
+
+#include <time.h>
+#include "config.h"
+#include "vm/vm.h"
+#include "emu.h"
+#include "vm/device.h"
+
+#define DATA_SRC	0x1000
+#define DATA_DST	0x1080
+#define DATA_SIZE	0x80
+#define DATA_RESULT	0x1200
+#define DATA_STOP	0x1300
+#define DATA_LOOPS	256
+
+#define CODE_ADDR	0x2000
+#define RUN_CLOCKS	1000
+#define MAX_CLOCKS	2000000000
+#define BENCH_SEC	0.5
+
+// ----------------------------------------------------------------------------
+// cpu cores and workloads
+// ----------------------------------------------------------------------------
+
+#if defined(BENCH_Z80)
+#include "vm/z80.h"
+#define CPU_CLASS	Z80
+#define CPU_NAME	"Z80"
+#define CPU_HAS_IO
+#define CPU_HAS_INTR
+#define CPU_HAS_CPM
+#define ADDR_MASK	0xffff
+#define GOLDEN_CLOCKS	1940529
+#define GOLDEN_OPECODES	295942
+
+static const uint8 program[] = {
+	0x0e, 0x00,		// LD   C,0		; sum
+	0x16, 0x00,		// LD   D,0		; 256 loops
+	0x21, 0x00, 0x10,	// LD   HL,1000h
+	0x06, 0x80,		// LD   B,80h
+	0x7e,			// LD   A,(HL)
+	0x81,			// ADD  A,C
+	0xcb, 0xfd,		// SET  7,L
+	0x77,			// LD   (HL),A
+	0xcb, 0xbd,		// RES  7,L
+	0xa9,			// XOR  C
+	0x4f,			// LD   C,A
+	0x2c,			// INC  L
+	0x10, 0xf4,		// DJNZ 2009h
+	0x15,			// DEC  D
+	0x20, 0xec,		// JR   NZ,2004h
+	0x79,			// LD   A,C
+	0x32, 0x00, 0x12,	// LD   (1200h),A
+	0x32, 0x00, 0x13,	// LD   (1300h),A	; stop
+	0x76,			// HALT
+};
+
+static void set_start(uint8* ram, uint32 addr)
+{
+	ram[0x0000] = 0xc3;	// JP addr
+	ram[0x0001] = addr & 0xff;
+	ram[0x0002] = addr >> 8;
+}
+#elif defined(BENCH_I8080)
+#include "vm/i8080.h"
+#define CPU_CLASS	I8080
+#define CPU_NAME	"I8080"
+#define CPU_HAS_IO
+#define CPU_HAS_INTR
+#define CPU_HAS_CPM
+#define ADDR_MASK	0xffff
+#define GOLDEN_CLOCKS	1718596
+#define GOLDEN_OPECODES	296455
+
+static const uint8 program[] = {
+	0x0e, 0x00,		// MVI  C,0		; sum
+	0x3e, 0x00,		// MVI  A,0
+	0x32, 0x01, 0x12,	// STA  1201h		; 256 loops
+	0x21, 0x00, 0x10,	// LXI  H,1000h
+	0x11, 0x80, 0x10,	// LXI  D,1080h
+	0x06, 0x80,		// MVI  B,80h
+	0x7e,			// MOV  A,M
+	0x81,			// ADD  C
+	0x12,			// STAX D
+	0xa9,			// XRA  C
+	0x4f,			// MOV  C,A
+	0x23,			// INX  H
+	0x13,			// INX  D
+	0x05,			// DCR  B
+	0xc2, 0x0f, 0x20,	// JNZ  200Fh
+	0x21, 0x01, 0x12,	// LXI  H,1201h
+	0x35,			// DCR  M
+	0xc2, 0x07, 0x20,	// JNZ  2007h
+	0x79,			// MOV  A,C
+	0x32, 0x00, 0x12,	// STA  1200h
+	0x32, 0x00, 0x13,	// STA  1300h		; stop
+	0x76,			// HLT
+};
+
+static void set_start(uint8* ram, uint32 addr)
+{
+	ram[0x0000] = 0xc3;	// JMP addr
+	ram[0x0001] = addr & 0xff;
+	ram[0x0002] = addr >> 8;
+}
+#elif defined(BENCH_M6502) || defined(BENCH_HUC6280)
+#if defined(BENCH_M6502)
+#include "vm/m6502.h"
+#define CPU_CLASS	M6502
+#define CPU_NAME	"M6502"
+#define ADDR_MASK	0xffff
+#define GOLDEN_CLOCKS	886293
+#define GOLDEN_OPECODES	295688
+// the workload is run at 2000h
+#define CODE_HI		0x20
+#else
+#include "vm/huc6280.h"
+#define CPU_CLASS	HUC6280
+#define CPU_NAME	"HUC6280"
+#define CPU_HAS_IO
+#define ADDR_MASK	0x1fffff
+#define GOLDEN_CLOCKS	4200544
+#define GOLDEN_OPECODES	295688
+// all mapping registers are 0 after reset and every bank is physical 0000h-1fffh,
+// the workload is run at e400h (physical 0400h) not to overlap the zero page
+#undef CODE_ADDR
+#define CODE_ADDR	0x0400
+#define CODE_HI		0xe4
+#endif
+
+static const uint8 program[] = {
+	0x78,			// SEI
+	0xd8,			// CLD
+	0xa9, 0x00,		// LDA  #$00
+	0x85, 0x10,		// STA  $10		; sum
+	0xa0, 0x00,		// LDY  #$00		; 256 loops
+	0xa2, 0x00,		// LDX  #$00
+	0xbd, 0x00, 0x10,	// LDA  $1000,X
+	0x18,			// CLC
+	0x65, 0x10,		// ADC  $10
+	0x9d, 0x80, 0x10,	// STA  $1080,X
+	0x45, 0x10,		// EOR  $10
+	0x85, 0x10,		// STA  $10
+	0xe8,			// INX
+	0xe0, 0x80,		// CPX  #$80
+	0xd0, 0xee,		// BNE  $200A
+	0x88,			// DEY
+	0xd0, 0xe9,		// BNE  $2008
+	0xa5, 0x10,		// LDA  $10
+	0x8d, 0x00, 0x12,	// STA  $1200
+	0x8d, 0x00, 0x13,	// STA  $1300		; stop
+	0x4c, 0x27, CODE_HI,	// JMP  $2027
+};
+
+static void set_start(uint8* ram, uint32 addr)
+{
+#if defined(BENCH_M6502)
+	ram[0xfffc] = addr & 0xff;
+	ram[0xfffd] = (addr >> 8) & 0xff;
+#else
+	// logical address of the first 8kb bank
+	ram[0x1ffe] = addr & 0xff;
+	ram[0x1fff] = ((addr >> 8) & 0x1f) | 0xe0;
+#endif
+}
+#elif defined(BENCH_MC6800)
+#include "vm/mc6800.h"
+#define CPU_CLASS	MC6800
+#define CPU_NAME	"MC6800"
+#define ADDR_MASK	0xffff
+#define GOLDEN_CLOCKS	658446
+#define GOLDEN_OPECODES	230148
+
+static const uint8 program[] = {
+	0x5f,			// CLRB			; sum
+	0x7f, 0x12, 0x01,	// CLR  $1201		; 256 loops
+	0xce, 0x10, 0x00,	// LDX  #$1000
+	0xa6, 0x00,		// LDAA 0,X
+	0x1b,			// ABA
+	0xa7, 0x80,		// STAA $80,X
+	0xe8, 0x80,		// EORB $80,X
+	0x08,			// INX
+	0x8c, 0x10, 0x80,	// CPX  #$1080
+	0x26, 0xf3,		// BNE  $2007
+	0x7a, 0x12, 0x01,	// DEC  $1201
+	0x26, 0xeb,		// BNE  $2004
+	0xf7, 0x12, 0x00,	// STAB $1200
+	0xf7, 0x13, 0x00,	// STAB $1300		; stop
+	0x20, 0xfe,		// BRA  *
+};
+
+static void set_start(uint8* ram, uint32 addr)
+{
+	ram[0xfffe] = (addr >> 8) & 0xff;
+	ram[0xffff] = addr & 0xff;
+}
+#elif defined(BENCH_MC6809)
+#include "vm/mc6809.h"
+#define CPU_CLASS	MC6809
+#define CPU_NAME	"MC6809"
+#define ADDR_MASK	0xffff
+#define GOLDEN_CLOCKS	1019930
+#define GOLDEN_OPECODES	230405
+
+static const uint8 program[] = {
+	0x0f, 0x10,		// CLR  <$10		; sum
+	0x0f, 0x11,		// CLR  <$11		; 256 loops
+	0x8e, 0x10, 0x00,	// LDX  #$1000
+	0x10, 0x8e, 0x10, 0x80,	// LDY  #$1080
+	0xa6, 0x80,		// LDA  ,X+
+	0x9b, 0x10,		// ADDA <$10
+	0xa7, 0xa0,		// STA  ,Y+
+	0x98, 0x10,		// EORA <$10
+	0x97, 0x10,		// STA  <$10
+	0x8c, 0x10, 0x80,	// CMPX #$1080
+	0x26, 0xf1,		// BNE  $200B
+	0x0a, 0x11,		// DEC  <$11
+	0x26, 0xe6,		// BNE  $2004
+	0x96, 0x10,		// LDA  <$10
+	0xb7, 0x12, 0x00,	// STA  $1200
+	0xb7, 0x13, 0x00,	// STA  $1300		; stop
+	0x20, 0xfe,		// BRA  *
+};
+
+static void set_start(uint8* ram, uint32 addr)
+{
+	ram[0xfffe] = (addr >> 8) & 0xff;
+	ram[0xffff] = addr & 0xff;
+}
+#elif defined(BENCH_UPD7801)
+#include "vm/upd7801.h"
+#define CPU_CLASS	UPD7801
+#define CPU_NAME	"UPD7801"
+#define CPU_HAS_IO
+#define ADDR_MASK	0xffff
+#define GOLDEN_CLOCKS	1553739
+#define GOLDEN_OPECODES	197897
+
+static const uint8 program[] = {
+	0x68, 0x12,		// MVI  V,12h
+	0x71, 0x01, 0xff,	// MVIW 01h,0FFh	; 256 loops
+	0x6b, 0x00,		// MVI  C,0		; sum
+	0x34, 0x00, 0x10,	// LXI  H,1000h
+	0x24, 0x80, 0x10,	// LXI  D,1080h
+	0x6a, 0x7f,		// MVI  B,7Fh
+	0x2d,			// LDAX H+
+	0x60, 0xc3,		// ADD  A,C
+	0x3c,			// STAX D+
+	0x60, 0x13,		// XRA  C,A
+	0x52,			// DCR  B
+	0xf8,			// JR   200Fh
+	0x30, 0x01,		// DCRW 01h
+	0xed,			// JR   2007h
+	0x0b,			// MOV  A,C
+	0x34, 0x00, 0x12,	// LXI  H,1200h
+	0x3b,			// STAX H
+	0x34, 0x00, 0x13,	// LXI  H,1300h
+	0x3b,			// STAX H		; stop
+	0xff,			// JR   *
+};
+
+static void set_start(uint8* ram, uint32 addr)
+{
+	ram[0x0000] = 0x54;	// JMP addr
+	ram[0x0001] = addr & 0xff;
+	ram[0x0002] = addr >> 8;
+}
+#elif defined(BENCH_TMS9995)
+#include "vm/tms9995.h"
+#define CPU_CLASS	TMS9995
+#define CPU_NAME	"TMS9995"
+#define CPU_HAS_IO
+#define ADDR_MASK	0xffff
+#define GOLDEN_CLOCKS	6069396
+#define GOLDEN_OPECODES	197892
+
+static const uint8 program[] = {
+	0x04, 0xc0,		// CLR  R0		; sum
+	0x02, 0x04, 0x01, 0x00,	// LI   R4,>0100	; 256 loops
+	0x02, 0x01, 0x10, 0x00,	// LI   R1,>1000
+	0x02, 0x02, 0x10, 0x80,	// LI   R2,>1080
+	0x02, 0x03, 0x00, 0x80,	// LI   R3,>0080
+	0xd1, 0x71,		// MOVB *R1+,R5
+	0xb1, 0x40,		// AB   R0,R5
+	0xdc, 0x85,		// MOVB R5,*R2+
+	0x28, 0x05,		// XOR  R5,R0
+	0x06, 0x03,		// DEC  R3
+	0x16, 0xfa,		// JNE  >2012
+	0x06, 0x04,		// DEC  R4
+	0x16, 0xf2,		// JNE  >2006
+	0xd8, 0x00, 0x12, 0x00,	// MOVB R0,@>1200
+	0xd8, 0x00, 0x13, 0x00,	// MOVB R0,@>1300	; stop
+	0x10, 0xff,		// JMP  $
+};
+
+static void set_start(uint8* ram, uint32 addr)
+{
+	// workspace in the internal ram
+	ram[0x0000] = 0xf0;
+	ram[0x0001] = 0x00;
+	ram[0x0002] = (addr >> 8) & 0xff;
+	ram[0x0003] = addr & 0xff;
+}
+#elif defined(BENCH_I86) || defined(BENCH_I386)
+#if defined(BENCH_I86)
+#include "vm/i86.h"
+#define CPU_CLASS	I86
+#define CPU_NAME	"I86"
+#define GOLDEN_CLOCKS	1838637
+#define GOLDEN_OPECODES	197639
+#else
+#include "vm/i386.h"
+#define CPU_CLASS	I386
+#define CPU_NAME	"I386"
+#define GOLDEN_CLOCKS	757012
+#define GOLDEN_OPECODES	197639
+#endif
+#define CPU_HAS_IO
+#define CPU_HAS_INTR
+// the reset address of i386 is also in the last 16 bytes of 1mb
+#define ADDR_MASK	0xfffff
+
+static const uint8 program[] = {
+	0x31, 0xc0,		// XOR  AX,AX
+	0x8e, 0xd8,		// MOV  DS,AX
+	0x31, 0xdb,		// XOR  BX,BX		; sum
+	0xba, 0x00, 0x01,	// MOV  DX,0100h	; 256 loops
+	0xbe, 0x00, 0x10,	// MOV  SI,1000h
+	0xb9, 0x80, 0x00,	// MOV  CX,0080h
+	0x8a, 0x04,		// MOV  AL,[SI]
+	0x00, 0xd8,		// ADD  AL,BL
+	0x88, 0x84, 0x80, 0x00,	// MOV  [SI+0080h],AL
+	0x30, 0xc3,		// XOR  BL,AL
+	0x46,			// INC  SI
+	0xe2, 0xf3,		// LOOP 200Fh
+	0x4a,			// DEC  DX
+	0x75, 0xea,		// JNZ  2009h
+	0x88, 0x1e, 0x00, 0x12,	// MOV  [1200h],BL
+	0x88, 0x1e, 0x00, 0x13,	// MOV  [1300h],BL	; stop
+	0xeb, 0xfe,		// JMP  $
+};
+
+static void set_start(uint8* ram, uint32 addr)
+{
+	ram[0xffff0] = 0xea;	// JMP  0000:addr
+	ram[0xffff1] = addr & 0xff;
+	ram[0xffff2] = (addr >> 8) & 0xff;
+	ram[0xffff3] = 0x00;
+	ram[0xffff4] = 0x00;
+}
+
+#if defined(BENCH_I386)
+#define CPU_HAS_PAGING
+#define PAGING_ADDR	0x3000
+#define PAGE_DIR	0x4000
+#define PAGE_TABLE	0x5000
+
+// enter protected mode with paging (the first 1mb is mapped to the same address),
+// and run the workload in the 16bit code segment after its opecodes to clear ds
+static const uint8 paging_program[] = {
+	0xfa,				// 3000: CLI
+	0x0f, 0x01, 0x16, 0x40, 0x30,	// 3001: LGDT [3040h]
+	0x66, 0xb8, 0x00, 0x40, 0x00, 0x00,	// 3006: MOV  EAX,00004000h
+	0x0f, 0x22, 0xd8,		// 300C: MOV  CR3,EAX
+	0x0f, 0x20, 0xc0,		// 300F: MOV  EAX,CR0
+	0x66, 0x0d, 0x01, 0x00, 0x00, 0x80,	// 3012: OR   EAX,80000001h
+	0x0f, 0x22, 0xc0,		// 3018: MOV  CR0,EAX
+	0xea, 0x20, 0x30, 0x08, 0x00,	// 301B: JMP  0008:3020h
+	0xb8, 0x10, 0x00,		// 3020: MOV  AX,0010h
+	0x8e, 0xd8,			// 3023: MOV  DS,AX
+	0x8e, 0xc0,			// 3025: MOV  ES,AX
+	0x8e, 0xd0,			// 3027: MOV  SS,AX
+	0xe9, 0xd8, 0xef,		// 3029: JMP  2004h
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00,
+	0x17, 0x00, 0x48, 0x30, 0x00, 0x00,	// 3040: gdt limit and base
+	0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,	// 3048: null
+	0xff, 0xff, 0x00, 0x00, 0x00, 0x9a, 0x00, 0x00,	// 3050: 16bit code, base 0
+	0xff, 0xff, 0x00, 0x00, 0x00, 0x92, 0x00, 0x00,	// 3058: 16bit data, base 0
+};
+
+static void set_paging(uint8* ram)
+{
+	memcpy(ram + PAGING_ADDR, paging_program, sizeof(paging_program));
+	// present, writable and user pages
+	ram[PAGE_DIR + 0] = (PAGE_TABLE & 0xff) | 7;
+	ram[PAGE_DIR + 1] = PAGE_TABLE >> 8;
+	for(int i = 0; i < 256; i++) {
+		ram[PAGE_TABLE + i * 4 + 0] = 7;
+		ram[PAGE_TABLE + i * 4 + 1] = (i << 4) & 0xff;
+		ram[PAGE_TABLE + i * 4 + 2] = i >> 4;
+	}
+	set_start(ram, PAGING_ADDR);
+}
+#endif
+#else
+#error "define one of BENCH_Z80, BENCH_I8080, BENCH_M6502, BENCH_MC6800, BENCH_MC6809, BENCH_UPD7801, BENCH_TMS9995, BENCH_I86, BENCH_I386 and BENCH_HUC6280"
+#endif
+
+#ifdef CPU_HAS_CPM
+// bdos: function 2 (console output) and 9 (print string) to i/o port 1
+static const uint8 bdos[] = {
+	0x79,			// F000: MOV  A,C
+	0xfe, 0x02,		// F001: CPI  2
+	0xca, 0x10, 0xf0,	// F003: JZ   F010h
+	0xfe, 0x09,		// F006: CPI  9
+	0xca, 0x20, 0xf0,	// F008: JZ   F020h
+	0xc9,			// F00B: RET
+	0x00, 0x00, 0x00, 0x00,
+	0x7b,			// F010: MOV  A,E
+	0xd3, 0x01,		// F011: OUT  1
+	0xc9,			// F013: RET
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x1a,			// F020: LDAX D
+	0xfe, 0x24,		// F021: CPI  '$'
+	0xc8,			// F023: RZ
+	0xd3, 0x01,		// F024: OUT  1
+	0x13,			// F026: INX  D
+	0xc3, 0x20, 0xf0,	// F027: JMP  F020h
+};
+#endif
+
+// ----------------------------------------------------------------------------
+// flat ram and dummy i/o
+// ----------------------------------------------------------------------------
+
+class BENCH_BUS : public DEVICE
+{
+private:
+	uint8* ram;
+	uint32 trap_addr;
+	uint8** rbank;
+	uint8** wbank;
+
+public:
+	BENCH_BUS(VM* parent_vm, EMU* parent_emu) : DEVICE(parent_vm, parent_emu) {
+		ram = (uint8*)calloc(ADDR_MASK + 1, 1);
+		trap_addr = 0xffffffff;
+		rbank = wbank = NULL;
+		stopped = cpm = paging = false;
+	}
+	~BENCH_BUS() {
+		free(ram);
+		if(rbank) {
+			free(rbank);
+			free(wbank);
+		}
+	}
+	
+	// 2kb banks, the bank to stop the workload is accessed by write_data8
+	void set_bank() {
+		int count = (ADDR_MASK + 1) >> 11;
+		rbank = (uint8**)malloc(count * sizeof(uint8*));
+		wbank = (uint8**)malloc(count * sizeof(uint8*));
+		for(int i = 0; i < count; i++) {
+			rbank[i] = wbank[i] = ram + (i << 11);
+		}
+		wbank[DATA_STOP >> 11] = NULL;
+	}
+	uint8** get_read_bank_table(int* shift) {
+		*shift = 11;
+		return rbank;
+	}
+	uint8** get_write_bank_table(int* shift) {
+		*shift = 11;
+		return wbank;
+	}
+	uint32 get_bank_table_addr_mask() {
+		return ADDR_MASK;
+	}
+	
+	void write_data8(uint32 addr, uint32 data) {
+		addr &= ADDR_MASK;
+		ram[addr] = data;
+		if(addr == DATA_STOP && !cpm && trap_addr == 0xffffffff) {
+			stopped = true;
+		}
+	}
+	uint32 read_data8(uint32 addr) {
+		return ram[addr & ADDR_MASK];
+	}
+	void write_data16(uint32 addr, uint32 data) {
+		write_data8(addr, data & 0xff);
+		write_data8(addr + 1, data >> 8);
+	}
+	uint32 read_data16(uint32 addr) {
+		return ram[addr & ADDR_MASK] | (ram[(addr + 1) & ADDR_MASK] << 8);
+	}
+	void write_data32(uint32 addr, uint32 data) {
+		write_data16(addr, data & 0xffff);
+		write_data16(addr + 2, data >> 16);
+	}
+	uint32 read_data32(uint32 addr) {
+		return read_data16(addr) | (read_data16(addr + 2) << 16);
+	}
+	void write_io8(uint32 addr, uint32 data) {
+		if(cpm) {
+			if((addr & 0xff) == 0x01) {
+				putchar(data & 0xff);
+				fflush(stdout);
+			}
+			else if((addr & 0xff) == 0xff) {
+				stopped = true;
+			}
+		}
+	}
+	uint32 read_io8(uint32 addr) {
+		return 0xff;
+	}
+	uint32 intr_ack() {
+		return 0xff;
+	}
+	
+	void load_workload() {
+		memset(ram, 0, ADDR_MASK + 1);
+		for(int i = 0; i < DATA_SIZE; i++) {
+			ram[DATA_SRC + i] = (uint8)(i * 37 + 11);
+		}
+		memcpy(ram + CODE_ADDR, program, sizeof(program));
+		set_start(ram, CODE_ADDR);
+#ifdef CPU_HAS_PAGING
+		if(paging) {
+			set_paging(ram);
+		}
+#endif
+		stopped = false;
+	}
+	bool load_binary(const char* path, uint32 addr, uint32 start) {
+		FILE* fp = fopen(path, "rb");
+		if(fp == NULL) {
+			return false;
+		}
+		memset(ram, 0, ADDR_MASK + 1);
+		fread(ram + (addr & ADDR_MASK), 1, ADDR_MASK + 1 - (addr & ADDR_MASK), fp);
+		fclose(fp);
+#ifdef CPU_HAS_CPM
+		if(cpm) {
+			// the warm boot is set after the first jump
+			memcpy(ram + 0xf000, bdos, sizeof(bdos));
+			ram[0x0005] = 0xc3;
+			ram[0x0006] = 0x00;
+			ram[0x0007] = 0xf0;
+		}
+#endif
+		set_start(ram, start);
+		stopped = false;
+		return true;
+	}
+	void set_warm_boot() {
+		ram[0x0000] = 0xd3;	// OUT  0FFh
+		ram[0x0001] = 0xff;
+		ram[0x0002] = 0x76;	// HLT
+	}
+	void set_trap(uint32 addr) {
+		trap_addr = addr;
+	}
+	bool check_trap(uint32 pc) {
+		if(pc == trap_addr) {
+			stopped = true;
+		}
+		return stopped;
+	}
+	uint8 get_result() {
+		return ram[DATA_RESULT];
+	}
+	uint32 get_dst_crc() {
+		return getcrc32(ram + DATA_DST, DATA_SIZE);
+	}
+	bool stopped, cpm, paging;
+};
+
+// minimum virtual machine to link the devices
+VM::VM(EMU* parent_emu) : emu(parent_emu)
+{
+	first_device = last_device = NULL;
+}
+
+VM::~VM()
+{
+	for(DEVICE* device = first_device; device;) {
+		DEVICE *next_device = device->next_device;
+		device->release();
+		delete device;
+		device = next_device;
+	}
+}
+
+// some cores report the undefined opecodes
+void EMU::out_debug(const _TCHAR* format, ...)
+{
+	va_list ap;
+	va_start(ap, format);
+	vfprintf(stderr, format, ap);
+	va_end(ap);
+}
+
+// ----------------------------------------------------------------------------
+// main
+// ----------------------------------------------------------------------------
+
+static double get_host_sec()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec / 1000000000.0;
+}
+
+static void usage(const char* name)
+{
+	fprintf(stderr, "usage: %s [options]\n", name);
+	fprintf(stderr, "  -bin <file>[:<addr>]  run the binary instead of the built-in workload\n");
+	fprintf(stderr, "  -start <addr>         start address of the binary\n");
+	fprintf(stderr, "  -trap <addr>          stop when the cpu reaches the address\n");
+#ifdef CPU_HAS_CPM
+	fprintf(stderr, "  -cpm                  run the cp/m program\n");
+#endif
+	fprintf(stderr, "  -bank                 export the ram as the bank tables\n");
+#ifdef CPU_HAS_PAGING
+	fprintf(stderr, "  -paging               run the workload with paging\n");
+#endif
+}
+
+int main(int argc, char* argv[])
+{
+	const char* bin_path = NULL;
+	uint32 bin_addr = 0xffffffff, start_addr = 0xffffffff, trap_addr = 0xffffffff;
+	bool cpm = false, bank = false, paging = false;
+	
+	for(int i = 1; i < argc; i++) {
+		bool has_value = (i + 1 < argc);
+		if(strcmp(argv[i], "-bin") == 0 && has_value) {
+			char* value = argv[++i];
+			char* sep = strrchr(value, ':');
+			if(sep != NULL) {
+				*sep = '\0';
+				bin_addr = strtoul(sep + 1, NULL, 0);
+			}
+			bin_path = value;
+		}
+		else if(strcmp(argv[i], "-start") == 0 && has_value) {
+			start_addr = strtoul(argv[++i], NULL, 0);
+		}
+		else if(strcmp(argv[i], "-trap") == 0 && has_value) {
+			trap_addr = strtoul(argv[++i], NULL, 0);
+		}
+#ifdef CPU_HAS_CPM
+		else if(strcmp(argv[i], "-cpm") == 0) {
+			cpm = true;
+		}
+#endif
+		else if(strcmp(argv[i], "-bank") == 0) {
+			bank = true;
+		}
+#ifdef CPU_HAS_PAGING
+		else if(strcmp(argv[i], "-paging") == 0) {
+			paging = true;
+		}
+#endif
+		else {
+			usage(argv[0]);
+			return 1;
+		}
+	}
+	
+	VM* vm = new VM(NULL);
+	BENCH_BUS* bus = new BENCH_BUS(vm, NULL);
+	CPU_CLASS* cpu = new CPU_CLASS(vm, NULL);
+	if(bank) {
+		bus->set_bank();
+	}
+	bus->paging = paging;
+	cpu->set_context_mem(bus);
+#ifdef CPU_HAS_IO
+	cpu->set_context_io(bus);
+#endif
+#ifdef CPU_HAS_INTR
+	cpu->set_context_intr(bus);
+#endif
+	cpu->initialize();
+	
+	if(bin_path != NULL) {
+		// run the instruction exerciser
+		if(bin_addr == 0xffffffff) {
+			bin_addr = cpm ? 0x100 : 0;
+		}
+		if(start_addr == 0xffffffff) {
+			start_addr = bin_addr;
+		}
+		bus->cpm = cpm;
+		bus->set_trap(trap_addr);
+		if(!bus->load_binary(bin_path, bin_addr, start_addr)) {
+			fprintf(stderr, "cannot open %s\n", bin_path);
+			delete vm;
+			return 1;
+		}
+		cpu->reset();
+		
+		double start_time = get_host_sec();
+		uint64 clocks = 0, opecodes = 0;
+		while(!bus->stopped && clocks < MAX_CLOCKS) {
+			clocks += cpu->run(-1);
+			if(opecodes++ == 0 && cpm) {
+				bus->set_warm_boot();
+			}
+			bus->check_trap(cpu->get_pc());
+		}
+		double passed_sec = get_host_sec() - start_time;
+		
+		printf("\n%s: %s after %llu clocks, %llu opecodes, pc=%x (%.3f sec)\n", CPU_NAME,
+			bus->stopped ? "stopped" : "timeout", clocks, opecodes, cpu->get_pc(), passed_sec);
+		delete vm;
+		return bus->stopped ? 0 : 1;
+	}
+	
+	// count the clocks and opecodes of the workload
+	bus->load_workload();
+	cpu->reset();
+	uint64 clocks = 0, opecodes = 0;
+	while(!bus->stopped && clocks < MAX_CLOCKS) {
+		clocks += cpu->run(-1);
+		opecodes++;
+	}
+	
+	// expected result
+	uint8 src[DATA_SIZE], dst[DATA_SIZE], sum = 0;
+	for(int i = 0; i < DATA_SIZE; i++) {
+		src[i] = (uint8)(i * 37 + 11);
+	}
+	for(int n = 0; n < DATA_LOOPS; n++) {
+		for(int i = 0; i < DATA_SIZE; i++) {
+			dst[i] = src[i] + sum;
+			sum ^= dst[i];
+		}
+	}
+	bool result_ok = bus->stopped && bus->get_result() == sum && bus->get_dst_crc() == getcrc32(dst, DATA_SIZE);
+	// the golden values are for the workload without paging
+	bool golden_ok = paging || (clocks == GOLDEN_CLOCKS && opecodes == GOLDEN_OPECODES);
+#ifdef CPU_HAS_PAGING
+	uint64 tlb_hit, tlb_miss;
+	cpu->get_tlb_count(&tlb_hit, &tlb_miss);
+#endif
+	
+	// run the workload repeatedly in the same way as the event manager
+	int passes = 0;
+	double passed_sec = 0;
+	while(passed_sec < BENCH_SEC) {
+		bus->load_workload();
+		cpu->reset();
+		double start_time = get_host_sec();
+		while(!bus->stopped) {
+			cpu->run(RUN_CLOCKS);
+		}
+		passed_sec += get_host_sec() - start_time;
+		passes++;
+	}
+	double mips = (double)opecodes * passes / passed_sec / 1000000.0;
+	
+	printf("%-8s clocks=%llu opecodes=%llu result=%02x (expected %02x) %s, golden %s\n", CPU_NAME, clocks, opecodes,
+		bus->get_result(), sum, result_ok ? "ok" : "NG", paging ? "skipped" : golden_ok ? "ok" : "NG");
+	printf("%-8s %.2f MIPS, %.2f nsec/opecode\n", CPU_NAME, mips, 1000.0 / mips);
+#ifdef CPU_HAS_PAGING
+	if(paging) {
+		printf("%-8s tlb hit=%llu miss=%llu (%.2f%%)\n", CPU_NAME, tlb_hit, tlb_miss,
+			(tlb_hit + tlb_miss) ? 100.0 * tlb_hit / (tlb_hit + tlb_miss) : 0.0);
+	}
+#endif
+	
+	delete vm;
+	return (result_ok && golden_ok) ? 0 : 1;
+}
@@ -0,0 +1,257 @@
+/*
+	Skelton for retropc emulator
+
+	Author : Takeda.Toshiya
+	Date   : 2013.03.01-
+
+	[ multi cpu synchronization benchmark ]
+
+	runs two Z80s connected by a pair of i8255s as the PC-8801 and the
+	PC-80S31K are, and measures the emulation speed and the handshakes
+	per emulated second for each quantum of EVENT::drive(). the main cpu
+	sends a byte with a 4 phase handshake and the sub cpu returns it
+	transformed, so every returned byte is checked. "fixed" runs without
+	the sync points of the i8255s, and "adaptive" runs with them.
+
+	build with the headless host definitions, for example:
+	g++ -O2 -D_FC100 -D_HEADLESS -fno-operator-names -fpermissive -I../../src \
+	    cpu_sync_bench.cpp ../../src/vm/event.cpp \
+	    ../../src/vm/z80.cpp ../../src/vm/i8255.cpp ../../src/config.cpp \
+	    ../../src/fileio.cpp ../../src/common.cpp -o cpu_sync_bench
+*/
+
+#include <time.h>
+#include "config.h"
+#include "vm/vm.h"
+#include "emu.h"
+#include "vm/device.h"
+#include "vm/event.h"
+#include "vm/i8255.h"
+#include "vm/z80.h"
+
+#define BENCH_FRAMES	300
+#define BENCH_CLOCKS	3993600
+
+static double get_host_sec()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec / 1000000000.0;
+}
+
+// main: spins (8006h) times, sends e to the sub cpu, and outputs the returned byte to port 10h
+static const uint8 main_prog[] = {
+	0x31, 0x00, 0xff,		// 0000	ld	sp,0ff00h
+	0x3e, 0x8a,			// 0003	ld	a,8ah
+	0xd3, 0x03,			// 0005	out	(3),a
+	0x1e, 0x00,			// 0007	ld	e,0
+	0xed, 0x4b, 0x06, 0x80,		// 0009	ld	bc,(8006h)
+	0x78,				// 000d	ld	a,b
+	0xb1,				// 000e	or	c
+	0x28, 0x03,			// 000f	jr	z,0014h
+	0x0b,				// 0011	dec	bc
+	0x18, 0xf9,			// 0012	jr	000dh
+	0x7b,				// 0014	ld	a,e
+	0xd3, 0x00,			// 0015	out	(0),a
+	0x3e, 0x01,			// 0017	ld	a,1
+	0xd3, 0x03,			// 0019	out	(3),a		; dav = 1
+	0xdb, 0x02,			// 001b	in	a,(2)
+	0xcb, 0x67,			// 001d	bit	4,a
+	0x28, 0xfa,			// 001f	jr	z,001bh		; wait ack = 1
+	0xdb, 0x01,			// 0021	in	a,(1)
+	0xd3, 0x10,			// 0023	out	(10h),a
+	0x3e, 0x00,			// 0025	ld	a,0
+	0xd3, 0x03,			// 0027	out	(3),a		; dav = 0
+	0xdb, 0x02,			// 0029	in	a,(2)
+	0xcb, 0x67,			// 002b	bit	4,a
+	0x20, 0xfa,			// 002d	jr	nz,0029h	; wait ack = 0
+	0x1c,				// 002f	inc	e
+	0x18, 0xd7,			// 0030	jr	0009h
+};
+
+// sub: returns (rlca(data) xor 5ah) for each byte
+static const uint8 sub_prog[] = {
+	0x31, 0x00, 0xff,		// 0000	ld	sp,0ff00h
+	0x3e, 0x8a,			// 0003	ld	a,8ah
+	0xd3, 0x03,			// 0005	out	(3),a
+	0xdb, 0x02,			// 0007	in	a,(2)
+	0xcb, 0x67,			// 0009	bit	4,a
+	0x28, 0xfa,			// 000b	jr	z,0007h		; wait dav = 1
+	0xdb, 0x01,			// 000d	in	a,(1)
+	0x07,				// 000f	rlca
+	0xee, 0x5a,			// 0010	xor	5ah
+	0xd3, 0x00,			// 0012	out	(0),a
+	0x3e, 0x01,			// 0014	ld	a,1
+	0xd3, 0x03,			// 0016	out	(3),a		; ack = 1
+	0xdb, 0x02,			// 0018	in	a,(2)
+	0xcb, 0x67,			// 001a	bit	4,a
+	0x20, 0xfa,			// 001c	jr	nz,0018h	; wait dav = 0
+	0x3e, 0x00,			// 001e	ld	a,0
+	0xd3, 0x03,			// 0020	out	(3),a		; ack = 0
+	0x18, 0xe3,			// 0022	jr	0007h
+};
+
+// flat ram, and the i8255 at port 0-3
+class BENCH_BUS : public DEVICE
+{
+private:
+	uint8 ram[0x10000];
+	DEVICE* d_pio;
+
+public:
+	BENCH_BUS(VM* parent_vm, EMU* parent_emu) : DEVICE(parent_vm, parent_emu) {
+		rounds = errors = 0;
+	}
+	~BENCH_BUS() {}
+	
+	void start(const uint8* prog, int size, int spin) {
+		memset(ram, 0, sizeof(ram));
+		memcpy(ram, prog, size);
+		ram[0x8006] = spin & 0xff;
+		ram[0x8007] = spin >> 8;
+	}
+	void write_data8(uint32 addr, uint32 data) {
+		ram[addr & 0xffff] = data;
+	}
+	uint32 read_data8(uint32 addr) {
+		return ram[addr & 0xffff];
+	}
+	void write_io8(uint32 addr, uint32 data) {
+		if((addr & 0xff) == 0x10) {
+			// check the returned byte
+			uint8 e = rounds & 0xff;
+			if(data != ((((e << 1) | (e >> 7)) ^ 0x5a) & 0xff)) {
+				errors++;
+			}
+			rounds++;
+		}
+		else {
+			d_pio->write_io8(addr & 3, data);
+		}
+	}
+	uint32 read_io8(uint32 addr) {
+		return d_pio->read_io8(addr & 3);
+	}
+	uint32 intr_ack() {
+		return 0xff;
+	}
+	void set_context_pio(DEVICE* device) {
+		d_pio = device;
+	}
+	int rounds, errors;
+};
+
+// minimum virtual machine that has the event manager and two cpus
+VM::VM(EMU* parent_emu) : emu(parent_emu)
+{
+	first_device = last_device = NULL;
+	dummy = new DEVICE(this, emu);	// must be 1st device
+	event = new EVENT(this, emu);	// must be 2nd device
+}
+
+VM::~VM()
+{
+	for(DEVICE* device = first_device; device;) {
+		DEVICE *next_device = device->next_device;
+		device->release();
+		delete device;
+		device = next_device;
+	}
+}
+
+DEVICE* VM::get_device(int id)
+{
+	for(DEVICE* device = first_device; device; device = device->next_device) {
+		if(device->this_device_id == id) {
+			return device;
+		}
+	}
+	return NULL;
+}
+
+typedef struct {
+	double fps;
+	double rounds_per_sec;
+	int errors;
+} result_t;
+
+static result_t bench(int quantum, bool sync_point, int spin)
+{
+	config.cpu_quantum = quantum;
+	
+	VM* vm = new VM(NULL);
+	EVENT* event = (EVENT*)vm->get_device(1);
+	BENCH_BUS* main_bus = new BENCH_BUS(vm, NULL);
+	BENCH_BUS* sub_bus = new BENCH_BUS(vm, NULL);
+	I8255* main_pio = new I8255(vm, NULL);
+	I8255* sub_pio = new I8255(vm, NULL);
+	Z80* main_cpu = new Z80(vm, NULL);
+	Z80* sub_cpu = new Z80(vm, NULL);
+	
+	event->set_context_cpu(main_cpu, BENCH_CLOCKS);
+	event->set_context_cpu(sub_cpu, BENCH_CLOCKS);
+	
+	main_pio->set_context_port_a(sub_pio, SIG_I8255_PORT_B, 0xff, 0);
+	main_pio->set_context_port_b(sub_pio, SIG_I8255_PORT_A, 0xff, 0);
+	main_pio->set_context_port_c(sub_pio, SIG_I8255_PORT_C, 0x0f, 4);
+	main_pio->set_context_port_c(sub_pio, SIG_I8255_PORT_C, 0xf0, -4);
+	main_pio->sync_cpus_by_output = sync_point;
+	sub_pio->set_context_port_a(main_pio, SIG_I8255_PORT_B, 0xff, 0);
+	sub_pio->set_context_port_b(main_pio, SIG_I8255_PORT_A, 0xff, 0);
+	sub_pio->set_context_port_c(main_pio, SIG_I8255_PORT_C, 0x0f, 4);
+	sub_pio->set_context_port_c(main_pio, SIG_I8255_PORT_C, 0xf0, -4);
+	sub_pio->sync_cpus_by_output = sync_point;
+	
+	main_bus->set_context_pio(main_pio);
+	main_cpu->set_context_mem(main_bus);
+	main_cpu->set_context_io(main_bus);
+	main_cpu->set_context_intr(main_bus);
+	sub_bus->set_context_pio(sub_pio);
+	sub_cpu->set_context_mem(sub_bus);
+	sub_cpu->set_context_io(sub_bus);
+	sub_cpu->set_context_intr(sub_bus);
+	
+	for(DEVICE* device = vm->first_device; device; device = device->next_device) {
+		device->initialize();
+	}
+	event->initialize_sound(48000, 4800);
+	for(DEVICE* device = vm->first_device; device; device = device->next_device) {
+		device->reset();
+	}
+	main_bus->start(main_prog, sizeof(main_prog), spin);
+	sub_bus->start(sub_prog, sizeof(sub_prog), 0);
+	
+	double start_time = get_host_sec();
+	for(int i = 0; i < BENCH_FRAMES; i++) {
+		event->drive();
+	}
+	double passed_sec = get_host_sec() - start_time;
+	
+	result_t result;
+	result.fps = (double)BENCH_FRAMES / passed_sec;
+	result.rounds_per_sec = (double)main_bus->rounds * event->frame_rate() / BENCH_FRAMES;
+	result.errors = main_bus->errors;
+	delete vm;
+	return result;
+}
+
+int main(int argc, char* argv[])
+{
+	static const int quanta[6] = {4, 16, 64, 256, 1024, 4096};
+	static const int spins[2] = {0, 300};
+	int errors = 0;
+	
+	init_config();
+	for(int s = 0; s < 2; s++) {
+		printf("%s (spin %d between handshakes)\n", spins[s] ? "sparse handshakes" : "dense handshakes", spins[s]);
+		printf("quantum     fixed: fps   handshakes/s    adaptive: fps   handshakes/s\n");
+		for(int q = 0; q < 6; q++) {
+			result_t fixed = bench(quanta[q], false, spins[s]);
+			result_t adaptive = bench(quanta[q], true, spins[s]);
+			printf("%7d  %12.1f %14.0f  %15.1f %14.0f\n", quanta[q], fixed.fps, fixed.rounds_per_sec, adaptive.fps, adaptive.rounds_per_sec);
+			errors += fixed.errors + adaptive.errors;
+		}
+	}
+	printf("%d errors in the returned bytes\n", errors);
+	return errors ? 1 : 0;
+}
@@ -0,0 +1,139 @@
+/*
+	Skelton for retropc emulator
+
+	Author : Takeda.Toshiya
+	Date   : 2013.03.01-
+
+	[ event manager micro benchmark ]
+
+	measures how many events EVENT::drive() dispatches per second with
+	8, 32 and 64 live events (3/4 are loop events and 1/4 are one-shot
+	events re-registered in the callback).
+
+	build with the headless host definitions, for example:
+	g++ -O2 -D_FC100 -D_HEADLESS -fno-operator-names -fpermissive -I../../src \
+	    event_bench.cpp ../../src/vm/event.cpp \
+	    ../../src/config.cpp ../../src/fileio.cpp ../../src/common.cpp -o event_bench
+*/
+
+#include <time.h>
+#include "config.h"
+#include "vm/vm.h"
+#include "emu.h"
+#include "vm/device.h"
+#include "vm/event.h"
+
+#define BENCH_FRAMES	2000
+
+static double get_host_sec()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec / 1000000000.0;
+}
+
+// cpu that runs 16 clocks per opecode
+class BENCH_CPU : public DEVICE
+{
+public:
+	BENCH_CPU(VM* parent_vm, EMU* parent_emu) : DEVICE(parent_vm, parent_emu) {}
+	~BENCH_CPU() {}
+	
+	int run(int clock) {
+		return (clock == -1) ? 16 : clock;
+	}
+};
+
+// device that counts the fired events
+class BENCH_DEVICE : public DEVICE
+{
+private:
+	int period[MAX_EVENT];
+
+public:
+	BENCH_DEVICE(VM* parent_vm, EMU* parent_emu) : DEVICE(parent_vm, parent_emu) {
+		fired = 0;
+	}
+	~BENCH_DEVICE() {}
+	
+	void start(int count) {
+		for(int i = 0; i < count; i++) {
+			period[i] = 64 + (i * 37) % 512;
+			register_event_by_clock(this, i, period[i], (i & 3) != 3, NULL);
+		}
+	}
+	void event_callback(int event_id, int err) {
+		if((event_id & 3) == 3) {
+			register_event_by_clock(this, event_id, period[event_id], false, NULL);
+		}
+		fired++;
+	}
+	int fired;
+};
+
+// minimum virtual machine that has only the event manager
+VM::VM(EMU* parent_emu) : emu(parent_emu)
+{
+	first_device = last_device = NULL;
+	dummy = new DEVICE(this, emu);	// must be 1st device
+	event = new EVENT(this, emu);	// must be 2nd device
+}
+
+VM::~VM()
+{
+	for(DEVICE* device = first_device; device;) {
+		DEVICE *next_device = device->next_device;
+		device->release();
+		delete device;
+		device = next_device;
+	}
+}
+
+DEVICE* VM::get_device(int id)
+{
+	for(DEVICE* device = first_device; device; device = device->next_device) {
+		if(device->this_device_id == id) {
+			return device;
+		}
+	}
+	return NULL;
+}
+
+static double bench(int count)
+{
+	VM* vm = new VM(NULL);
+	EVENT* event = (EVENT*)vm->get_device(1);
+	BENCH_CPU* cpu = new BENCH_CPU(vm, NULL);
+	BENCH_DEVICE* dev = new BENCH_DEVICE(vm, NULL);
+	
+	event->set_context_cpu(cpu);
+	for(DEVICE* device = vm->first_device; device; device = device->next_device) {
+		device->initialize();
+	}
+	event->initialize_sound(48000, 4800);
+	event->reset();
+	dev->start(count);
+	
+	double start_time = get_host_sec();
+	for(int i = 0; i < BENCH_FRAMES; i++) {
+		event->drive();
+	}
+	double passed_sec = get_host_sec() - start_time;
+	
+	double result = (double)dev->fired / passed_sec;
+	delete vm;
+	return result;
+}
+
+int main(int argc, char* argv[])
+{
+	static const int counts[3] = {8, 32, 64};
+	
+	init_config();
+	for(int i = 0; i < 3; i++) {
+		// keep one slot for the safety
+		int count = (counts[i] < MAX_EVENT) ? counts[i] : MAX_EVENT;
+		printf("%2d live events: %8.2f M events/sec\n", count, bench(count) / 1000000.0);
+	}
+	return 0;
+}
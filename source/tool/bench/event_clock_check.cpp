@@ -0,0 +1,269 @@
+/*
+	Skelton for retropc emulator
+
+	Author : Takeda.Toshiya
+	Date   : 2013.03.01-
+
+	[ event clock check in the cpu run ]
+
+	runs a Z80 that reads the counter 0 of i8253 in a loop, and is
+	interrupted by the output of the counter. the isr reprograms the counter,
+	so the events of i8253 are registered from the i/o in the cpu run.
+	the port writes are logged with current_clock(), and the log of the cpu
+	run until the next event is compared with the log of the cpu run one
+	opecode at a time by set_fine_sync(). the run that ignores the clocks
+	passed in the cpu run is also compared, and it must differ.
+
+	build with the headless host definitions, for example:
+	g++ -O2 -D_FC100 -D_HEADLESS -fno-operator-names -fpermissive -I../../src \
+	    event_clock_check.cpp ../../src/vm/event.cpp \
+	    ../../src/vm/z80.cpp ../../src/vm/i8253.cpp ../../src/config.cpp \
+	    ../../src/fileio.cpp ../../src/common.cpp -o event_clock_check
+	add -DZ80_THREADED_DISPATCH to check the chained opecodes of Z80.
+*/
+
+#include "config.h"
+#include "vm/vm.h"
+#include "emu.h"
+#include "vm/device.h"
+#include "vm/event.h"
+#include "vm/i8253.h"
+#include "vm/z80.h"
+
+#define CHECK_FRAMES	120
+#define CHECK_CLOCKS	4000000
+#define MAX_LOG		0x40000
+
+#define SIG_CHECK_IRQ	0
+
+typedef struct {
+	uint32 clock[MAX_LOG];
+	uint32 value[MAX_LOG];
+	int count;
+} log_t;
+
+static const uint8 reset_prog[] = {
+	0x31, 0x00, 0xff,		// 0000	ld	sp,0ff00h
+	0xc3, 0x56, 0x00,		// 0003	jp	0056h
+};
+
+static const uint8 main_prog[] = {
+	0xf5,				// 0038	push	af
+	0x3a, 0x00, 0x80,		// 0039	ld	a,(8000h)
+	0x3c,				// 003c	inc	a
+	0x32, 0x00, 0x80,		// 003d	ld	(8000h),a
+	0xd3, 0x11,			// 0040	out	(11h),a
+	0xe6, 0x03,			// 0042	and	3
+	0x20, 0x0c,			// 0044	jr	nz,0052h
+	0x3e, 0x34,			// 0046	ld	a,34h
+	0xd3, 0x43,			// 0048	out	(43h),a		; reprogram the counter 0
+	0x3e, 0xbc,			// 004a	ld	a,0bch
+	0xd3, 0x40,			// 004c	out	(40h),a
+	0x3e, 0x02,			// 004e	ld	a,02h
+	0xd3, 0x40,			// 0050	out	(40h),a		; count 700
+	0xf1,				// 0052	pop	af
+	0xfb,				// 0053	ei
+	0xed, 0x4d,			// 0054	reti
+	0x3e, 0x34,			// 0056	ld	a,34h
+	0xd3, 0x43,			// 0058	out	(43h),a		; counter 0, mode 2
+	0x3e, 0xe8,			// 005a	ld	a,0e8h
+	0xd3, 0x40,			// 005c	out	(40h),a
+	0x3e, 0x03,			// 005e	ld	a,03h
+	0xd3, 0x40,			// 0060	out	(40h),a		; count 1000
+	0xed, 0x56,			// 0062	im	1
+	0xfb,				// 0064	ei
+	0x0e, 0x00,			// 0065	ld	c,0
+	0x3e, 0x00,			// 0067	ld	a,00h
+	0xd3, 0x43,			// 0069	out	(43h),a		; latch the counter 0
+	0xdb, 0x40,			// 006b	in	a,(40h)
+	0xd3, 0x10,			// 006d	out	(10h),a
+	0xdb, 0x40,			// 006f	in	a,(40h)
+	0xd3, 0x10,			// 0071	out	(10h),a
+	0x0c,				// 0073	inc	c
+	0x79,				// 0074	ld	a,c
+	0xe6, 0x0f,			// 0075	and	0fh
+	0x47,				// 0077	ld	b,a
+	0x04,				// 0078	inc	b
+	0x10, 0xfe,			// 0079	djnz	0079h
+	0x79,				// 007b	ld	a,c
+	0xe6, 0x3f,			// 007c	and	3fh
+	0x20, 0xe7,			// 007e	jr	nz,0067h
+	0x76,				// 0080	halt
+	0x18, 0xe4,			// 0081	jr	0067h
+};
+
+// flat ram, i8253 at port 40h-43h, and the log ports 10h and 11h
+class CHECK_BUS : public DEVICE
+{
+private:
+	uint8 ram[0x10000];
+	DEVICE *d_pit, *d_cpu;
+	log_t* log;
+
+public:
+	CHECK_BUS(VM* parent_vm, EMU* parent_emu, log_t* log_buffer) : DEVICE(parent_vm, parent_emu) {
+		log = log_buffer;
+		log->count = 0;
+		memset(ram, 0, sizeof(ram));
+		memcpy(ram, reset_prog, sizeof(reset_prog));
+		memcpy(ram + 0x38, main_prog, sizeof(main_prog));
+	}
+	~CHECK_BUS() {}
+	
+	void write_data8(uint32 addr, uint32 data) {
+		ram[addr & 0xffff] = data;
+	}
+	uint32 read_data8(uint32 addr) {
+		return ram[addr & 0xffff];
+	}
+	void write_io8(uint32 addr, uint32 data) {
+		if((addr & 0xf0) == 0x40) {
+			d_pit->write_io8(addr & 3, data);
+		}
+		else if(log->count < MAX_LOG) {
+			log->clock[log->count] = current_clock();
+			log->value[log->count++] = ((addr & 0xff) << 8) | (data & 0xff);
+		}
+	}
+	uint32 read_io8(uint32 addr) {
+		return d_pit->read_io8(addr & 3);
+	}
+	void write_signal(int id, uint32 data, uint32 mask) {
+		// the output of counter 0 goes low for one count
+		if(!(data & mask)) {
+			d_cpu->set_intr_line(true, true, 0);
+		}
+	}
+	uint32 intr_ack() {
+		d_cpu->set_intr_line(false, false, 0);
+		return 0xff;
+	}
+	void set_context_pit(DEVICE* device) {
+		d_pit = device;
+	}
+	void set_context_cpu(DEVICE* device) {
+		d_cpu = device;
+	}
+};
+
+// the cpu core before the clocks passed in run() were added to current_clock()
+class STALE_Z80 : public Z80
+{
+public:
+	STALE_Z80(VM* parent_vm, EMU* parent_emu) : Z80(parent_vm, parent_emu) {}
+	int get_run_clock() {
+		return 0;
+	}
+	void stop_run() {}
+};
+
+// minimum virtual machine that has the event manager
+VM::VM(EMU* parent_emu) : emu(parent_emu)
+{
+	first_device = last_device = NULL;
+	dummy = new DEVICE(this, emu);	// must be 1st device
+	event = new EVENT(this, emu);	// must be 2nd device
+}
+
+VM::~VM()
+{
+	for(DEVICE* device = first_device; device;) {
+		DEVICE *next_device = device->next_device;
+		device->release();
+		delete device;
+		device = next_device;
+	}
+}
+
+DEVICE* VM::get_device(int id)
+{
+	for(DEVICE* device = first_device; device; device = device->next_device) {
+		if(device->this_device_id == id) {
+			return device;
+		}
+	}
+	return NULL;
+}
+
+static log_t* run(int mode)
+{
+	// mode 0: one opecode at a time, 1: until the next event, 2: same as 1 with the stale clock
+	VM* vm = new VM(NULL);
+	EVENT* event = (EVENT*)vm->get_device(1);
+	log_t* log = (log_t*)malloc(sizeof(log_t));
+	CHECK_BUS* bus = new CHECK_BUS(vm, NULL, log);
+	I8253* pit = new I8253(vm, NULL);
+	Z80* cpu = (mode == 2) ? new STALE_Z80(vm, NULL) : new Z80(vm, NULL);
+	
+	event->set_context_cpu(cpu, CHECK_CLOCKS);
+	pit->set_context_ch0(bus, SIG_CHECK_IRQ, 1);
+	pit->set_constant_clock(0, 1000000);
+	bus->set_context_pit(pit);
+	bus->set_context_cpu(cpu);
+	cpu->set_context_mem(bus);
+	cpu->set_context_io(bus);
+	cpu->set_context_intr(bus);
+	
+	for(DEVICE* device = vm->first_device; device; device = device->next_device) {
+		device->initialize();
+	}
+	event->initialize_sound(48000, 4800);
+	for(DEVICE* device = vm->first_device; device; device = device->next_device) {
+		device->reset();
+	}
+	if(mode == 0) {
+		event->set_fine_sync(true);
+	}
+	for(int i = 0; i < CHECK_FRAMES; i++) {
+		event->drive();
+	}
+	delete vm;
+	return log;
+}
+
+static int compare(const char* name, log_t* ref, log_t* log)
+{
+	int count = (ref->count < log->count) ? ref->count : log->count;
+	int first = -1, mismatches = 0;
+	
+	for(int i = 0; i < count; i++) {
+		if(ref->clock[i] != log->clock[i] || ref->value[i] != log->value[i]) {
+			if(first < 0) {
+				first = i;
+			}
+			mismatches++;
+		}
+	}
+	mismatches += (ref->count > log->count) ? ref->count - log->count : log->count - ref->count;
+	printf("%-24s %6d writes, %6d mismatches", name, log->count, mismatches);
+	if(first >= 0) {
+		printf(" (first at %d: port %02x=%02x clock %u, expected port %02x=%02x clock %u)",
+			first, log->value[first] >> 8, log->value[first] & 0xff, log->clock[first],
+			ref->value[first] >> 8, ref->value[first] & 0xff, ref->clock[first]);
+	}
+	printf("\n");
+	return mismatches;
+}
+
+int main(int argc, char* argv[])
+{
+	init_config();
+	
+	log_t* ref = run(0);
+	log_t* batch = run(1);
+	log_t* stale = run(2);
+	int irqs = 0;
+	for(int i = 0; i < ref->count; i++) {
+		if((ref->value[i] >> 8) == 0x11) {
+			irqs++;
+		}
+	}
+	printf("one opecode at a time   %6d writes, %d interrupts\n", ref->count, irqs);
+	int errors = compare("until the next event", ref, batch);
+	bool detected = (compare("stale clock (must differ)", ref, stale) != 0);
+	
+	free(ref);
+	free(batch);
+	free(stale);
+	return (errors == 0 && detected && irqs != 0) ? 0 : 1;
+}
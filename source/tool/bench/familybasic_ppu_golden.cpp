@@ -0,0 +1,760 @@
+/*
+	Skelton for retropc emulator
+
+	Author : Takeda.Toshiya
+	Date   : 2013.03.01-
+
+	[ family basic ppu golden output test ]
+
+	drives PPU and the reference renderer below (the per pixel renderer
+	that PPU used before the patterns were expanded 8 pixels at once and
+	the sprites were listed per line) with the same recorded session of
+	pseudo random register, vram, palette, sprite ram and dma writes,
+	and compares the screen and the status register of every frame.
+
+	build with the headless host definitions, for example:
+	g++ -O2 -D_FAMILYBASIC -D_HEADLESS -fno-operator-names -fpermissive \
+	    -I../../src -I../../src/vm/familybasic familybasic_ppu_golden.cpp \
+	    ../../src/vm/familybasic/ppu.cpp ../../src/fileio.cpp \
+	    ../../src/common.cpp -o familybasic_ppu_golden
+*/
+
+#include <time.h>
+#include "vm/vm.h"
+#include "emu.h"
+#include "vm/device.h"
+// the screens are compared in the palette index, before the emphasis is applied
+#define private public
+#include "vm/familybasic/ppu.h"
+#undef private
+
+#define TEST_FRAMES	3000
+
+static inline uint32 next_rand(uint32 r)
+{
+	r ^= r << 13;
+	r ^= r >> 17;
+	r ^= r << 5;
+	return r;
+}
+
+static double get_host_sec()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec / 1000000000.0;
+}
+
+// reference renderer
+class REF_PPU
+{
+private:
+	uint8 solid_buf[512];
+	
+	uint8* banks[16];
+	uint8 name_tables[0x1000];
+	uint8 bg_pal[0x10];
+	uint8 spr_pal[0x10];
+	uint8 spr_ram_rw_ptr;
+	
+	uint8 regs[8];
+	uint16 bg_pattern_table_addr;
+	uint16 spr_pattern_table_addr;
+	uint16 ppu_addr_inc;
+	bool toggle_2005_2006;
+	uint8 read_2007_buffer;
+	
+	uint16 loopy_v;
+	uint16 loopy_t;
+	uint8 loopy_x;
+	
+	void render_scanline(int v);
+	void render_bg(int v);
+	void render_spr(int v);
+
+public:
+	REF_PPU() {
+		nmi_count = 0;
+	}
+	void initialize();
+	void reset();
+	void write_data8(uint32 addr, uint32 data);
+	uint32 read_data8(uint32 addr);
+	void event_vline(int v, int clock);
+	uint8 screen[240][256 + 16];	// 2*8 = side margin
+	uint8 chr_rom[0x2000];
+	uint8 spr_ram[0x100];
+	int nmi_count;
+};
+
+#define VRAM(addr)	banks[((addr) >> 10) & 0x0f][(addr) & 0x3ff]
+
+#define NMI_enabled()	(regs[0] & 0x80)
+#define sprites_8x16()	(regs[0] & 0x20)
+#define spr_enabled()	(regs[1] & 0x10)
+#define bg_enabled()	(regs[1] & 0x08)
+#define spr_clip()	(!(regs[1] & 0x04))
+#define bg_clip()	(!(regs[1] & 0x02))
+#define monochrome()	(regs[1] & 0x01)
+#define sprite0_hit()	(regs[2] & 0x40)
+
+#define LOOPY_SCANLINE_START(v, t) { \
+	v = (v & 0xfbe0) | (t & 0x041f); \
+}
+
+#define LOOPY_NEXT_LINE(v) { \
+	if((v & 0x7000) == 0x7000) { \
+		v &= 0x8fff; \
+		if((v & 0x3e0) == 0x3a0) { \
+			v ^= 0x0800; \
+			v &= 0xfc1f; \
+		} \
+		else { \
+			if((v & 0x3e0) == 0x3e0) { \
+				v &= 0xfc1f; \
+			} \
+			else { \
+				v += 0x20; \
+			} \
+		} \
+	} \
+	else { \
+		v += 0x1000; \
+	} \
+}
+
+#define LOOPY_NEXT_TILE(v) { \
+	if((v & 0x1f) == 0x1f) { \
+		v ^= 0x0400; \
+		v &= 0xffe0; \
+	} \
+	else { \
+		v++; \
+	} \
+}
+
+#define LOOPY_NEXT_PIXEL(v, x) { \
+	if(x == 7) { \
+		LOOPY_NEXT_TILE(v); \
+		x = 0; \
+	} \
+	else { \
+		x++; \
+	} \
+}
+
+void REF_PPU::initialize()
+{
+	// set up PPU memory space table
+	for(int i = 0; i < 8; i++) {
+		banks[i] = chr_rom + 0x400 * i;
+	}
+#if 0
+	if(header[6] & 8) {
+		// 4 screen mirroring
+		banks[ 8] = name_tables;
+		banks[ 9] = name_tables + 0x400;
+		banks[10] = name_tables + 0x800;
+		banks[11] = name_tables + 0xc00;
+	}
+	else if(header[6] & 1) {
+		// vertical mirroring
+		banks[ 8] = banks[10] = name_tables;
+		banks[ 9] = banks[11] = name_tables + 0x400;
+	}
+	else {
+		// horizontal mirroring
+		banks[ 8] = banks[ 9] = name_tables;
+		banks[10] = banks[11] = name_tables + 0x400;
+	}
+#else
+	// family basic must be vertical mirroring
+	banks[ 8] = banks[10] = name_tables;
+	banks[ 9] = banks[11] = name_tables + 0x400;
+#endif
+	banks[12] = banks[ 8];
+	banks[13] = banks[ 9];
+	banks[14] = banks[10];
+	banks[15] = banks[11];
+
+}
+
+void REF_PPU::reset()
+{
+	memset(bg_pal, 0, sizeof(bg_pal));
+	memset(spr_pal, 0, sizeof(spr_pal));
+	memset(solid_buf, 0, sizeof(solid_buf));
+	memset(name_tables, 0, sizeof(name_tables));
+	
+	memset(spr_ram, 0, sizeof(spr_ram));
+	spr_ram_rw_ptr = 0;
+	
+	memset(regs, 0, sizeof(regs));
+	bg_pattern_table_addr = 0;
+	spr_pattern_table_addr = 0;
+	ppu_addr_inc = 0;
+	toggle_2005_2006 = false;
+	read_2007_buffer = 0;
+	
+	loopy_v = 0;
+	loopy_t = 0;
+	loopy_x = 0;
+
+}
+
+void REF_PPU::write_data8(uint32 addr, uint32 data)
+{
+	uint16 ofs;
+	
+	regs[addr & 7] = data;
+	
+	switch(addr & 0xe007) {
+	case 0x2000:
+		bg_pattern_table_addr = (data & 0x10) ? 0x1000 : 0;
+		spr_pattern_table_addr = (data & 0x08) ? 0x1000 : 0;
+		ppu_addr_inc = (data & 0x04) ? 32 : 1;
+		loopy_t = (loopy_t & 0xf3ff) | (((uint16)(data & 0x03)) << 10);
+		break;
+	case 0x2003:
+		spr_ram_rw_ptr = data;
+		break;
+	case 0x2004:
+		spr_ram[spr_ram_rw_ptr++] = data;
+		break;
+	case 0x2005:
+		toggle_2005_2006 = !toggle_2005_2006;
+		if(toggle_2005_2006) {
+			// first write
+			loopy_t = (loopy_t & 0xffe0) | (((uint16)(data & 0xf8)) >> 3);
+			loopy_x = data & 0x07;
+		}
+		else {
+			// second write
+			loopy_t = (loopy_t & 0xfc1f) | (((uint16)(data & 0xf8)) << 2);
+			loopy_t = (loopy_t & 0x8fff) | (((uint16)(data & 0x07)) << 12);
+		}
+		break;
+	case 0x2006:
+		toggle_2005_2006 = !toggle_2005_2006;
+		if(toggle_2005_2006) {
+			// first write
+			loopy_t = (loopy_t & 0x00ff) | (((uint16)(data & 0x3f)) << 8);
+		}
+		else {
+			// second write
+			loopy_t = (loopy_t & 0xff00) | ((uint16)data);
+			loopy_v = loopy_t;
+		}
+		break;
+	case 0x2007:
+		ofs = loopy_v & 0x3fff;
+		loopy_v += ppu_addr_inc;
+		if(ofs >= 0x3000) {
+			// is it a palette entry?
+			if(ofs >= 0x3f00) {
+				data &= 0x3f;
+				if(!(ofs & 0x000f)) {
+					bg_pal[0] = spr_pal[0] = data;
+				}
+				else if(!(ofs & 0x10)) {
+					bg_pal[ofs & 0x000f] = data;
+				}
+				else {
+					spr_pal[ofs & 0x000f] = data;
+				}
+				break;
+			}
+			// handle mirroring
+			ofs &= 0xefff;
+		}
+		if(ofs >= 0x2000) {
+			VRAM(ofs) = data;
+		}
+		break;
+	}
+}
+
+uint32 REF_PPU::read_data8(uint32 addr)
+{
+	uint16 ofs;
+	uint8 val;
+	
+	switch(addr & 0xe007) {
+	case 0x2002:
+		// clear toggle
+		toggle_2005_2006 = false;
+		val = regs[2];
+		// clear v-blank flag
+		regs[2] &= ~0x80;
+		return val;
+	case 0x2007:
+		ofs = loopy_v & 0x3fff;
+		loopy_v += ppu_addr_inc;
+		if(ofs >= 0x3000) {
+			// is it a palette entry?
+			if(ofs >= 0x3f00) {
+				if(!(ofs & 0x0010)) {
+					return bg_pal[ofs & 0x000f];
+				}
+				else {
+					return spr_pal[ofs & 0x000f];
+				}
+			}
+			// handle mirroring
+			ofs &= 0xefff;
+		}
+		val = read_2007_buffer;
+		read_2007_buffer = VRAM(ofs);
+		return val;
+	}
+	return regs[addr & 7];
+}
+
+void REF_PPU::event_vline(int v, int clock)
+{
+	switch(v) {
+	case 0:
+		if(spr_enabled() || bg_enabled()) {
+			loopy_v = loopy_t;
+		}
+		break;
+	case 241:
+		// set vblank register flag
+		regs[2] |= 0x80;
+		if(NMI_enabled()) {
+			nmi_count++;
+		}
+		break;
+	case 261:
+		// reset vblank register flag and sprite0 hit flag1
+		regs[2] &= 0x3F;
+		break;
+	}
+	if(v < 240) {
+		render_scanline(v);
+	}
+}
+
+void REF_PPU::render_scanline(int v)
+{
+	uint8* buf = screen[v];
+	
+	if(!bg_enabled()) {
+		// set to background color
+		memset(screen[v], bg_pal[0], 256 + 16);
+	}
+	if(spr_enabled() || bg_enabled()) {
+		LOOPY_SCANLINE_START(loopy_v, loopy_t);
+		if(bg_enabled()) {
+			render_bg(v);
+		}
+		else {
+			memset(solid_buf, 0, sizeof(solid_buf));
+		}
+		if(spr_enabled()) {
+			// draw sprites
+			render_spr(v);
+		}
+		LOOPY_NEXT_LINE(loopy_v);
+	}
+}
+
+#define BG_WRITTEN_FLAG 1
+#define SPR_WRITTEN_FLAG 2
+
+#define DRAW_BG_PIXEL() \
+	col = attrib_bits; \
+	if(pattern_lo & pattern_mask) { \
+		col |= 1; \
+	} \
+	if(pattern_hi & pattern_mask) { \
+		col |= 2; \
+	} \
+	*p++ = monochrome() ? (bg_pal[col] & 0xf0) : bg_pal[col]; \
+	*solid++ = (col & 3) ? BG_WRITTEN_FLAG : 0; \
+
+void REF_PPU::render_bg(int v)
+{
+	uint32 tile_x = (loopy_v & 0x001f);
+	uint32 tile_y = (loopy_v & 0x03e0) >> 5;
+	uint32 name_addr = 0x2000 + (loopy_v & 0x0fff);
+	uint32 attrib_addr = 0x2000 + (loopy_v & 0x0c00) + 0x03c0 + ((tile_y & 0xfffc) << 1) + (tile_x >> 2);
+	uint8 attrib_bits;
+	
+	if(!(tile_y & 2)) {
+		if(!(tile_x & 2)) {
+			attrib_bits = (VRAM(attrib_addr) & 0x03) << 2;
+		}
+		else {
+			attrib_bits = (VRAM(attrib_addr) & 0x0C);
+		}
+	}
+	else {
+		if(!(tile_x & 2)) {
+			attrib_bits = (VRAM(attrib_addr) & 0x30) >> 2;
+		}
+		else {
+			attrib_bits = (VRAM(attrib_addr) & 0xC0) >> 4;
+		}
+	}
+	uint8 *p = screen[v] + (8 - loopy_x);
+	uint8 *solid = solid_buf + (8 - loopy_x);
+	
+	for(int i = 33; i; i--) {
+		uint32 pattern_addr = bg_pattern_table_addr + ((int32)VRAM(name_addr) << 4) + ((loopy_v & 0x7000) >> 12);
+		uint8 pattern_lo = VRAM(pattern_addr);
+		uint8 pattern_hi = VRAM(pattern_addr + 8);
+		uint8 pattern_mask = 0x80;
+		uint8 col;
+		
+		DRAW_BG_PIXEL();
+		pattern_mask >>= 1;
+		DRAW_BG_PIXEL();
+		pattern_mask >>= 1;
+		DRAW_BG_PIXEL();
+		pattern_mask >>= 1;
+		DRAW_BG_PIXEL();
+		pattern_mask >>= 1;
+		DRAW_BG_PIXEL();
+		pattern_mask >>= 1;
+		DRAW_BG_PIXEL();
+		pattern_mask >>= 1;
+		DRAW_BG_PIXEL();
+		pattern_mask >>= 1;
+		DRAW_BG_PIXEL();
+		
+		tile_x++;
+		name_addr++;
+		
+		if(!(tile_x & 1)) {
+			if(!(tile_x & 3)) {
+				if(!(tile_x & 0x1f)) {
+					name_addr ^= 0x0400; // switch name tables
+					attrib_addr ^= 0x0400;
+					name_addr -= 0x0020;
+					attrib_addr -= 0x0008;
+					tile_x -= 0x0020;
+				}
+				attrib_addr++;
+			}
+			if(!(tile_y & 2)) {
+				if(!(tile_x & 2)) {
+					attrib_bits = (VRAM(attrib_addr) & 0x03) << 2;
+				}
+				else {
+					attrib_bits = (VRAM(attrib_addr) & 0x0c);
+				}
+			}
+			else {
+				if(!(tile_x & 2)) {
+					attrib_bits = (VRAM(attrib_addr) & 0x30) >> 2;
+				}
+				else {
+					attrib_bits = (VRAM(attrib_addr) & 0xc0) >> 4;
+				}
+			}
+		}
+	}
+	if(bg_clip()) {
+		memset(&screen[v][8], bg_pal[0], 8);
+		memset(solid + 8, 0, 8);
+	}
+}
+
+void REF_PPU::render_spr(int v)
+{
+	int num_sprites = 0;
+	int spr_height = sprites_8x16() ? 16 : 8;
+	
+	for(int s = 0; s < 64; s++) {
+		uint8* spr = &spr_ram[s << 2];
+		int spr_y = spr[0] + 1;
+		
+		if(spr_y > v || (spr_y + spr_height) <= v) {
+			continue;
+		}
+		num_sprites++;
+		if(num_sprites > 8) {
+			break;
+		}
+		int spr_x = spr[3];
+		int start_x = 0;
+		int end_x = 8;
+		int inc_x = 1;
+		
+		if((spr_x + 7) > 255) {
+			end_x -= ((spr_x + 7) - 255);
+		}
+		if((spr_x < 8) && (spr_clip())) {
+			if(!spr_x) {
+				continue;
+			}
+			start_x += (8 - spr_x);
+		}
+		int y = v - spr_y;
+		
+		uint8 *p = &screen[v][8 + spr_x + start_x];
+		uint8 *solid = &solid_buf[8 + spr_x + start_x];
+		
+		if(spr[2] & 0x40) {
+			start_x = (8 - 1) - start_x;
+			end_x = (8 - 1) - end_x;
+			inc_x = -1;
+		}
+		if(spr[2] & 0x80) {
+			y = (spr_height - 1) - y;
+		}
+		uint8 priority = spr[2] & 0x20;
+		
+		for(int x = start_x; x != end_x; x += inc_x) {
+			uint8 col = 0;
+			uint32 tile_addr;
+			uint8 tile_mask;
+			
+			if(!((*solid) & SPR_WRITTEN_FLAG)) {
+				if(sprites_8x16()) {
+					tile_addr = spr[1] << 4;
+					if(spr[1] & 0x01) {
+						tile_addr += 0x1000;
+						if(y < 8) {
+							tile_addr -= 16;
+						}
+					}
+					else {
+						if(y >= 8) {
+							tile_addr += 16;
+						}
+					}
+					tile_addr += y & 0x07;
+					tile_mask = (0x80 >> (x & 0x07));
+				}
+				else {
+					tile_addr = spr[1] << 4;
+					tile_addr += y & 0x07;
+					tile_addr += spr_pattern_table_addr;
+					tile_mask = (0x80 >> (x & 0x07));
+				}
+				if(VRAM(tile_addr) & tile_mask) {
+					col |= 1;
+				}
+				tile_addr += 8;
+				if(VRAM(tile_addr) & tile_mask) {
+					col |= 2;
+				}
+				if(spr[2] & 2) {
+					col |= 8;
+				}
+				if(spr[2] & 1) {
+					col |= 4;
+				}
+				if(col & 3) {
+					if(s && (*solid & BG_WRITTEN_FLAG)) {
+						regs[2] |= 0x40;
+					}
+					if(priority) {
+						*solid |= SPR_WRITTEN_FLAG;
+						if(!(*solid & BG_WRITTEN_FLAG)) {
+							*p = monochrome() ? (spr_pal[col] & 0xf0) : spr_pal[col];
+						}
+					}
+					else {
+						if(!(*solid & SPR_WRITTEN_FLAG)) {
+							*p = monochrome() ? (spr_pal[col] & 0xf0) : spr_pal[col];
+							*solid |= SPR_WRITTEN_FLAG;
+						}
+					}
+				}
+			}
+			p++;
+			solid++;
+		}
+	}
+	if(num_sprites >= 8) {
+		regs[2] |= 0x20;
+	}
+	else {
+		regs[2] &= ~0x20;
+	}
+}
+
+// the test writes the chr rom as BASIC.NES into the current directory
+_TCHAR* EMU::bios_path(_TCHAR* file_name)
+{
+	return file_name;
+}
+
+// cpu to count nmi, and event manager to accept the vline event
+class BENCH_DEVICE : public DEVICE
+{
+public:
+	BENCH_DEVICE(VM* parent_vm, EMU* parent_emu) : DEVICE(parent_vm, parent_emu) {
+		nmi_count = 0;
+	}
+	~BENCH_DEVICE() {}
+	
+	void write_signal(int id, uint32 data, uint32 mask) {
+		nmi_count++;
+	}
+	void register_vline_event(DEVICE* device) {}
+	int nmi_count;
+};
+
+// minimum virtual machine to link the device
+VM::VM(EMU* parent_emu) : emu(parent_emu)
+{
+	first_device = last_device = NULL;
+}
+
+// one write or read of the recorded session
+typedef struct {
+	int line;
+	uint32 addr;	// 0x4014 = sprite dma
+	uint8 data;
+} access_t;
+
+#define MAX_ACCESSES	(262 * 32)
+
+static access_t session[MAX_ACCESSES];
+static int session_count;
+static uint8 dma_data[256];
+
+// the writes are weighted to keep bg and sprites on and to hit the name tables
+static void record_frame(uint32* r)
+{
+	session_count = 0;
+	for(int v = 0; v < 262; v++) {
+		// a few writes in a line, and bursts of vram writes in vblank
+		*r = next_rand(*r);
+		int accesses = (v >= 241) ? (*r & 31) : (*r & 3);
+		for(int i = 0; i < accesses; i++) {
+			*r = next_rand(*r);
+			access_t* a = &session[session_count++];
+			a->line = v;
+			a->addr = 0x2000 | (*r & 7);
+			a->data = (*r >> 8) & 0xff;
+			
+			switch(a->addr) {
+			case 0x2001:
+				// sometimes monochrome, clipped or disabled, and rarely emphasized
+				if(*r & 0x30000) {
+					a->data |= 0x18;
+				}
+				if(*r & 0x3c0000) {
+					a->data &= 0x1f;
+				}
+				break;
+			case 0x2003:
+				// dma instead of the sprite ram address
+				if(*r & 0x10000) {
+					a->addr = 0x4014;
+				}
+				break;
+			case 0x2006:
+				// mostly name tables and palettes
+				if(*r & 0x30000) {
+					a->data = 0x20 | (a->data & 0x1f);
+				}
+				break;
+			}
+		}
+	}
+	// sprite ram for the dma, y is in the screen
+	for(int i = 0; i < 256; i++) {
+		*r = next_rand(*r);
+		dma_data[i] = (i & 3) ? (*r & 0xff) : (*r % 240);
+	}
+}
+
+static void do_dma(PPU* ppu)
+{
+	memcpy(ppu->get_spr_ram(), dma_data, 256);
+	ppu->write_signal(SIG_PPU_SPR_RAM, 1, 1);
+}
+
+static void do_dma(REF_PPU* ref)
+{
+	memcpy(ref->spr_ram, dma_data, 256);
+}
+
+// replay the recorded frame, and returns the values read from the status register
+template <class T> static double replay_frame(T* ppu, uint8* status)
+{
+	double start_time = get_host_sec();
+	access_t* a = session;
+	access_t* end = session + session_count;
+	
+	for(int v = 0; v < 262; v++) {
+		for(; a != end && a->line == v; a++) {
+			if(a->addr == 0x4014) {
+				do_dma(ppu);
+			}
+			else if(a->addr == 0x2002) {
+				*status++ = ppu->read_data8(a->addr);
+			}
+			else {
+				ppu->write_data8(a->addr, a->data);
+			}
+		}
+		ppu->event_vline(v, 0);
+	}
+	return get_host_sec() - start_time;
+}
+
+int main(int argc, char* argv[])
+{
+	VM* vm = new VM(NULL);
+	BENCH_DEVICE* dummy = new BENCH_DEVICE(vm, NULL);	// must be 1st device
+	BENCH_DEVICE* event = new BENCH_DEVICE(vm, NULL);	// must be 2nd device
+	PPU* ppu = new PPU(vm, NULL);
+	REF_PPU* ref = new REF_PPU();
+	static uint8 ppu_status[MAX_ACCESSES], ref_status[MAX_ACCESSES];
+	uint32 r = 0x9e3779b9;
+	int errors = 0, status_errors = 0;
+	
+	// random chr rom
+	uint8 header[16];
+	memset(header, 0, sizeof(header));
+	for(int i = 0; i < 0x2000; i++) {
+		r = next_rand(r);
+		ref->chr_rom[i] = r & 0xff;
+	}
+	FILE* fp = fopen("BASIC.NES", "wb");
+	fwrite(header, sizeof(header), 1, fp);
+	fwrite(ref->chr_rom, sizeof(ref->chr_rom), 1, fp);
+	fclose(fp);
+	
+	ppu->set_context_cpu(dummy);
+	ppu->initialize();
+	ppu->reset();
+	ref->initialize();
+	ref->reset();
+	remove("BASIC.NES");
+	
+	double ppu_sec = 0, ref_sec = 0;
+	for(int frame = 0; frame < TEST_FRAMES; frame++) {
+		record_frame(&r);
+		ref_sec += replay_frame(ref, ref_status);
+		ppu_sec += replay_frame(ppu, ppu_status);
+		
+		uint32 ppu_crc = getcrc32((uint8*)ppu->screen, sizeof(ppu->screen));
+		uint32 ref_crc = getcrc32((uint8*)ref->screen, sizeof(ref->screen));
+		if(ppu_crc != ref_crc) {
+			if(errors == 0) {
+				printf("frame %d: crc32 %08x != %08x\n", frame, ppu_crc, ref_crc);
+			}
+			errors++;
+		}
+		if(memcmp(ppu_status, ref_status, sizeof(ppu_status)) != 0) {
+			status_errors++;
+		}
+	}
+	if(dummy->nmi_count != ref->nmi_count) {
+		status_errors++;
+	}
+	printf("%d frames: %d mismatched frames, %d mismatched status\n", TEST_FRAMES, errors, status_errors);
+	printf("reference %.3f sec, PPU %.3f sec\n", ref_sec, ppu_sec);
+	
+	delete ref;
+	delete ppu;
+	return (errors || status_errors) ? 1 : 0;
+}
@@ -0,0 +1,172 @@
+/*
+	Skelton for retropc emulator
+
+	Author : Takeda.Toshiya
+	Date   : 2013.03.01-
+
+	[ fmgen synthesis benchmark ]
+
+	mixes the psg (tone, noise and envelope) and the opn/opna (3, 5 and 6
+	channels, with and without lfo) with the fixed register settings, and
+	checks the crc of the output with the values of the scalar code.
+
+	build with the instruction set to test, for example:
+	g++ -O2 -D_HEADLESS -D_PC8801MA -fno-operator-names -fpermissive -I../../src \
+	    -I../../src/vm/pc8801 fmgen_bench.cpp ../../src/vm/fmgen/opna.cpp \
+	    ../../src/vm/fmgen/fmgen.cpp ../../src/vm/fmgen/psg.cpp \
+	    ../../src/vm/fmgen/fmtimer.cpp ../../src/vm/fmgen/file.cpp \
+	    ../../src/fileio.cpp ../../src/common.cpp -o fmgen_bench
+	add -mavx2 for the avx2 version, and -U__SSE2__ for the scalar version.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "vm/fmgen/headers.h"
+#include "vm/fmgen/opna.h"
+
+#define BENCH_LOOPS	4000
+
+static FM::Sample buffer[1024 * 2];
+
+static double get_host_sec()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec / 1000000000.0;
+}
+
+static int check(const char* name, uint32 crc, uint32 expected, double time)
+{
+	printf("%-10s crc=%08x %6.2f nsec/sample %s\n", name, crc, time, (crc == expected) ? "" : "(mismatch)");
+	return (crc == expected) ? 0 : 1;
+}
+
+// the counters of PSG are not cleared by Reset(), so they are static
+static PSG psg_table[3];
+
+static int run_psg(const char* name, int mode, uint32 expected)
+{
+	PSG& psg = psg_table[mode];
+	psg.SetClock(1996800, 96000);
+	psg.Reset();
+	psg.SetReg(0, 0x80);
+	psg.SetReg(2, 0x40);
+	psg.SetReg(4, 0x33);
+	psg.SetReg(6, 0x0c);
+	psg.SetReg(7, (mode == 0) ? 0x38 : 0x30);
+	psg.SetReg(8, 0x0f);
+	psg.SetReg(9, 0x0c);
+	psg.SetReg(10, (mode == 2) ? 0x10 : 0x0a);
+	psg.SetReg(11, 0x40);
+	psg.SetReg(13, 0x0e);
+	
+	uint32 crc = 0;
+	int total = 0;
+	double start_time = get_host_sec();
+	for(int i = 0; i < BENCH_LOOPS * 5; i++) {
+		int n = 1000 + (i & 7);
+		memset(buffer, 0, sizeof(buffer));
+		psg.Mix(buffer, n);
+		for(int j = 0; j < n * 2; j++) {
+			crc = crc * 31 + buffer[j];
+		}
+		total += n;
+	}
+	return check(name, crc, expected, (get_host_sec() - start_time) * 1000000000.0 / total);
+}
+
+template <class T> int run_opn(T& chip, const char* name, int nch, bool lfo, uint32 expected)
+{
+	chip.SetVolumeFM(0);
+	chip.SetVolumePSG(-200);
+	if(lfo) {
+		chip.SetReg(0x22, 0x0b);
+	}
+	if(nch > 3) {
+		chip.SetReg(0x29, 0x80);
+	}
+	for(int c = 0; c < nch; c++) {
+		int base = (c < 3) ? 0 : 0x100, ch = c % 3;
+		for(int op = 0; op < 4; op++) {
+			int ofs = base + ch + op * 4;
+			chip.SetReg(0x30 + ofs, 0x71 + op);
+			chip.SetReg(0x40 + ofs, (op == 3) ? 0x05 : 0x20 + op * 3);
+			chip.SetReg(0x50 + ofs, 0x1f);
+			chip.SetReg(0x60 + ofs, (lfo ? 0x80 : 0) | 0x05);
+			chip.SetReg(0x70 + ofs, 0x02);
+			chip.SetReg(0x80 + ofs, 0x11);
+		}
+		chip.SetReg(base + 0xb0 + ch, (c % 8) | (((c * 3) % 8) << 3));
+		chip.SetReg(base + 0xb4 + ch, 0xc0 | (lfo ? 0x33 : 0));
+		chip.SetReg(base + 0xa4 + ch, 0x22 + c);
+		chip.SetReg(base + 0xa0 + ch, 0x69 + c * 7);
+	}
+	
+	uint32 crc = 0;
+	int total = 0;
+	double start_time = get_host_sec();
+	for(int i = 0; i < BENCH_LOOPS; i++) {
+		// key on/off, and change the frequency and the algorithm of the first channel
+		for(int c = 0; c < nch; c++) {
+			if((i % 50) == 0) {
+				chip.SetReg(0x28, 0xf0 | ((c < 3) ? c : c + 1));
+			}
+			else if((i % 50) == 40) {
+				chip.SetReg(0x28, (c < 3) ? c : c + 1);
+			}
+		}
+		if((i % 7) == 0) {
+			chip.SetReg(0xa0, 0x40 + i % 91);
+		}
+		if((i % 13) == 0) {
+			chip.SetReg(0xb1, ((i / 13) % 8) | ((i % 8) << 3));
+		}
+		int n = 900 + (i % 97);
+		memset(buffer, 0, sizeof(buffer));
+		chip.Mix(buffer, n);
+		for(int j = 0; j < n * 2; j++) {
+			crc = crc * 31 + buffer[j];
+		}
+		total += n;
+	}
+	return check(name, crc, expected, (get_host_sec() - start_time) * 1000000000.0 / total);
+}
+
+int main(int argc, char* argv[])
+{
+	int errors = 0;
+	
+#if defined(SIMD_USE_AVX2)
+	printf("fmgen: avx2\n");
+#elif defined(SIMD_USE_SSE2)
+	printf("fmgen: sse2\n");
+#else
+	printf("fmgen: scalar\n");
+#endif
+	errors += run_psg("psg tone", 0, 0xcde6ac20);
+	errors += run_psg("psg noise", 1, 0x25093ac0);
+	errors += run_psg("psg env", 2, 0xe3518ee0);
+	{
+		FM::OPN opn;
+		opn.Init(3993600, 96000, false, NULL);
+		errors += run_opn(opn, "opn", 3, false, 0xed7f7ac0);
+	}
+	{
+		FM::OPNA opna;
+		opna.Init(7987200, 96000, false, NULL);
+		errors += run_opn(opna, "opna 5ch", 5, false, 0xdc298b00);
+	}
+	{
+		FM::OPNA opna;
+		opna.Init(7987200, 96000, false, NULL);
+		errors += run_opn(opna, "opna 6ch", 6, false, 0xdef802c0);
+	}
+	{
+		FM::OPNA opna;
+		opna.Init(7987200, 96000, false, NULL);
+		errors += run_opn(opna, "opna lfo", 6, true, 0x38b21ea0);
+	}
+	printf("%s\n", errors ? "results differ" : "results ok");
+	return errors ? 1 : 0;
+}
@@ -0,0 +1,283 @@
+/*
+	Skelton for retropc emulator
+
+	Author : Takeda.Toshiya
+	Date   : 2013.03.01-
+
+	[ pc engine psg golden output test ]
+
+	drives PCE::mix() and the reference generator below (the per sample
+	generator that PCE::mix() used before the periods and the volumes were
+	precomputed) with the same pseudo random register writes, and compares
+	all output samples at several sample rates. the blocks are mixed in
+	random lengths to cross the block boundary of PCE::mix().
+
+	build with the headless host definitions, for example:
+	g++ -O2 -D_PCENGINE -D_HEADLESS -fno-operator-names -fpermissive \
+	    -I../../src -I../../src/vm/pcengine pce_psg_golden.cpp \
+	    ../../src/vm/pcengine/pce.cpp ../../src/vm/huc6280.cpp \
+	    ../../src/fileio.cpp ../../src/common.cpp -o pce_psg_golden
+*/
+
+#include <time.h>
+#include "vm/vm.h"
+#include "emu.h"
+#include "vm/device.h"
+#include "vm/pcengine/pce.h"
+
+#define TEST_WRITES	200000
+#define MAX_SAMPLES	2048
+
+static inline uint32 next_rand(uint32 r)
+{
+	r ^= r << 13;
+	r ^= r >> 17;
+	r ^= r << 5;
+	return r;
+}
+
+static double get_host_sec()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec / 1000000000.0;
+}
+
+// reference generator
+class REF_PSG
+{
+private:
+	typedef struct {
+		uint8 regs[8];
+		uint8 wav[32];
+		uint8 wavptr;
+		uint32 genptr;
+		uint32 remain;
+		bool noise;
+		uint32 randval;
+	} psg_t;
+	psg_t psg[8];
+	uint8 psg_ch, psg_vol;
+	int sample_rate;
+
+public:
+	REF_PSG(int rate) {
+		sample_rate = rate;
+		memset(psg, 0, sizeof(psg));
+		for(int i = 0; i < 6; i++) {
+			psg[i].regs[4] = 0x80;
+		}
+		psg[4].randval = psg[5].randval = 0x51f631e4;
+		psg_ch = psg_vol = 0;
+	}
+	void write(uint16 addr, uint8 data) {
+		switch(addr & 0x1f) {
+		case 0:
+			psg_ch = data & 7;
+			break;
+		case 1:
+			psg_vol = data;
+			break;
+		case 2:
+			psg[psg_ch].regs[2] = data;
+			break;
+		case 3:
+			psg[psg_ch].regs[3] = data & 0xf;
+			break;
+		case 4:
+			psg[psg_ch].regs[4] = data;
+			break;
+		case 5:
+			psg[psg_ch].regs[5] = data;
+			break;
+		case 6:
+			if(psg[psg_ch].regs[4] & 0x40) {
+				psg[psg_ch].wav[0] =data & 0x1f;
+			}
+			else {
+				psg[psg_ch].wav[psg[psg_ch].wavptr] = data & 0x1f;
+				psg[psg_ch].wavptr = (psg[psg_ch].wavptr + 1) & 0x1f;
+			}
+			break;
+		case 7:
+			psg[psg_ch].regs[7] = data;
+			break;
+		}
+	}
+	void mix(int32* buffer, int cnt);
+};
+
+#define MAX(a, b) (((a) > (b)) ? (a) : (b))
+
+void REF_PSG::mix(int32* buffer, int cnt)
+{
+	int vol_tbl[32] = {
+		 100, 451, 508, 573, 646, 728, 821, 925,1043,1175,1325, 1493, 1683, 1898, 2139, 2411,
+		2718,3064,3454,3893,4388,4947,5576,6285,7085,7986,9002,10148,11439,12894,14535,16384
+	};
+	
+	for(int ch = 0; ch < 6; ch++) {
+		if(!(psg[ch].regs[4] & 0x80)) {
+			// mute
+			psg[ch].genptr = psg[ch].remain = 0;
+		}
+		else if(psg[ch].regs[4] & 0x40) {
+			// dda
+			int32 wav = ((int32)psg[ch].wav[0] - 16) * 702;
+			int32 vol = MAX((psg_vol >> 3) & 0x1e, (psg_vol << 1) & 0x1e) + (psg[ch].regs[4] & 0x1f) + MAX((psg[ch].regs[5] >> 3) & 0x1e, (psg[ch].regs[5] << 1) & 0x1e) - 60;
+			vol = (vol < 0) ? 0 : (vol > 31) ? 31 : vol;
+			vol = wav * vol_tbl[vol] / 16384;
+			for(int i = 0, j = 0; i < cnt; i++, j += 2) {
+				buffer[j    ] += vol; // L
+				buffer[j + 1] += vol; // R
+			}
+		}
+		else if(ch >= 4 && (psg[ch].regs[7] & 0x80)) {
+			// noise
+			uint16 freq = (psg[ch].regs[7] & 0x1f);
+			int32 vol = MAX((psg_vol >> 3) & 0x1e, (psg_vol << 1) & 0x1e) + (psg[ch].regs[4] & 0x1f) + MAX((psg[ch].regs[5] >> 3) & 0x1e, (psg[ch].regs[5] << 1) & 0x1e) - 60;
+			vol = (vol < 0) ? 0 : (vol > 31) ? 31 : vol;
+			vol = vol_tbl[vol];
+			for(int i = 0, j = 0; i < cnt; i++, j += 2) {
+				psg[ch].remain += 3000 + freq * 512;
+				uint32 t = psg[ch].remain / sample_rate;
+				if(t >= 1) {
+					if(psg[ch].randval & 0x80000) {
+						psg[ch].randval = ((psg[ch].randval ^ 4) << 1) + 1;
+						psg[ch].noise = true;
+					}
+					else {
+						psg[ch].randval <<= 1;
+						psg[ch].noise = false;
+					}
+					psg[ch].remain -= sample_rate * t;
+				}
+				int32 outvol = (int32)((psg[ch].noise ? 10 * 702 : -10 * 702) * vol / 16384);
+				buffer[j    ] += outvol; // L
+				buffer[j + 1] += outvol; // R
+			}
+		}
+		else {
+			int32 wav[32];
+			for(int i = 0; i < 32; i++) {
+				wav[i] = ((int32)psg[ch].wav[i] - 16) * 702;
+			}
+			uint32 freq = psg[ch].regs[2] + ((uint32)psg[ch].regs[3] << 8);
+			if(freq) {
+				int32 vol = MAX((psg_vol >> 3) & 0x1e, (psg_vol << 1) & 0x1e) + (psg[ch].regs[4] & 0x1f) + MAX((psg[ch].regs[5] >> 3) & 0x1e, (psg[ch].regs[5] << 1) & 0x1e) - 60;
+				vol = (vol < 0) ? 0 : (vol > 31) ? 31 : vol;
+				vol = vol_tbl[vol];
+				for(int i = 0, j = 0; i < cnt; i++, j += 2) {
+					int32 outvol = wav[psg[ch].genptr] * vol / 16384;
+					buffer[j    ] += outvol; // L
+					buffer[j + 1] += outvol; // R
+					psg[ch].remain += 32 * 1118608 / freq;
+					uint32 t = psg[ch].remain / (10 * sample_rate);
+					psg[ch].genptr = (psg[ch].genptr + t) & 0x1f;
+					psg[ch].remain -= 10 * sample_rate * t;
+				}
+			}
+		}
+	}
+}
+
+// pce.cpp refers to the rom path only in initialize() and release(), that are not called here
+_TCHAR* EMU::bios_path(_TCHAR* file_name)
+{
+	return file_name;
+}
+
+// minimum virtual machine to link the device
+VM::VM(EMU* parent_emu) : emu(parent_emu)
+{
+	first_device = last_device = NULL;
+}
+
+// random register write, the frequencies are often low to run the noise and the tone faster than the sample rate
+static void random_write(uint32 r, uint16* addr, uint8* data)
+{
+	static const uint8 regs[16] = {0, 0, 1, 2, 2, 3, 4, 4, 5, 6, 6, 6, 6, 7, 7, 4};
+	*addr = regs[r & 15];
+	*data = (r >> 8) & 0xff;
+	
+	switch(*addr) {
+	case 0:
+		*data %= 6;
+		break;
+	case 3:
+		*data = (r & 0x10000) ? 0 : *data;
+		break;
+	case 4:
+		// mostly enabled, sometimes in dda mode
+		*data = (*data & 0x1f) | ((r & 0x30000) ? 0x80 : 0) | (((r >> 18) & 7) == 0 ? 0x40 : 0);
+		break;
+	}
+}
+
+static int test(int rate, double* ref_sec, double* test_sec)
+{
+	VM* vm = new VM(NULL);
+	PCE* pce = new PCE(vm, NULL);
+	REF_PSG* ref = new REF_PSG(rate);
+	static int32 ref_buffer[MAX_SAMPLES * 2], test_buffer[MAX_SAMPLES * 2];
+	uint32 r = 0x9e3779b9 * rate;
+	int errors = 0;
+	
+	pce->initialize_sound(rate);
+	pce->reset();
+	pce->running = true;
+	*ref_sec = *test_sec = 0;
+	
+	for(int n = 0; n < TEST_WRITES; n++) {
+		uint16 addr;
+		uint8 data;
+		r = next_rand(r);
+		random_write(r, &addr, &data);
+		ref->write(addr, data);
+		pce->write_data8(0x1fe800 | addr, data);
+		
+		// mix some samples every 64 writes
+		if((n & 63) == 0) {
+			r = next_rand(r);
+			int samples = 1 + (r % MAX_SAMPLES);
+			memset(ref_buffer, 0, sizeof(int32) * samples * 2);
+			memset(test_buffer, 0, sizeof(int32) * samples * 2);
+			
+			double start_time = get_host_sec();
+			ref->mix(ref_buffer, samples);
+			double mid_time = get_host_sec();
+			pce->mix(test_buffer, samples);
+			*ref_sec += mid_time - start_time;
+			*test_sec += get_host_sec() - mid_time;
+			
+			if(memcmp(ref_buffer, test_buffer, sizeof(int32) * samples * 2) != 0) {
+				for(int i = 0; i < samples * 2; i++) {
+					if(ref_buffer[i] != test_buffer[i]) {
+						if(errors == 0) {
+							printf("%d Hz: mismatch after write %d at sample %d: %d != %d\n", rate, n, i >> 1, test_buffer[i], ref_buffer[i]);
+						}
+						break;
+					}
+				}
+				errors++;
+			}
+		}
+	}
+	delete ref;
+	delete pce;
+	return errors;
+}
+
+int main(int argc, char* argv[])
+{
+	static const int rates[5] = {11025, 22050, 44100, 48000, 96000};
+	int errors = 0;
+	
+	for(int i = 0; i < 5; i++) {
+		double ref_sec, test_sec;
+		int result = test(rates[i], &ref_sec, &test_sec);
+		printf("%5d Hz: %d mismatched blocks, reference %.3f sec, PCE::mix() %.3f sec\n", rates[i], result, ref_sec, test_sec);
+		errors += result;
+	}
+	return errors ? 1 : 0;
+}
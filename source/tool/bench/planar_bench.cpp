@@ -0,0 +1,211 @@
+/*
+	Skelton for retropc emulator
+
+	Author : Takeda.Toshiya
+	Date   : 2013.03.01-
+
+	[ bitplane micro benchmark ]
+
+	checks that planar_to_chunky() returns the same pixels as the old code of
+	the graphic renderers (pc9801, x1, mz2500 and mz2800), and measures them
+	with the lines of 80 bytes of the 640 dots screen.
+
+	build with the instruction set to test, for example:
+	g++ -O2 -I../../src planar_bench.cpp ../../src/common.cpp -o planar_bench
+	g++ -O2 -mavx2 -I../../src planar_bench.cpp ../../src/common.cpp -o planar_bench_avx2
+	g++ -O2 -U__SSE2__ -I../../src planar_bench.cpp ../../src/common.cpp -o planar_bench_c
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "common.h"
+
+#define BENCH_LINES	400
+#define BENCH_BYTES	80
+#define BENCH_LOOPS	500
+
+static double get_host_sec()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec / 1000000000.0;
+}
+
+static inline uint32 next_rand(uint32 r)
+{
+	r ^= r << 13;
+	r ^= r >> 17;
+	r ^= r << 5;
+	return r;
+}
+
+static uint8 vram[8][BENCH_LINES * BENCH_BYTES];
+
+// same as the old code of pc9801 DISPLAY::draw_gfx_screen()
+static void ref_pc9801(uint8* dest, int y)
+{
+	for(int x = 0; x < BENCH_BYTES; x++) {
+		uint8 b = vram[0][y * BENCH_BYTES + x];
+		uint8 r = vram[1][y * BENCH_BYTES + x];
+		uint8 g = vram[2][y * BENCH_BYTES + x];
+		uint8 e = vram[3][y * BENCH_BYTES + x];
+		
+		*dest++ = ((b & 0x80) >> 7) | ((r & 0x80) >> 6) | ((g & 0x80) >> 5) | ((e & 0x80) >> 4);
+		*dest++ = ((b & 0x40) >> 6) | ((r & 0x40) >> 5) | ((g & 0x40) >> 4) | ((e & 0x40) >> 3);
+		*dest++ = ((b & 0x20) >> 5) | ((r & 0x20) >> 4) | ((g & 0x20) >> 3) | ((e & 0x20) >> 2);
+		*dest++ = ((b & 0x10) >> 4) | ((r & 0x10) >> 3) | ((g & 0x10) >> 2) | ((e & 0x10) >> 1);
+		*dest++ = ((b & 0x08) >> 3) | ((r & 0x08) >> 2) | ((g & 0x08) >> 1) | ((e & 0x08)     );
+		*dest++ = ((b & 0x04) >> 2) | ((r & 0x04) >> 1) | ((g & 0x04)     ) | ((e & 0x04) << 1);
+		*dest++ = ((b & 0x02) >> 1) | ((r & 0x02)     ) | ((g & 0x02) << 1) | ((e & 0x02) << 2);
+		*dest++ = ((b & 0x01)     ) | ((r & 0x01) << 1) | ((g & 0x01) << 2) | ((e & 0x01) << 3);
+	}
+}
+
+// same as the old code of x1 DISPLAY::draw_cg()
+static void ref_x1(uint8* dest, int y)
+{
+	for(int x = 0; x < BENCH_BYTES; x++) {
+		uint8 b = vram[0][y * BENCH_BYTES + x];
+		uint8 r = vram[1][y * BENCH_BYTES + x];
+		uint8 g = vram[2][y * BENCH_BYTES + x];
+		uint8* d = &dest[x << 3];
+		
+		d[0] = ((b & 0x80) >> 7) | ((r & 0x80) >> 6) | ((g & 0x80) >> 5);
+		d[1] = ((b & 0x40) >> 6) | ((r & 0x40) >> 5) | ((g & 0x40) >> 4);
+		d[2] = ((b & 0x20) >> 5) | ((r & 0x20) >> 4) | ((g & 0x20) >> 3);
+		d[3] = ((b & 0x10) >> 4) | ((r & 0x10) >> 3) | ((g & 0x10) >> 2);
+		d[4] = ((b & 0x08) >> 3) | ((r & 0x08) >> 2) | ((g & 0x08) >> 1);
+		d[5] = ((b & 0x04) >> 2) | ((r & 0x04) >> 1) | ((g & 0x04) >> 0);
+		d[6] = ((b & 0x02) >> 1) | ((r & 0x02) >> 0) | ((g & 0x02) << 1);
+		d[7] = ((b & 0x01) >> 0) | ((r & 0x01) << 1) | ((g & 0x01) << 2);
+	}
+}
+
+// same as the old cg optimize matrix of mz2500 (lsb first) and mz2800 (msb first)
+static uint8 cg_matrix[2][4][256][256][8];
+
+static void init_cg_matrix()
+{
+	for(int p1 = 0; p1 < 256; p1++) {
+		for(int p2 = 0; p2 < 256; p2++) {
+			for(int i = 0; i < 8; i++) {
+				for(int m = 0; m < 4; m++) {
+					cg_matrix[0][m][p1][p2][i] = (p1 & (1 << i) ? (0x01 << (m * 2)) : 0) | (p2 & (1 << i) ? (0x02 << (m * 2)) : 0);
+					cg_matrix[1][m][p1][p2][i] = (p1 & (0x80 >> i) ? (0x01 << (m * 2)) : 0) | (p2 & (0x80 >> i) ? (0x02 << (m * 2)) : 0);
+				}
+			}
+		}
+	}
+}
+
+static void ref_matrix(uint8* dest, int y, int msb, int plane_num)
+{
+	for(int x = 0; x < BENCH_BYTES; x++) {
+		uint8 p[8];
+		for(int k = 0; k < 8; k++) {
+			p[k] = vram[k][y * BENCH_BYTES + x];
+		}
+		for(int i = 0; i < 8; i++) {
+			uint8 col = cg_matrix[msb][0][p[0]][p[1]][i] | cg_matrix[msb][1][p[2]][p[3]][i];
+			if(plane_num == 8) {
+				col |= cg_matrix[msb][2][p[4]][p[5]][i] | cg_matrix[msb][3][p[6]][p[7]][i];
+			}
+			*dest++ = col;
+		}
+	}
+}
+
+static void new_kernel(uint8* dest, int y, int lsb_first, int plane_num)
+{
+	uint8* plane[8];
+	for(int k = 0; k < 8; k++) {
+		plane[k] = &vram[k][y * BENCH_BYTES];
+	}
+	planar_to_chunky(dest, plane, plane_num, BENCH_BYTES, lsb_first != 0);
+}
+
+static void run_ref(int kernel, uint8* dest, int y)
+{
+	switch(kernel) {
+	case 0: ref_pc9801(dest, y); break;
+	case 1: ref_x1(dest, y); break;
+	case 2: ref_matrix(dest, y, 0, 4); break;
+	case 3: ref_matrix(dest, y, 0, 8); break;
+	case 4: ref_matrix(dest, y, 1, 4); break;
+	}
+}
+
+static void run_new(int kernel, uint8* dest, int y)
+{
+	switch(kernel) {
+	case 0: new_kernel(dest, y, 0, 4); break;
+	case 1: new_kernel(dest, y, 0, 3); break;
+	case 2: new_kernel(dest, y, 1, 4); break;
+	case 3: new_kernel(dest, y, 1, 8); break;
+	case 4: new_kernel(dest, y, 0, 4); break;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	static const char* kernel_names[5] = {
+		"pc9801 16 colors", "x1 8 colors", "mz2500 16 colors", "mz2500 256 colors", "mz2800 16 colors"
+	};
+	static uint8 ref[BENCH_LINES][BENCH_BYTES * 8];
+	static uint8 dst[BENCH_LINES][BENCH_BYTES * 8];
+	uint32 seed = 0x12345678;
+	int errors = 0;
+
+#if defined(__AVX2__)
+	printf("bitplanes: avx2\n");
+#elif defined(__SSE2__) || defined(_M_X64)
+	printf("bitplanes: sse2\n");
+#else
+	printf("bitplanes: scalar\n");
+#endif
+	init_cg_matrix();
+	for(int k = 0; k < 8; k++) {
+		for(int i = 0; i < BENCH_LINES * BENCH_BYTES; i++) {
+			seed = next_rand(seed);
+			vram[k][i] = seed >> 24;
+		}
+	}
+	// all patterns of each byte
+	for(int i = 0; i < 256; i++) {
+		vram[i & 7][i] = i;
+	}
+	printf("kernel            | ref/new (nsec/byte)\n");
+	
+	for(int kernel = 0; kernel < 5; kernel++) {
+		for(int y = 0; y < BENCH_LINES; y++) {
+			run_ref(kernel, ref[y], y);
+			run_new(kernel, dst[y], y);
+		}
+		if(memcmp(ref, dst, sizeof(ref)) != 0) {
+			printf("%s: mismatch\n", kernel_names[kernel]);
+			errors++;
+		}
+		
+		// measure
+		double time[2];
+		for(int k = 0; k < 2; k++) {
+			double start_time = get_host_sec();
+			for(int i = 0; i < BENCH_LOOPS; i++) {
+				for(int y = 0; y < BENCH_LINES; y++) {
+					if(k == 0) {
+						run_ref(kernel, ref[y], y);
+					}
+					else {
+						run_new(kernel, dst[y], y);
+					}
+				}
+			}
+			time[k] = (get_host_sec() - start_time) * 1000000000.0 / ((double)BENCH_LOOPS * BENCH_LINES * BENCH_BYTES);
+		}
+		printf("%-17s | %6.3f %6.3f (x%.1f)\n", kernel_names[kernel], time[0], time[1], time[0] / time[1]);
+	}
+	printf("%s\n", errors ? "results differ" : "results ok");
+	return errors ? 1 : 0;
+}
@@ -0,0 +1,167 @@
+/*
+	Skelton for retropc emulator
+
+	Author : Takeda.Toshiya
+	Date   : 2013.03.01-
+
+	[ sound buffer micro benchmark ]
+
+	checks that lowpass_sound() and saturate_sound() return the same results
+	as the scalar code of EVENT::create_sound(), and measures them with the
+	stereo buffers of 48KHz and 96KHz at all latency settings.
+
+	build with the instruction set to test, for example:
+	g++ -O2 -I../../src sound_bench.cpp ../../src/common.cpp -o sound_bench
+	g++ -O2 -mavx2 -I../../src sound_bench.cpp ../../src/common.cpp -o sound_bench_avx2
+	g++ -O2 -U__SSE2__ -I../../src sound_bench.cpp ../../src/common.cpp -o sound_bench_c
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "common.h"
+
+#define BENCH_SAMPLES	(1 << 23)
+
+static double get_host_sec()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec / 1000000000.0;
+}
+
+static inline uint32 next_rand(uint32 r)
+{
+	r ^= r << 13;
+	r ^= r >> 17;
+	r ^= r << 5;
+	return r;
+}
+
+// same as the old code of EVENT::create_sound()
+static void lowpass_sound_ref(int32* buffer, int samples)
+{
+	for(int i = 0; i < samples - 1; i++) {
+		buffer[i * 2    ] = (buffer[i * 2    ] + buffer[i * 2 + 2]) / 2; // L
+		buffer[i * 2 + 1] = (buffer[i * 2 + 1] + buffer[i * 2 + 3]) / 2; // R
+	}
+}
+
+static void saturate_sound_ref(uint16* dst, int32* src, int samples)
+{
+	for(int i = 0; i < samples * 2; i++) {
+		int dat = src[i];
+		uint16 highlow = (uint16)(dat & 0x0000ffff);
+		
+		if((dat > 0) && (highlow >= 0x8000)) {
+			dst[i] = 0x7fff;
+			continue;
+		}
+		if((dat < 0) && (highlow < 0x8000)) {
+			dst[i] = 0x8000;
+			continue;
+		}
+		dst[i] = highlow;
+	}
+}
+
+// mixed samples: mostly in 16bit range, sometimes clipped or wrapped
+static void fill_samples(int32* buffer, int count, uint32* seed)
+{
+	for(int i = 0; i < count; i++) {
+		uint32 r = *seed = next_rand(*seed);
+		switch(r & 7) {
+		case 0:
+			buffer[i] = (int32)(r ^ (r << 7)) >> 4;	// wide range
+			break;
+		case 1:
+			buffer[i] = (r & 0x100) ? 0x8000 + (int32)((r >> 9) & 0xff) : -0x8001 - (int32)((r >> 9) & 0xff);
+			break;
+		case 2:
+			buffer[i] = ((r >> 8) & 1) ? 0x7fff : ((r >> 9) & 1) ? -0x8000 : 0;
+			break;
+		default:
+			buffer[i] = (int32)(int16)(r >> 16) / 2;
+			break;
+		}
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	static const int freq_table[2] = {48000, 96000};
+	static const double late_table[5] = {0.05, 0.1, 0.2, 0.3, 0.4};
+	uint32 seed = 0x12345678;
+	int errors = 0;
+	
+#if defined(__AVX2__)
+	printf("sound buffer: avx2\n");
+#elif defined(__SSE2__) || defined(_M_X64)
+	printf("sound buffer: sse2\n");
+#else
+	printf("sound buffer: scalar\n");
+#endif
+	printf("rate  latency samples | lowpass ref/new (nsec/sample) | saturate ref/new (nsec/sample)\n");
+	
+	for(int f = 0; f < 2; f++) {
+		for(int l = 0; l < 5; l++) {
+			int samples = (int)(freq_table[f] * late_table[l] + 0.5);
+			int count = samples * 2;
+			int32* src = (int32*)malloc(count * sizeof(int32));
+			int32* ref = (int32*)malloc(count * sizeof(int32));
+			int32* tmp = (int32*)malloc(count * sizeof(int32));
+			uint16* dst_ref = (uint16*)malloc(count * sizeof(uint16));
+			uint16* dst = (uint16*)malloc(count * sizeof(uint16));
+			
+			// check the results with some buffers (and odd lengths for the tail loops)
+			for(int pass = 0; pass < 8; pass++) {
+				int n = samples - pass;
+				fill_samples(src, count, &seed);
+				memcpy(ref, src, count * sizeof(int32));
+				memcpy(tmp, src, count * sizeof(int32));
+				lowpass_sound_ref(ref, n);
+				lowpass_sound(tmp, n);
+				if(memcmp(ref, tmp, count * sizeof(int32)) != 0) {
+					printf("lowpass_sound: mismatch (%d samples)\n", n);
+					errors++;
+				}
+				memset(dst_ref, 0, count * sizeof(uint16));
+				memset(dst, 0, count * sizeof(uint16));
+				saturate_sound_ref(dst_ref, src, n);
+				saturate_sound(dst, src, n);
+				if(memcmp(dst_ref, dst, count * sizeof(uint16)) != 0) {
+					printf("saturate_sound: mismatch (%d samples)\n", n);
+					errors++;
+				}
+			}
+			
+			// measure
+			int loops = BENCH_SAMPLES / samples + 1;
+			double time[4];
+			for(int k = 0; k < 4; k++) {
+				double start_time = get_host_sec();
+				for(int i = 0; i < loops; i++) {
+					switch(k) {
+					case 0: lowpass_sound_ref(tmp, samples); break;
+					case 1: lowpass_sound(tmp, samples); break;
+					case 2: saturate_sound_ref(dst_ref, src, samples); break;
+					case 3: saturate_sound(dst, src, samples); break;
+					}
+				}
+				time[k] = (get_host_sec() - start_time) * 1000000000.0 / ((double)loops * samples);
+			}
+			printf("%5d %4dms %7d | %6.3f %6.3f (x%.1f) | %6.3f %6.3f (x%.1f)\n",
+				freq_table[f], (int)(late_table[l] * 1000 + 0.5), samples,
+				time[0], time[1], time[0] / time[1], time[2], time[3], time[2] / time[3]);
+			
+			free(src);
+			free(ref);
+			free(tmp);
+			free(dst_ref);
+			free(dst);
+		}
+	}
+	printf("%s\n", errors ? "results differ" : "results ok");
+	return errors ? 1 : 0;
+}
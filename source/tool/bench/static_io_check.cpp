@@ -0,0 +1,64 @@
+/*
+	Skelton for retropc emulator
+
+	Author : Takeda.Toshiya
+	Date   : 2013.03.01-
+
+	[ compile time i/o map check ]
+
+	creates the virtual machine, and checks that every port in the map of
+	STATIC_IO_MAP is passed to the same device and address as the runtime
+	i/o map of IO set by VM::VM(). the ports that are not in the map are
+	accessed through IO, so they are not checked.
+
+	build with the headless host and all sources of the machine, for example:
+	g++ -O2 -D_FC100 -D_HEADLESS -D_STATIC_IO -fno-operator-names -fpermissive -I../../src -I../../src/vm \
+	    static_io_check.cpp <sources of the machine except headless_main.cpp> \
+	    -o static_io_check
+*/
+
+// the tables of IO and the devices of VM are compared
+#define private public
+#define protected public
+#include "emu.h"
+#include "vm/vm.h"
+#include STATIC_IO_MAP_H
+#undef protected
+#undef private
+
+int main(int argc, char* argv[])
+{
+	EMU* emu = new EMU(_T("."), false);
+	VM* vm = emu->vm;
+	IO* io = vm->io;
+	int ports_r = 0, ports_w = 0, errors = 0;
+	
+	if(!STATIC_IO_MAP::static_io_r::is_bus(vm, io) || !STATIC_IO_MAP::static_io_w::is_bus(vm, io)) {
+		printf("the map is not for IO\n");
+		delete emu;
+		return 1;
+	}
+	for(uint32 addr = 0; addr < IO_ADDR_MAX; addr++) {
+		uint32 addr2;
+		DEVICE* device = STATIC_IO_MAP::static_io_r::get_device(vm, addr, &addr2);
+		if(device != NULL) {
+			if(device != io->rd_table[addr].dev || addr2 != io->rd_table[addr].addr || io->rd_table[addr].value_registered) {
+				printf("in %04x: device %d addr %04x, runtime device %d addr %04x\n", addr, device->this_device_id, addr2, io->rd_table[addr].dev->this_device_id, io->rd_table[addr].addr);
+				errors++;
+			}
+			ports_r++;
+		}
+		device = STATIC_IO_MAP::static_io_w::get_device(vm, addr, &addr2);
+		if(device != NULL) {
+			if(device != io->wr_table[addr].dev || addr2 != io->wr_table[addr].addr || io->wr_table[addr].is_flipflop) {
+				printf("out %04x: device %d addr %04x, runtime device %d addr %04x\n", addr, device->this_device_id, addr2, io->wr_table[addr].dev->this_device_id, io->wr_table[addr].addr);
+				errors++;
+			}
+			ports_w++;
+		}
+	}
+	printf("%s\n", DEVICE_NAME);
+	printf("%d in ports and %d out ports in the map, %d errors\n", ports_r, ports_w, errors);
+	delete emu;
+	return errors ? 1 : 0;
+}
@@ -0,0 +1,256 @@
+/*
+	Skelton for retropc emulator
+
+	Author : Takeda.Toshiya
+	Date   : 2013.03.01-
+
+	[ z80 dispatch lockstep test ]
+
+	runs the switch dispatch core and the threaded dispatch core of Z80 over
+	the same pseudo random instruction streams, and compares the registers and
+	the remaining clocks at every opecode fetch. the streams are run in random
+	slices with irq, nmi and busreq to check the opecodes chained in OP().
+
+	build z80.cpp twice with the different class names, for example:
+	g++ -O2 -D_FC100 -D_HEADLESS -fno-operator-names -fpermissive -I../../src \
+	    -DZ80=Z80_SWITCH -c ../../src/vm/z80.cpp -o z80_switch.o
+	g++ -O2 -D_FC100 -D_HEADLESS -fno-operator-names -fpermissive -I../../src \
+	    -DZ80=Z80_THREADED -DZ80_THREADED_DISPATCH -c ../../src/vm/z80.cpp -o z80_threaded.o
+	g++ -O2 -D_FC100 -D_HEADLESS -fno-operator-names -fpermissive -I../../src \
+	    z80_lockstep.cpp z80_switch.o z80_threaded.o ../../src/fileio.cpp \
+	    ../../src/common.cpp -o z80_lockstep
+*/
+
+#include "config.h"
+#include "vm/vm.h"
+#include "emu.h"
+#include "fileio.h"
+#include "vm/device.h"
+
+#define Z80 Z80_SWITCH
+#include "vm/z80.h"
+#undef Z80
+#undef _Z80_H_
+#define Z80_THREADED_DISPATCH
+#define Z80 Z80_THREADED
+#include "vm/z80.h"
+#undef Z80
+
+#define TEST_BLOCKS	64
+#define TEST_CLOCKS	1000000
+
+static inline uint32 next_rand(uint32 r)
+{
+	r ^= r << 13;
+	r ^= r >> 17;
+	r ^= r << 5;
+	return r;
+}
+
+// flat ram, random i/o and interrupt controller
+class TEST_BUS : public DEVICE
+{
+private:
+	DEVICE* d_cpu;
+	uint8 ram[0x10000];
+	uint32 io_rand;
+	FILEIO* fio;
+	
+	// crc of the cpu state at every opecode fetch
+	uint32* trace;
+	int trace_alloc;
+	
+	void snapshot() {
+		fio->Fseek(0, FILEIO_SEEK_SET);
+		d_cpu->save_state(fio);
+		// skip the state version and the device id
+		uint32 crc = getcrc32((uint8*)fio->GetBuffer() + 8, fio->Ftell() - 8);
+		if(ref_trace != NULL) {
+			if(error_index < 0 && (trace_count >= ref_count || ref_trace[trace_count] != crc)) {
+				error_index = trace_count;
+			}
+		}
+		else {
+			if(trace_count == trace_alloc) {
+				trace_alloc = trace_alloc ? trace_alloc * 2 : 0x10000;
+				trace = (uint32*)realloc(trace, trace_alloc * sizeof(uint32));
+			}
+			trace[trace_count] = crc;
+		}
+		if(trace_count == dump_index) {
+			memcpy(dump, fio->GetBuffer(), fio->Ftell());
+			dump_size = fio->Ftell();
+		}
+		trace_count++;
+	}
+
+public:
+	TEST_BUS(VM* parent_vm, EMU* parent_emu) : DEVICE(parent_vm, parent_emu) {
+		fio = new FILEIO();
+		fio->Mopen(NULL, 0, FILEIO_WRITE_BINARY);
+		trace = NULL;
+		trace_alloc = 0;
+		ref_trace = NULL;
+		dump_index = -1;
+	}
+	~TEST_BUS() {
+		fio->Fclose();
+		delete fio;
+		if(trace) {
+			free(trace);
+		}
+	}
+	
+	void start(DEVICE* cpu, uint32 seed, uint32* ref, int count) {
+		d_cpu = cpu;
+		for(int i = 0; i < 0x10000; i++) {
+			seed = next_rand(seed);
+			// avoid waiting for the interrupt at many halt opecodes
+			ram[i] = ((seed & 0xff) == 0x76) ? 0x00 : (seed & 0xff);
+		}
+		io_rand = seed;
+		trace_count = 0;
+		ref_trace = ref;
+		ref_count = count;
+		error_index = -1;
+	}
+	uint32* get_trace() {
+		return trace;
+	}
+	uint32 get_ram_crc() {
+		return getcrc32(ram, sizeof(ram));
+	}
+	
+	void write_data8(uint32 addr, uint32 data) {
+		ram[addr & 0xffff] = data;
+	}
+	uint32 read_data8(uint32 addr) {
+		return ram[addr & 0xffff];
+	}
+	uint32 fetch_op(uint32 addr, int *wait) {
+		snapshot();
+		*wait = 0;
+		return ram[addr & 0xffff];
+	}
+	void write_io8(uint32 addr, uint32 data) {
+		// stop the cpu in the middle of the slice
+		if((addr & 0xff) == 0xfe && (data & 1)) {
+			d_cpu->write_signal(SIG_CPU_BUSREQ, 1, 1);
+		}
+	}
+	uint32 read_io8(uint32 addr) {
+		io_rand = next_rand(io_rand);
+		return io_rand & 0xff;
+	}
+	uint32 intr_ack() {
+		io_rand = next_rand(io_rand);
+		return io_rand & 0xff;
+	}
+	
+	uint32* ref_trace;
+	int ref_count, trace_count, error_index;
+	int dump_index, dump_size;
+	uint8 dump[256];
+};
+
+// minimum virtual machine to link the devices
+VM::VM(EMU* parent_emu) : emu(parent_emu)
+{
+	first_device = last_device = NULL;
+}
+
+VM::~VM()
+{
+	for(DEVICE* device = first_device; device;) {
+		DEVICE *next_device = device->next_device;
+		device->release();
+		delete device;
+		device = next_device;
+	}
+}
+
+template <class T> static DEVICE* create_cpu(VM* vm, TEST_BUS* bus)
+{
+	T* cpu = new T(vm, NULL);
+	cpu->set_context_mem(bus);
+	cpu->set_context_io(bus);
+	cpu->set_context_intr(bus);
+	cpu->initialize();
+	cpu->reset();
+	return cpu;
+}
+
+// run one block and return the passed clocks
+static int run_block(DEVICE* cpu, TEST_BUS* bus, uint32 seed, uint32* ref, int count)
+{
+	bus->start(cpu, seed, ref, count);
+	int passed = 0;
+	while(passed < TEST_CLOCKS) {
+		seed = next_rand(seed);
+		cpu->write_signal(SIG_CPU_BUSREQ, 0, 1);
+		if(((seed >> 8) & 15) == 0) {
+			cpu->write_signal(SIG_CPU_IRQ, (seed >> 12) & 1, 1);
+		}
+		if(((seed >> 16) & 255) == 0) {
+			cpu->write_signal(SIG_CPU_NMI, 1, 1);
+		}
+		int clock = (seed >> 20) & 1023;
+		passed += cpu->run(clock ? clock : -1);
+	}
+	return passed;
+}
+
+static void print_state(const char* name, TEST_BUS* bus)
+{
+	printf("%s:", name);
+	for(int i = 0; i < bus->dump_size; i++) {
+		printf(" %02x", bus->dump[i]);
+	}
+	printf("\n");
+}
+
+int main(int argc, char* argv[])
+{
+	VM* vm = new VM(NULL);
+	TEST_BUS* ref_bus = new TEST_BUS(vm, NULL);
+	TEST_BUS* test_bus = new TEST_BUS(vm, NULL);
+	DEVICE* ref_cpu = create_cpu<Z80_SWITCH>(vm, ref_bus);
+	DEVICE* test_cpu = create_cpu<Z80_THREADED>(vm, test_bus);
+	int total_count = 0, errors = 0;
+	
+	for(int block = 0; block < TEST_BLOCKS; block++) {
+		uint32 seed = 0x9e3779b9 * (block + 1);
+		ref_cpu->reset();
+		test_cpu->reset();
+		
+		int ref_passed = run_block(ref_cpu, ref_bus, seed, NULL, 0);
+		int count = ref_bus->trace_count;
+		int test_passed = run_block(test_cpu, test_bus, seed, ref_bus->get_trace(), count);
+		
+		int error_index = test_bus->error_index;
+		if(error_index < 0 && test_bus->trace_count != count) {
+			error_index = (test_bus->trace_count < count) ? test_bus->trace_count : count;
+		}
+		if(error_index < 0 && (test_passed != ref_passed || test_bus->get_ram_crc() != ref_bus->get_ram_crc())) {
+			error_index = count;
+		}
+		if(error_index >= 0) {
+			printf("block %d: mismatch at opecode fetch %d of %d\n", block, error_index, count);
+			// run both cores again to dump the states
+			ref_bus->dump_size = test_bus->dump_size = 0;
+			ref_bus->dump_index = test_bus->dump_index = error_index;
+			ref_cpu->reset();
+			test_cpu->reset();
+			run_block(ref_cpu, ref_bus, seed, NULL, 0);
+			run_block(test_cpu, test_bus, seed, ref_bus->get_trace(), count);
+			ref_bus->dump_index = test_bus->dump_index = -1;
+			print_state("switch  ", ref_bus);
+			print_state("threaded", test_bus);
+			errors++;
+		}
+		total_count += count;
+	}
+	printf("%d blocks, %d opecode fetches, %d errors\n", TEST_BLOCKS, total_count, errors);
+	delete vm;
+	return errors ? 1 : 0;
+}